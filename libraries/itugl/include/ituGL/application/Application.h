@@ -8,7 +8,8 @@ class Application
 {
 public:
     // Construct the application specifying the dimensions of the window and its title
-    Application(int width, int height, const char* title);
+    // Headless applications use an invisible window, and usually render to a framebuffer object instead
+    Application(int width, int height, const char* title, bool headless = false);
 
     // Destroy de application
     virtual ~Application();
@@ -16,6 +17,10 @@ public:
     // Start the application
     int Run();
 
+    // Stop after a fixed number of frames (0 for no limit), advancing the time by timeStep seconds each frame
+    // instead of using the real time, so every run produces the same frames
+    void SetFrameLimit(unsigned int frameCount, float timeStep);
+
 protected:
     // (C++) 1
     // Get the OpenGL device
@@ -33,6 +38,12 @@ protected:
     // Get time in seconds of the current frame
     float GetDeltaTime() const { return m_deltaTime; }
 
+    // Get the number of frames completed since the start of the application
+    unsigned int GetFrameIndex() const { return m_frameIndex; }
+
+    // Test if the application runs without a visible window
+    bool IsHeadless() const { return m_headless; }
+
     // Test if the application is currently running
     bool IsRunning() const;
 
@@ -72,6 +83,13 @@ private:
     // Time in seconds of the current frame
     float m_deltaTime;
 
+    // Frames completed, and fixed frame settings (m_frameLimit == 0 means real time with no limit)
+    unsigned int m_frameIndex;
+    unsigned int m_frameLimit;
+    float m_fixedTimeStep;
+
+    bool m_headless;
+
     // Exit code
     int m_exitCode;
     // Error message to display on exit
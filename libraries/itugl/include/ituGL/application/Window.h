@@ -6,7 +6,9 @@
 class Window
 {
 public:
-    Window(int width, int height, const char* title);
+    // Invisible windows still have a valid context, for rendering offscreen without a display
+    // With a shared window, the context shares its objects (buffers, textures, programs...) with the one of that window
+    Window(int width, int height, const char* title, bool visible = true, Window* sharedWindow = nullptr);
     ~Window();
 
     // (C++) 1
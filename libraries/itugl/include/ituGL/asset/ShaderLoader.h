@@ -2,12 +2,20 @@
 
 #include <ituGL/asset/AssetLoader.h>
 #include <ituGL/shader/Shader.h>
+#include <set>
 #include <span>
+#include <string>
+#include <vector>
 
 class ShaderLoader : AssetLoader<Shader>
 {
 public:
-    ShaderLoader(Shader::Type type);
+    // Preprocessor defines, as "NAME" or "NAME VALUE". Sorted, so the same defines in any order are the same set
+    using DefineSet = std::set<std::string>;
+
+public:
+    // The defines are added to all the shaders loaded, after the #version line
+    ShaderLoader(Shader::Type type, const DefineSet& defines = DefineSet());
 
     using AssetLoader<Shader>::IsValid;
     bool IsValid(std::span<const char*> paths);
@@ -22,8 +30,15 @@ public:
 
     static Shader Load(Shader::Type type, const char* path);
 
+    // Read the sources of the files, with the defines added to the first one, without compiling them
+    static std::vector<std::string> LoadSources(std::span<const char*> paths, const DefineSet& defines = DefineSet());
+
 private:
     void Compile(Shader& shader);
 
+    // Add the defines after the #version line, that must be the first one, or at the start if there is none
+    static void AddDefines(std::string& source, const DefineSet& defines);
+
     Shader::Type m_type;
+    DefineSet m_defines;
 };
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/shader/ShaderUniformCollection.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Window;
+class ShaderProgramCache;
+class Material;
+
+// Programs built from the same shader files with different sets of defines, so the shaders can choose features with
+//     #ifdef TEXTURED ... #endif
+// instead of branching on uniforms. Each define set is built once, the first time it is requested
+// With background compilation, programs are built in another thread, with a context that shares objects with the main
+// one. Until then, GetProgram returns null, and the caller can draw something else
+class ShaderPermutationCache
+{
+public:
+    using DefineSet = ShaderLoader::DefineSet;
+
+public:
+    // Optionally, programs can be stored in a program cache, that must outlive this object
+    ShaderPermutationCache(std::vector<std::string> vertexPaths, std::vector<std::string> fragmentPaths,
+        ShaderProgramCache* programCache = nullptr);
+    ~ShaderPermutationCache();
+
+    // Create the context of the background thread, sharing objects with the window, and start the thread
+    // Without it, programs are built in GetProgram, in the calling thread
+    void StartBackgroundCompilation(Window& window);
+
+    // Program of the define set, or null if it is not built yet. The first time, the build is requested
+    // With wait, it doesn't return until the program is built. Programs that failed to build are null too
+    std::shared_ptr<ShaderProgram> GetProgram(const DefineSet& defines, bool wait = false);
+
+    // Build again all the programs, from the current files, in new program objects. Each one is swapped in GetProgram
+    // once it is built, so callers can tell it changed by the pointer. Programs that fail to build keep the previous one
+    void Reload();
+
+    // Switch the material to the program of the define set once it is built, and again after each Reload
+    // The uniforms keep the values already set in the material. Returns true if the program changed, so the caller
+    // can register the new one where needed, like in the renderer
+    bool UpdateMaterial(Material& material, const DefineSet& defines,
+        const ShaderUniformCollection::NameSet& filteredUniforms = ShaderUniformCollection::NameSet());
+
+    // Number of define sets requested, and how many of them are waiting to be built
+    unsigned int GetPermutationCount() const;
+    unsigned int GetPendingCount() const;
+
+private:
+    enum class State
+    {
+        Pending,
+        Built,
+        Failed,
+    };
+
+    struct Permutation
+    {
+        // Created with the request, in the main thread, so it is also deleted there
+        std::shared_ptr<ShaderProgram> program;
+        State state = State::Pending;
+
+        // Program being rebuilt by Reload, until it is swapped
+        std::shared_ptr<ShaderProgram> reloadedProgram;
+        State reloadState = State::Pending;
+        // Reload was called while building or rebuilding, the files could have changed after they were read
+        bool reloadAgain = false;
+    };
+
+    struct Request
+    {
+        DefineSet defines;
+        bool reload;
+    };
+
+    bool BuildProgram(ShaderProgram& shaderProgram, const DefineSet& defines) const;
+
+    // Start rebuilding the program of the permutation. The lock is released while building, without background thread
+    void ReloadPermutation(const DefineSet& defines, Permutation& permutation, std::unique_lock<std::mutex>& lock);
+
+    void RunBackgroundThread();
+
+private:
+    std::vector<std::string> m_vertexPaths;
+    std::vector<std::string> m_fragmentPaths;
+    ShaderProgramCache* m_programCache;
+
+    std::map<DefineSet, Permutation> m_permutations;
+
+    // Requests for the background thread, in order
+    std::deque<Request> m_requests;
+
+    std::unique_ptr<Window> m_backgroundWindow;
+    std::thread m_backgroundThread;
+    bool m_stopBackgroundThread;
+
+    // Protects the permutations and the requests. The condition is notified when either of them changes
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
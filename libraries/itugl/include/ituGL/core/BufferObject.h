@@ -13,6 +13,12 @@ public:
         ArrayBuffer = GL_ARRAY_BUFFER,
         // Element Buffer Object
         ElementArrayBuffer = GL_ELEMENT_ARRAY_BUFFER,
+        // Uniform Buffer Object, storage for uniform blocks
+        UniformBuffer = GL_UNIFORM_BUFFER,
+        // Shader Storage Buffer Object, storage for buffer blocks. Requires OpenGL 4.3
+        ShaderStorageBuffer = GL_SHADER_STORAGE_BUFFER,
+        // Draw Indirect Buffer, parameters of indirect drawcalls. Requires OpenGL 4.0 (multi draw: 4.3)
+        DrawIndirectBuffer = GL_DRAW_INDIRECT_BUFFER,
         // TODO: There are more types, add them when they are supported
     };
 
@@ -63,6 +69,11 @@ protected:
     void Bind(Target target) const;
     // Unbind the specific target. It is static because we dont need any objects to do it
     static void Unbind(Target target);
+
+    // Bind the whole buffer, or a range of it, to an indexed binding point of the target (uniform or shader storage)
+    // It also binds the buffer to the target, like Bind(target)
+    void BindBase(Target target, GLuint index) const;
+    void BindRange(Target target, GLuint index, size_t offset, size_t size) const;
 };
 
 // (C++) 5
@@ -83,6 +94,10 @@ public:
     // When unbinding this class, we unbind the corresponding Target
     static void Unbind();
 
+    // Bind to an indexed binding point. Only for the targets with binding points, like UniformBuffer
+    void BindBase(GLuint index) const;
+    void BindRange(GLuint index, size_t offset, size_t size) const;
+
 #ifndef NDEBUG
     // Check if there is any BufferObject currently bound to this target
     inline static bool IsAnyBound() { return s_boundHandle != Object::NullHandle; }
@@ -119,4 +134,22 @@ void BufferObjectBase<T>::Unbind()
 #ifndef NDEBUG
     s_boundHandle = NullHandle;
 #endif
-}
\ No newline at end of file
+}
+
+template<BufferObject::Target T>
+void BufferObjectBase<T>::BindBase(GLuint index) const
+{
+    BufferObject::BindBase(T, index);
+#ifndef NDEBUG
+    s_boundHandle = GetHandle();
+#endif
+}
+
+template<BufferObject::Target T>
+void BufferObjectBase<T>::BindRange(GLuint index, size_t offset, size_t size) const
+{
+    BufferObject::BindRange(T, index, offset, size);
+#ifndef NDEBUG
+    s_boundHandle = GetHandle();
+#endif
+}
@@ -2,6 +2,7 @@
 
 #include <ituGL/core/Color.h>
 #include <glad/glad.h>
+#include <vector>
 
 class Window;
 struct GLFWwindow;
@@ -10,6 +11,25 @@ struct GLFWwindow;
 // Implemented as a Singleton pattern, as there can only be one
 class DeviceGL
 {
+public:
+    // Number of state changes sent to OpenGL, and skipped because the state was already set, in one frame
+    struct StateCounters
+    {
+        unsigned int programChanges = 0;
+        unsigned int programSkips = 0;
+        unsigned int vertexArrayChanges = 0;
+        unsigned int vertexArraySkips = 0;
+        unsigned int textureChanges = 0;
+        unsigned int textureSkips = 0;
+        unsigned int bufferBindingChanges = 0;
+        unsigned int bufferBindingSkips = 0;
+        unsigned int fixedStateChanges = 0;
+        unsigned int fixedStateSkips = 0;
+        unsigned int uniformChanges = 0;
+        unsigned int uniformSkips = 0;
+        size_t uniformBytes = 0;
+    };
+
 public:
     DeviceGL();
     ~DeviceGL();
@@ -23,6 +43,9 @@ public:
     // Check if device is initialized
     inline bool IsReady() const { return m_contextLoaded; }
 
+    // Check if the context supports glMultiDraw*Indirect and shader storage blocks (OpenGL 4.3)
+    inline bool IsMultiDrawIndirectSupported() const { return m_contextLoaded && GLAD_GL_VERSION_4_3; }
+
     // Set the window that OpenGL will use for rendering
     void SetCurrentWindow(Window &window);
 
@@ -52,10 +75,95 @@ public:
     // enable / disable v-sync
     void SetVSyncEnabled(bool enabled);
 
+    // Render state cache: each function only calls OpenGL if the state is different from the last one set
+    // Code that changes these states with OpenGL directly must call InvalidateState afterwards
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vertexArray);
+    void SetActiveTexture(GLint textureUnit);
+    void BindTexture(GLenum target, GLuint texture);
+    // Indexed binding of GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER. Size 0 binds the whole buffer (glBindBufferBase)
+    void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    void SetDepthFunction(GLenum function);
+    void SetDepthWrite(bool enabled);
+    // face can be GL_FRONT, GL_BACK or GL_FRONT_AND_BACK. Culling also needs GL_CULL_FACE enabled
+    void SetCullFace(GLenum face);
+    void SetBlendEquation(GLenum colorEquation, GLenum alphaEquation);
+    void SetBlendFunction(GLenum sourceColor, GLenum destinationColor, GLenum sourceAlpha, GLenum destinationAlpha);
+    // face can be GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+    void SetStencilOperation(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+    void SetStencilFunction(GLenum face, GLenum function, GLint reference, GLuint mask);
+
+    // Forget all the cached states, so the next change of each one is always sent
+    void InvalidateState();
+
+    // Called when an object is deleted, as OpenGL can reuse its handle for a new object
+    void OnProgramDeleted(GLuint program);
+    void OnVertexArrayDeleted(GLuint vertexArray);
+    void OnTextureDeleted(GLuint texture);
+    void OnBufferDeleted(GLuint buffer);
+
+    // Called when the storage of a buffer is reallocated, so its indexed bindings are sent again the next time
+    void OnBufferReallocated(GLuint buffer);
+
+    // Called when uniform values are sent to OpenGL, or skipped because the program already has them
+    void OnUniformSet(size_t bytes);
+    void OnUniformSkipped();
+
+    // Counters of the frame in progress, and of the last completed frame
+    inline const StateCounters& GetStateCounters() const { return m_stateCounters; }
+    inline const StateCounters& GetLastFrameStateCounters() const { return m_lastFrameStateCounters; }
+
+    // Stores the counters of the frame and starts counting a new one
+    void EndFrame();
+
+private:
+    // Compares a cached value with a new one, updating it and the counters. Returns if OpenGL needs to be called
+    template<typename T>
+    bool ChangeState(T& cached, const T& value, unsigned int& changes, unsigned int& skips);
+
 private:
     // Has a context been loaded? We use the context of the current window
     bool m_contextLoaded;
 
+    // Cached render states. Unknown values use values that OpenGL can never return, so the first change is always sent
+    struct TextureBinding
+    {
+        GLint unit;
+        GLenum target;
+        GLuint texture;
+    };
+    struct BufferBinding
+    {
+        GLenum target;
+        GLuint index;
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+    struct FeatureState
+    {
+        GLenum feature;
+        bool enabled;
+    };
+    GLuint m_program;
+    GLuint m_vertexArray;
+    GLint m_activeTexture;
+    std::vector<TextureBinding> m_textureBindings;
+    std::vector<BufferBinding> m_bufferBindings;
+    std::vector<FeatureState> m_features;
+    GLenum m_depthFunction;
+    GLint m_depthWrite;
+    GLenum m_cullFace;
+    GLenum m_blendEquations[2];
+    GLenum m_blendFunctions[4];
+    GLenum m_stencilOperations[2][3];
+    GLenum m_stencilFunctions[2];
+    GLint m_stencilReferences[2];
+    GLuint m_stencilMasks[2];
+
+    StateCounters m_stateCounters;
+    StateCounters m_lastFrameStateCounters;
+
 private:
     // Singleton instance
     static DeviceGL* m_instance;
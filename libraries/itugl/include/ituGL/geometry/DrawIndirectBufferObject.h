@@ -0,0 +1,60 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+
+// Draw Indirect Buffer Object is the common term for a BufferObject when it is storing the parameters of drawcalls
+// The GPU reads them when the drawcall is executed, so many drawcalls can be submitted with a single call
+// See Drawcall::MultiDrawIndirect
+class DrawIndirectBufferObject : public BufferObjectBase<BufferObject::DrawIndirectBuffer>
+{
+public:
+    // Parameters of one drawcall without EBO, with the layout expected by glMultiDrawArraysIndirect
+    struct ArraysCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    // Parameters of one drawcall with EBO, with the layout expected by glMultiDrawElementsIndirect
+    struct ElementsCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+public:
+    DrawIndirectBufferObject();
+
+    // Use the same AllocateData methods from the base class
+    using BufferObject::AllocateData;
+    // Additionally, provide AllocateData template method for any type of data span, with StreamDraw as default usage
+    template<typename T>
+    void AllocateData(std::span<const T> data, Usage usage = Usage::StreamDraw);
+
+    // Use the same UpdateData methods from the base class
+    using BufferObject::UpdateData;
+    // Additionally, provide UpdateData template method for any type of data span
+    template<typename T>
+    void UpdateData(std::span<const T> data, size_t offsetBytes = 0);
+};
+
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void DrawIndirectBufferObject::AllocateData(std::span<const T> data, Usage usage)
+{
+    BufferObject::AllocateData(Data::GetBytes(data), usage);
+}
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void DrawIndirectBufferObject::UpdateData(std::span<const T> data, size_t offsetBytes)
+{
+    BufferObject::UpdateData(Data::GetBytes(data), offsetBytes);
+}
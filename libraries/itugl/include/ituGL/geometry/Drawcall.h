@@ -31,9 +31,22 @@ public:
     // Check if the drawcall is valid
     inline bool IsValid() const { return m_primitive != Primitive::Invalid && m_count > 0; }
 
+    inline Primitive GetPrimitive() const { return m_primitive; }
+    inline GLint GetFirst() const { return m_first; }
+    inline GLsizei GetCount() const { return m_count; }
+    inline Data::Type GetEBOType() const { return m_eboType; }
+
     // Execute the drawcall
     void Draw() const;
 
+    // Execute the drawcall once for each instance. Attributes with a divisor advance per instance instead of per vertex
+    void DrawInstanced(GLsizei instanceCount) const;
+
+    // Execute drawCount drawcalls with the commands stored in the bound DrawIndirectBufferObject, starting at offset bytes
+    // Commands are DrawIndirectBufferObject::ElementsCommand if there is an EBO, or ArraysCommand if eboType is None
+    // Requires OpenGL 4.3, see DeviceGL::IsMultiDrawIndirectSupported
+    static void MultiDrawIndirect(Primitive primitive, Data::Type eboType, size_t offset, GLsizei drawCount);
+
 private:
     // Type of primitive to be rendered
     Primitive m_primitive;
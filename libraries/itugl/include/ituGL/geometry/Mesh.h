@@ -46,6 +46,14 @@ public:
     template<typename TIterator>
     unsigned int AddVertexArray(std::span<unsigned int> vboIndices, TIterator& it, const TIterator itEnd, const SemanticMap& locations = SemanticMap());
 
+    // (C++) 7
+    // Adds a new VAO, with data stored in a single VBO and an EBO inside the mesh, and an iterator for the attributes
+    // The same VAO can then be shared by several submeshes drawing different ranges of the EBO
+    // vboIndex is the index inside m_vbos of the VBO to be used
+    // eboIndex is the index inside m_ebos of the EBO to be used
+    template<typename TIterator>
+    unsigned int AddVertexArray(unsigned int vboIndex, unsigned int eboIndex, TIterator& it, const TIterator itEnd, const SemanticMap& locations = SemanticMap());
+
     // Adds a new submesh, with the index of the VAO to be bound, and the Drawcall parameters
     unsigned int AddSubmesh(unsigned int vaoIndex, const Drawcall& drawcall);
 
@@ -111,6 +119,7 @@ public:
 
     inline unsigned int GetSubmeshCount() const { return static_cast<unsigned int>(m_submeshes.size()); }
     inline const VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) const { return m_vaos[m_submeshes[submeshIndex].vaoIndex]; }
+    inline VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) { return m_vaos[m_submeshes[submeshIndex].vaoIndex]; }
     inline const Drawcall& GetSubmeshDrawcall(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].drawcall; }
 
     // Draws a submesh
@@ -228,6 +237,23 @@ unsigned int Mesh::AddVertexArray(std::span<unsigned int> vboIndices, TIterator&
     return vaoIndex;
 }
 
+template<typename TIterator>
+unsigned int Mesh::AddVertexArray(unsigned int vboIndex, unsigned int eboIndex, TIterator& it, const TIterator itEnd, const SemanticMap& locations)
+{
+    unsigned int vaoIndex = AddVertexArray(vboIndex, it, itEnd, locations);
+
+    VertexArrayObject& vao = GetVertexArray(vaoIndex);
+    vao.Bind();
+
+    const ElementBufferObject& ebo = GetElementBuffer(eboIndex);
+    ebo.Bind();
+
+    VertexArrayObject::Unbind();
+    ElementBufferObject::Unbind();
+
+    return vaoIndex;
+}
+
 template<typename TIterator>
 unsigned int Mesh::AddSubmesh(Drawcall::Primitive primitive, int firstVertex, int vertexCount,
     unsigned int vboIndex,
@@ -251,17 +277,7 @@ unsigned int Mesh::AddSubmesh(Drawcall::Primitive primitive, int firstElement, i
     unsigned int vboIndex, unsigned int eboIndex,
     TIterator it, const TIterator itEnd, const SemanticMap& locations)
 {
-    unsigned int vaoIndex = AddVertexArray(vboIndex, it, itEnd, locations);
-
-    VertexArrayObject& vao = GetVertexArray(vaoIndex);
-    vao.Bind();
-
-    const ElementBufferObject& ebo = GetElementBuffer(eboIndex);
-    ebo.Bind();
-
-    VertexArrayObject::Unbind();
-    ElementBufferObject::Unbind();
-
+    unsigned int vaoIndex = AddVertexArray(vboIndex, eboIndex, it, itEnd, locations);
     return AddSubmesh(vaoIndex, primitive, firstElement, elementCount, elementType);
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <glm/vec3.hpp>
 #include <memory>
 #include <vector>
 
@@ -36,10 +37,19 @@ public:
     // Draw all the submeshes of the mesh, each one with a material on the list
     void Draw();
 
+    // Box around all the vertices, in local space, as center and half size. Default: from -1 to 1 in all axes
+    inline const glm::vec3& GetLocalBoundsCenter() const { return m_localBoundsCenter; }
+    inline const glm::vec3& GetLocalBoundsSize() const { return m_localBoundsSize; }
+    void SetLocalBounds(const glm::vec3& center, const glm::vec3& size);
+
 private:
     // Pointer to the model Mesh
     std::shared_ptr<Mesh> m_mesh;
 
     // List of material pointers, one for each submesh
     std::vector<std::shared_ptr<Material>> m_materials;
+
+    // Local bounding box, for culling
+    glm::vec3 m_localBoundsCenter;
+    glm::vec3 m_localBoundsSize;
 };
@@ -27,6 +27,15 @@ public:
     // stride: how far each element is from the previous one. Default value 0 will use the attribute size
     void SetAttribute(GLuint location, const VertexAttribute& attribute, GLint offset, GLsizei stride = 0);
 
+    // Sets how often the attribute in location advances: 0 (default) for every vertex, or once every divisor instances
+    void SetAttributeDivisor(GLuint location, GLuint divisor);
+
+    // Disables the attribute in location. Shaders read the value set with SetAttributeValue instead
+    void DisableAttribute(GLuint location);
+
+    // Sets the value that an integer attribute reads in location while it is disabled. It is not part of the VAO state
+    static void SetAttributeValue(GLuint location, GLuint value);
+
 #ifndef NDEBUG
     // Check if there is any VertexArrayObject currently bound
     inline static bool IsAnyBound() { return s_boundHandle != Object::NullHandle; }
@@ -13,6 +13,17 @@ public:
         Spot,
     };
 
+    // Light parameters in 4 vec4, so the layout is the same in std140 and std430. For light arrays in buffer blocks:
+    //   struct Light { vec4 Color; vec4 Position; vec4 Direction; vec4 Attenuation; };
+    // Color is multiplied by the intensity, and Color.w is the type
+    struct PackedData
+    {
+        glm::vec4 color;
+        glm::vec4 position;
+        glm::vec4 direction;
+        glm::vec4 attenuation;
+    };
+
 public:
     Light();
     virtual ~Light();
@@ -35,6 +46,11 @@ public:
     float GetIntensity() const;
     void SetIntensity(float intensity);
 
+    // Sphere containing all the points the light reaches. Returns false if the light has no limit, like directional lights
+    virtual bool GetBoundingSphere(glm::vec3& center, float& radius) const;
+
+    PackedData GetPackedData() const;
+
 private:
     glm::vec3 m_color;
     float m_intensity;
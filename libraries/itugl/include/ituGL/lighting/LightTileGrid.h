@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/vec4.hpp>
+#include <span>
+#include <vector>
+
+class Camera;
+class Light;
+
+// Bins the lights in square screen tiles, on the CPU, so each pixel only shades the lights that can reach it
+// Lights are binned with the screen rectangle of their bounding sphere. Lights without one go in every tile
+// The result is packed in a single array of uint, to upload it in a storage block:
+//   layout(std430) readonly buffer LightTileBlock { uvec4 LightTileGrid; uint LightTileData[]; };
+// LightTileGrid is (tile size, tile count x, tile count y, light count), and the tile at (x, y), with index
+// i = y * countX + x, has LightTileData[2i + 1] lights, starting at LightTileData[LightTileData[2i]]
+class LightTileGrid
+{
+public:
+    LightTileGrid(unsigned int tileSize = 32);
+
+    unsigned int GetTileSize() const { return m_tileSize; }
+    unsigned int GetTileCountX() const { return m_tileCountX; }
+    unsigned int GetTileCountY() const { return m_tileCountY; }
+
+    // Bin the lights for a viewport of width x height pixels
+    void Build(const Camera& camera, std::span<const Light* const> lights, int width, int height);
+
+    // Indices of the lights in the tile, in the span given to Build
+    std::span<const unsigned int> GetTileLights(unsigned int x, unsigned int y) const;
+
+    // (tile size, tile count x, tile count y, light count)
+    glm::uvec4 GetGridInfo() const;
+
+    // Offsets and counts of the tiles, followed by the light indices. See LightTileBlock above
+    std::span<const unsigned int> GetData() const { return m_data; }
+
+    // Average lights per tile in the last Build, to compare with the total
+    float GetAverageLightCount() const;
+
+private:
+    unsigned int m_tileSize;
+    unsigned int m_tileCountX;
+    unsigned int m_tileCountY;
+    unsigned int m_lightCount;
+
+    // Tile rectangle covered by each light, as (min x, min y, max x, max y), inclusive. Empty if min > max
+    std::vector<glm::ivec4> m_lightRects;
+
+    std::vector<unsigned int> m_data;
+};
@@ -19,6 +19,9 @@ public:
     glm::vec2 GetDistanceAttenuation() const;
     void SetDistanceAttenuation(glm::vec2 attenuation);
 
+    // Sphere of radius GetDistanceAttenuation().y, where the attenuation ends. Unbounded if it is not set
+    bool GetBoundingSphere(glm::vec3& center, float& radius) const override;
+
 private:
     glm::vec3 m_position;
     glm::vec2 m_attenuation;
@@ -29,6 +29,9 @@ public:
     glm::vec2 GetAngleAttenuation() const;
     void SetAngleAttenuation(glm::vec2 attenuation);
 
+    // Sphere containing the cone of half angle GetAngle() and length GetDistanceAttenuation().y. Unbounded if it is not set
+    bool GetBoundingSphere(glm::vec3& center, float& radius) const override;
+
 private:
     glm::vec3 m_position;
     glm::vec3 m_direction;
@@ -3,22 +3,80 @@
 #include <ituGL/renderer/RenderPass.h>
 
 #include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/shader/ShaderStorageBufferObject.h>
 #include <ituGL/geometry/Mesh.h>
+#include <ituGL/lighting/Light.h>
+#include <ituGL/lighting/LightTileGrid.h>
+#include <glm/mat4x4.hpp>
 #include <memory>
+#include <vector>
 
 class Texture2DObject;
 class Material;
+class Camera;
+class SphereBounds;
 
 class DeferredRenderPass: public RenderPass
 {
+public:
+    // Binding points of the storage blocks for tiled lighting
+    //   layout(std430) readonly buffer LightArrayBlock { Light Lights[]; };  (see Light::PackedData)
+    //   layout(std430) readonly buffer LightTileBlock { uvec4 LightTileGrid; uint LightTileData[]; };  (see LightTileGrid)
+    static const GLuint LightArrayBinding = 1;
+    static const GLuint LightTileBinding = 2;
+
 public:
     DeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr);
 
     void Render() override;
 
+    const char* GetName() const override { return "DeferredRenderPass"; }
+
+    // Draw point and spot lights with a mesh around the volume they light, instead of a fullscreen triangle
+    // The front faces are drawn with GL_LEQUAL, so the pixels in front of the volume are not shaded, or the back faces
+    // with GL_GEQUAL when the camera is inside the volume. The depth test needs the material to enable it, and the
+    // target framebuffer to have the depth of the G-buffer. The G-buffer has no stencil, so the two-sided stencil test
+    // that also skips the pixels on the other side is not used
+    // The shader must compute its texture coordinates from gl_FragCoord, instead of the vertex positions. Default: enabled
+    bool IsLightVolumesEnabled() const { return m_lightVolumesEnabled; }
+    void SetLightVolumesEnabled(bool enabled) { m_lightVolumesEnabled = enabled; }
+
+    // Draw all the lights in a single fullscreen pass, with the lights of each tile binned on the CPU
+    // Only available if the material declares LightArrayBlock and LightTileBlock (OpenGL 4.3). The uniforms only
+    // have the indirect light then
+    bool IsTiledLightingSupported() const { return m_tiledLightingSupported; }
+    bool IsTiledLightingEnabled() const { return m_tiledLightingEnabled && m_tiledLightingSupported; }
+    void SetTiledLightingEnabled(bool enabled) { m_tiledLightingEnabled = enabled; }
+
+    const LightTileGrid& GetLightTileGrid() const { return m_lightTileGrid; }
+
 private:
     void InitializeMeshes();
+    void InitializeTiledLighting();
+
+    // Select the light volume mesh, its world matrix and a sphere containing it. Returns false if the light needs a
+    // fullscreen triangle
+    bool GetLightVolume(const Light& light, const Mesh*& mesh, glm::mat4& worldMatrix, SphereBounds& volumeBounds) const;
+
+    void RenderLights(const Camera& camera);
+    void RenderTiledLights(const Camera& camera);
+
+    // Bin the lights in tiles, and upload the lights and the tiles for the shader
+    void UpdateLightTiles(const Camera& camera, std::span<const Light* const> lights);
 
 private:
     std::shared_ptr<Material> m_material;
+
+    bool m_lightVolumesEnabled;
+
+    // Unit sphere, and cone with the apex at the origin and a base of radius 1 at z = 1
+    Mesh m_sphereMesh;
+    Mesh m_coneMesh;
+
+    bool m_tiledLightingSupported;
+    bool m_tiledLightingEnabled;
+    LightTileGrid m_lightTileGrid;
+    std::vector<Light::PackedData> m_lightArrayData;
+    ShaderStorageBufferObject m_lightArrayBuffer;
+    ShaderStorageBufferObject m_lightTileBuffer;
 };
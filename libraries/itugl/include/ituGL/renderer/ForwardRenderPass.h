@@ -10,6 +10,8 @@ public:
 
     void Render() override;
 
+    const char* GetName() const override { return "ForwardRenderPass"; }
+
 private:
     int m_drawcallCollectionIndex;
 };
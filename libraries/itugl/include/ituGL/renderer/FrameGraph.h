@@ -0,0 +1,166 @@
+#pragma once
+
+#include <ituGL/texture/TextureObject.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Texture2DObject;
+class FramebufferObject;
+
+// Textures read and written by the render passes of one frame
+// Each frame, the passes declare the resources they read and write, then the graph is compiled:
+// - Passes that don't contribute to any side effect (like drawing to the default framebuffer) are culled
+// - Transient textures only live from the first to the last pass that uses them. They are taken from a pool, and
+//   textures with the same size and format are reused by resources that are not alive at the same time
+// - Passes writing the same textures share the framebuffer, so they don't need to switch it
+class FrameGraph
+{
+public:
+    using ResourceId = int;
+    static const ResourceId InvalidResource = -1;
+
+    struct TextureDesc
+    {
+        int width = 0;
+        int height = 0;
+        TextureObject::Format format = TextureObject::FormatInvalid;
+        TextureObject::InternalFormat internalFormat = TextureObject::InternalFormatInvalid;
+
+        bool IsValid() const { return width > 0 && height > 0 && format != TextureObject::FormatInvalid; }
+        bool operator == (const TextureDesc& other) const = default;
+    };
+
+    // Declares the resources of one pass
+    class Builder
+    {
+    public:
+        Builder(FrameGraph& frameGraph, unsigned int passIndex);
+
+        // New transient texture, written by this pass
+        ResourceId Create(const char* name, const TextureDesc& desc);
+
+        // Texture owned outside the graph, with the desc it was created with, written by this pass
+        // Writing it is a side effect
+        ResourceId Import(const char* name, std::shared_ptr<Texture2DObject> texture, const TextureDesc& desc);
+
+        // Resource created by a previous pass
+        ResourceId Read(const char* name);
+        ResourceId Write(const char* name);
+
+        // The pass has effects outside of the graph, and must not be culled
+        void SetSideEffect();
+
+    private:
+        FrameGraph& m_frameGraph;
+        unsigned int m_passIndex;
+    };
+
+    // Work of the last Compile
+    struct Stats
+    {
+        unsigned int passCount = 0;
+        unsigned int culledPassCount = 0;
+        unsigned int transientCount = 0;
+        unsigned int textureCount = 0;
+        // Memory of the transients, if each had its own texture, and memory of the textures actually used
+        size_t transientBytes = 0;
+        size_t textureBytes = 0;
+    };
+
+public:
+    FrameGraph();
+    ~FrameGraph();
+
+    // Remove the passes and resources of the previous frame. The pooled textures are kept
+    void Reset();
+
+    // Add a pass, in execution order
+    Builder AddPass(const char* name);
+
+    // Cull the passes and assign the textures to the transients
+    void Compile();
+
+    unsigned int GetPassCount() const { return static_cast<unsigned int>(m_passes.size()); }
+    bool IsPassCulled(unsigned int passIndex) const;
+
+    ResourceId FindResource(const char* name) const;
+
+    // Texture assigned to the resource. Transient textures are only valid during the passes that use them
+    std::shared_ptr<Texture2DObject> GetTexture(ResourceId resourceId) const;
+
+    // Framebuffer with the textures written by the pass: depth formats in the depth attachment, the others in color
+    // attachments, in declaration order. Null if the pass doesn't write any resource
+    std::shared_ptr<const FramebufferObject> GetFramebuffer(unsigned int passIndex);
+
+    const Stats& GetStats() const { return m_stats; }
+
+    // Approximate size of one texel with this format, for the stats
+    static size_t GetTexelSize(TextureObject::InternalFormat internalFormat);
+
+private:
+    struct Resource
+    {
+        std::string name;
+        TextureDesc desc;
+        // Imported, or assigned by Compile
+        std::shared_ptr<Texture2DObject> texture;
+        bool imported = false;
+        std::vector<unsigned int> writers;
+        unsigned int readCount = 0;
+        // Alive passes that use it, first and last
+        int firstPass = -1;
+        int lastPass = -1;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        std::vector<ResourceId> reads;
+        std::vector<ResourceId> writes;
+        bool sideEffect = false;
+        bool culled = false;
+    };
+
+    struct PooledTexture
+    {
+        std::shared_ptr<Texture2DObject> texture;
+        TextureDesc desc;
+        unsigned int lastFrame = 0;
+        bool inUse = false;
+    };
+
+    ResourceId AddResource(const char* name, const TextureDesc& desc, std::shared_ptr<Texture2DObject> texture);
+
+    void CullPasses();
+    void AssignTextures();
+
+    std::shared_ptr<Texture2DObject> AcquireTexture(const TextureDesc& desc);
+    void ReleaseTexture(const std::shared_ptr<Texture2DObject>& texture);
+    void RemoveUnusedTextures();
+
+private:
+    std::vector<Pass> m_passes;
+    std::vector<Resource> m_resources;
+
+    // Pooled textures are deleted when they are not used for this many frames
+    static const unsigned int s_maxUnusedFrames = 8;
+    std::vector<PooledTexture> m_texturePool;
+    unsigned int m_frame;
+
+    // Framebuffer with the textures it was created with. The textures are weak, a deleted texture doesn't keep
+    // the framebuffer alive, and a new texture created at the same address doesn't find it
+    struct CachedFramebuffer
+    {
+        std::vector<std::weak_ptr<Texture2DObject>> textures;
+        std::shared_ptr<FramebufferObject> framebuffer;
+
+        bool IsExpired() const;
+    };
+
+    // Framebuffers by their attachments, the depth first
+    std::map<std::vector<const Texture2DObject*>, CachedFramebuffer> m_framebuffers;
+
+    Stats m_stats;
+};
@@ -7,10 +7,40 @@ class Texture2DObject;
 class GBufferRenderPass : public RenderPass
 {
 public:
-    GBufferRenderPass(int width, int height, int drawcallCollectionIndex = 0);
+    // Textures and encoding of the G-buffer. The shaders writing and reading it must be built for the same layout,
+    // with the defines from GetLayoutDefines
+    enum class Layout
+    {
+        // Albedo SRGBA8, view normal xy RG16F, and others (ambient occlusion, roughness, metalness) SRGBA8
+        Standard,
+        // Albedo with ambient occlusion in alpha SRGBA8, and octahedral normal with roughness and metalness RGBA8
+        // There is no others texture. 12 bytes per pixel, depth included, instead of 16
+        Compact,
+    };
+
+    // Names of the G-buffer textures in the frame graph, to read them in the next passes
+    static constexpr const char* DepthResourceName = "GBuffer.Depth";
+    static constexpr const char* AlbedoResourceName = "GBuffer.Albedo";
+    static constexpr const char* NormalResourceName = "GBuffer.Normal";
+    static constexpr const char* OthersResourceName = "GBuffer.Others";
+
+public:
+    // With transient targets, the textures are taken from the frame graph every frame, and only exist while the passes
+    // that read them run. The texture getters return null then, and GetOthersTexture in the compact layout
+    GBufferRenderPass(int width, int height, int drawcallCollectionIndex = 0, bool transientTargets = false, Layout layout = Layout::Standard);
 
     void Render() override;
 
+    const char* GetName() const override { return "GBufferRenderPass"; }
+
+    Layout GetLayout() const { return m_layout; }
+
+    // Source to add before the G-buffer functions in the shaders, selecting the layout: "#define GBUFFER_COMPACT 1" or empty
+    static const char* GetLayoutDefines(Layout layout);
+
+    // Memory of one pixel of the G-buffer, depth included
+    static size_t GetBytesPerPixel(Layout layout);
+
     const std::shared_ptr<Texture2DObject> GetDepthTexture() const { return m_depthTexture; }
     const std::shared_ptr<Texture2DObject> GetAlbedoTexture() const { return m_albedoTexture; }
     const std::shared_ptr<Texture2DObject> GetNormalTexture() const { return m_normalTexture; }
@@ -19,10 +49,21 @@ public:
 private:
     void InitTextures(int width, int height);
     void InitFramebuffer();
+    void InitTextureOutputs(int width, int height, bool transientTargets);
+
+    // Desc of each texture in the layout. The others desc is not valid in the compact layout
+    static FrameGraph::TextureDesc GetDepthDesc(int width, int height);
+    static FrameGraph::TextureDesc GetAlbedoDesc(int width, int height);
+    static FrameGraph::TextureDesc GetNormalDesc(int width, int height, Layout layout);
+    static FrameGraph::TextureDesc GetOthersDesc(int width, int height, Layout layout);
+
+    static std::shared_ptr<Texture2DObject> CreateTexture(const FrameGraph::TextureDesc& desc);
 
 private:
     int m_drawcallCollectionIndex;
 
+    Layout m_layout;
+
     std::shared_ptr<Texture2DObject> m_depthTexture;
     std::shared_ptr<Texture2DObject> m_albedoTexture;
     std::shared_ptr<Texture2DObject> m_normalTexture;
@@ -14,6 +14,8 @@ public:
 
     void Render() override;
 
+    const char* GetName() const override { return "PostFXRenderPass"; }
+
 private:
     std::shared_ptr<Material> m_material;
     std::shared_ptr<FramebufferObject> m_framebuffer;
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <ituGL/renderer/FrameGraph.h>
 #include <memory>
+#include <string>
+#include <vector>
 
 class Renderer;
 class FramebufferObject;
+class Material;
 
 class RenderPass
 {
@@ -15,13 +19,50 @@ public:
 
     virtual void Render() = 0;
 
+    // Name shown in the profiler
+    virtual const char* GetName() const { return "RenderPass"; }
+
+    // Declare the resources of the frame graph read and written by the pass. By default, the texture inputs and outputs
+    // Passes with their own target framebuffer, or without outputs, have side effects and are never culled
+    virtual void DeclareResources(FrameGraph::Builder& builder);
+
+    // Read a texture of the frame graph, and set it in a material uniform, see BindTextureInputs
+    void AddTextureInput(const char* resourceName, const char* uniformName);
+
+    // Write a new transient texture of the frame graph
+    void AddTextureOutput(const char* resourceName, const FrameGraph::TextureDesc& desc);
+    // Write a texture created by a previous pass
+    void AddTextureOutput(const char* resourceName);
+
 protected:
     Renderer& GetRenderer();
     const Renderer& GetRenderer() const;
 
+    // Write a texture owned by the pass
+    void AddTextureOutput(const char* resourceName, std::shared_ptr<Texture2DObject> texture, const FrameGraph::TextureDesc& desc);
+
+    // Set the textures of the inputs in the material, before using it
+    void BindTextureInputs(Material& material) const;
+
 protected:
     std::shared_ptr<const FramebufferObject> m_targetFramebuffer;
 
+private:
+    struct TextureInput
+    {
+        std::string resourceName;
+        std::string uniformName;
+    };
+    struct TextureOutput
+    {
+        std::string resourceName;
+        // Valid desc to create it, and texture to import it
+        FrameGraph::TextureDesc desc;
+        std::shared_ptr<Texture2DObject> texture;
+    };
+    std::vector<TextureInput> m_textureInputs;
+    std::vector<TextureOutput> m_textureOutputs;
+
 private:
     friend class Renderer;
     void SetRenderer(Renderer* renderer);
@@ -2,15 +2,23 @@
 
 #include <ituGL/core/DeviceGL.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/FrameGraph.h>
 #include <ituGL/geometry/Drawcall.h>
 #include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/geometry/DrawIndirectBufferObject.h>
 #include <ituGL/shader/Material.h>
+#include <ituGL/shader/UniformBufferObject.h>
+#include <ituGL/shader/ShaderStorageBufferObject.h>
+#include <ituGL/lighting/Light.h>
 #include <glm/mat4x4.hpp>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <span>
 #include <functional>
+#include <cstdint>
 
 class Camera;
 class Light;
@@ -27,18 +35,47 @@ public:
     class DrawcallInfo
     {
     public:
-        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall);
+        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, VertexArrayObject& vao, const Drawcall& drawcall, uint64_t stateKey = 0);
 
         const Material& GetMaterial() const { return m_material; }
         unsigned int GetWorldMatrixIndex() const { return m_worldMatrixIndex; }
-        const VertexArrayObject& GetVAO() const { return m_vao; }
+        // Not const, the renderer adds the draw index attribute to it for multi draw indirect
+        VertexArrayObject& GetVAO() const { return m_vao; }
         const Drawcall& GetDrawcall() const { return m_drawcall; }
 
+        // Packed layer, shader, material and VAO, computed when the drawcall is added. See SortKey
+        uint64_t GetStateKey() const { return m_stateKey; }
+
     private:
         std::reference_wrapper<const Material> m_material;
         unsigned int m_worldMatrixIndex;
-        std::reference_wrapper<const VertexArrayObject> m_vao;
+        std::reference_wrapper<VertexArrayObject> m_vao;
         std::reference_wrapper<const Drawcall> m_drawcall;
+        uint64_t m_stateKey;
+    };
+
+    // Bits of the 64-bit sort keys, from the most significant. Layer is 0 for opaque materials and 1 for blended ones,
+    // so blended drawcalls always go last. Depth is the view depth, quantized, and goes before or after the state
+    // depending on the sort order
+    struct SortKey
+    {
+        static const unsigned int LayerBits = 4;
+        static const unsigned int ShaderBits = 12;
+        static const unsigned int MaterialBits = 16;
+        static const unsigned int VAOBits = 12;
+        static const unsigned int DepthBits = 20;
+
+        static const unsigned int StateBits = ShaderBits + MaterialBits + VAOBits;
+    };
+
+    enum class DrawcallSortOrder
+    {
+        // Group drawcalls with the same state, then front to back. For opaque passes
+        State,
+        // Closest first, to reject more fragments with the depth test
+        FrontToBack,
+        // Farthest first, for blending
+        BackToFront,
     };
 
     using DrawcallSupportedFunction = std::function<bool(const DrawcallInfo& drawcallInfo)>;
@@ -56,13 +93,93 @@ public:
         void AddDrawcall(const DrawcallInfo& drawcallInfo);
         void Clear();
 
+        // Reorder the drawcalls by the given keys, one per drawcall, in ascending order. Radix sort, stable
+        void SortByKeys(std::span<const uint64_t> keys);
+
     private:
         DrawcallSupportedFunction m_isSupported;
         std::vector<DrawcallInfo> m_drawcallInfos;
+
+        // Scratch memory for sorting, kept to avoid allocating every frame
+        struct KeyIndex
+        {
+            uint64_t key;
+            unsigned int index;
+        };
+        std::vector<KeyIndex> m_sortScratch[2];
+        std::vector<DrawcallInfo> m_sortedDrawcallInfos;
     };
 
     using DrawcallSortFunction = std::function<bool(const DrawcallInfo&, const DrawcallInfo&)>;
 
+    // Consecutive drawcalls that are prepared and submitted together. See BatchDrawcalls
+    class DrawcallBatch
+    {
+    public:
+        DrawcallBatch(std::span<const DrawcallInfo> drawcallInfos, bool indirect, size_t indirectOffset);
+
+        std::span<const DrawcallInfo> GetDrawcalls() const { return m_drawcallInfos; }
+        const DrawcallInfo& GetFirstDrawcall() const { return m_drawcallInfos.front(); }
+
+        // Indirect batches are submitted with one Drawcall::MultiDrawIndirect, with their commands starting at this offset
+        bool IsIndirect() const { return m_indirect; }
+        size_t GetIndirectOffset() const { return m_indirectOffset; }
+
+    private:
+        std::span<const DrawcallInfo> m_drawcallInfos;
+        bool m_indirect;
+        size_t m_indirectOffset;
+    };
+
+    // Work done and skipped by PrepareDrawcall in one frame
+    struct Counters
+    {
+        unsigned int drawcalls = 0;
+        unsigned int materialChanges = 0;
+        unsigned int materialSkips = 0;
+        unsigned int transformChanges = 0;
+        unsigned int transformSkips = 0;
+        unsigned int indirectBatches = 0;
+        unsigned int indirectDrawcalls = 0;
+        unsigned int framebufferChanges = 0;
+    };
+
+    // Binding points of the uniform blocks filled by the renderer. Registered shader programs that declare them read the
+    // camera and world matrices from buffers, instead of getting them as uniforms in every drawcall:
+    //   layout(std140) uniform CameraBlock { mat4 ViewMatrix; mat4 ProjMatrix; mat4 ViewProjMatrix; vec4 CameraPosition; };
+    //   layout(std140) uniform TransformBlock { mat4 WorldMatrix; mat4 WorldViewProjMatrix; ivec4 ObjectLightIndices[2]; int ObjectLightCount; };
+    static const GLuint CameraBlockBinding = 0;
+    static const GLuint TransformBlockBinding = 1;
+
+    // Data of the camera block, with the std140 layout. Also for applications that draw without the renderer
+    struct CameraBlock
+    {
+        glm::mat4 viewMatrix;
+        glm::mat4 projMatrix;
+        glm::mat4 viewProjMatrix;
+        glm::vec4 cameraPosition;
+    };
+    static CameraBlock GetCameraBlock(const Camera& camera);
+
+    // Programs that declare the light block get all the lights of the frame at once, and are drawn only once per drawcall
+    // in forward passes, instead of once per light. Each object gets the indices of the lights that reach it in its
+    // TransformBlock, the most relevant first, up to MaxObjectLights:
+    //   struct Light { vec4 Color; vec4 Position; vec4 Direction; vec4 Attenuation; };  (see Light::PackedData)
+    //   layout(std140) uniform LightBlock { uint LightCount; Light Lights[64]; };
+    static const GLuint LightBlockBinding = 2;
+    static const unsigned int MaxLights = 64;
+    static const unsigned int MaxObjectLights = 8;
+
+    // Binding 3 is for the material parameters, see MaterialBlockPool::MaterialBlockBinding
+
+    // Programs drawn with multi draw indirect can't bind one TransformBlock per object. Instead, they declare all of them
+    // in a storage block, and get the index of their object in a vertex attribute. Requires OpenGL 4.3:
+    //   struct Transform { mat4 WorldMatrix; mat4 WorldViewProjMatrix; ivec4 ObjectLightIndices[2]; int ObjectLightCount; };
+    //   layout(std430) readonly buffer TransformArrayBlock { Transform Transforms[]; };
+    //   layout(location = 15) in uint DrawIndex;
+    static const GLuint TransformArrayBinding = 0;
+    static const GLuint DrawIndexLocation = 15;
+
     using UpdateTransformsFunction = std::function<void(const ShaderProgram&, const glm::mat4&, const Camera&, bool)>;
     using UpdateLightsFunction = std::function<bool(const ShaderProgram&, std::span<const Light* const>, unsigned int&)>;
 
@@ -86,12 +203,15 @@ public:
     void AddLight(const Light& light);
 
     std::span<const DrawcallInfo> GetDrawcalls(unsigned int collectionIndex) const;
-    void AddModel(const Model& model, const glm::mat4& worldMatrix);
+    void AddModel(Model& model, const glm::mat4& worldMatrix);
 
     unsigned int AddDrawcallCollection(const DrawcallSupportedFunction &drawcallSupportedFunction);
     void SetDrawcallCollectionSupportedFunction(unsigned int index, const DrawcallSupportedFunction& drawcallSupportedFunction);
 
     void SortDrawcallCollection(unsigned int index, const DrawcallSortFunction& drawcallSortFunction);
+    // Sort using the packed 64-bit keys, with the current camera for depth. Much faster than a comparison function
+    // Blended drawcalls go last, back to front, with any order
+    void SortDrawcallCollection(unsigned int index, DrawcallSortOrder sortOrder);
     bool IsBackToFront(const DrawcallInfo& a, const DrawcallInfo& b) const;
     bool IsFrontToBack(const DrawcallInfo& a, const DrawcallInfo& b) const;
 
@@ -107,25 +227,82 @@ public:
     UpdateLightsFunction GetDefaultUpdateLightsFunction(const ShaderProgram& shaderProgram);
     bool UpdateLights(std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const Light* const> lights, unsigned int& lightIndex) const;
 
+    // If the program reads the lights from the LightBlock, so all of them can be drawn in a single pass
+    bool HasLightBlock(const ShaderProgram& shaderProgram) const;
+
     void PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride = Material::NoOverride);
 
+    // Multi draw indirect is enabled by default if the device supports it (OpenGL 4.3). Disabled or not supported,
+    // all the batches have one drawcall, and are prepared and drawn like with PrepareDrawcall
+    bool IsMultiDrawIndirectEnabled() const { return m_multiDrawIndirectEnabled; }
+    void SetMultiDrawIndirectEnabled(bool enabled);
+
+    // Group consecutive drawcalls with the same material, VAO and primitive, if their program reads the TransformArrayBlock,
+    // and upload their indirect commands. Sort the drawcalls by state first, to get larger batches
+    // The batches are valid until the next call
+    std::span<const DrawcallBatch> BatchDrawcalls(std::span<const DrawcallInfo> drawcallInfos);
+
+    // Like PrepareDrawcall, for all the drawcalls in the batch
+    void PrepareDrawcallBatch(const DrawcallBatch& drawcallBatch, Material::OverrideFlags materialOverride = Material::NoOverride);
+
+    // Draw all the drawcalls in the batch
+    void DrawBatch(const DrawcallBatch& drawcallBatch) const;
+
     void SetLightingRenderStates(bool firstPass);
 
     void Render();
 
+    // Resources of the passes in the current frame. Built and compiled in Render, before running the passes
+    const FrameGraph& GetFrameGraph() const { return m_frameGraph; }
+
+    // Counters of the last frame rendered. See also DeviceGL::GetLastFrameStateCounters
+    const Counters& GetLastFrameCounters() const { return m_lastFrameCounters; }
+
 private:
     void Reset();
 
+    // Declare the resources of all the passes, and cull the ones not needed this frame
+    void BuildFrameGraph();
+
+    // Forget the material and world matrix of the last drawcall, so the next one sets them again
+    void InvalidateDrawcallState();
+
     void InitializeFullscreenMesh();
 
     const glm::mat4& GetWorldMatrix(const DrawcallInfo& drawcallInfo) const;
 
+    // Layer, shader, material and VAO bits of the sort key
+    uint64_t ComputeStateKey(const Material& material, const VertexArrayObject& vao);
+
+    // Upload the camera block, and the transform blocks of all the world matrices, once per frame
+    void UpdateUniformBuffers();
+
+    // Upload the light block, and find the lights of each object for their transform blocks
+    void UpdateLightBlock();
+    void UpdateObjectLights(unsigned int worldMatrixIndex, int* lightIndices, int& lightCount) const;
+
+    // Set the uniforms and render states of the material, unless they are already set
+    void PrepareMaterial(const Material& material, Material::OverrideFlags materialOverride);
+
+    // Feed the draw index of the VAO, that must be bound, from the indices buffer for indirect drawcalls, or as a constant value
+    void SetDrawIndexAttribute(VertexArrayObject& vao, bool indirect, unsigned int worldMatrixIndex);
+
+    bool IsIndirectDrawcall(const DrawcallInfo& drawcallInfo) const;
+    static bool CanBatch(const DrawcallInfo& a, const DrawcallInfo& b);
+
 private:
     DeviceGL& m_device;
 
     const Camera *m_currentCamera;
 
-    std::shared_ptr<const Material> m_currentMaterial;
+    // Material and world matrix set by the last PrepareDrawcall, to skip setting them again for the next one
+    const Material* m_currentMaterial;
+    Material::OverrideFlags m_currentMaterialOverride;
+    mutable const ShaderProgram* m_currentTransformProgram;
+    unsigned int m_currentWorldMatrixIndex;
+
+    Counters m_counters;
+    Counters m_lastFrameCounters;
 
     std::shared_ptr<const FramebufferObject> m_defaultFramebuffer;
     std::shared_ptr<const FramebufferObject> m_currentFramebuffer;
@@ -134,12 +311,79 @@ private:
 
     std::vector<glm::mat4> m_worldMatrices;
 
+    // Bounding sphere of each world matrix, as (center, radius), to find the lights of each object
+    std::vector<glm::vec4> m_worldBoundingSpheres;
+
     std::vector<DrawcallCollection> m_drawcallCollections;
 
+    // Small ids for the materials, for the sort keys. Assigned again every frame, so materials that are gone are dropped
+    std::unordered_map<const Material*, unsigned int> m_materialSortIds;
+
+    // Scratch memory for the sort keys
+    std::vector<uint64_t> m_sortKeys;
+
     std::unordered_map<std::shared_ptr<const ShaderProgram>, UpdateTransformsFunction> m_updateTransformsFunctions;
     std::unordered_map<std::shared_ptr<const ShaderProgram>, UpdateLightsFunction> m_updateLightsFunctions;
 
+    // Data of the uniform blocks, with the std140 layout
+    struct TransformBlock
+    {
+        glm::mat4 worldMatrix;
+        glm::mat4 worldViewProjMatrix;
+        int objectLightIndices[MaxObjectLights];
+        int objectLightCount;
+        // Structs are aligned to vec4 in std140 and std430
+        int padding[3];
+    };
+    struct LightBlock
+    {
+        unsigned int lightCount;
+        unsigned int padding[3];
+        Light::PackedData lights[MaxLights];
+    };
+
+    UniformBufferObject m_cameraBuffer;
+
+    // Transform blocks of one frame, one block every m_transformStride bytes
+    // The buffer is allocated again every frame (orphaning) instead of cycling a ring of buffers with fences: the driver
+    // gives new storage while the GPU still reads the previous frame, so uploading doesn't stall either, and there is
+    // no ring to size for the largest frame. Persistently mapped rings would need OpenGL 4.4, the context is 4.1
+    UniformBufferObject m_transformBuffer;
+    std::vector<std::byte> m_transformData;
+    size_t m_transformStride;
+
+    // Programs that read the world matrices from TransformBlock
+    std::unordered_set<const ShaderProgram*> m_transformBlockPrograms;
+
+    // All the transform blocks of one frame, packed. Copied to m_transformData, and uploaded for the TransformArrayBlock
+    std::vector<TransformBlock> m_transformBlocks;
+    ShaderStorageBufferObject m_transformArrayBuffer;
+
+    // Programs that read the world matrices from TransformArrayBlock
+    std::unordered_set<const ShaderProgram*> m_transformArrayPrograms;
+
+    UniformBufferObject m_lightBuffer;
+
+    // Programs that read the lights from LightBlock
+    std::unordered_set<const ShaderProgram*> m_lightBlockPrograms;
+
+    // Bounding sphere of each light in the light block, with negative radius for lights without bounds, and how bright
+    // they are, to pick the most relevant for each object
+    std::vector<glm::vec4> m_lightBoundingSpheres;
+    std::vector<float> m_lightIntensities;
+
+    // Sequential indices 0, 1, 2... read once per instance. Each command starts at the index of its world matrix
+    // with baseInstance, so DrawIndex gets that index
+    VertexBufferObject m_drawIndexBuffer;
+    unsigned int m_drawIndexCount;
+
+    bool m_multiDrawIndirectEnabled;
+    DrawIndirectBufferObject m_drawIndirectBuffer;
+    std::vector<std::byte> m_drawIndirectData;
+    std::vector<DrawcallBatch> m_drawcallBatches;
+
     Mesh m_fullscreenMesh;
 
     std::vector<std::unique_ptr<RenderPass>> m_passes;
+    FrameGraph m_frameGraph;
 };
@@ -17,6 +17,8 @@ public:
 
     void Render() override;
 
+    const char* GetName() const override { return "SkyboxRenderPass"; }
+
 private:
     std::shared_ptr<TextureCubemapObject> m_texture;
 
@@ -1,7 +1,13 @@
 #pragma once
 
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cassert>
 
 class Bounds
 {
@@ -103,21 +109,60 @@ private:
     glm::vec3 m_size;
 };
 
-class FrustumBounds : public RotatedBounds
+// Many sphere, AABB or box bounds, one array per component, to test them together against a frustum
+// Every entry has a center, a radius and 3 scaled axes. Spheres have zero axes, AABBs have zero radius and axes
+// aligned to the world, so the same loop tests all of them, and the compiler can vectorize it
+class BoundsBatch
 {
 public:
-    FrustumBounds(const glm::vec3& center, const glm::vec3& size);
+    BoundsBatch();
+
+    inline unsigned int GetCount() const { return m_count; }
+
+    void Add(const SphereBounds& bounds);
+    void Add(const AabbBounds& bounds);
+    void Add(const BoxBounds& bounds);
+
+    void Clear();
+
+private:
+    void Add(const glm::vec3& center, float radius, const glm::mat3& axes);
+
+    friend class FrustumBounds;
+
+    // The arrays grow in blocks, padded with zeros, so the tests always process full blocks of a fixed size
+    static constexpr unsigned int s_blockSize = 16;
+
+    unsigned int m_count;
+    std::vector<float> m_centerX, m_centerY, m_centerZ;
+    std::vector<float> m_radius;
+    std::array<std::vector<float>, 9> m_axes;
+};
+
+// The 6 planes of a camera frustum, with their normals pointing inside
+class FrustumBounds : public Bounds
+{
+public:
+    // Extracts the planes from a view projection matrix (OpenGL clip space)
+    FrustumBounds(const glm::mat4& viewProjectionMatrix);
 
     inline Type GetType() const override { return Type::Frustum; }
 
+    // Each plane is (normal, distance), with normalized normals, so dot(normal, point) + distance is the signed distance
+    inline const std::array<glm::vec4, 6>& GetPlanes() const { return m_planes; }
+
+    // Test all the bounds in the batch. The results are 1 if they intersect the frustum, and 0 if they don't
+    void Intersects(const BoundsBatch& batch, std::vector<uint8_t>& results) const;
+
 private:
+    std::array<glm::vec4, 6> m_planes;
 };
 
 
 template<typename T>
 bool Bounds::Intersects(const T& other) const
 {
-    Bounds::Intersects(this, other);
+    return Bounds::Intersects(*this, other);
 }
 
 template<typename TA, typename TB>
@@ -144,6 +189,8 @@ bool Bounds::Intersects(const Bounds& boundsA, const TB& boundsB)
         return Bounds::Intersects(static_cast<const AabbBounds&>(boundsA), boundsB);
     case Type::Box:
         return Bounds::Intersects(static_cast<const BoxBounds&>(boundsA), boundsB);
+    case Type::Frustum:
+        return Bounds::Intersects(static_cast<const FrustumBounds&>(boundsA), boundsB);
     default:
         assert(false);
         return false;
@@ -168,8 +215,9 @@ template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const AabbBounds& boundsB);
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const BoxBounds& boundsB);
-//template<>
-//bool Bounds::Intersects(const FrustumBounds& boundsA, const FrustumBounds& boundsB);
+// Not supported, it asserts and returns false
+template<>
+bool Bounds::Intersects(const FrustumBounds& boundsA, const FrustumBounds& boundsB);
 
 
 
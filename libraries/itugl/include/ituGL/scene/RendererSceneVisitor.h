@@ -1,6 +1,8 @@
 #pragma once
 
 #include <ituGL/scene/SceneVisitor.h>
+#include <ituGL/scene/Bounds.h>
+#include <vector>
 
 class Renderer;
 class SceneCamera;
@@ -8,17 +10,48 @@ class SceneLight;
 class SceneModel;
 class Transform;
 
+// Adds the camera, lights and models of a scene to the renderer
+// Scene::AcceptVisitor skips the models outside the camera frustum with its bounding volume hierarchy. The models
+// visited are collected, and the ones with box bounds outside the frustum are culled together in EndVisit
 class RendererSceneVisitor : public SceneVisitor
 {
 public:
     RendererSceneVisitor(Renderer& renderer);
 
+    void BeginVisit() override;
+    void EndVisit() override;
+
+    const FrustumBounds* GetCullingFrustum() override;
+    void SetCulledNodeCount(unsigned int count) override;
+
     void VisitCamera(SceneCamera& sceneCamera) override;
 
     void VisitLight(SceneLight& sceneLight) override;
 
     void VisitModel(SceneModel& sceneModel) override;
 
+    // Enable / disable frustum culling. Default: enabled
+    inline bool IsCullingEnabled() const { return m_cullingEnabled; }
+    inline void SetCullingEnabled(bool enabled) { m_cullingEnabled = enabled; }
+
+    // Models added to the renderer and culled in the last visit, by the scene or in EndVisit
+    inline unsigned int GetVisibleCount() const { return m_visibleCount; }
+    inline unsigned int GetCulledCount() const { return m_culledCount; }
+
 private:
     Renderer& m_renderer;
+
+    bool m_cullingEnabled;
+
+    // Frustum of the camera, valid once the camera is visited
+    FrustumBounds m_frustum;
+
+    // Models visited, and their bounds, waiting for EndVisit
+    std::vector<const SceneModel*> m_models;
+    BoundsBatch m_bounds;
+    std::vector<uint8_t> m_visible;
+
+    unsigned int m_visibleCount;
+    unsigned int m_culledCount;
+    unsigned int m_sceneCulledCount;
 };
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <ituGL/scene/SceneBvh.h>
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <vector>
 
 class SceneNode;
 class SceneVisitor;
@@ -20,9 +22,35 @@ public:
     bool RemoveSceneNode(std::shared_ptr<SceneNode> node);
     bool RemoveSceneNode(const std::string& name);
 
+    // Visit the nodes without bounds first, and then the nodes with bounds that intersect the culling frustum of the
+    // visitor, found with the bounding volume hierarchy. See SceneVisitor::GetCullingFrustum
     void AcceptVisitor(SceneVisitor& visitor);
+    // Visit all the nodes, without updating the bounding volume hierarchy
     void AcceptVisitor(SceneVisitor& visitor) const;
 
+    // Update the bounding volume hierarchy with the nodes that moved since the last update
+    // Called by AcceptVisitor. The queries below use the bounds of the last update
+    void UpdateBounds();
+
+    // Nodes with bounds intersecting the frustum or the AABB
+    void QueryNodes(const FrustumBounds& frustum, std::vector<SceneNode*>& nodes) const;
+    void QueryNodes(const AabbBounds& bounds, std::vector<SceneNode*>& nodes) const;
+
+    // Closest node with bounds hit by the ray. See SceneBvh::RayCast
+    SceneNode* Pick(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+    inline const SceneBvh& GetBvh() const { return m_bvh; }
+
+private:
+    void RemoveFromBvh(SceneNode& node);
+
 private:
     std::unordered_map<std::string, std::shared_ptr<SceneNode>> m_nodes;
+
+    // Bounding volume hierarchy of the nodes with bounds, and list of the other ones
+    SceneBvh m_bvh;
+    std::vector<SceneNode*> m_unboundedNodes;
+
+    // Scratch list for the nodes with bounds to visit
+    std::vector<SceneNode*> m_visibleNodes;
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <ituGL/scene/Bounds.h>
+#include <glm/vec3.hpp>
+#include <vector>
+
+class SceneNode;
+
+// Dynamic bounding volume hierarchy of scene nodes, a binary tree of AABBs
+// Leaves store "fat" bounds, a bit larger than the node, so small movements don't change the tree
+// Insertions pick the sibling that grows the tree the least, and rotations keep it balanced, so queries are O(log n)
+class SceneBvh
+{
+public:
+    static constexpr int NullProxy = -1;
+
+public:
+    // Margin added to the bounds of the leaves
+    SceneBvh(float margin = 0.1f);
+
+    // Returns the proxy that identifies the node in the tree
+    int Insert(SceneNode* sceneNode, const AabbBounds& bounds);
+    void Remove(int proxy);
+
+    // Update the bounds of a node. Returns true if they moved out of the fat bounds, and the tree changed
+    bool Move(int proxy, const AabbBounds& bounds);
+
+    void Clear();
+
+    inline SceneNode* GetSceneNode(int proxy) const { return m_nodes[proxy].sceneNode; }
+    inline unsigned int GetProxyCount() const { return m_proxyCount; }
+    int GetHeight() const;
+
+    // Nodes with fat bounds intersecting the frustum
+    void Query(const FrustumBounds& frustum, std::vector<SceneNode*>& sceneNodes) const;
+
+    // Nodes with fat bounds intersecting the AABB
+    void Query(const AabbBounds& bounds, std::vector<SceneNode*>& sceneNodes) const;
+
+    // Closest node hit by the ray, tested against the box bounds of the node. Distance is in units of direction
+    // On input, distance is the maximum distance. Returns nullptr if nothing is hit
+    SceneNode* RayCast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+private:
+    struct Node
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+
+        SceneNode* sceneNode;
+
+        // Parent in the tree, or next free node in the free list
+        int parent;
+        int child1;
+        int child2;
+
+        // Leaves have height 0, free nodes -1
+        int height;
+
+        inline bool IsLeaf() const { return child1 == NullProxy; }
+    };
+
+    int AllocateNode();
+    void FreeNode(int index);
+
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+
+    // Rotate the tree at the node if its children heights differ by more than 1. Returns the new root of the subtree
+    int Balance(int index);
+
+    // Recompute the bounds and height of an internal node from its children
+    void UpdateNode(int index);
+
+private:
+    std::vector<Node> m_nodes;
+    int m_root;
+    int m_freeList;
+    unsigned int m_proxyCount;
+    float m_margin;
+};
@@ -3,6 +3,7 @@
 #include <ituGL/scene/Bounds.h>
 #include <string>
 #include <memory>
+#include <cstdint>
 
 class Scene;
 class SceneVisitor;
@@ -23,6 +24,9 @@ public:
     std::shared_ptr<const Transform> GetTransform() const;
     void SetTransform(std::shared_ptr<Transform> transform);
 
+    // Nodes with bounds are kept in the bounding volume hierarchy of the scene, for culling and picking
+    virtual bool HasBounds() const;
+
     virtual SphereBounds GetSphereBounds() const;
     virtual AabbBounds GetAabbBounds() const;
     virtual BoxBounds GetBoxBounds() const;
@@ -38,6 +42,14 @@ private:
 
     Scene* m_scene;
 
+    // Proxy in the bounding volume hierarchy of the scene, and version of the transform when it was last updated
+    int m_bvhProxy;
+    uint64_t m_bvhTransformVersion;
+
+protected:
+    // Call when the bounds change for other reasons than the transform, to update them in the scene
+    void InvalidateBounds();
+
 protected:
     std::string m_name;
     std::shared_ptr<Transform> m_transform;
@@ -4,10 +4,22 @@ class SceneCamera;
 class SceneLight;
 class SceneModel;
 class Renderable;
+class FrustumBounds;
 
 class SceneVisitor
 {
 public:
+    // Called by Scene::AcceptVisitor before and after visiting all the nodes
+    virtual void BeginVisit();
+    virtual void EndVisit();
+
+    // Frustum that Scene::AcceptVisitor uses to skip the nodes with bounds outside of it, or null to visit all of them
+    // Asked after visiting the nodes without bounds, so cameras are already visited
+    virtual const FrustumBounds* GetCullingFrustum();
+
+    // Number of nodes skipped with the culling frustum, before EndVisit
+    virtual void SetCulledNodeCount(unsigned int count);
+
     virtual void VisitCamera(SceneCamera& sceneCamera);
     virtual void VisitCamera(const SceneCamera& sceneCamera);
 
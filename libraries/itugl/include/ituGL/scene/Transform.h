@@ -3,6 +3,7 @@
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <memory>
+#include <cstdint>
 
 class Transform
 {
@@ -10,16 +11,16 @@ public:
     Transform();
 
     inline glm::vec3 GetTranslation() const { return m_translation; }
-    inline void SetTranslation(const glm::vec3& translation) { m_translation = translation; m_dirty = true; }
+    inline void SetTranslation(const glm::vec3& translation) { m_translation = translation; SetDirty(); }
 
     inline glm::vec3 GetRotation() const { return m_rotation; }
-    inline void SetRotation(const glm::vec3& rotation) { m_rotation = rotation; m_dirty = true; }
+    inline void SetRotation(const glm::vec3& rotation) { m_rotation = rotation; SetDirty(); }
 
     inline glm::vec3 GetScale() const { return m_scale; }
-    inline void SetScale(const glm::vec3& scale) { m_scale = scale; m_dirty = true; }
+    inline void SetScale(const glm::vec3& scale) { m_scale = scale; SetDirty(); }
 
     inline std::shared_ptr<Transform> GetParent() const { return m_parent; }
-    inline void SetParent(std::shared_ptr<Transform> parent) { m_parent = parent; m_dirty = true; }
+    inline void SetParent(std::shared_ptr<Transform> parent) { m_parent = parent; SetDirty(); }
 
     glm::mat4 GetTranslationMatrix() const;
     glm::mat4 GetRotationMatrix() const;
@@ -27,8 +28,19 @@ public:
 
     glm::mat4 GetTransformMatrix() const;
 
+    // If the cached matrix is older than this transform or one of its parents
     bool IsDirty() const;
 
+    // Every change takes a new stamp from a counter shared by all the transforms, that only grows. The version is the
+    // latest stamp of this transform and its parents, so it is different after any of them changes, or the parent is
+    // replaced. Unlike IsDirty, several users can check if the transform changed since they last saw it
+    uint64_t GetVersion() const;
+
+private:
+    inline void SetDirty() { m_version = NewVersion(); }
+
+    static uint64_t NewVersion();
+
 private:
     glm::vec3 m_translation;
     glm::vec3 m_rotation;
@@ -36,7 +48,11 @@ private:
 
     std::shared_ptr<Transform> m_parent;
 
-    // Cached matrix
+    // Cached matrix, and the version it was computed for
     mutable glm::mat4 m_matrix;
-    mutable bool m_dirty;
+    mutable uint64_t m_matrixVersion;
+
+    uint64_t m_version;
+
+    static uint64_t s_lastVersion;
 };
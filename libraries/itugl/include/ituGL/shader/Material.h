@@ -126,6 +126,10 @@ public:
     // You can skip depth, stencil or blending using the override flags
     void Use(OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
 
+    // Use the shader program and set the depth, stencil and blending properties, but not the uniforms
+    // Enough when the uniforms are already set, because this material was the last one used with its shader program
+    void UseRenderStates(OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
+
 private:
     // Set all the properties relative to depth
     void UseDepthTest() const;
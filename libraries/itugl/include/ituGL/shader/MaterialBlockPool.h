@@ -0,0 +1,92 @@
+#pragma once
+
+#include <ituGL/shader/UniformBufferObject.h>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Uniform buffer with the material parameters of all the materials, one range for each material
+// Shaders opt in by declaring their parameters in a block:
+//     layout(std140) uniform MaterialBlock { vec4 Color; float Roughness; };
+// ShaderUniformCollection writes the values in the range of the material, and switching material only binds its range
+class MaterialBlockPool
+{
+public:
+    // Binding point of MaterialBlock. The renderer uses the lower ones for its own blocks
+    static const GLuint MaterialBlockBinding = 3;
+
+    // Range allocated in the shared pool, freed with the object
+    // Copies get their own range, with the same contents
+    class Range
+    {
+    public:
+        Range();
+        Range(const Range& other);
+        ~Range();
+
+        Range& operator = (const Range& other);
+
+        void Allocate(size_t size);
+        void Free();
+
+        bool IsValid() const { return m_pool != nullptr; }
+        size_t GetSize() const { return m_size; }
+
+        std::span<std::byte> GetData() const;
+        void SetDirty() const;
+        void Bind() const;
+
+    private:
+        std::shared_ptr<MaterialBlockPool> m_pool;
+        size_t m_offset;
+        size_t m_size;
+    };
+
+public:
+    MaterialBlockPool();
+
+    // Shared by all the materials. Created with the first one that needs it, and deleted with the last one
+    static std::shared_ptr<MaterialBlockPool> GetInstance();
+
+    // Reserve a range of the buffer, aligned for BindRange. Returns its offset
+    size_t Allocate(size_t size);
+    void Free(size_t offset, size_t size);
+
+    // Copy of the range in memory. Mark the changes with SetDirty, they are uploaded the next time a range is bound
+    std::span<std::byte> GetData(size_t offset, size_t size);
+    void SetDirty(size_t offset, size_t size);
+
+    // Upload the pending changes and bind the range to MaterialBlockBinding
+    // The binding goes through the DeviceGL cache, so it is skipped if the range is already bound
+    void BindRange(size_t offset, size_t size);
+
+    // Total size of the buffer, and the size of the allocated ranges
+    size_t GetCapacity() const { return m_data.size(); }
+    size_t GetAllocatedSize() const { return m_allocatedSize; }
+
+private:
+    struct FreeRange
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    void UploadData();
+
+private:
+    UniformBufferObject m_buffer;
+
+    // Contents of the buffer. The buffer is reallocated when it grows
+    std::vector<std::byte> m_data;
+    size_t m_bufferSize;
+    size_t m_allocatedSize;
+
+    // Free ranges, sorted by offset. Adjacent ranges are merged
+    std::vector<FreeRange> m_freeRanges;
+
+    // Range of m_data that changed since the last upload
+    size_t m_dirtyBegin;
+    size_t m_dirtyEnd;
+
+    static std::weak_ptr<MaterialBlockPool> s_instance;
+};
@@ -17,6 +17,8 @@
 #include <glm/mat4x4.hpp>
 
 #include <span>
+#include <vector>
+#include <cstdint>
 
 class Shader;
 class TextureObject;
@@ -78,6 +80,16 @@ public:
     // The max length of the string returned is determined by the capacity of the span
     void GetLinkingErrors(std::span<char> errors) const;
 
+    // Ask the driver to keep the binary of the program when it is linked, so GetBinary can return it
+    void SetBinaryRetrievable(bool retrievable);
+
+    // Get the binary of the linked program, and the format it is in. Only valid for the same driver
+    bool GetBinary(std::vector<std::byte>& binary, GLenum& format) const;
+
+    // Link the program from a binary returned by GetBinary, instead of attaching shaders
+    // Fails if the driver doesn't accept it anymore, then the program must be built from the shaders
+    bool LoadBinary(std::span<const std::byte> binary, GLenum format);
+
     // Find an attribute location by name
     Location GetAttributeLocation(const char* name) const;
 
@@ -90,6 +102,25 @@ public:
     // Get information about a specific uniform
     void GetUniformInfo(unsigned int index, int& size, GLenum& glType, std::span<char> uniformName) const;
 
+    // Find a uniform block index by name. Returns GL_INVALID_INDEX if the block is not used by the program
+    GLuint GetUniformBlockIndex(const char* name) const;
+
+    // Set the binding point the uniform block reads its buffer from. See UniformBufferObject::BindBase
+    void SetUniformBlockBinding(GLuint blockIndex, GLuint binding) const;
+
+    // Size in bytes of the uniform block, with the layout of the program
+    GLint GetUniformBlockSize(GLuint blockIndex) const;
+
+    // Layout of a uniform inside a block: the block index (-1 if it is not in a block), the offset in bytes, and the
+    // strides between array elements and matrix columns (0 if it is not an array or a matrix)
+    void GetUniformBlockMemberInfo(unsigned int index, GLint& blockIndex, GLint& offset, GLint& arrayStride, GLint& matrixStride) const;
+
+    // Find a shader storage block index by name. Returns GL_INVALID_INDEX if the block is not used. Requires OpenGL 4.3
+    GLuint GetShaderStorageBlockIndex(const char* name) const;
+
+    // Set the binding point the shader storage block reads its buffer from. See ShaderStorageBufferObject::BindBase
+    void SetShaderStorageBlockBinding(GLuint blockIndex, GLuint binding) const;
+
     // Template method combinations to simplify getting uniforms
     template<typename T>
     void GetUniform(Location location, T& value) const;
@@ -113,6 +144,11 @@ public:
     // Set texture value for a texture uniform
     void SetTexture(Location location, GLint textureUnit, const TextureObject& texture) const;
 
+    // Version of the value in a uniform location, set by ShaderUniformCollection after uploading it, so it can skip
+    // uploading the same value again. Setting the uniform any other way forgets the version
+    bool HasUniformVersion(Location location, uint64_t version) const;
+    void SetUniformVersion(Location location, uint64_t version) const;
+
     // Set the shader program as the active one to be used for rendering
     void Use() const;
 
@@ -138,7 +174,13 @@ private:
     template<typename T, int C, int R>
     void SetUniforms(Location location, const T* values, GLsizei count) const;
 
+    // Forget the version of the location, and count the bytes uploaded
+    void OnUniformsSet(Location location, GLsizei count, size_t bytes) const;
+
 private:
+    // Version of the value in each location, 0 if unknown
+    mutable std::vector<uint64_t> m_uniformVersions;
+
 #ifndef NDEBUG
     inline bool IsUsed() const { return s_usedHandle == GetHandle(); }
     static Handle s_usedHandle;
@@ -191,18 +233,21 @@ template<typename T>
 void ShaderProgram::SetUniforms(Location location, std::span<const T> values) const
 {
     SetUniforms<T, 1>(location, &values[0], static_cast<GLsizei>(values.size()));
+    OnUniformsSet(location, static_cast<GLsizei>(values.size()), values.size_bytes());
 }
 
 template<typename T, int N>
 void ShaderProgram::SetUniforms(Location location, std::span<const glm::vec<N, T>> values) const
 {
     SetUniforms<T, N>(location, &values[0][0], static_cast<GLsizei>(values.size()));
+    OnUniformsSet(location, static_cast<GLsizei>(values.size()), values.size_bytes());
 }
 
 template<typename T, int C, int R>
 void ShaderProgram::SetUniforms(Location location, std::span<const glm::mat<C, R, T>> values) const
 {
     SetUniforms<T, C, R>(location, &values[0][0][0], static_cast<GLsizei>(values.size()));
+    OnUniformsSet(location, static_cast<GLsizei>(values.size()), values.size_bytes());
 }
 
 template<> void ShaderProgram::SetUniforms<GLint, 1>(Location location, const GLint* values, GLsizei count) const;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <ituGL/shader/ShaderProgram.h>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+
+class Shader;
+
+// Linked programs stored on disk, so the next runs load them instead of compiling the sources again
+// Programs are found by a hash of their sources and the driver: changing either one is a miss, and the program is
+// compiled and stored again. The driver can also reject a binary (for instance, after an update), then it is compiled too
+// Programs can be built from several threads, each one with its own context
+class ShaderProgramCache
+{
+public:
+    // Programs built, and the time spent building them, in seconds
+    struct Stats
+    {
+        unsigned int hitCount = 0;
+        unsigned int missCount = 0;
+        double hitTime = 0.0;
+        double missTime = 0.0;
+    };
+
+public:
+    // The directory is created when the first program is stored
+    ShaderProgramCache(const char* directory);
+
+    // Build a program with vertex and fragment shaders, from their sources, like in Shader::SetSource
+    bool Build(ShaderProgram& shaderProgram, std::span<const char*> vertexSource, std::span<const char*> fragmentSource);
+
+    // False if the driver doesn't support any binary format. Then every program is compiled
+    bool IsEnabled() const { return m_enabled; }
+
+    Stats GetStats() const;
+
+private:
+    // Query the driver the first time a program is built, when there is a context
+    void Initialize();
+
+    // 64-bit FNV-1a of the driver and the sources of each stage
+    uint64_t GetKey(std::span<const char*> vertexSource, std::span<const char*> fragmentSource) const;
+    std::filesystem::path GetPath(uint64_t key) const;
+
+    bool LoadBinary(ShaderProgram& shaderProgram, uint64_t key) const;
+    void StoreBinary(const ShaderProgram& shaderProgram, uint64_t key) const;
+
+    static bool CompileShader(Shader& shader, std::span<const char*> source);
+
+private:
+    std::filesystem::path m_directory;
+
+    // Vendor, renderer and version of the driver. Binaries are only valid for the one that created them
+    std::string m_driver;
+    bool m_initialized;
+    bool m_enabled;
+
+    Stats m_stats;
+
+    // Protects the initialization and the stats
+    mutable std::mutex m_mutex;
+};
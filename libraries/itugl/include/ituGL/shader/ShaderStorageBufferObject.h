@@ -0,0 +1,45 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+
+// Shader Storage Buffer Object (SSBO) is the common term for a BufferObject when it is used as storage for buffer blocks
+// The data must follow the layout of the block in the shader, usually std430. Requires OpenGL 4.3
+class ShaderStorageBufferObject : public BufferObjectBase<BufferObject::ShaderStorageBuffer>
+{
+public:
+    ShaderStorageBufferObject();
+
+    // Use the same AllocateData methods from the base class
+    using BufferObject::AllocateData;
+    // Additionally, provide AllocateData methods with DynamicDraw as default usage
+    void AllocateData(size_t size);
+    void AllocateData(std::span<const std::byte> data);
+    // Additionally, provide AllocateData template method for any type of data span
+    template<typename T>
+    void AllocateData(std::span<const T> data, Usage usage = Usage::DynamicDraw);
+
+    // Use the same UpdateData methods from the base class
+    using BufferObject::UpdateData;
+    // Additionally, provide UpdateData template method for any type of data span
+    template<typename T>
+    void UpdateData(std::span<const T> data, size_t offsetBytes = 0);
+
+    // Offsets used in BindRange must be multiples of this value (GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT)
+    static size_t GetOffsetAlignment();
+};
+
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void ShaderStorageBufferObject::AllocateData(std::span<const T> data, Usage usage)
+{
+    AllocateData(Data::GetBytes(data), usage);
+}
+
+// Call the base implementation with the span converted to bytes
+template<typename T>
+void ShaderStorageBufferObject::UpdateData(std::span<const T> data, size_t offsetBytes)
+{
+    UpdateData(Data::GetBytes(data), offsetBytes);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/shader/MaterialBlockPool.h>
 #include <ituGL/texture/TextureObject.h>
 #include <ituGL/core/Data.h>
 #include <vector>
@@ -8,6 +9,7 @@
 #include <unordered_set>
 #include <string>
 #include <cstring>
+#include <cstdint>
 #include <memory>
 
 class ShaderUniformCollection
@@ -26,14 +28,20 @@ public:
     std::shared_ptr<const ShaderProgram> GetShaderProgram() const;
 
     // Reset the material with a different shader
-    void ChangeShader(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet& filteredUniforms = NameSet());
+    // With keepValues, uniforms of the new shader with the same name and type as one in the previous shader keep its value,
+    // like when the shader is reloaded after editing it
+    void ChangeShader(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet& filteredUniforms = NameSet(), bool keepValues = false);
 
     // Get the vertex attribute location by name
     ShaderProgram::Location GetAttributeLocation(const char* name) const;
 
     // Get the shader uniform location by name
+    // Uniforms in MaterialBlock get a location of the collection, as they don't have one in the program
     ShaderProgram::Location GetUniformLocation(const char* name) const;
 
+    // If the shader declares MaterialBlock, its uniforms are stored in the material block pool. See MaterialBlockPool
+    bool HasMaterialBlock() const { return m_materialBlock.IsValid(); }
+
     // Get uniform value for different types, using the name or the uniform location
     template<typename T>
     T GetUniformValue(const char* name) const;
@@ -62,13 +70,15 @@ public:
     template<typename T>
     void SetUniformValues(ShaderProgram::Location location, std::span<const T> value);
 
-    // Get the pointer to the uniform data
+    // Get the pointer to the uniform data. The uniform counts as changed, the pointer must not be kept to change it later
     template<typename T>
     T* GetDataUniformPointer(const char* name);
     template<typename T>
     T* GetDataUniformPointer(ShaderProgram::Location location);
 
     // Set all the properties to the shader. Requires the shader program to be in use
+    // Values that the program already has, from the last time they were set, are skipped
+    // Values in MaterialBlock are written to the range of the collection, and the range is bound
     void SetUniforms() const;
 
 private:
@@ -97,6 +107,14 @@ private:
         unsigned int count;
         // Index in the data buffer
         int index;
+        // Version of the value, see NewVersion
+        uint64_t version;
+        // Layout in MaterialBlock, in bytes. The offset is -1 if it is not in the block
+        int blockOffset;
+        int arrayStride;
+        int matrixStride;
+        // Version of the value written to the block
+        mutable uint64_t blockVersion;
     };
 
     // Struct to store a texture property
@@ -108,6 +126,8 @@ private:
         TextureObject::Target target;
         // Shared pointer to the texture object
         std::shared_ptr<const TextureObject> texture;
+        // Version of the value, see NewVersion
+        uint64_t version;
     };
 
 private:
@@ -141,6 +161,10 @@ private:
     void UseUniform(const DataUniform& uniform) const;
     void UseUniform(const TextureUniform& uniform) const;
 
+    // Write the changed uniforms of MaterialBlock in its range and bind it
+    void UseMaterialBlock() const;
+    void WriteBlockUniform(const DataUniform& uniform, std::span<std::byte> blockData) const;
+
     // Get the buffer where data values are stored for a certain type
     template<typename T>
     std::vector<T>& GetDataValues();
@@ -164,6 +188,16 @@ private:
     // Get the size of a data property
     int GetDataUniformSize(const DataUniform& uniform) const;
 
+    // Get the number of columns and rows of a dimension. Vectors have one column
+    static void GetDimensionSize(UniformDimension dimension, int& columns, int& rows);
+
+    // Every new value of any uniform, in any collection, gets a different version. A program that has a location with
+    // the same version already has that value, see ShaderProgram::HasUniformVersion
+    static uint64_t NewVersion();
+
+    // Copy the values of the uniforms with the same name and type in the other collection
+    void CopyUniformValues(const ShaderUniformCollection& other);
+
     // Delete all the properties and set the shader program to null
     void Reset();
 
@@ -195,6 +229,15 @@ private:
     std::vector<unsigned int> m_uintDataValues;
     std::vector<float> m_floatDataValues;
     std::vector<double> m_doubleDataValues;
+
+    // Locations of the uniforms in MaterialBlock by name, starting at s_blockLocationBase
+    std::unordered_map<std::string, ShaderProgram::Location> m_blockLocations;
+    static const ShaderProgram::Location s_blockLocationBase = 1 << 24;
+
+    // Values of the uniforms in MaterialBlock, with the std140 layout
+    MaterialBlockPool::Range m_materialBlock;
+
+    static uint64_t s_lastVersion;
 };
 
 
@@ -297,7 +340,11 @@ void ShaderUniformCollection::SetUniformValues(ShaderProgram::Location location,
     std::span<T> storedValues;
     GetDataValues(location, storedValues);
     assert(values.size() == storedValues.size());
-    std::memcpy(storedValues.data(), values.data(), values.size_bytes());
+    if (std::memcmp(storedValues.data(), values.data(), values.size_bytes()) != 0)
+    {
+        std::memcpy(storedValues.data(), values.data(), values.size_bytes());
+        GetDataUniform(location).version = NewVersion();
+    }
 }
 
 template<typename T>
@@ -380,7 +427,8 @@ T* ShaderUniformCollection::GetDataUniformPointer(const char* name)
 template<typename T>
 T* ShaderUniformCollection::GetDataUniformPointer(ShaderProgram::Location location)
 {
-    const DataUniform& uniform = GetDataUniform(location);
+    DataUniform& uniform = GetDataUniform(location);
+    uniform.version = NewVersion();
     std::vector<T>& allValues = GetDataValues<T>();
     return &allValues[uniform.index];
 }
@@ -393,6 +441,7 @@ void ShaderUniformCollection::AddUniform(const DataUniform& uniform)
 
     std::vector<T>& values = GetDataValues<T>();
     m_dataUniforms.back().index = static_cast<int>(values.size());
+    m_dataUniforms.back().version = NewVersion();
     int size = GetDataUniformSize(uniform);
     values.insert(values.end(), size, T());
 }
@@ -20,12 +20,20 @@ public:
         GLsizei width, GLsizei height,
         Format format, InternalFormat internalFormat,
         std::span<const T> data, Data::Type type = Data::Type::None);
+
+    // Read back the texture2D data of a level, converted to the specified format
+    template <typename T>
+    void GetImage(GLint level, Format format, std::span<T> data, Data::Type type = Data::Type::None) const;
 };
 
 // Set image with data in bytes
 template <>
 void Texture2DObject::SetImage<std::byte>(GLint level, GLsizei width, GLsizei height, Format format, InternalFormat internalFormat, std::span<const std::byte> data, Data::Type type);
 
+// Get image with data in bytes
+template <>
+void Texture2DObject::GetImage<std::byte>(GLint level, Format format, std::span<std::byte> data, Data::Type type) const;
+
 // Template method to set image with any kind of data
 template <typename T>
 inline void Texture2DObject::SetImage(GLint level, GLsizei width, GLsizei height,
@@ -38,3 +46,13 @@ inline void Texture2DObject::SetImage(GLint level, GLsizei width, GLsizei height
     SetImage(level, width, height, format, internalFormat, Data::GetBytes(data), type);
 }
 
+// Template method to get image with any kind of data
+template <typename T>
+inline void Texture2DObject::GetImage(GLint level, Format format, std::span<T> data, Data::Type type) const
+{
+    if (type == Data::Type::None)
+    {
+        type = Data::GetType<T>();
+    }
+    GetImage(level, format, Data::GetBytes(data), type);
+}
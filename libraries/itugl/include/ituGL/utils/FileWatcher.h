@@ -0,0 +1,45 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <vector>
+
+// Reports the files that changed since the last time it was asked, without blocking
+// On Linux, it gets the changes from inotify. Elsewhere, or for files whose directory can't be watched, it compares
+// the modification times of the files
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator = (const FileWatcher&) = delete;
+
+    // Watch a file. Its directory is watched too, because editors often save by writing a new file and renaming it
+    void AddFile(const std::filesystem::path& path);
+
+    // Watched files that changed since the last call, each one only once
+    std::vector<std::filesystem::path> GetChangedFiles();
+
+private:
+    struct WatchedFile
+    {
+        // Absolute, to compare it with the paths of the events
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastWriteTime;
+        // Its directory is watched with inotify, so the modification time is not checked
+        bool watched;
+    };
+
+    static std::filesystem::file_time_type GetLastWriteTime(const std::filesystem::path& path);
+
+private:
+    std::vector<WatchedFile> m_files;
+
+#ifdef __linux__
+    int m_inotifyDescriptor;
+    // Watched directories, by their watch descriptor
+    std::map<int, std::filesystem::path> m_directories;
+#endif
+};
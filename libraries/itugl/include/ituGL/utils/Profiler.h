@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Records the CPU time of named scopes, from any thread, and shows them per frame
+// Events go to a fixed-size ring buffer without locks, so the oldest ones are overwritten once it is full
+// Implemented as a Singleton pattern, like DeviceGL, so scopes can be measured anywhere
+class Profiler
+{
+public:
+    // Time interval of a scope, in nanoseconds from the creation of the profiler
+    struct Event
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+        uint32_t threadId;
+        uint32_t depth;
+    };
+
+    // Measures the time from its construction to its destruction. Use with ITUGL_PROFILE_SCOPE
+    class Scope
+    {
+    public:
+        // The name must outlive the profiler, usually a string literal
+        Scope(const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator = (const Scope&) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t m_start;
+    };
+
+public:
+    static Profiler& GetInstance();
+
+    // Enable / disable recording. Disabled by default, disabled scopes cost one atomic load
+    inline bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    inline void SetEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+
+    // Marks the start of a new frame. Call it from the main thread only
+    void BeginFrame();
+
+    // Time in nanoseconds from the creation of the profiler
+    uint64_t GetTime() const;
+
+    // Adds an event to the ring buffer. Safe to call from any thread
+    void Record(const Event& event);
+
+    // Copies the recorded events that started in [start, end), sorted by start time
+    void GetEvents(uint64_t start, uint64_t end, std::vector<Event>& events) const;
+
+    // Start time of the last completed frame, and its duration
+    void GetLastFrame(uint64_t& start, uint64_t& end) const;
+
+    // Writes all the events still in the ring buffer in the Chrome trace format (chrome://tracing or ui.perfetto.dev)
+    bool ExportChromeTrace(const char* path) const;
+
+    // Draws the frame times and a timeline of the last frame, in the current DearImGui window
+    void DrawImGui();
+
+private:
+    Profiler();
+
+    static uint32_t GetThreadId();
+
+private:
+    // Each slot stores the index of the event it holds, plus one, once it is completely written. Readers use it to
+    // skip the slots that are being written or were overwritten while they read them
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        Event event;
+    };
+
+    static constexpr size_t s_slotCount = 1 << 16;
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<uint64_t> m_writeIndex;
+    std::atomic<bool> m_enabled;
+
+    // Start times of the last frames, in a small ring, and their durations for the GUI
+    static constexpr unsigned int s_frameHistorySize = 128;
+    uint64_t m_frameStarts[s_frameHistorySize];
+    float m_frameTimes[s_frameHistorySize];
+    unsigned int m_frameCount;
+
+    // GUI state
+    bool m_paused;
+    std::vector<Event> m_guiEvents;
+    uint64_t m_guiFrameStart;
+    uint64_t m_guiFrameEnd;
+};
+
+#define ITUGL_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ITUGL_PROFILE_CONCAT(a, b) ITUGL_PROFILE_CONCAT_IMPL(a, b)
+
+// Measures the rest of the current scope under the given name
+#define ITUGL_PROFILE_SCOPE(name) Profiler::Scope ITUGL_PROFILE_CONCAT(profilerScope, __LINE__)(name)
+
+// Measures the rest of the current function
+#define ITUGL_PROFILE_FUNCTION() ITUGL_PROFILE_SCOPE(__func__)
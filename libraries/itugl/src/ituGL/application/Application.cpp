@@ -6,10 +6,13 @@
 #include <chrono>
 // For error messages
 #include <iostream>
+// For measuring the phases of each frame
+#include <ituGL/utils/Profiler.h>
 
 // DeviceGL and main Window are constructed in the correct order because they were declared like that!
-Application::Application(int width, int height, const char* title)
-    : m_mainWindow(width, height, title), m_currentTime(0), m_deltaTime(0), m_exitCode(0)
+Application::Application(int width, int height, const char* title, bool headless)
+    : m_mainWindow(width, height, title, !headless), m_currentTime(0), m_deltaTime(0)
+    , m_frameIndex(0), m_frameLimit(0), m_fixedTimeStep(0), m_headless(headless), m_exitCode(0)
 {
     // If the main window is not valid, exit with error
     if (!m_mainWindow.IsValid())
@@ -26,6 +29,12 @@ Application::Application(int width, int height, const char* title)
         Terminate(-2, "Failed to initialize OpenGL with GLAD");
         return;
     }
+
+    // Headless frames are never presented, so there is no point in waiting for the display
+    if (headless)
+    {
+        m_device.SetVSyncEnabled(false);
+    }
 }
 
 Application::~Application()
@@ -50,17 +59,47 @@ int Application::Run()
         // Main loop
         while (IsRunning())
         {
-            // set current time relative to start time
-            std::chrono::duration<float> duration = std::chrono::steady_clock::now() - startTime;
-            UpdateTime(duration.count());
-
-            Update();
-
-            Render();
-
-            // Swap buffers and poll events at the end of the frame
-            m_mainWindow.SwapBuffers();
-            m_device.PollEvents();
+            Profiler::GetInstance().BeginFrame();
+
+            // set current time relative to start time, or advance it a fixed step with a frame limit
+            if (m_frameLimit)
+            {
+                UpdateTime(m_frameIndex * m_fixedTimeStep);
+            }
+            else
+            {
+                std::chrono::duration<float> duration = std::chrono::steady_clock::now() - startTime;
+                UpdateTime(duration.count());
+            }
+
+            {
+                ITUGL_PROFILE_SCOPE("Update");
+                Update();
+            }
+
+            {
+                ITUGL_PROFILE_SCOPE("Render");
+                Render();
+            }
+
+            // Swap buffers and poll events at the end of the frame. Headless windows are never shown, so no swap
+            {
+                ITUGL_PROFILE_SCOPE("SwapBuffers");
+                if (!m_headless)
+                {
+                    m_mainWindow.SwapBuffers();
+                }
+                m_device.PollEvents();
+            }
+
+            // Keep the render state counters of this frame, and start counting again
+            m_device.EndFrame();
+
+            ++m_frameIndex;
+            if (m_frameLimit && m_frameIndex >= m_frameLimit)
+            {
+                Close();
+            }
         }
 
         Cleanup();
@@ -70,6 +109,12 @@ int Application::Run()
     return m_exitCode;
 }
 
+void Application::SetFrameLimit(unsigned int frameCount, float timeStep)
+{
+    m_frameLimit = frameCount;
+    m_fixedTimeStep = timeStep;
+}
+
 void Application::Initialize()
 {
 }
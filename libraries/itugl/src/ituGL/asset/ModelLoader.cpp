@@ -6,6 +6,8 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <glm/common.hpp>
+#include <limits>
 #include <iostream>
 #include <bit>
 
@@ -90,11 +92,21 @@ Model ModelLoader::Load(const char* path)
     {
         model.SetMesh(std::make_shared<Mesh>());
         Mesh& mesh = model.GetMesh();
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
         for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; ++meshIndex)
         {
             aiMesh& meshData = *scene->mMeshes[meshIndex];
             GenerateSubmesh(mesh, meshData);
 
+            // Grow the bounds of the model with the vertex positions
+            for (unsigned int vertexIndex = 0; vertexIndex < meshData.mNumVertices; ++vertexIndex)
+            {
+                const aiVector3D& position = meshData.mVertices[vertexIndex];
+                boundsMin = glm::min(boundsMin, glm::vec3(position.x, position.y, position.z));
+                boundsMax = glm::max(boundsMax, glm::vec3(position.x, position.y, position.z));
+            }
+
             std::shared_ptr<Material> material = m_referenceMaterial;
             if (m_createMaterials)
             {
@@ -103,6 +115,11 @@ Model ModelLoader::Load(const char* path)
             }
             model.AddMaterial(material);
         }
+
+        if (boundsMin.x <= boundsMax.x)
+        {
+            model.SetLocalBounds(0.5f * (boundsMin + boundsMax), 0.5f * (boundsMax - boundsMin));
+        }
     }
 
     return model;
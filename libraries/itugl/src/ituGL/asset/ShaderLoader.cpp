@@ -8,7 +8,7 @@
 
 #include <iostream>
 
-ShaderLoader::ShaderLoader(Shader::Type type) : m_type(type)
+ShaderLoader::ShaderLoader(Shader::Type type, const DefineSet& defines) : m_type(type), m_defines(defines)
 {
 }
 
@@ -28,8 +28,10 @@ Shader ShaderLoader::Load(const char* path)
     std::ifstream file(path);
     assert(file.is_open());
     std::stringstream stringStream;
-    stringStream << file.rdbuf() << '\0';
-    shader.SetSource(stringStream.str().c_str());
+    stringStream << file.rdbuf();
+    std::string source = stringStream.str();
+    AddDefines(source, m_defines);
+    shader.SetSource(source.c_str());
     Compile(shader);
     return shader;
 }
@@ -37,15 +39,10 @@ Shader ShaderLoader::Load(const char* path)
 Shader ShaderLoader::Load(std::span<const char*> paths)
 {
     Shader shader(m_type);
-    std::vector<std::stringstream> stringStreams(paths.size());
-    std::vector<std::string> sourceCodeStrings(paths.size());
+    std::vector<std::string> sourceCodeStrings = LoadSources(paths, m_defines);
     std::vector<const char*> sourceCode(paths.size());
-    for (int i = 0; i < paths.size(); ++i)
+    for (size_t i = 0; i < paths.size(); ++i)
     {
-        std::ifstream file(paths[i]);
-        assert(file.is_open());
-        stringStreams[i] << file.rdbuf() << '\0';
-        sourceCodeStrings[i] = stringStreams[i].str();
         sourceCode[i] = sourceCodeStrings[i].c_str();
     }
     shader.SetSource(sourceCode);
@@ -53,6 +50,50 @@ Shader ShaderLoader::Load(std::span<const char*> paths)
     return shader;
 }
 
+std::vector<std::string> ShaderLoader::LoadSources(std::span<const char*> paths, const DefineSet& defines)
+{
+    std::vector<std::string> sourceCodeStrings(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        std::ifstream file(paths[i]);
+        assert(file.is_open());
+        std::stringstream stringStream;
+        stringStream << file.rdbuf();
+        sourceCodeStrings[i] = stringStream.str();
+    }
+    if (!sourceCodeStrings.empty())
+    {
+        AddDefines(sourceCodeStrings[0], defines);
+    }
+    return sourceCodeStrings;
+}
+
+void ShaderLoader::AddDefines(std::string& source, const DefineSet& defines)
+{
+    if (defines.empty())
+        return;
+
+    std::string defineLines;
+    for (const std::string& define : defines)
+    {
+        defineLines += "#define " + define + "\n";
+    }
+
+    size_t position = 0;
+    if (source.compare(0, 8, "#version") == 0)
+    {
+        position = source.find('\n');
+        position = position == std::string::npos ? source.size() : position + 1;
+        if (position == source.size() && source.back() != '\n')
+        {
+            defineLines = "\n" + defineLines;
+        }
+        // Keep the line numbers of the errors matching the file
+        defineLines += "#line 2\n";
+    }
+    source.insert(position, defineLines);
+}
+
 Shader* ShaderLoader::LoadNew(std::span<const char*> paths)
 {
     Shader* shader = nullptr;
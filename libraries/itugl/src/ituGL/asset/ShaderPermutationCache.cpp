@@ -0,0 +1,254 @@
+#include <ituGL/asset/ShaderPermutationCache.h>
+
+#include <ituGL/application/Window.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/shader/Shader.h>
+#include <ituGL/shader/ShaderProgramCache.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+
+ShaderPermutationCache::ShaderPermutationCache(std::vector<std::string> vertexPaths, std::vector<std::string> fragmentPaths,
+    ShaderProgramCache* programCache)
+    : m_vertexPaths(std::move(vertexPaths))
+    , m_fragmentPaths(std::move(fragmentPaths))
+    , m_programCache(programCache)
+    , m_stopBackgroundThread(false)
+{
+}
+
+ShaderPermutationCache::~ShaderPermutationCache()
+{
+    if (m_backgroundThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopBackgroundThread = true;
+        }
+        m_condition.notify_all();
+        m_backgroundThread.join();
+    }
+
+    // The window of the context must be destroyed in the main thread
+    m_backgroundWindow.reset();
+}
+
+void ShaderPermutationCache::StartBackgroundCompilation(Window& window)
+{
+    assert(!m_backgroundThread.joinable());
+
+    // Windows can only be created in the main thread. This one is never shown, it is only for its context
+    m_backgroundWindow = std::make_unique<Window>(1, 1, "Shader compilation", false, &window);
+    if (!m_backgroundWindow->IsValid())
+    {
+        std::cerr << "Can't create a shared context, shaders are compiled in the main thread" << std::endl;
+        m_backgroundWindow.reset();
+        return;
+    }
+
+    m_backgroundThread = std::thread(&ShaderPermutationCache::RunBackgroundThread, this);
+}
+
+std::shared_ptr<ShaderProgram> ShaderPermutationCache::GetProgram(const DefineSet& defines, bool wait)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_permutations.find(defines);
+    if (it == m_permutations.end())
+    {
+        it = m_permutations.emplace(defines, Permutation()).first;
+        it->second.program = std::make_shared<ShaderProgram>();
+
+        if (m_backgroundThread.joinable())
+        {
+            m_requests.push_back({ defines, false });
+            m_condition.notify_all();
+        }
+        else
+        {
+            // No background thread, build it now. Only this thread uses the permutations
+            lock.unlock();
+            bool built = BuildProgram(*it->second.program, defines);
+            lock.lock();
+            it->second.state = built ? State::Built : State::Failed;
+        }
+    }
+
+    Permutation& permutation = it->second;
+    if (wait)
+    {
+        m_condition.wait(lock, [&permutation] { return permutation.state != State::Pending; });
+    }
+
+    // Swap the reloaded program, here in the main thread. If it failed, the errors were printed, and it is discarded
+    if (permutation.reloadedProgram && permutation.reloadState != State::Pending)
+    {
+        if (permutation.reloadState == State::Built)
+        {
+            permutation.program = permutation.reloadedProgram;
+            permutation.state = State::Built;
+        }
+        permutation.reloadedProgram.reset();
+    }
+
+    // Reload was called while it was building, so it is built again once it is done
+    if (permutation.reloadAgain && !permutation.reloadedProgram && permutation.state != State::Pending)
+    {
+        permutation.reloadAgain = false;
+        ReloadPermutation(defines, permutation, lock);
+    }
+
+    return permutation.state == State::Built ? permutation.program : nullptr;
+}
+
+void ShaderPermutationCache::Reload()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (auto& [defines, permutation] : m_permutations)
+    {
+        if (permutation.reloadedProgram || permutation.state == State::Pending)
+        {
+            // It is building, and may have read the files before they changed. It is reloaded again when it is done
+            permutation.reloadAgain = true;
+        }
+        else
+        {
+            ReloadPermutation(defines, permutation, lock);
+        }
+    }
+}
+
+void ShaderPermutationCache::ReloadPermutation(const DefineSet& defines, Permutation& permutation, std::unique_lock<std::mutex>& lock)
+{
+    permutation.reloadedProgram = std::make_shared<ShaderProgram>();
+    permutation.reloadState = State::Pending;
+
+    if (m_backgroundThread.joinable())
+    {
+        m_requests.push_back({ defines, true });
+        m_condition.notify_all();
+    }
+    else
+    {
+        lock.unlock();
+        bool built = BuildProgram(*permutation.reloadedProgram, defines);
+        lock.lock();
+        permutation.reloadState = built ? State::Built : State::Failed;
+    }
+}
+
+bool ShaderPermutationCache::UpdateMaterial(Material& material, const DefineSet& defines,
+    const ShaderUniformCollection::NameSet& filteredUniforms)
+{
+    std::shared_ptr<ShaderProgram> shaderProgram = GetProgram(defines);
+    if (!shaderProgram || shaderProgram == material.GetShaderProgram())
+    {
+        return false;
+    }
+
+    material.ChangeShader(shaderProgram, filteredUniforms, true);
+    return true;
+}
+
+unsigned int ShaderPermutationCache::GetPermutationCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<unsigned int>(m_permutations.size());
+}
+
+unsigned int ShaderPermutationCache::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<unsigned int>(std::count_if(m_permutations.begin(), m_permutations.end(),
+        [](const auto& entry)
+        {
+            const Permutation& permutation = entry.second;
+            return permutation.state == State::Pending || permutation.reloadAgain
+                || (permutation.reloadedProgram && permutation.reloadState == State::Pending);
+        }));
+}
+
+bool ShaderPermutationCache::BuildProgram(ShaderProgram& shaderProgram, const DefineSet& defines) const
+{
+    std::vector<const char*> vertexPaths, fragmentPaths;
+    for (const std::string& path : m_vertexPaths)
+    {
+        vertexPaths.push_back(path.c_str());
+    }
+    for (const std::string& path : m_fragmentPaths)
+    {
+        fragmentPaths.push_back(path.c_str());
+    }
+
+    if (m_programCache)
+    {
+        // The cache needs the sources, to find the program
+        std::vector<std::string> vertexSourceStrings = ShaderLoader::LoadSources(vertexPaths, defines);
+        std::vector<std::string> fragmentSourceStrings = ShaderLoader::LoadSources(fragmentPaths, defines);
+        std::vector<const char*> vertexSources, fragmentSources;
+        for (const std::string& source : vertexSourceStrings)
+        {
+            vertexSources.push_back(source.c_str());
+        }
+        for (const std::string& source : fragmentSourceStrings)
+        {
+            fragmentSources.push_back(source.c_str());
+        }
+        return m_programCache->Build(shaderProgram, vertexSources, fragmentSources);
+    }
+
+    ShaderLoader vertexShaderLoader(Shader::VertexShader, defines);
+    Shader vertexShader = vertexShaderLoader.Load(vertexPaths);
+
+    ShaderLoader fragmentShaderLoader(Shader::FragmentShader, defines);
+    Shader fragmentShader = fragmentShaderLoader.Load(fragmentPaths);
+
+    // The loader already printed the errors
+    if (!vertexShader.IsCompiled() || !fragmentShader.IsCompiled())
+    {
+        return false;
+    }
+
+    if (!shaderProgram.Build(vertexShader, fragmentShader))
+    {
+        std::array<char, 512> errors;
+        shaderProgram.GetLinkingErrors(errors);
+        std::cerr << "Error linking shaders" << std::endl;
+        std::cerr << errors.data() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ShaderPermutationCache::RunBackgroundThread()
+{
+    glfwMakeContextCurrent(m_backgroundWindow->GetInternalWindow());
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this] { return m_stopBackgroundThread || !m_requests.empty(); });
+        if (m_stopBackgroundThread)
+            break;
+
+        Request request = std::move(m_requests.front());
+        m_requests.pop_front();
+        Permutation& permutation = m_permutations.at(request.defines);
+        ShaderProgram& shaderProgram = request.reload ? *permutation.reloadedProgram : *permutation.program;
+
+        // Nobody else uses the program until it is built
+        lock.unlock();
+        bool built = BuildProgram(shaderProgram, request.defines);
+
+        // Wait until the driver is done with it, so the main context sees the finished program
+        glFinish();
+        lock.lock();
+
+        (request.reload ? permutation.reloadState : permutation.state) = built ? State::Built : State::Failed;
+        m_condition.notify_all();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
@@ -1,5 +1,6 @@
 #include <ituGL/core/BufferObject.h>
 
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 // Create the object initially null, get object handle and generate 1 buffer
@@ -14,6 +15,10 @@ BufferObject::~BufferObject()
 {
     Handle& handle = GetHandle();
     glDeleteBuffers(1, &handle);
+    if (DeviceGL* device = DeviceGL::GetInstancePointer())
+    {
+        device->OnBufferDeleted(handle);
+    }
 }
 
 BufferObject::BufferObject(BufferObject&& bufferObject) noexcept : Object(std::move(bufferObject))
@@ -40,12 +45,30 @@ void BufferObject::Unbind(Target target)
     glBindBuffer(target, handle);
 }
 
+// Bind the buffer handle to an indexed binding point of the target
+void BufferObject::BindBase(Target target, GLuint index) const
+{
+    assert(target == Target::UniformBuffer || target == Target::ShaderStorageBuffer);
+    DeviceGL::GetInstance().BindBufferRange(target, index, GetHandle(), 0, 0);
+}
+
+// Bind a range of the buffer to an indexed binding point of the target
+void BufferObject::BindRange(Target target, GLuint index, size_t offset, size_t size) const
+{
+    assert(target == Target::UniformBuffer || target == Target::ShaderStorageBuffer);
+    assert(size > 0);
+    DeviceGL::GetInstance().BindBufferRange(target, index, GetHandle(), offset, size);
+}
+
 // Get buffer Target and allocate buffer data
 void BufferObject::AllocateData(size_t size, Usage usage)
 {
     assert(IsBound());
     Target target = GetTarget();
     glBufferData(target, size, nullptr, usage);
+
+    // Ranges bound to the old storage could be out of the new one, bind them again
+    DeviceGL::GetInstance().OnBufferReallocated(GetHandle());
 }
 
 // Get buffer Target and allocate buffer data
@@ -54,6 +77,9 @@ void BufferObject::AllocateData(std::span<const std::byte> data, Usage usage)
     assert(IsBound());
     Target target = GetTarget();
     glBufferData(target, data.size_bytes(), data.data(), usage);
+
+    // Ranges bound to the old storage could be out of the new one, bind them again
+    DeviceGL::GetInstance().OnBufferReallocated(GetHandle());
 }
 
 // Get buffer Target and set buffer subdata
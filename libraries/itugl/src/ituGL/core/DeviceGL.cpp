@@ -2,14 +2,20 @@
 
 #include <ituGL/application/Window.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <cassert>
 
 DeviceGL* DeviceGL::m_instance = nullptr;
 
+// Value of the cached states before they are set for the first time
+static const GLuint s_unknownState = ~0u;
+
 DeviceGL::DeviceGL() : m_contextLoaded(false)
 {
     m_instance = this;
 
+    InvalidateState();
+
     // Init GLFW
     glfwInit();
 }
@@ -85,19 +91,30 @@ void DeviceGL::Clear(bool clearColor, const Color& color, bool clearDepth, GLdou
 // Get if a feature is enabled
 bool DeviceGL::IsFeatureEnabled(GLenum feature) const
 {
-    return glIsEnabled(feature);
+    auto itFind = std::find_if(m_features.begin(), m_features.end(), [=](const FeatureState& state) { return state.feature == feature; });
+    return itFind != m_features.end() ? itFind->enabled : glIsEnabled(feature);
 }
 
 // enable / disable a feature
 void DeviceGL::SetFeatureEnabled(GLenum feature, bool enabled)
 {
-    if (enabled)
+    auto itFind = std::find_if(m_features.begin(), m_features.end(), [=](const FeatureState& state) { return state.feature == feature; });
+    if (itFind == m_features.end())
     {
-        glEnable(feature);
+        m_features.push_back(FeatureState{ feature, !enabled });
+        itFind = m_features.end() - 1;
     }
-    else
+
+    if (ChangeState(itFind->enabled, enabled, m_stateCounters.fixedStateChanges, m_stateCounters.fixedStateSkips))
     {
-        glDisable(feature);
+        if (enabled)
+        {
+            glEnable(feature);
+        }
+        else
+        {
+            glDisable(feature);
+        }
     }
 }
 
@@ -112,3 +129,273 @@ void DeviceGL::SetVSyncEnabled(bool enabled)
 {
     glfwSwapInterval(enabled ? 1 : 0);
 }
+
+template<typename T>
+bool DeviceGL::ChangeState(T& cached, const T& value, unsigned int& changes, unsigned int& skips)
+{
+    if (cached == value)
+    {
+        ++skips;
+        return false;
+    }
+    cached = value;
+    ++changes;
+    return true;
+}
+
+void DeviceGL::UseProgram(GLuint program)
+{
+    if (ChangeState(m_program, program, m_stateCounters.programChanges, m_stateCounters.programSkips))
+    {
+        glUseProgram(program);
+    }
+}
+
+void DeviceGL::BindVertexArray(GLuint vertexArray)
+{
+    if (ChangeState(m_vertexArray, vertexArray, m_stateCounters.vertexArrayChanges, m_stateCounters.vertexArraySkips))
+    {
+        glBindVertexArray(vertexArray);
+    }
+}
+
+void DeviceGL::SetActiveTexture(GLint textureUnit)
+{
+    if (ChangeState(m_activeTexture, textureUnit, m_stateCounters.fixedStateChanges, m_stateCounters.fixedStateSkips))
+    {
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+    }
+}
+
+void DeviceGL::BindTexture(GLenum target, GLuint texture)
+{
+    // Each texture unit has one binding per target
+    GLint unit = m_activeTexture;
+    auto itFind = std::find_if(m_textureBindings.begin(), m_textureBindings.end(),
+        [=](const TextureBinding& binding) { return binding.unit == unit && binding.target == target; });
+
+    if (unit == static_cast<GLint>(s_unknownState) || itFind == m_textureBindings.end())
+    {
+        // Unknown, always bind, but only remember it if the unit is known
+        ++m_stateCounters.textureChanges;
+        glBindTexture(target, texture);
+        if (unit != static_cast<GLint>(s_unknownState))
+        {
+            m_textureBindings.push_back(TextureBinding{ unit, target, texture });
+        }
+    }
+    else if (ChangeState(itFind->texture, texture, m_stateCounters.textureChanges, m_stateCounters.textureSkips))
+    {
+        glBindTexture(target, texture);
+    }
+}
+
+void DeviceGL::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    assert(target == GL_UNIFORM_BUFFER || target == GL_SHADER_STORAGE_BUFFER);
+    auto itFind = std::find_if(m_bufferBindings.begin(), m_bufferBindings.end(),
+        [=](const BufferBinding& binding) { return binding.target == target && binding.index == index; });
+
+    if (itFind != m_bufferBindings.end() && itFind->buffer == buffer && itFind->offset == offset && itFind->size == size)
+    {
+        ++m_stateCounters.bufferBindingSkips;
+        return;
+    }
+
+    if (itFind == m_bufferBindings.end())
+    {
+        m_bufferBindings.push_back(BufferBinding{ target, index, buffer, offset, size });
+    }
+    else
+    {
+        *itFind = BufferBinding{ target, index, buffer, offset, size };
+    }
+    ++m_stateCounters.bufferBindingChanges;
+
+    if (size == 0)
+    {
+        glBindBufferBase(target, index, buffer);
+    }
+    else
+    {
+        glBindBufferRange(target, index, buffer, offset, size);
+    }
+}
+
+void DeviceGL::SetDepthFunction(GLenum function)
+{
+    if (ChangeState(m_depthFunction, function, m_stateCounters.fixedStateChanges, m_stateCounters.fixedStateSkips))
+    {
+        glDepthFunc(function);
+    }
+}
+
+void DeviceGL::SetDepthWrite(bool enabled)
+{
+    if (ChangeState(m_depthWrite, enabled ? GL_TRUE : GL_FALSE, m_stateCounters.fixedStateChanges, m_stateCounters.fixedStateSkips))
+    {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void DeviceGL::SetCullFace(GLenum face)
+{
+    if (ChangeState(m_cullFace, face, m_stateCounters.fixedStateChanges, m_stateCounters.fixedStateSkips))
+    {
+        glCullFace(face);
+    }
+}
+
+void DeviceGL::SetBlendEquation(GLenum colorEquation, GLenum alphaEquation)
+{
+    if (m_blendEquations[0] == colorEquation && m_blendEquations[1] == alphaEquation)
+    {
+        ++m_stateCounters.fixedStateSkips;
+        return;
+    }
+    m_blendEquations[0] = colorEquation;
+    m_blendEquations[1] = alphaEquation;
+    ++m_stateCounters.fixedStateChanges;
+    glBlendEquationSeparate(colorEquation, alphaEquation);
+}
+
+void DeviceGL::SetBlendFunction(GLenum sourceColor, GLenum destinationColor, GLenum sourceAlpha, GLenum destinationAlpha)
+{
+    GLenum functions[4] = { sourceColor, destinationColor, sourceAlpha, destinationAlpha };
+    if (std::equal(functions, functions + 4, m_blendFunctions))
+    {
+        ++m_stateCounters.fixedStateSkips;
+        return;
+    }
+    std::copy(functions, functions + 4, m_blendFunctions);
+    ++m_stateCounters.fixedStateChanges;
+    glBlendFuncSeparate(sourceColor, destinationColor, sourceAlpha, destinationAlpha);
+}
+
+void DeviceGL::SetStencilOperation(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+{
+    // Index 0 is the front face, 1 is the back face
+    int first = face == GL_BACK ? 1 : 0;
+    int last = face == GL_FRONT ? 0 : 1;
+
+    bool changed = false;
+    for (int i = first; i <= last; ++i)
+    {
+        changed |= m_stencilOperations[i][0] != stencilFail || m_stencilOperations[i][1] != depthFail || m_stencilOperations[i][2] != depthPass;
+        m_stencilOperations[i][0] = stencilFail;
+        m_stencilOperations[i][1] = depthFail;
+        m_stencilOperations[i][2] = depthPass;
+    }
+
+    if (changed)
+    {
+        ++m_stateCounters.fixedStateChanges;
+        glStencilOpSeparate(face, stencilFail, depthFail, depthPass);
+    }
+    else
+    {
+        ++m_stateCounters.fixedStateSkips;
+    }
+}
+
+void DeviceGL::SetStencilFunction(GLenum face, GLenum function, GLint reference, GLuint mask)
+{
+    // Index 0 is the front face, 1 is the back face
+    int first = face == GL_BACK ? 1 : 0;
+    int last = face == GL_FRONT ? 0 : 1;
+
+    bool changed = false;
+    for (int i = first; i <= last; ++i)
+    {
+        changed |= m_stencilFunctions[i] != function || m_stencilReferences[i] != reference || m_stencilMasks[i] != mask;
+        m_stencilFunctions[i] = function;
+        m_stencilReferences[i] = reference;
+        m_stencilMasks[i] = mask;
+    }
+
+    if (changed)
+    {
+        ++m_stateCounters.fixedStateChanges;
+        glStencilFuncSeparate(face, function, reference, mask);
+    }
+    else
+    {
+        ++m_stateCounters.fixedStateSkips;
+    }
+}
+
+void DeviceGL::InvalidateState()
+{
+    m_program = s_unknownState;
+    m_vertexArray = s_unknownState;
+    m_activeTexture = static_cast<GLint>(s_unknownState);
+    m_textureBindings.clear();
+    m_bufferBindings.clear();
+    m_features.clear();
+    m_depthFunction = s_unknownState;
+    m_depthWrite = static_cast<GLint>(s_unknownState);
+    m_cullFace = s_unknownState;
+    std::fill(m_blendEquations, m_blendEquations + 2, s_unknownState);
+    std::fill(m_blendFunctions, m_blendFunctions + 4, s_unknownState);
+    std::fill(&m_stencilOperations[0][0], &m_stencilOperations[0][0] + 6, s_unknownState);
+    std::fill(m_stencilFunctions, m_stencilFunctions + 2, s_unknownState);
+    std::fill(m_stencilReferences, m_stencilReferences + 2, static_cast<GLint>(s_unknownState));
+    std::fill(m_stencilMasks, m_stencilMasks + 2, s_unknownState);
+}
+
+void DeviceGL::OnProgramDeleted(GLuint program)
+{
+    if (m_program == program)
+    {
+        m_program = s_unknownState;
+    }
+}
+
+void DeviceGL::OnVertexArrayDeleted(GLuint vertexArray)
+{
+    // OpenGL reverts the binding to 0 when the bound object is deleted
+    if (m_vertexArray == vertexArray)
+    {
+        m_vertexArray = 0;
+    }
+}
+
+void DeviceGL::OnTextureDeleted(GLuint texture)
+{
+    // OpenGL reverts the binding to 0 when the bound object is deleted
+    for (TextureBinding& binding : m_textureBindings)
+    {
+        if (binding.texture == texture)
+        {
+            binding.texture = 0;
+        }
+    }
+}
+
+void DeviceGL::OnBufferDeleted(GLuint buffer)
+{
+    // Forget the bindings, OpenGL reverts them to 0
+    OnBufferReallocated(buffer);
+}
+
+void DeviceGL::OnBufferReallocated(GLuint buffer)
+{
+    std::erase_if(m_bufferBindings, [buffer](const BufferBinding& binding) { return binding.buffer == buffer; });
+}
+
+void DeviceGL::OnUniformSet(size_t bytes)
+{
+    ++m_stateCounters.uniformChanges;
+    m_stateCounters.uniformBytes += bytes;
+}
+
+void DeviceGL::OnUniformSkipped()
+{
+    ++m_stateCounters.uniformSkips;
+}
+
+void DeviceGL::EndFrame()
+{
+    m_lastFrameStateCounters = m_stateCounters;
+    m_stateCounters = StateCounters();
+}
@@ -2,6 +2,8 @@
 
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/geometry/ElementBufferObject.h>
+#include <ituGL/geometry/DrawIndirectBufferObject.h>
+#include <ituGL/utils/Profiler.h>
 #include <cassert>
 
 Drawcall::Drawcall()
@@ -25,6 +27,8 @@ Drawcall::Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint
 // Execute the drawcall
 void Drawcall::Draw() const
 {
+    ITUGL_PROFILE_SCOPE("Draw");
+
     assert(IsValid());
     assert(VertexArrayObject::IsAnyBound());
 
@@ -38,7 +42,52 @@ void Drawcall::Draw() const
     {
         // If there is an EBO, use glDrawElements
         assert(ElementBufferObject::IsSupportedType(m_eboType));
+        // The offset is in bytes, so the first element needs to be scaled by the size of the element type
         const char* basePointer = nullptr; // Actual element pointer is in VAO
-        glDrawElements(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first);
+        glDrawElements(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first * Data::GetTypeSize(m_eboType));
+    }
+}
+
+// Execute the drawcall for several instances
+void Drawcall::DrawInstanced(GLsizei instanceCount) const
+{
+    ITUGL_PROFILE_SCOPE("DrawInstanced");
+
+    assert(IsValid());
+    assert(VertexArrayObject::IsAnyBound());
+    assert(instanceCount >= 0);
+
+    GLenum primitive = static_cast<GLenum>(m_primitive);
+    if (m_eboType == Data::Type::None)
+    {
+        glDrawArraysInstanced(primitive, m_first, m_count, instanceCount);
+    }
+    else
+    {
+        assert(ElementBufferObject::IsSupportedType(m_eboType));
+        const char* basePointer = nullptr; // Actual element pointer is in VAO
+        glDrawElementsInstanced(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first * Data::GetTypeSize(m_eboType), instanceCount);
+    }
+}
+
+// Execute several drawcalls with the parameters in the indirect buffer
+void Drawcall::MultiDrawIndirect(Primitive primitive, Data::Type eboType, size_t offset, GLsizei drawCount)
+{
+    ITUGL_PROFILE_SCOPE("MultiDrawIndirect");
+
+    assert(primitive != Primitive::Invalid);
+    assert(VertexArrayObject::IsAnyBound());
+    assert(DrawIndirectBufferObject::IsAnyBound());
+    assert(drawCount >= 0);
+
+    const char* basePointer = nullptr; // Actual commands are in the indirect buffer
+    if (eboType == Data::Type::None)
+    {
+        glMultiDrawArraysIndirect(static_cast<GLenum>(primitive), basePointer + offset, drawCount, 0);
+    }
+    else
+    {
+        assert(ElementBufferObject::IsSupportedType(eboType));
+        glMultiDrawElementsIndirect(static_cast<GLenum>(primitive), static_cast<GLenum>(eboType), basePointer + offset, drawCount, 0);
     }
 }
@@ -3,7 +3,7 @@
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/shader/Material.h>
 
-Model::Model(std::shared_ptr<Mesh> mesh) : m_mesh(mesh)
+Model::Model(std::shared_ptr<Mesh> mesh) : m_mesh(mesh), m_localBoundsCenter(0.0f), m_localBoundsSize(1.0f)
 {
 }
 
@@ -75,3 +75,9 @@ void Model::Draw()
         }
     }
 }
+
+void Model::SetLocalBounds(const glm::vec3& center, const glm::vec3& size)
+{
+    m_localBoundsCenter = center;
+    m_localBoundsSize = size;
+}
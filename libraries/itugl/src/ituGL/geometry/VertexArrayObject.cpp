@@ -1,6 +1,7 @@
 #include <ituGL/geometry/VertexArrayObject.h>
 
 #include <ituGL/geometry/VertexAttribute.h>
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 #ifndef NDEBUG
@@ -21,6 +22,10 @@ VertexArrayObject::~VertexArrayObject()
 {
     Handle& handle = GetHandle();
     glDeleteVertexArrays(1, &handle);
+    if (DeviceGL* device = DeviceGL::GetInstancePointer())
+    {
+        device->OnVertexArrayDeleted(handle);
+    }
 }
 
 VertexArrayObject::VertexArrayObject(VertexArrayObject&& vao) noexcept : Object(std::move(vao))
@@ -37,7 +42,7 @@ VertexArrayObject& VertexArrayObject::operator = (VertexArrayObject&& vao) noexc
 void VertexArrayObject::Bind() const
 {
     Handle handle = GetHandle();
-    glBindVertexArray(handle);
+    DeviceGL::GetInstance().BindVertexArray(handle);
 #ifndef NDEBUG
     s_boundHandle = handle;
 #endif
@@ -47,7 +52,7 @@ void VertexArrayObject::Bind() const
 void VertexArrayObject::Unbind()
 {
     Handle handle = NullHandle;
-    glBindVertexArray(handle);
+    DeviceGL::GetInstance().BindVertexArray(handle);
 #ifndef NDEBUG
     s_boundHandle = handle;
 #endif
@@ -81,3 +86,25 @@ void VertexArrayObject::SetAttribute(GLuint location, const VertexAttribute& att
     // Finally, we enable the VertexAttribute in this location
     glEnableVertexAttribArray(location);
 }
+
+// Sets the divisor of the VertexAttribute in that location, used for instanced rendering
+void VertexArrayObject::SetAttributeDivisor(GLuint location, GLuint divisor)
+{
+    assert(IsBound());
+
+    glVertexAttribDivisor(location, divisor);
+}
+
+// Disables the VertexAttribute in that location, so it reads the current value
+void VertexArrayObject::DisableAttribute(GLuint location)
+{
+    assert(IsBound());
+
+    glDisableVertexAttribArray(location);
+}
+
+// Sets the current value of the integer VertexAttribute in that location
+void VertexArrayObject::SetAttributeValue(GLuint location, GLuint value)
+{
+    glVertexAttribI4ui(location, value, 0, 0, 0);
+}
@@ -60,3 +60,18 @@ void Light::SetIntensity(float intensity)
 {
     m_intensity = intensity;
 }
+
+bool Light::GetBoundingSphere(glm::vec3& /*center*/, float& /*radius*/) const
+{
+    return false;
+}
+
+Light::PackedData Light::GetPackedData() const
+{
+    PackedData packedData;
+    packedData.color = glm::vec4(GetColor() * GetIntensity(), static_cast<float>(GetType()));
+    packedData.position = glm::vec4(GetPosition(), 1.0f);
+    packedData.direction = glm::vec4(GetDirection(), 0.0f);
+    packedData.attenuation = GetAttenuation();
+    return packedData;
+}
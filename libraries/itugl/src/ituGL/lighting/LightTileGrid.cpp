@@ -0,0 +1,143 @@
+#include <ituGL/lighting/LightTileGrid.h>
+
+#include <ituGL/lighting/Light.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/utils/Profiler.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cassert>
+
+LightTileGrid::LightTileGrid(unsigned int tileSize)
+    : m_tileSize(tileSize)
+    , m_tileCountX(0)
+    , m_tileCountY(0)
+    , m_lightCount(0)
+{
+    assert(tileSize > 0);
+}
+
+void LightTileGrid::Build(const Camera& camera, std::span<const Light* const> lights, int width, int height)
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    m_tileCountX = (std::max(width, 1) + m_tileSize - 1) / m_tileSize;
+    m_tileCountY = (std::max(height, 1) + m_tileSize - 1) / m_tileSize;
+    m_lightCount = static_cast<unsigned int>(lights.size());
+
+    const glm::ivec4 fullRect(0, 0, m_tileCountX - 1, m_tileCountY - 1);
+    const glm::ivec4 emptyRect(1, 1, 0, 0);
+    const glm::mat4& viewMatrix = camera.GetViewMatrix();
+    const glm::mat4& projMatrix = camera.GetProjectionMatrix();
+
+    m_lightRects.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        glm::vec3 center;
+        float radius;
+        if (!lights[i]->GetBoundingSphere(center, radius))
+        {
+            m_lightRects[i] = fullRect;
+            continue;
+        }
+
+        // Project the corners of the box around the sphere in view space. It is a bit larger than the sphere, but
+        // much simpler than projecting the sphere exactly
+        glm::vec3 viewCenter(viewMatrix * glm::vec4(center, 1.0f));
+        glm::vec3 ndcMin(1.0f), ndcMax(-1.0f);
+        unsigned int behindCount = 0;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec3 offset((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+            glm::vec4 clip = projMatrix * glm::vec4(viewCenter + offset, 1.0f);
+            if (clip.w <= 0.0f)
+            {
+                ++behindCount;
+                continue;
+            }
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+
+        if (behindCount == 8)
+        {
+            // Completely behind the camera
+            m_lightRects[i] = emptyRect;
+        }
+        else if (behindCount > 0)
+        {
+            // Crossing the camera plane, the projection of the corners in front is not enough
+            m_lightRects[i] = fullRect;
+        }
+        else if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f || ndcMin.z > 1.0f || ndcMax.z < -1.0f)
+        {
+            // Outside of the frustum
+            m_lightRects[i] = emptyRect;
+        }
+        else
+        {
+            // From NDC to pixels, and then to tiles
+            glm::vec2 pixelMin = (glm::vec2(ndcMin) * 0.5f + 0.5f) * glm::vec2(width, height);
+            glm::vec2 pixelMax = (glm::vec2(ndcMax) * 0.5f + 0.5f) * glm::vec2(width, height);
+            glm::ivec2 tileMin = glm::ivec2(glm::floor(pixelMin / static_cast<float>(m_tileSize)));
+            glm::ivec2 tileMax = glm::ivec2(glm::floor(pixelMax / static_cast<float>(m_tileSize)));
+            tileMin = glm::clamp(tileMin, glm::ivec2(0), glm::ivec2(fullRect.z, fullRect.w));
+            tileMax = glm::clamp(tileMax, glm::ivec2(0), glm::ivec2(fullRect.z, fullRect.w));
+            m_lightRects[i] = glm::ivec4(tileMin, tileMax);
+        }
+    }
+
+    // Count the lights of each tile, then turn the counts into offsets, and fill the indices counting again
+    const unsigned int tileCount = m_tileCountX * m_tileCountY;
+    m_data.assign(2 * tileCount, 0);
+    for (const glm::ivec4& rect : m_lightRects)
+    {
+        for (int y = rect.y; y <= rect.w; ++y)
+        {
+            for (int x = rect.x; x <= rect.z; ++x)
+            {
+                ++m_data[2 * (y * m_tileCountX + x) + 1];
+            }
+        }
+    }
+
+    unsigned int offset = 2 * tileCount;
+    for (unsigned int tile = 0; tile < tileCount; ++tile)
+    {
+        m_data[2 * tile] = offset;
+        offset += m_data[2 * tile + 1];
+        m_data[2 * tile + 1] = 0;
+    }
+    m_data.resize(offset);
+
+    for (unsigned int lightIndex = 0; lightIndex < m_lightRects.size(); ++lightIndex)
+    {
+        const glm::ivec4& rect = m_lightRects[lightIndex];
+        for (int y = rect.y; y <= rect.w; ++y)
+        {
+            for (int x = rect.x; x <= rect.z; ++x)
+            {
+                unsigned int tile = y * m_tileCountX + x;
+                m_data[m_data[2 * tile] + m_data[2 * tile + 1]++] = lightIndex;
+            }
+        }
+    }
+}
+
+std::span<const unsigned int> LightTileGrid::GetTileLights(unsigned int x, unsigned int y) const
+{
+    assert(x < m_tileCountX && y < m_tileCountY);
+    unsigned int tile = y * m_tileCountX + x;
+    return std::span<const unsigned int>(m_data).subspan(m_data[2 * tile], m_data[2 * tile + 1]);
+}
+
+glm::uvec4 LightTileGrid::GetGridInfo() const
+{
+    return glm::uvec4(m_tileSize, m_tileCountX, m_tileCountY, m_lightCount);
+}
+
+float LightTileGrid::GetAverageLightCount() const
+{
+    unsigned int tileCount = m_tileCountX * m_tileCountY;
+    return tileCount > 0 ? static_cast<float>(m_data.size() - 2 * tileCount) / tileCount : 0.0f;
+}
@@ -33,3 +33,10 @@ void PointLight::SetDistanceAttenuation(glm::vec2 attenuation)
 {
     m_attenuation = attenuation;
 }
+
+bool PointLight::GetBoundingSphere(glm::vec3& center, float& radius) const
+{
+    center = m_position;
+    radius = m_attenuation.y;
+    return radius > 0.0f;
+}
@@ -1,6 +1,8 @@
 #include <ituGL/lighting/SpotLight.h>
 
 #include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+#include <cmath>
 
 SpotLight::SpotLight() : m_position(0.0f), m_direction(0.0f, 1.0f, 0.0f), m_attenuation(0.0f)
 {
@@ -67,3 +69,28 @@ void SpotLight::SetAngleAttenuation(glm::vec2 attenuation)
     m_attenuation.z = attenuation.x;
     m_attenuation.w = attenuation.y;
 }
+
+bool SpotLight::GetBoundingSphere(glm::vec3& center, float& radius) const
+{
+    float range = m_attenuation.y;
+    float angle = GetAngle();
+    if (angle <= glm::quarter_pi<float>())
+    {
+        // Narrow cone: sphere through the apex and the edge of the cap. The center is the same distance from both
+        float distance = range / (2.0f * std::cos(angle));
+        center = m_position + m_direction * distance;
+        radius = distance;
+    }
+    else if (angle < glm::half_pi<float>())
+    {
+        // Wide cone: the sphere around the edge of the cap already contains the apex
+        center = m_position + m_direction * (range * std::cos(angle));
+        radius = range * std::sin(angle);
+    }
+    else
+    {
+        center = m_position;
+        radius = range;
+    }
+    return range > 0.0f;
+}
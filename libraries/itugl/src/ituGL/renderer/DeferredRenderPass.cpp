@@ -3,15 +3,27 @@
 #include <ituGL/renderer/Renderer.h>
 #include <ituGL/geometry/VertexFormat.h>
 #include <ituGL/lighting/Light.h>
+#include <ituGL/lighting/SpotLight.h>
 #include <ituGL/camera/Camera.h>
+#include <ituGL/scene/Bounds.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/utils/Profiler.h>
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+
+// The volume meshes are pushed out to contain the light volume. Their vertices are never further than this, relative to it
+static const float s_meshScale = 1.1f;
 
 DeferredRenderPass::DeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> framebuffer)
     : RenderPass(framebuffer), m_material(material)
+    , m_lightVolumesEnabled(true)
+    , m_tiledLightingSupported(false)
+    , m_tiledLightingEnabled(true)
 {
     InitializeMeshes();
+    InitializeTiledLighting();
 }
 
 void DeferredRenderPass::Render()
@@ -23,13 +35,45 @@ void DeferredRenderPass::Render()
     const Camera& camera = renderer.GetCurrentCamera();
 
     assert(m_material);
+    BindTextureInputs(*m_material);
     m_material->Use();
+
+    if (IsTiledLightingEnabled())
+    {
+        RenderTiledLights(camera);
+    }
+    else
+    {
+        RenderLights(camera);
+    }
+
+    //TODO: temp hack
+    renderer.GetDevice().EnableFeature(GL_DEPTH_TEST);
+}
+
+void DeferredRenderPass::RenderLights(const Camera& camera)
+{
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
     std::shared_ptr<const ShaderProgram> shaderProgram = m_material->GetShaderProgram();
 
     // Our fullscreen triangle is directly in clip coordinates.
     // Use the inverse view proj matrix to cancel view projection from the camera
     glm::mat4 fullscreenMatrix = glm::inverse(camera.GetViewProjectionMatrix());
 
+    FrustumBounds frustum(camera.GetViewProjectionMatrix());
+
+    // Distance from the camera to the corners of the near plane. Volumes closer than that can be clipped by it
+    glm::vec3 cameraPosition = camera.ExtractTranslation();
+    float nearPlaneRadius = 0.0f;
+    for (glm::vec2 corner : { glm::vec2(-1, -1), glm::vec2(1, -1), glm::vec2(-1, 1), glm::vec2(1, 1) })
+    {
+        glm::vec4 position = fullscreenMatrix * glm::vec4(corner, -1.0f, 1.0f);
+        nearPlaneRadius = std::max(nearPlaneRadius, glm::distance(glm::vec3(position) / position.w, cameraPosition));
+    }
+
+    bool wasCullFaceEnabled = device.IsFeatureEnabled(GL_CULL_FACE);
+
     bool first = true;
     unsigned int lightIndex = 0;
     const auto& lights = renderer.GetLights();
@@ -41,21 +85,217 @@ void DeferredRenderPass::Render()
         const Mesh* mesh = &renderer.GetFullscreenMesh();
         glm::mat4 worldMatrix = fullscreenMatrix;
 
-        // TODO: select different meshes depending on the type
+        // The first pass also adds the indirect light, so it must cover all the pixels
+        bool lightVolume = false;
+        bool cameraInVolume = false;
+        if (!first && m_lightVolumesEnabled)
+        {
+            glm::vec3 center;
+            float radius;
+            if (light->GetBoundingSphere(center, radius) && !Bounds::Intersects(frustum, SphereBounds(center, radius)))
+            {
+                // Light is not visible, nothing to do
+                continue;
+            }
+            SphereBounds volumeBounds(center, radius);
+            lightVolume = GetLightVolume(*light, mesh, worldMatrix, volumeBounds);
+            cameraInVolume = glm::distance(cameraPosition, volumeBounds.GetCenter()) < volumeBounds.GetRadius() + nearPlaneRadius;
+        }
 
         // Set the render states for the first and additional lights
         renderer.SetLightingRenderStates(first);
 
-        renderer.UpdateTransforms(shaderProgram, fullscreenMatrix, first);
+        // With the camera outside, the front faces are drawn with GL_LEQUAL: the pixels in front of the volume are skipped
+        // With the camera inside, the front faces are behind it or clipped by the near plane, so the back faces are drawn
+        // with GL_GEQUAL instead: the pixels behind the volume are skipped
+        // Depth clamp keeps the back faces beyond the far plane, that would be clipped otherwise
+        device.SetFeatureEnabled(GL_CULL_FACE, lightVolume || wasCullFaceEnabled);
+        device.SetCullFace(lightVolume && cameraInVolume ? GL_FRONT : GL_BACK);
+        device.SetFeatureEnabled(GL_DEPTH_CLAMP, lightVolume && cameraInVolume);
+        if (lightVolume)
+        {
+            device.SetDepthFunction(cameraInVolume ? GL_GEQUAL : GL_LEQUAL);
+        }
+
+        renderer.UpdateTransforms(shaderProgram, worldMatrix, first);
         mesh->DrawSubmesh(0);
         first = false;
     }
 
-    //TODO: temp hack
-    renderer.GetDevice().EnableFeature(GL_DEPTH_TEST);
+    device.SetFeatureEnabled(GL_CULL_FACE, wasCullFaceEnabled);
+    device.SetCullFace(GL_BACK);
+    device.DisableFeature(GL_DEPTH_CLAMP);
+}
+
+void DeferredRenderPass::RenderTiledLights(const Camera& camera)
+{
+    Renderer& renderer = GetRenderer();
+    std::shared_ptr<const ShaderProgram> shaderProgram = m_material->GetShaderProgram();
+
+    UpdateLightTiles(camera, renderer.GetLights());
+
+    // Only the indirect light goes in the uniforms, the shader gets the other lights from the tiles
+    unsigned int lightIndex = 0;
+    renderer.UpdateLights(shaderProgram, std::span<const Light* const>(), lightIndex);
+    renderer.SetLightingRenderStates(true);
+
+    glm::mat4 fullscreenMatrix = glm::inverse(camera.GetViewProjectionMatrix());
+    renderer.UpdateTransforms(shaderProgram, fullscreenMatrix, true);
+    renderer.GetFullscreenMesh().DrawSubmesh(0);
+}
+
+void DeferredRenderPass::UpdateLightTiles(const Camera& camera, std::span<const Light* const> lights)
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    m_lightTileGrid.Build(camera, lights, viewport[2], viewport[3]);
+
+    // At least one light, empty buffers can't be bound
+    m_lightArrayData.resize(std::max<size_t>(lights.size(), 1));
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        m_lightArrayData[i] = lights[i]->GetPackedData();
+    }
+    m_lightArrayBuffer.Bind();
+    m_lightArrayBuffer.AllocateData<Light::PackedData>(m_lightArrayData);
+    m_lightArrayBuffer.BindBase(LightArrayBinding);
+
+    // Grid info, followed by the tile data
+    glm::uvec4 gridInfo = m_lightTileGrid.GetGridInfo();
+    std::span<const unsigned int> tileData = m_lightTileGrid.GetData();
+    m_lightTileBuffer.Bind();
+    m_lightTileBuffer.AllocateData(sizeof(gridInfo) + tileData.size_bytes());
+    m_lightTileBuffer.UpdateData(Data::GetBytes(gridInfo));
+    m_lightTileBuffer.UpdateData(tileData, sizeof(gridInfo));
+    m_lightTileBuffer.BindBase(LightTileBinding);
+}
+
+bool DeferredRenderPass::GetLightVolume(const Light& light, const Mesh*& mesh, glm::mat4& worldMatrix, SphereBounds& volumeBounds) const
+{
+    glm::vec3 center;
+    float radius;
+    if (!light.GetBoundingSphere(center, radius))
+    {
+        return false;
+    }
+
+    // Cones wider than this are too flat, and the sphere is a better fit
+    const float maxConeAngle = glm::radians(70.0f);
+
+    if (light.GetType() == Light::Type::Spot && static_cast<const SpotLight&>(light).GetAngle() < maxConeAngle)
+    {
+        const SpotLight& spotLight = static_cast<const SpotLight&>(light);
+        float range = spotLight.GetDistanceAttenuation().y;
+        float baseRadius = range * std::tan(spotLight.GetAngle());
+
+        // Rotate z to the direction of the light, with any perpendicular axes
+        glm::vec3 axisZ = spotLight.GetDirection();
+        glm::vec3 up = std::abs(axisZ.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 axisX = glm::normalize(glm::cross(up, axisZ));
+        glm::vec3 axisY = glm::cross(axisZ, axisX);
+
+        mesh = &m_coneMesh;
+        worldMatrix = glm::mat4(
+            glm::vec4(axisX * baseRadius, 0.0f),
+            glm::vec4(axisY * baseRadius, 0.0f),
+            glm::vec4(axisZ * range, 0.0f),
+            glm::vec4(spotLight.GetPosition(), 1.0f));
+
+        // Around the middle of the axis, reaching the apex and the pushed out base
+        volumeBounds = SphereBounds(spotLight.GetPosition() + 0.5f * range * axisZ,
+            glm::length(glm::vec2(0.5f * range, baseRadius * s_meshScale)));
+    }
+    else
+    {
+        mesh = &m_sphereMesh;
+        worldMatrix = glm::translate(center) * glm::scale(glm::vec3(radius));
+        volumeBounds = SphereBounds(center, radius * s_meshScale);
+    }
+    return true;
 }
 
 void DeferredRenderPass::InitializeMeshes()
 {
-    //TODO: Create meshes for spot and point lights
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+
+    // Sphere with rings of segments. The vertices are pushed out, so the flat faces contain the whole unit sphere
+    {
+        const unsigned int segmentCount = 16;
+        const unsigned int ringCount = 8;
+        const float scale = 1.0f / (std::cos(glm::pi<float>() / segmentCount) * std::cos(glm::half_pi<float>() / ringCount));
+
+        std::vector<glm::vec3> vertices;
+        for (unsigned int ring = 0; ring <= ringCount; ++ring)
+        {
+            float theta = glm::pi<float>() * ring / ringCount;
+            for (unsigned int segment = 0; segment < segmentCount; ++segment)
+            {
+                float phi = glm::two_pi<float>() * segment / segmentCount;
+                vertices.emplace_back(scale * std::sin(theta) * std::cos(phi), scale * std::cos(theta), scale * std::sin(theta) * std::sin(phi));
+            }
+        }
+
+        // Counter-clockwise seen from outside. Triangles at the poles are degenerate, that is fine
+        std::vector<unsigned short> indices;
+        for (unsigned int ring = 0; ring < ringCount; ++ring)
+        {
+            for (unsigned int segment = 0; segment < segmentCount; ++segment)
+            {
+                unsigned short a = ring * segmentCount + segment;
+                unsigned short b = ring * segmentCount + (segment + 1) % segmentCount;
+                unsigned short c = a + segmentCount;
+                unsigned short d = b + segmentCount;
+                indices.insert(indices.end(), { a, b, c, b, d, c });
+            }
+        }
+
+        m_sphereMesh.AddSubmesh<glm::vec3, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles,
+            vertices, indices, vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
+    }
+
+    // Cone with the apex at the origin, closed at z = 1. The base is pushed out too, to contain the unit circle
+    {
+        const unsigned int segmentCount = 16;
+        const float scale = 1.0f / std::cos(glm::pi<float>() / segmentCount);
+
+        std::vector<glm::vec3> vertices;
+        vertices.emplace_back(0.0f, 0.0f, 0.0f);
+        vertices.emplace_back(0.0f, 0.0f, 1.0f);
+        for (unsigned int segment = 0; segment < segmentCount; ++segment)
+        {
+            float phi = glm::two_pi<float>() * segment / segmentCount;
+            vertices.emplace_back(scale * std::cos(phi), scale * std::sin(phi), 1.0f);
+        }
+
+        std::vector<unsigned short> indices;
+        for (unsigned int segment = 0; segment < segmentCount; ++segment)
+        {
+            unsigned short a = 2 + segment;
+            unsigned short b = 2 + (segment + 1) % segmentCount;
+            indices.insert(indices.end(), { 0, b, a, 1, a, b });
+        }
+
+        m_coneMesh.AddSubmesh<glm::vec3, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles,
+            vertices, indices, vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
+    }
+}
+
+void DeferredRenderPass::InitializeTiledLighting()
+{
+    // Storage blocks need OpenGL 4.3
+    std::shared_ptr<const ShaderProgram> shaderProgram = m_material ? m_material->GetShaderProgram() : nullptr;
+    if (!shaderProgram || !DeviceGL::GetInstance().IsMultiDrawIndirectSupported())
+        return;
+
+    GLuint lightArrayBlockIndex = shaderProgram->GetShaderStorageBlockIndex("LightArrayBlock");
+    GLuint lightTileBlockIndex = shaderProgram->GetShaderStorageBlockIndex("LightTileBlock");
+    if (lightArrayBlockIndex != GL_INVALID_INDEX && lightTileBlockIndex != GL_INVALID_INDEX)
+    {
+        shaderProgram->SetShaderStorageBlockBinding(lightArrayBlockIndex, LightArrayBinding);
+        shaderProgram->SetShaderStorageBlockBinding(lightTileBlockIndex, LightTileBinding);
+        m_tiledLightingSupported = true;
+    }
 }
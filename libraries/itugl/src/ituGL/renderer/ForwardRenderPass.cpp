@@ -21,15 +21,27 @@ void ForwardRenderPass::Render()
 
     const Camera& camera = renderer.GetCurrentCamera();
     const auto& lights = renderer.GetLights();
+    // Group the drawcalls with the same state, for fewer state changes and larger batches
+    renderer.SortDrawcallCollection(m_drawcallCollectionIndex, Renderer::DrawcallSortOrder::State);
     const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
 
-    // for all drawcalls
-    for (const Renderer::DrawcallInfo& drawcallInfo : drawcallCollection)
+    // for all drawcall batches. Without multi draw indirect, each batch is a single drawcall
+    for (const Renderer::DrawcallBatch& drawcallBatch : renderer.BatchDrawcalls(drawcallCollection))
     {
         // Prepare drawcall states
-        renderer.PrepareDrawcall(drawcallInfo);
+        renderer.PrepareDrawcallBatch(drawcallBatch);
 
-        std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+        std::shared_ptr<const ShaderProgram> shaderProgram = drawcallBatch.GetFirstDrawcall().GetMaterial().GetShaderProgram();
+
+        // Programs with the light block get all the lights at once, only the indirect light goes in the uniforms
+        if (renderer.HasLightBlock(*shaderProgram))
+        {
+            unsigned int lightIndex = 0;
+            renderer.UpdateLights(shaderProgram, std::span<const Light* const>(), lightIndex);
+            renderer.SetLightingRenderStates(true);
+            renderer.DrawBatch(drawcallBatch);
+            continue;
+        }
 
         //for all lights
         bool first = true;
@@ -40,7 +52,7 @@ void ForwardRenderPass::Render()
             renderer.SetLightingRenderStates(first);
 
             // Draw
-            drawcallInfo.GetDrawcall().Draw();
+            renderer.DrawBatch(drawcallBatch);
 
             first = false;
         }
@@ -0,0 +1,424 @@
+#include <ituGL/renderer/FrameGraph.h>
+
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <ituGL/utils/Profiler.h>
+#include <algorithm>
+#include <cassert>
+
+FrameGraph::Builder::Builder(FrameGraph& frameGraph, unsigned int passIndex)
+    : m_frameGraph(frameGraph)
+    , m_passIndex(passIndex)
+{
+}
+
+FrameGraph::ResourceId FrameGraph::Builder::Create(const char* name, const TextureDesc& desc)
+{
+    assert(desc.IsValid());
+    assert(m_frameGraph.FindResource(name) == InvalidResource);
+    m_frameGraph.AddResource(name, desc, nullptr);
+    return Write(name);
+}
+
+FrameGraph::ResourceId FrameGraph::Builder::Import(const char* name, std::shared_ptr<Texture2DObject> texture, const TextureDesc& desc)
+{
+    assert(texture);
+    assert(m_frameGraph.FindResource(name) == InvalidResource);
+    m_frameGraph.AddResource(name, desc, texture);
+    return Write(name);
+}
+
+FrameGraph::ResourceId FrameGraph::Builder::Read(const char* name)
+{
+    ResourceId resourceId = m_frameGraph.FindResource(name);
+    assert(resourceId != InvalidResource);
+    if (resourceId != InvalidResource)
+    {
+        m_frameGraph.m_passes[m_passIndex].reads.push_back(resourceId);
+        ++m_frameGraph.m_resources[resourceId].readCount;
+    }
+    return resourceId;
+}
+
+FrameGraph::ResourceId FrameGraph::Builder::Write(const char* name)
+{
+    ResourceId resourceId = m_frameGraph.FindResource(name);
+    assert(resourceId != InvalidResource);
+    if (resourceId != InvalidResource)
+    {
+        Resource& resource = m_frameGraph.m_resources[resourceId];
+        m_frameGraph.m_passes[m_passIndex].writes.push_back(resourceId);
+        resource.writers.push_back(m_passIndex);
+
+        // Imported textures can be used after the frame, the graph can't know
+        if (resource.imported)
+        {
+            SetSideEffect();
+        }
+    }
+    return resourceId;
+}
+
+void FrameGraph::Builder::SetSideEffect()
+{
+    m_frameGraph.m_passes[m_passIndex].sideEffect = true;
+}
+
+FrameGraph::FrameGraph() : m_frame(0)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+}
+
+void FrameGraph::Reset()
+{
+    m_passes.clear();
+    m_resources.clear();
+}
+
+FrameGraph::Builder FrameGraph::AddPass(const char* name)
+{
+    unsigned int passIndex = static_cast<unsigned int>(m_passes.size());
+    Pass& pass = m_passes.emplace_back();
+    pass.name = name;
+    return Builder(*this, passIndex);
+}
+
+void FrameGraph::Compile()
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    ++m_frame;
+    m_stats = Stats();
+    m_stats.passCount = GetPassCount();
+
+    CullPasses();
+    AssignTextures();
+    RemoveUnusedTextures();
+}
+
+bool FrameGraph::IsPassCulled(unsigned int passIndex) const
+{
+    assert(passIndex < m_passes.size());
+    return m_passes[passIndex].culled;
+}
+
+FrameGraph::ResourceId FrameGraph::FindResource(const char* name) const
+{
+    for (size_t i = 0; i < m_resources.size(); ++i)
+    {
+        if (m_resources[i].name == name)
+        {
+            return static_cast<ResourceId>(i);
+        }
+    }
+    return InvalidResource;
+}
+
+std::shared_ptr<Texture2DObject> FrameGraph::GetTexture(ResourceId resourceId) const
+{
+    return resourceId >= 0 && resourceId < static_cast<ResourceId>(m_resources.size()) ? m_resources[resourceId].texture : nullptr;
+}
+
+std::shared_ptr<const FramebufferObject> FrameGraph::GetFramebuffer(unsigned int passIndex)
+{
+    assert(passIndex < m_passes.size());
+    const Pass& pass = m_passes[passIndex];
+    if (pass.writes.empty())
+    {
+        return nullptr;
+    }
+
+    // Depth first, null if there is none, then the colors
+    std::vector<const Texture2DObject*> key(1, nullptr);
+    std::vector<std::shared_ptr<Texture2DObject>> textures(1);
+    for (ResourceId resourceId : pass.writes)
+    {
+        const Resource& resource = m_resources[resourceId];
+        assert(resource.texture);
+        assert(resource.desc.format != TextureObject::FormatDepthStencil);
+        if (resource.desc.format == TextureObject::FormatDepth)
+        {
+            assert(!key[0]);
+            key[0] = resource.texture.get();
+            textures[0] = resource.texture;
+        }
+        else if (std::find(key.begin() + 1, key.end(), resource.texture.get()) == key.end())
+        {
+            key.push_back(resource.texture.get());
+            textures.push_back(resource.texture);
+        }
+    }
+
+    CachedFramebuffer& cachedFramebuffer = m_framebuffers[key];
+    std::shared_ptr<FramebufferObject>& framebuffer = cachedFramebuffer.framebuffer;
+
+    // The textures it was created with were deleted, and the new ones got their addresses
+    if (framebuffer && cachedFramebuffer.IsExpired())
+    {
+        framebuffer.reset();
+    }
+
+    if (!framebuffer)
+    {
+        framebuffer = std::make_shared<FramebufferObject>();
+        framebuffer->Bind();
+
+        if (textures[0])
+        {
+            framebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *textures[0]);
+        }
+
+        assert(textures.size() <= 9);
+        std::vector<FramebufferObject::Attachment> drawBuffers;
+        for (size_t i = 1; i < textures.size(); ++i)
+        {
+            FramebufferObject::Attachment attachment = static_cast<FramebufferObject::Attachment>(
+                static_cast<GLenum>(FramebufferObject::Attachment::Color0) + drawBuffers.size());
+            framebuffer->SetTexture(FramebufferObject::Target::Draw, attachment, *textures[i]);
+            drawBuffers.push_back(attachment);
+        }
+        framebuffer->SetDrawBuffers(drawBuffers);
+
+        FramebufferObject::Unbind();
+
+        cachedFramebuffer.textures.clear();
+        for (const std::shared_ptr<Texture2DObject>& texture : textures)
+        {
+            if (texture)
+            {
+                cachedFramebuffer.textures.push_back(texture);
+            }
+        }
+    }
+    return framebuffer;
+}
+
+size_t FrameGraph::GetTexelSize(TextureObject::InternalFormat internalFormat)
+{
+    switch (internalFormat)
+    {
+    case TextureObject::InternalFormatR8:
+    case TextureObject::InternalFormatR8SNorm:
+        return 1;
+    case TextureObject::InternalFormatRG8:
+    case TextureObject::InternalFormatRG8SNorm:
+    case TextureObject::InternalFormatR16:
+    case TextureObject::InternalFormatR16SNorm:
+    case TextureObject::InternalFormatR16F:
+    case TextureObject::InternalFormatDepth16:
+        return 2;
+    case TextureObject::InternalFormatRGB8:
+    case TextureObject::InternalFormatRGB8SNorm:
+    case TextureObject::InternalFormatSRGB8:
+    case TextureObject::InternalFormatDepth24:
+        return 3;
+    case TextureObject::InternalFormatRGB16:
+    case TextureObject::InternalFormatRGB16SNorm:
+    case TextureObject::InternalFormatRGB16F:
+        return 6;
+    case TextureObject::InternalFormatRGBA16:
+    case TextureObject::InternalFormatRGBA16SNorm:
+    case TextureObject::InternalFormatRGBA16F:
+    case TextureObject::InternalFormatRG32F:
+        return 8;
+    case TextureObject::InternalFormatRGB32F:
+        return 12;
+    case TextureObject::InternalFormatRGBA32F:
+        return 16;
+    default:
+        // 4 bytes is the most common case, like RGBA8 or depth 32
+        return 4;
+    }
+}
+
+FrameGraph::ResourceId FrameGraph::AddResource(const char* name, const TextureDesc& desc, std::shared_ptr<Texture2DObject> texture)
+{
+    ResourceId resourceId = static_cast<ResourceId>(m_resources.size());
+    Resource& resource = m_resources.emplace_back();
+    resource.name = name;
+    resource.desc = desc;
+    resource.texture = texture;
+    resource.imported = texture != nullptr;
+    return resourceId;
+}
+
+void FrameGraph::CullPasses()
+{
+    // Passes are referenced by the resources they write, and resources by the passes that read them
+    // Starting from the resources nobody reads, remove the references of their writers. The writers that end up without
+    // references are culled, and their reads removed too
+    std::vector<unsigned int> passRefCounts(m_passes.size());
+    for (size_t i = 0; i < m_passes.size(); ++i)
+    {
+        passRefCounts[i] = static_cast<unsigned int>(m_passes[i].writes.size());
+    }
+
+    std::vector<unsigned int> resourceRefCounts(m_resources.size());
+    std::vector<ResourceId> unreferenced;
+    for (size_t i = 0; i < m_resources.size(); ++i)
+    {
+        resourceRefCounts[i] = m_resources[i].readCount;
+        if (resourceRefCounts[i] == 0)
+        {
+            unreferenced.push_back(static_cast<ResourceId>(i));
+        }
+    }
+
+    while (!unreferenced.empty())
+    {
+        ResourceId resourceId = unreferenced.back();
+        unreferenced.pop_back();
+
+        for (unsigned int passIndex : m_resources[resourceId].writers)
+        {
+            Pass& pass = m_passes[passIndex];
+            assert(passRefCounts[passIndex] > 0);
+            if (--passRefCounts[passIndex] == 0 && !pass.sideEffect)
+            {
+                pass.culled = true;
+                ++m_stats.culledPassCount;
+                for (ResourceId readId : pass.reads)
+                {
+                    if (--resourceRefCounts[readId] == 0)
+                    {
+                        unreferenced.push_back(readId);
+                    }
+                }
+            }
+        }
+    }
+
+    // Passes without writes nor side effects don't do anything
+    for (Pass& pass : m_passes)
+    {
+        if (pass.writes.empty() && !pass.sideEffect && !pass.culled)
+        {
+            pass.culled = true;
+            ++m_stats.culledPassCount;
+        }
+    }
+}
+
+void FrameGraph::AssignTextures()
+{
+    // Lifetimes of the resources, only in the passes that will run
+    for (unsigned int passIndex = 0; passIndex < m_passes.size(); ++passIndex)
+    {
+        const Pass& pass = m_passes[passIndex];
+        if (pass.culled)
+            continue;
+
+        for (const std::vector<ResourceId>* resourceIds : { &pass.reads, &pass.writes })
+        {
+            for (ResourceId resourceId : *resourceIds)
+            {
+                Resource& resource = m_resources[resourceId];
+                if (resource.firstPass < 0)
+                {
+                    resource.firstPass = passIndex;
+                }
+                resource.lastPass = passIndex;
+            }
+        }
+    }
+
+    // Acquire the textures before the first pass, and release them after the last one, so the next passes can reuse them
+    for (unsigned int passIndex = 0; passIndex < m_passes.size(); ++passIndex)
+    {
+        for (Resource& resource : m_resources)
+        {
+            if (!resource.imported && resource.firstPass == static_cast<int>(passIndex))
+            {
+                resource.texture = AcquireTexture(resource.desc);
+                ++m_stats.transientCount;
+                m_stats.transientBytes += GetTexelSize(resource.desc.internalFormat) * resource.desc.width * resource.desc.height;
+            }
+        }
+        for (Resource& resource : m_resources)
+        {
+            if (!resource.imported && resource.lastPass == static_cast<int>(passIndex))
+            {
+                ReleaseTexture(resource.texture);
+            }
+        }
+    }
+
+    for (const PooledTexture& pooledTexture : m_texturePool)
+    {
+        if (pooledTexture.lastFrame == m_frame)
+        {
+            ++m_stats.textureCount;
+            m_stats.textureBytes += GetTexelSize(pooledTexture.desc.internalFormat) * pooledTexture.desc.width * pooledTexture.desc.height;
+        }
+    }
+}
+
+std::shared_ptr<Texture2DObject> FrameGraph::AcquireTexture(const TextureDesc& desc)
+{
+    for (PooledTexture& pooledTexture : m_texturePool)
+    {
+        if (!pooledTexture.inUse && pooledTexture.desc == desc)
+        {
+            pooledTexture.inUse = true;
+            pooledTexture.lastFrame = m_frame;
+            return pooledTexture.texture;
+        }
+    }
+
+    std::shared_ptr<Texture2DObject> texture = std::make_shared<Texture2DObject>();
+    texture->Bind();
+    texture->SetImage(0, desc.width, desc.height, desc.format, desc.internalFormat);
+    texture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    texture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+    Texture2DObject::Unbind();
+
+    PooledTexture& pooledTexture = m_texturePool.emplace_back();
+    pooledTexture.texture = texture;
+    pooledTexture.desc = desc;
+    pooledTexture.lastFrame = m_frame;
+    pooledTexture.inUse = true;
+    return texture;
+}
+
+void FrameGraph::ReleaseTexture(const std::shared_ptr<Texture2DObject>& texture)
+{
+    for (PooledTexture& pooledTexture : m_texturePool)
+    {
+        if (pooledTexture.texture == texture)
+        {
+            assert(pooledTexture.inUse);
+            pooledTexture.inUse = false;
+            return;
+        }
+    }
+    assert(false);
+}
+
+void FrameGraph::RemoveUnusedTextures()
+{
+    std::erase_if(m_texturePool, [&](const PooledTexture& pooledTexture)
+        {
+            return pooledTexture.lastFrame + s_maxUnusedFrames < m_frame;
+        });
+
+    // The framebuffers with deleted textures can't be used anymore, pooled or imported
+    std::erase_if(m_framebuffers, [](const auto& entry)
+        {
+            return entry.second.IsExpired();
+        });
+}
+
+bool FrameGraph::CachedFramebuffer::IsExpired() const
+{
+    for (const std::weak_ptr<Texture2DObject>& texture : textures)
+    {
+        if (texture.expired())
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -6,12 +6,91 @@
 #include <ituGL/renderer/Renderer.h>
 #include <ituGL/texture/Texture2DObject.h>
 #include <ituGL/texture/FramebufferObject.h>
+#include <array>
 
-GBufferRenderPass::GBufferRenderPass(int width, int height, int drawcallCollectionIndex)
+GBufferRenderPass::GBufferRenderPass(int width, int height, int drawcallCollectionIndex, bool transientTargets, Layout layout)
     : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_layout(layout)
 {
-    InitTextures(width, height);
-    InitFramebuffer();
+    if (!transientTargets)
+    {
+        InitTextures(width, height);
+        InitFramebuffer();
+    }
+    InitTextureOutputs(width, height, transientTargets);
+}
+
+const char* GBufferRenderPass::GetLayoutDefines(Layout layout)
+{
+    return layout == Layout::Compact ? "#define GBUFFER_COMPACT 1\n" : "";
+}
+
+size_t GBufferRenderPass::GetBytesPerPixel(Layout layout)
+{
+    size_t bytes = 0;
+    for (const FrameGraph::TextureDesc& desc : { GetDepthDesc(1, 1), GetAlbedoDesc(1, 1), GetNormalDesc(1, 1, layout), GetOthersDesc(1, 1, layout) })
+    {
+        if (desc.IsValid())
+        {
+            bytes += FrameGraph::GetTexelSize(desc.internalFormat);
+        }
+    }
+    return bytes;
+}
+
+FrameGraph::TextureDesc GBufferRenderPass::GetDepthDesc(int width, int height)
+{
+    return FrameGraph::TextureDesc{ width, height, TextureObject::FormatDepth, TextureObject::InternalFormatDepth };
+}
+
+FrameGraph::TextureDesc GBufferRenderPass::GetAlbedoDesc(int width, int height)
+{
+    // Alpha is always linear, so the ambient occlusion of the compact layout keeps its precision
+    return FrameGraph::TextureDesc{ width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatSRGBA8 };
+}
+
+FrameGraph::TextureDesc GBufferRenderPass::GetNormalDesc(int width, int height, Layout layout)
+{
+    return layout == Layout::Compact
+        ? FrameGraph::TextureDesc{ width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8 }
+        : FrameGraph::TextureDesc{ width, height, TextureObject::FormatRG, TextureObject::InternalFormatRG16F };
+}
+
+FrameGraph::TextureDesc GBufferRenderPass::GetOthersDesc(int width, int height, Layout layout)
+{
+    return layout == Layout::Compact
+        ? FrameGraph::TextureDesc()
+        : FrameGraph::TextureDesc{ width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatSRGBA8 };
+}
+
+void GBufferRenderPass::InitTextureOutputs(int width, int height, bool transientTargets)
+{
+    // The depth goes in the depth attachment, and the others in color 0, 1 and 2, in this order
+    const FrameGraph::TextureDesc depthDesc = GetDepthDesc(width, height);
+    const FrameGraph::TextureDesc albedoDesc = GetAlbedoDesc(width, height);
+    const FrameGraph::TextureDesc normalDesc = GetNormalDesc(width, height, m_layout);
+    const FrameGraph::TextureDesc othersDesc = GetOthersDesc(width, height, m_layout);
+
+    if (transientTargets)
+    {
+        AddTextureOutput(DepthResourceName, depthDesc);
+        AddTextureOutput(AlbedoResourceName, albedoDesc);
+        AddTextureOutput(NormalResourceName, normalDesc);
+        if (othersDesc.IsValid())
+        {
+            AddTextureOutput(OthersResourceName, othersDesc);
+        }
+    }
+    else
+    {
+        AddTextureOutput(DepthResourceName, m_depthTexture, depthDesc);
+        AddTextureOutput(AlbedoResourceName, m_albedoTexture, albedoDesc);
+        AddTextureOutput(NormalResourceName, m_normalTexture, normalDesc);
+        if (m_othersTexture)
+        {
+            AddTextureOutput(OthersResourceName, m_othersTexture, othersDesc);
+        }
+    }
 }
 
 void GBufferRenderPass::InitFramebuffer()
@@ -28,16 +107,20 @@ void GBufferRenderPass::InitFramebuffer()
     // Set the normal texture as color attachment 1
     targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color1, *m_normalTexture);
 
-    // Set the others texture as color attachment 2
-    targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color2, *m_othersTexture);
+    // Set the others texture as color attachment 2, if the layout has it
+    if (m_othersTexture)
+    {
+        targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color2, *m_othersTexture);
+    }
 
     // Set the draw buffers used by the framebuffer (all attachments except depth)
-    targetFramebuffer->SetDrawBuffers(std::array<FramebufferObject::Attachment, 3>(
+    std::array<FramebufferObject::Attachment, 3> drawBuffers(
         {
             FramebufferObject::Attachment::Color0,
             FramebufferObject::Attachment::Color1,
             FramebufferObject::Attachment::Color2
-        }));
+        });
+    targetFramebuffer->SetDrawBuffers(std::span(drawBuffers).first(m_othersTexture ? 3 : 2));
 
     m_targetFramebuffer = targetFramebuffer;
 
@@ -46,43 +129,38 @@ void GBufferRenderPass::InitFramebuffer()
 
 void GBufferRenderPass::InitTextures(int width, int height)
 {
-    // Depth: Set the min and magfilter as nearest
-    m_depthTexture = std::make_shared<Texture2DObject>();
-    m_depthTexture->Bind();
-    m_depthTexture->SetImage(0, width, height, TextureObject::FormatDepth, TextureObject::InternalFormatDepth);
-    m_depthTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
-    m_depthTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
-
-    // Albedo: Bind the newly created texture, set the image, and the min and magfilter as nearest
-    m_albedoTexture = std::make_shared<Texture2DObject>();
-    m_albedoTexture->Bind();
-    m_albedoTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatSRGBA8);
-    m_albedoTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
-    m_albedoTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
-
-    // Normal: Bind the newly created texture, set the image and the min and magfilter as nearest
-    m_normalTexture = std::make_shared<Texture2DObject>();
-    m_normalTexture->Bind();
-    m_normalTexture->SetImage(0, width, height, TextureObject::FormatRG, TextureObject::InternalFormatRG16F);
-    m_normalTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
-    m_normalTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
-
-    // Others: Bind the newly created texture, set the image and the min and magfilter as nearest
-    m_othersTexture = std::make_shared<Texture2DObject>();
-    m_othersTexture->Bind();
-    m_othersTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatSRGBA8);
-    m_othersTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
-    m_othersTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+    // All the textures use nearest filtering, each pixel is read on its own
+    m_depthTexture = CreateTexture(GetDepthDesc(width, height));
+    m_albedoTexture = CreateTexture(GetAlbedoDesc(width, height));
+    m_normalTexture = CreateTexture(GetNormalDesc(width, height, m_layout));
+
+    FrameGraph::TextureDesc othersDesc = GetOthersDesc(width, height, m_layout);
+    if (othersDesc.IsValid())
+    {
+        m_othersTexture = CreateTexture(othersDesc);
+    }
 
     Texture2DObject::Unbind();
 }
 
+std::shared_ptr<Texture2DObject> GBufferRenderPass::CreateTexture(const FrameGraph::TextureDesc& desc)
+{
+    std::shared_ptr<Texture2DObject> texture = std::make_shared<Texture2DObject>();
+    texture->Bind();
+    texture->SetImage(0, desc.width, desc.height, desc.format, desc.internalFormat);
+    texture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    texture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+    return texture;
+}
+
 void GBufferRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
 
     const Camera& camera = renderer.GetCurrentCamera();
     const auto& lights = renderer.GetLights();
+    // Group the drawcalls with the same state, for fewer state changes and larger batches
+    renderer.SortDrawcallCollection(m_drawcallCollectionIndex, Renderer::DrawcallSortOrder::State);
     const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
 
     renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
@@ -90,19 +168,19 @@ void GBufferRenderPass::Render()
     bool wasSRGB = renderer.GetDevice().IsFeatureEnabled(GL_FRAMEBUFFER_SRGB);
     renderer.GetDevice().EnableFeature(GL_FRAMEBUFFER_SRGB);
 
-    // for all drawcalls
-    for (const Renderer::DrawcallInfo& drawcallInfo : drawcallCollection)
+    // for all drawcall batches
+    for (const Renderer::DrawcallBatch& drawcallBatch : renderer.BatchDrawcalls(drawcallCollection))
     {
-        const Material& material = drawcallInfo.GetMaterial();
+        const Material& material = drawcallBatch.GetFirstDrawcall().GetMaterial();
         assert(material.GetBlendEquationColor() == Material::BlendEquation::None);
         assert(material.GetBlendEquationAlpha() == Material::BlendEquation::None);
         assert(material.GetDepthWrite());
 
-        // Prepare drawcall (similar to forward)
-        renderer.PrepareDrawcall(drawcallInfo);
+        // Prepare drawcall batch (similar to forward)
+        renderer.PrepareDrawcallBatch(drawcallBatch);
 
-        // Render drawcall
-        drawcallInfo.GetDrawcall().Draw();
+        // Render drawcall batch
+        renderer.DrawBatch(drawcallBatch);
     }
 
     renderer.GetDevice().SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, wasSRGB);
@@ -14,6 +14,7 @@ void PostFXRenderPass::Render()
     Renderer& renderer = GetRenderer();
 
     assert(m_material);
+    BindTextureInputs(*m_material);
     m_material->Use();
 
     const Mesh* mesh = &renderer.GetFullscreenMesh();
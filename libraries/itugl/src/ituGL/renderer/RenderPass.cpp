@@ -1,6 +1,8 @@
 #include <ituGL/renderer/RenderPass.h>
 
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/texture/Texture2DObject.h>
 #include <cassert>
 
 RenderPass::RenderPass(std::shared_ptr<const FramebufferObject> targetFramebuffer)
@@ -18,6 +20,68 @@ std::shared_ptr<const FramebufferObject> RenderPass::GetTargetFramebuffer() cons
     return m_targetFramebuffer;
 }
 
+void RenderPass::DeclareResources(FrameGraph::Builder& builder)
+{
+    for (const TextureInput& input : m_textureInputs)
+    {
+        builder.Read(input.resourceName.c_str());
+    }
+
+    for (const TextureOutput& output : m_textureOutputs)
+    {
+        if (output.texture)
+        {
+            builder.Import(output.resourceName.c_str(), output.texture, output.desc);
+        }
+        else if (output.desc.IsValid())
+        {
+            builder.Create(output.resourceName.c_str(), output.desc);
+        }
+        else
+        {
+            builder.Write(output.resourceName.c_str());
+        }
+    }
+
+    if (m_targetFramebuffer || m_textureOutputs.empty())
+    {
+        builder.SetSideEffect();
+    }
+}
+
+void RenderPass::AddTextureInput(const char* resourceName, const char* uniformName)
+{
+    m_textureInputs.push_back({ resourceName, uniformName });
+}
+
+void RenderPass::AddTextureOutput(const char* resourceName, const FrameGraph::TextureDesc& desc)
+{
+    assert(desc.IsValid());
+    m_textureOutputs.push_back({ resourceName, desc, nullptr });
+}
+
+void RenderPass::AddTextureOutput(const char* resourceName)
+{
+    m_textureOutputs.push_back({ resourceName, FrameGraph::TextureDesc(), nullptr });
+}
+
+void RenderPass::AddTextureOutput(const char* resourceName, std::shared_ptr<Texture2DObject> texture, const FrameGraph::TextureDesc& desc)
+{
+    assert(texture);
+    m_textureOutputs.push_back({ resourceName, desc, texture });
+}
+
+void RenderPass::BindTextureInputs(Material& material) const
+{
+    const FrameGraph& frameGraph = GetRenderer().GetFrameGraph();
+    for (const TextureInput& input : m_textureInputs)
+    {
+        std::shared_ptr<Texture2DObject> texture = frameGraph.GetTexture(frameGraph.FindResource(input.resourceName.c_str()));
+        assert(texture);
+        material.SetUniformValue(input.uniformName.c_str(), texture);
+    }
+}
+
 void RenderPass::SetRenderer(Renderer* renderer)
 {
     m_renderer = renderer;
@@ -9,15 +9,27 @@
 #include <ituGL/camera/Camera.h>
 #include <ituGL/texture/FramebufferObject.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/utils/Profiler.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/core/Data.h>
 #include <span>
 #include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
 #include <cassert>
 
-Renderer::DrawcallInfo::DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall)
-    : m_material(material), m_worldMatrixIndex(worldMatrixIndex), m_vao(vao), m_drawcall(drawcall)
+Renderer::DrawcallInfo::DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, VertexArrayObject& vao, const Drawcall& drawcall, uint64_t stateKey)
+    : m_material(material), m_worldMatrixIndex(worldMatrixIndex), m_vao(vao), m_drawcall(drawcall), m_stateKey(stateKey)
 {
 }
 
+Renderer::DrawcallBatch::DrawcallBatch(std::span<const DrawcallInfo> drawcallInfos, bool indirect, size_t indirectOffset)
+    : m_drawcallInfos(drawcallInfos), m_indirect(indirect), m_indirectOffset(indirectOffset)
+{
+    assert(!drawcallInfos.empty());
+}
+
 Renderer::DrawcallCollection::DrawcallCollection(const DrawcallSupportedFunction& isSupported) : m_isSupported(isSupported)
 {
 }
@@ -45,16 +57,87 @@ void Renderer::DrawcallCollection::Clear()
     m_drawcallInfos.clear();
 }
 
+void Renderer::DrawcallCollection::SortByKeys(std::span<const uint64_t> keys)
+{
+    assert(keys.size() == m_drawcallInfos.size());
+    const size_t count = keys.size();
+
+    std::vector<KeyIndex>& source = m_sortScratch[0];
+    std::vector<KeyIndex>& destination = m_sortScratch[1];
+    source.resize(count);
+    destination.resize(count);
+
+    uint64_t keysOr = 0, keysAnd = ~0ULL;
+    for (size_t i = 0; i < count; ++i)
+    {
+        source[i] = KeyIndex{ keys[i], static_cast<unsigned int>(i) };
+        keysOr |= keys[i];
+        keysAnd &= keys[i];
+    }
+
+    // LSD radix sort, one byte per pass. Bytes that are the same in all keys would not change the order, so they are skipped
+    const uint64_t differentBits = keysOr ^ keysAnd;
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        if (((differentBits >> shift) & 0xFF) == 0)
+            continue;
+
+        size_t offsets[256] = {};
+        for (const KeyIndex& keyIndex : source)
+        {
+            ++offsets[(keyIndex.key >> shift) & 0xFF];
+        }
+        size_t offset = 0;
+        for (size_t& bucketOffset : offsets)
+        {
+            size_t bucketCount = bucketOffset;
+            bucketOffset = offset;
+            offset += bucketCount;
+        }
+        for (const KeyIndex& keyIndex : source)
+        {
+            destination[offsets[(keyIndex.key >> shift) & 0xFF]++] = keyIndex;
+        }
+        source.swap(destination);
+    }
+
+    // DrawcallInfo can't be default constructed, so build the sorted list and swap
+    m_sortedDrawcallInfos.clear();
+    m_sortedDrawcallInfos.reserve(count);
+    for (const KeyIndex& keyIndex : source)
+    {
+        m_sortedDrawcallInfos.push_back(m_drawcallInfos[keyIndex.index]);
+    }
+    m_drawcallInfos.swap(m_sortedDrawcallInfos);
+}
+
 
 Renderer::Renderer(DeviceGL& device)
     : m_device(device)
     , m_currentCamera(nullptr)
+    , m_currentMaterial(nullptr)
+    , m_currentMaterialOverride(Material::NoOverride)
+    , m_currentTransformProgram(nullptr)
+    , m_currentWorldMatrixIndex(0)
     , m_defaultFramebuffer(FramebufferObject::GetDefault())
     , m_currentFramebuffer(m_defaultFramebuffer)
     , m_drawcallCollections(1)
+    , m_transformStride(0)
+    , m_drawIndexCount(0)
+    , m_multiDrawIndirectEnabled(device.IsMultiDrawIndirectSupported())
 {
     InitializeFullscreenMesh();
 
+    m_cameraBuffer.Bind();
+    m_cameraBuffer.AllocateData(sizeof(CameraBlock));
+    m_lightBuffer.Bind();
+    m_lightBuffer.AllocateData(sizeof(LightBlock));
+    UniformBufferObject::Unbind();
+
+    // Each transform block starts at an offset that can be bound with BindRange
+    size_t alignment = UniformBufferObject::GetOffsetAlignment();
+    m_transformStride = (sizeof(TransformBlock) + alignment - 1) / alignment * alignment;
+
     device.EnableFeature(GL_FRAMEBUFFER_SRGB);
     device.EnableFeature(GL_DEPTH_TEST);
     device.EnableFeature(GL_CULL_FACE);
@@ -94,6 +177,7 @@ void Renderer::SetCurrentFramebuffer(std::shared_ptr<const FramebufferObject> fr
     {
         m_currentFramebuffer = framebuffer;
         m_currentFramebuffer->Bind();
+        ++m_counters.framebufferChanges;
     }
 }
 
@@ -106,26 +190,69 @@ void Renderer::Render()
 {
     assert(m_currentCamera);
 
-    for (auto& pass : m_passes)
+    UpdateUniformBuffers();
+
+    BuildFrameGraph();
+
+    for (unsigned int passIndex = 0; passIndex < m_passes.size(); ++passIndex)
     {
-        SetCurrentFramebuffer(pass->GetTargetFramebuffer());
+        if (m_frameGraph.IsPassCulled(passIndex))
+            continue;
+
+        RenderPass* pass = m_passes[passIndex].get();
+        ITUGL_PROFILE_SCOPE(pass->GetName());
+
+        // Passes without their own framebuffer draw to the textures they write in the graph, if any
+        std::shared_ptr<const FramebufferObject> framebuffer = pass->GetTargetFramebuffer();
+        if (!framebuffer)
+        {
+            framebuffer = m_frameGraph.GetFramebuffer(passIndex);
+        }
+        SetCurrentFramebuffer(framebuffer);
+
+        // Passes can change the states directly, so each pass starts with nothing cached
+        InvalidateDrawcallState();
         pass->Render();
     }
 
     Reset();
 }
 
+void Renderer::BuildFrameGraph()
+{
+    m_frameGraph.Reset();
+    for (auto& pass : m_passes)
+    {
+        FrameGraph::Builder builder = m_frameGraph.AddPass(pass->GetName());
+        pass->DeclareResources(builder);
+    }
+    m_frameGraph.Compile();
+}
+
 void Renderer::Reset()
 {
     m_worldMatrices.clear();
+    m_worldBoundingSpheres.clear();
     m_lights.clear();
 
     for (auto& collection : m_drawcallCollections)
     {
         collection.Clear();
     }
+    m_materialSortIds.clear();
 
     m_currentCamera = nullptr;
+
+    InvalidateDrawcallState();
+
+    m_lastFrameCounters = m_counters;
+    m_counters = Counters();
+}
+
+void Renderer::InvalidateDrawcallState()
+{
+    m_currentMaterial = nullptr;
+    m_currentTransformProgram = nullptr;
 }
 
 int Renderer::AddRenderPass(std::unique_ptr<RenderPass> renderPass)
@@ -152,6 +279,187 @@ void Renderer::RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shader
     {
         m_updateLightsFunctions[shaderProgramPtr] = updateLightsFunction;
     }
+
+    // Connect the uniform blocks to the buffers of the renderer, if the program declares them
+    GLuint cameraBlockIndex = shaderProgramPtr->GetUniformBlockIndex("CameraBlock");
+    if (cameraBlockIndex != GL_INVALID_INDEX)
+    {
+        shaderProgramPtr->SetUniformBlockBinding(cameraBlockIndex, CameraBlockBinding);
+    }
+
+    GLuint transformBlockIndex = shaderProgramPtr->GetUniformBlockIndex("TransformBlock");
+    if (transformBlockIndex != GL_INVALID_INDEX)
+    {
+        shaderProgramPtr->SetUniformBlockBinding(transformBlockIndex, TransformBlockBinding);
+        m_transformBlockPrograms.insert(shaderProgramPtr.get());
+    }
+
+    GLuint lightBlockIndex = shaderProgramPtr->GetUniformBlockIndex("LightBlock");
+    if (lightBlockIndex != GL_INVALID_INDEX)
+    {
+        shaderProgramPtr->SetUniformBlockBinding(lightBlockIndex, LightBlockBinding);
+        m_lightBlockPrograms.insert(shaderProgramPtr.get());
+    }
+
+    // Storage blocks need OpenGL 4.3, like multi draw indirect
+    if (m_device.IsMultiDrawIndirectSupported())
+    {
+        GLuint transformArrayBlockIndex = shaderProgramPtr->GetShaderStorageBlockIndex("TransformArrayBlock");
+        if (transformArrayBlockIndex != GL_INVALID_INDEX)
+        {
+            shaderProgramPtr->SetShaderStorageBlockBinding(transformArrayBlockIndex, TransformArrayBinding);
+            m_transformArrayPrograms.insert(shaderProgramPtr.get());
+        }
+    }
+}
+
+Renderer::CameraBlock Renderer::GetCameraBlock(const Camera& camera)
+{
+    CameraBlock cameraBlock;
+    cameraBlock.viewMatrix = camera.GetViewMatrix();
+    cameraBlock.projMatrix = camera.GetProjectionMatrix();
+    cameraBlock.viewProjMatrix = camera.GetViewProjectionMatrix();
+    cameraBlock.cameraPosition = glm::vec4(camera.ExtractTranslation(), 1.0f);
+    return cameraBlock;
+}
+
+void Renderer::UpdateUniformBuffers()
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    if (!m_currentCamera)
+        return;
+
+    CameraBlock cameraBlock = GetCameraBlock(*m_currentCamera);
+    const glm::mat4& viewProjMatrix = cameraBlock.viewProjMatrix;
+    m_cameraBuffer.Bind();
+    m_cameraBuffer.UpdateData(Data::GetBytes(cameraBlock));
+    m_cameraBuffer.BindBase(CameraBlockBinding);
+
+    UpdateLightBlock();
+
+    // No need for the transform blocks if no program reads them
+    if (m_worldMatrices.empty() || (m_transformBlockPrograms.empty() && m_transformArrayPrograms.empty()))
+        return;
+
+    // Fill the blocks once, packed, and then copy them where each buffer needs them
+    m_transformBlocks.resize(m_worldMatrices.size());
+    for (unsigned int i = 0; i < m_worldMatrices.size(); ++i)
+    {
+        TransformBlock& transformBlock = m_transformBlocks[i];
+        transformBlock.worldMatrix = m_worldMatrices[i];
+        transformBlock.worldViewProjMatrix = viewProjMatrix * m_worldMatrices[i];
+        UpdateObjectLights(i, transformBlock.objectLightIndices, transformBlock.objectLightCount);
+    }
+
+    if (!m_transformBlockPrograms.empty())
+    {
+        m_transformData.resize(m_worldMatrices.size() * m_transformStride);
+        for (size_t i = 0; i < m_transformBlocks.size(); ++i)
+        {
+            std::memcpy(&m_transformData[i * m_transformStride], &m_transformBlocks[i], sizeof(TransformBlock));
+        }
+
+        // Allocating every frame lets the driver give new storage if the GPU still reads the previous one
+        m_transformBuffer.Bind();
+        m_transformBuffer.AllocateData(m_transformData, BufferObject::StreamDraw);
+    }
+
+    if (!m_transformArrayPrograms.empty())
+    {
+        // std430 arrays are tightly packed, so they are uploaded as they are
+        // Allocating every frame lets the driver give new storage if the GPU still reads the previous one
+        m_transformArrayBuffer.Bind();
+        m_transformArrayBuffer.AllocateData<TransformBlock>(m_transformBlocks);
+        m_transformArrayBuffer.BindBase(TransformArrayBinding);
+
+        // The indices only grow, and never change
+        if (m_worldMatrices.size() > m_drawIndexCount)
+        {
+            m_drawIndexCount = std::max(static_cast<unsigned int>(m_worldMatrices.size()), 2 * m_drawIndexCount);
+            std::vector<GLuint> drawIndices(m_drawIndexCount);
+            for (unsigned int i = 0; i < m_drawIndexCount; ++i)
+            {
+                drawIndices[i] = i;
+            }
+            m_drawIndexBuffer.Bind();
+            m_drawIndexBuffer.AllocateData<GLuint>(drawIndices);
+        }
+    }
+}
+
+void Renderer::UpdateLightBlock()
+{
+    m_lightBoundingSpheres.clear();
+    m_lightIntensities.clear();
+
+    if (m_lightBlockPrograms.empty())
+        return;
+
+    // Lights after the maximum are ignored
+    LightBlock lightBlock;
+    lightBlock.lightCount = static_cast<unsigned int>(std::min<size_t>(m_lights.size(), MaxLights));
+    for (unsigned int i = 0; i < lightBlock.lightCount; ++i)
+    {
+        const Light& light = *m_lights[i];
+        lightBlock.lights[i] = light.GetPackedData();
+
+        glm::vec3 center;
+        float radius;
+        if (!light.GetBoundingSphere(center, radius))
+        {
+            radius = -1.0f;
+        }
+        m_lightBoundingSpheres.emplace_back(center, radius);
+        const glm::vec3 color = light.GetColor();
+        m_lightIntensities.push_back(light.GetIntensity() * std::max(color.r, std::max(color.g, color.b)));
+    }
+
+    // Only the lights that are used, the rest of the array is not read
+    size_t size = offsetof(LightBlock, lights) + lightBlock.lightCount * sizeof(Light::PackedData);
+    m_lightBuffer.Bind();
+    m_lightBuffer.UpdateData(Data::GetBytes(lightBlock).first(size));
+    m_lightBuffer.BindBase(LightBlockBinding);
+}
+
+void Renderer::UpdateObjectLights(unsigned int worldMatrixIndex, int* lightIndices, int& lightCount) const
+{
+    lightCount = 0;
+
+    const glm::vec4& objectSphere = m_worldBoundingSpheres[worldMatrixIndex];
+    float scores[MaxObjectLights];
+    for (unsigned int lightIndex = 0; lightIndex < m_lightBoundingSpheres.size(); ++lightIndex)
+    {
+        // Lights without bounds reach everything. The others, only if their spheres intersect
+        const glm::vec4& lightSphere = m_lightBoundingSpheres[lightIndex];
+        float distance = 0.0f;
+        if (lightSphere.w >= 0.0f)
+        {
+            distance = glm::distance(glm::vec3(lightSphere), glm::vec3(objectSphere)) - objectSphere.w;
+            if (distance > lightSphere.w)
+                continue;
+            distance = std::max(distance, 0.0f);
+        }
+
+        // Brighter and closer lights first, keeping the list sorted by insertion
+        float score = m_lightIntensities[lightIndex] / (1.0f + distance * distance);
+        int position = lightCount;
+        while (position > 0 && scores[position - 1] < score)
+        {
+            if (position < static_cast<int>(MaxObjectLights))
+            {
+                scores[position] = scores[position - 1];
+                lightIndices[position] = lightIndices[position - 1];
+            }
+            --position;
+        }
+        if (position < static_cast<int>(MaxObjectLights))
+        {
+            scores[position] = score;
+            lightIndices[position] = static_cast<int>(lightIndex);
+            lightCount = std::min(lightCount + 1, static_cast<int>(MaxObjectLights));
+        }
+    }
 }
 
 void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, unsigned int worldMatrixIndex, bool cameraChanged) const
@@ -162,6 +470,11 @@ void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgr
 
 void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const glm::mat4& worldMatrix, bool cameraChanged) const
 {
+    ITUGL_PROFILE_SCOPE("UpdateTransforms");
+
+    // Other world matrices may be set outside of PrepareDrawcall, so it has to set its own again
+    m_currentTransformProgram = nullptr;
+
     const auto& itFind = m_updateTransformsFunctions.find(shaderProgramPtr);
     if (itFind != m_updateTransformsFunctions.end())
     {
@@ -205,6 +518,11 @@ Renderer::UpdateLightsFunction Renderer::GetDefaultUpdateLightsFunction(const Sh
     };
 }
 
+bool Renderer::HasLightBlock(const ShaderProgram& shaderProgram) const
+{
+    return m_lightBlockPrograms.contains(&shaderProgram);
+}
+
 bool Renderer::UpdateLights(std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const Light* const> lights, unsigned int& lightIndex) const
 {
     const auto& itFind = m_updateLightsFunctions.find(shaderProgramPtr);
@@ -230,16 +548,25 @@ std::span<const Renderer::DrawcallInfo> Renderer::GetDrawcalls(unsigned int coll
     return m_drawcallCollections[collectionIndex].GetDrawcalls();
 }
 
-void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix)
+void Renderer::AddModel(Model& model, const glm::mat4& worldMatrix)
 {
     unsigned int worldMatrixIndex = static_cast<unsigned int>(m_worldMatrices.size());
     m_worldMatrices.push_back(worldMatrix);
 
-    const Mesh& mesh = model.GetMesh();
+    // Sphere around the local bounds box. The radius adds the scaled half axes, so it is always large enough
+    // The bounds size of the model is already a half size
+    const glm::vec3& halfSize = model.GetLocalBoundsSize();
+    glm::vec3 center = worldMatrix * glm::vec4(model.GetLocalBoundsCenter(), 1.0f);
+    float radius = glm::length(glm::vec3(worldMatrix[0])) * halfSize.x + glm::length(glm::vec3(worldMatrix[1])) * halfSize.y
+        + glm::length(glm::vec3(worldMatrix[2])) * halfSize.z;
+    m_worldBoundingSpheres.emplace_back(center, radius);
+
+    Mesh& mesh = model.GetMesh();
     for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
     {
-        DrawcallInfo drawcallInfo(model.GetMaterial(submeshIndex), worldMatrixIndex,
-            mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex));
+        const Material& material = model.GetMaterial(submeshIndex);
+        VertexArrayObject& vao = mesh.GetSubmeshVertexArray(submeshIndex);
+        DrawcallInfo drawcallInfo(material, worldMatrixIndex, vao, mesh.GetSubmeshDrawcall(submeshIndex), ComputeStateKey(material, vao));
 
         for (DrawcallCollection& collection : m_drawcallCollections)
         {
@@ -266,6 +593,56 @@ void Renderer::SortDrawcallCollection(unsigned int index, const DrawcallSortFunc
     std::sort(drawcalls.begin(), drawcalls.end(), drawcallSortFunction);
 }
 
+void Renderer::SortDrawcallCollection(unsigned int index, DrawcallSortOrder sortOrder)
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    auto drawcalls = m_drawcallCollections[index].GetDrawcalls();
+
+    // Camera vectors only once for all the drawcalls
+    const Camera& camera = GetCurrentCamera();
+    glm::vec3 cameraPosition = camera.ExtractTranslation();
+    glm::vec3 right, up, forward;
+    camera.ExtractVectors(right, up, forward);
+
+    const uint64_t depthMask = (1ULL << SortKey::DepthBits) - 1;
+    const uint64_t layerMask = ((1ULL << SortKey::LayerBits) - 1) << SortKey::StateBits;
+    const uint64_t stateMask = (1ULL << SortKey::StateBits) - 1;
+
+    m_sortKeys.resize(drawcalls.size());
+    for (size_t i = 0; i < drawcalls.size(); ++i)
+    {
+        const DrawcallInfo& drawcallInfo = drawcalls[i];
+
+        // The bits of a positive float grow with its value, so the top bits are a quantized depth with more
+        // precision close to the camera. Objects behind the camera get 0
+        float depth = std::max(glm::dot(forward, glm::vec3(GetWorldMatrix(drawcallInfo)[3]) - cameraPosition), 0.0f);
+        uint64_t depthKey = (std::bit_cast<uint32_t>(depth) >> (32 - SortKey::DepthBits)) & depthMask;
+
+        uint64_t stateKey = drawcallInfo.GetStateKey();
+        uint64_t layer = stateKey & layerMask;
+        uint64_t state = stateKey & stateMask;
+
+        // Blended drawcalls are always sorted back to front, so they blend in the right order
+        uint64_t key = 0;
+        switch (layer ? DrawcallSortOrder::BackToFront : sortOrder)
+        {
+        case DrawcallSortOrder::State:
+            key = (layer | state) << SortKey::DepthBits | depthKey;
+            break;
+        case DrawcallSortOrder::FrontToBack:
+            key = layer << SortKey::DepthBits | depthKey << SortKey::StateBits | state;
+            break;
+        case DrawcallSortOrder::BackToFront:
+            key = layer << SortKey::DepthBits | (depthMask - depthKey) << SortKey::StateBits | state;
+            break;
+        }
+        m_sortKeys[i] = key;
+    }
+
+    m_drawcallCollections[index].SortByKeys(m_sortKeys);
+}
+
 bool Renderer::IsBackToFront(const DrawcallInfo& a, const DrawcallInfo& b) const
 {
     const Camera& camera = GetCurrentCamera();
@@ -285,19 +662,205 @@ bool Renderer::IsFrontToBack(const DrawcallInfo& a, const DrawcallInfo& b) const
 
 void Renderer::PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride)
 {
-    std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+    ITUGL_PROFILE_SCOPE("PrepareDrawcall");
 
-    // TODO: Room for optimization here, caching current material, current worldMatrixIndex and current VAO
+    const Material& material = drawcallInfo.GetMaterial();
+    std::shared_ptr<const ShaderProgram> shaderProgram = material.GetShaderProgram();
+    unsigned int worldMatrixIndex = drawcallInfo.GetWorldMatrixIndex();
+    ++m_counters.drawcalls;
 
     // Setup material
-    drawcallInfo.GetMaterial().Use(materialOverride);
+    PrepareMaterial(material, materialOverride);
 
-    // Setup world matrix
-    // Setup camera
-    UpdateTransforms(shaderProgram, drawcallInfo.GetWorldMatrixIndex());
+    // Setup world matrix and camera, unless they are already set in this shader program
+    if (shaderProgram.get() != m_currentTransformProgram || worldMatrixIndex != m_currentWorldMatrixIndex)
+    {
+        if (m_transformBlockPrograms.contains(shaderProgram.get()))
+        {
+            // Already uploaded for this frame, only bind the block of this object
+            m_transformBuffer.BindRange(TransformBlockBinding, worldMatrixIndex * m_transformStride, sizeof(TransformBlock));
+        }
+        else
+        {
+            UpdateTransforms(shaderProgram, worldMatrixIndex);
+        }
+        m_currentTransformProgram = shaderProgram.get();
+        m_currentWorldMatrixIndex = worldMatrixIndex;
+        ++m_counters.transformChanges;
+    }
+    else
+    {
+        ++m_counters.transformSkips;
+    }
+
+    // Setup VAO. DeviceGL skips it if it is already bound
+    VertexArrayObject& vao = drawcallInfo.GetVAO();
+    vao.Bind();
+
+    // Programs for multi draw indirect still need their draw index, when drawn one by one
+    if (m_transformArrayPrograms.contains(shaderProgram.get()))
+    {
+        SetDrawIndexAttribute(vao, false, worldMatrixIndex);
+    }
+}
 
-    // Setup VAO
-    drawcallInfo.GetVAO().Bind();
+void Renderer::SetMultiDrawIndirectEnabled(bool enabled)
+{
+    m_multiDrawIndirectEnabled = enabled && m_device.IsMultiDrawIndirectSupported();
+}
+
+std::span<const Renderer::DrawcallBatch> Renderer::BatchDrawcalls(std::span<const DrawcallInfo> drawcallInfos)
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    m_drawcallBatches.clear();
+    m_drawIndirectData.clear();
+
+    size_t batchStart = 0;
+    while (batchStart < drawcallInfos.size())
+    {
+        const DrawcallInfo& firstDrawcallInfo = drawcallInfos[batchStart];
+        size_t batchEnd = batchStart + 1;
+        if (!IsIndirectDrawcall(firstDrawcallInfo))
+        {
+            m_drawcallBatches.emplace_back(drawcallInfos.subspan(batchStart, 1), false, 0);
+            batchStart = batchEnd;
+            continue;
+        }
+
+        // Extend the batch while the drawcalls only differ in their range and world matrix
+        while (batchEnd < drawcallInfos.size() && CanBatch(firstDrawcallInfo, drawcallInfos[batchEnd]))
+        {
+            ++batchEnd;
+        }
+
+        // One command per drawcall, with baseInstance pointing to its world matrix
+        size_t indirectOffset = m_drawIndirectData.size();
+        for (size_t i = batchStart; i < batchEnd; ++i)
+        {
+            const Drawcall& drawcall = drawcallInfos[i].GetDrawcall();
+            GLuint count = static_cast<GLuint>(drawcall.GetCount());
+            GLuint first = static_cast<GLuint>(drawcall.GetFirst());
+            GLuint worldMatrixIndex = drawcallInfos[i].GetWorldMatrixIndex();
+
+            std::span<const std::byte> commandBytes;
+            DrawIndirectBufferObject::ArraysCommand arraysCommand{ count, 1, first, worldMatrixIndex };
+            DrawIndirectBufferObject::ElementsCommand elementsCommand{ count, 1, first, 0, worldMatrixIndex };
+            if (drawcall.GetEBOType() == Data::Type::None)
+            {
+                commandBytes = Data::GetBytes(arraysCommand);
+            }
+            else
+            {
+                commandBytes = Data::GetBytes(elementsCommand);
+            }
+            m_drawIndirectData.insert(m_drawIndirectData.end(), commandBytes.begin(), commandBytes.end());
+        }
+
+        m_drawcallBatches.emplace_back(drawcallInfos.subspan(batchStart, batchEnd - batchStart), true, indirectOffset);
+        batchStart = batchEnd;
+    }
+
+    if (!m_drawIndirectData.empty())
+    {
+        // Allocating every time lets the driver give new storage if the GPU still reads the commands of the previous pass
+        m_drawIndirectBuffer.Bind();
+        m_drawIndirectBuffer.AllocateData<std::byte>(m_drawIndirectData);
+    }
+
+    return m_drawcallBatches;
+}
+
+void Renderer::PrepareDrawcallBatch(const DrawcallBatch& drawcallBatch, Material::OverrideFlags materialOverride)
+{
+    if (!drawcallBatch.IsIndirect())
+    {
+        PrepareDrawcall(drawcallBatch.GetFirstDrawcall(), materialOverride);
+        return;
+    }
+
+    ITUGL_PROFILE_SCOPE("PrepareDrawcallBatch");
+
+    const DrawcallInfo& drawcallInfo = drawcallBatch.GetFirstDrawcall();
+    unsigned int drawcallCount = static_cast<unsigned int>(drawcallBatch.GetDrawcalls().size());
+    m_counters.drawcalls += drawcallCount;
+    m_counters.indirectDrawcalls += drawcallCount;
+    ++m_counters.indirectBatches;
+
+    PrepareMaterial(drawcallInfo.GetMaterial(), materialOverride);
+
+    // The world matrices come from the TransformArrayBlock, so the next drawcall has to set its own again
+    m_currentTransformProgram = nullptr;
+
+    VertexArrayObject& vao = drawcallInfo.GetVAO();
+    vao.Bind();
+    SetDrawIndexAttribute(vao, true, 0);
+
+    m_drawIndirectBuffer.Bind();
+}
+
+void Renderer::DrawBatch(const DrawcallBatch& drawcallBatch) const
+{
+    const Drawcall& drawcall = drawcallBatch.GetFirstDrawcall().GetDrawcall();
+    if (drawcallBatch.IsIndirect())
+    {
+        GLsizei drawCount = static_cast<GLsizei>(drawcallBatch.GetDrawcalls().size());
+        Drawcall::MultiDrawIndirect(drawcall.GetPrimitive(), drawcall.GetEBOType(), drawcallBatch.GetIndirectOffset(), drawCount);
+    }
+    else
+    {
+        drawcall.Draw();
+    }
+}
+
+void Renderer::PrepareMaterial(const Material& material, Material::OverrideFlags materialOverride)
+{
+    // If it is the same as in the last drawcall, its uniforms are still set, and only the render states
+    // need to be restored (the pass may have changed them). DeviceGL skips the ones that did not change
+    if (&material != m_currentMaterial || materialOverride != m_currentMaterialOverride)
+    {
+        material.Use(materialOverride);
+        m_currentMaterial = &material;
+        m_currentMaterialOverride = materialOverride;
+        ++m_counters.materialChanges;
+    }
+    else
+    {
+        material.UseRenderStates(materialOverride);
+        ++m_counters.materialSkips;
+    }
+}
+
+void Renderer::SetDrawIndexAttribute(VertexArrayObject& vao, bool indirect, unsigned int worldMatrixIndex)
+{
+    // The attribute is part of the VAO state, but the mesh doesn't use this location, so it is set on every batch
+    // instead of keeping track of the VAOs that have it. The mesh attributes are not changed
+    if (indirect)
+    {
+        m_drawIndexBuffer.Bind();
+        vao.SetAttribute(DrawIndexLocation, VertexAttribute(Data::Type::UInt, 1), 0);
+        vao.SetAttributeDivisor(DrawIndexLocation, 1);
+    }
+    else
+    {
+        vao.DisableAttribute(DrawIndexLocation);
+        VertexArrayObject::SetAttributeValue(DrawIndexLocation, worldMatrixIndex);
+    }
+}
+
+bool Renderer::IsIndirectDrawcall(const DrawcallInfo& drawcallInfo) const
+{
+    return m_multiDrawIndirectEnabled && m_transformArrayPrograms.contains(drawcallInfo.GetMaterial().GetShaderProgram().get());
+}
+
+bool Renderer::CanBatch(const DrawcallInfo& a, const DrawcallInfo& b)
+{
+    const Drawcall& drawcallA = a.GetDrawcall();
+    const Drawcall& drawcallB = b.GetDrawcall();
+    return &a.GetMaterial() == &b.GetMaterial()
+        && &a.GetVAO() == &b.GetVAO()
+        && drawcallA.GetPrimitive() == drawcallB.GetPrimitive()
+        && drawcallA.GetEBOType() == drawcallB.GetEBOType();
 }
 
 void Renderer::SetLightingRenderStates(bool firstPass)
@@ -306,8 +869,8 @@ void Renderer::SetLightingRenderStates(bool firstPass)
     if (!firstPass)
     {
         m_device.SetFeatureEnabled(GL_BLEND, true);
-        glDepthFunc(firstPass ? GL_LESS : GL_EQUAL);
-        glBlendFunc(GL_ONE, GL_ONE);
+        m_device.SetDepthFunction(firstPass ? GL_LESS : GL_EQUAL);
+        m_device.SetBlendFunction(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
     }
 }
 
@@ -328,3 +891,22 @@ const glm::mat4& Renderer::GetWorldMatrix(const DrawcallInfo& drawcallInfo) cons
 {
     return m_worldMatrices[drawcallInfo.GetWorldMatrixIndex()];
 }
+
+uint64_t Renderer::ComputeStateKey(const Material& material, const VertexArrayObject& vao)
+{
+    // Materials get sequential ids the first time they are seen. Shaders and VAOs use their handles, that are already small
+    auto itMaterial = m_materialSortIds.try_emplace(&material, static_cast<unsigned int>(m_materialSortIds.size())).first;
+
+    const std::shared_ptr<const ShaderProgram>& shaderProgram = material.GetShaderProgram();
+    uint64_t layer = material.HasBlend() ? 1 : 0;
+    uint64_t shader = shaderProgram ? shaderProgram->GetHandle() : 0;
+    uint64_t materialId = itMaterial->second;
+    uint64_t vaoId = vao.GetHandle();
+
+    // Ids that don't fit just share their bits with others. The order is still correct for layer and depth
+    uint64_t key = layer & ((1ULL << SortKey::LayerBits) - 1);
+    key = key << SortKey::ShaderBits | (shader & ((1ULL << SortKey::ShaderBits) - 1));
+    key = key << SortKey::MaterialBits | (materialId & ((1ULL << SortKey::MaterialBits) - 1));
+    key = key << SortKey::VAOBits | (vaoId & ((1ULL << SortKey::VAOBits) - 1));
+    return key;
+}
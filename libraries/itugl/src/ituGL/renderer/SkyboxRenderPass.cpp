@@ -45,11 +45,11 @@ void SkyboxRenderPass::Render()
     m_shaderProgram.SetTexture(m_skyboxTextureLocation, 0, *m_texture);
 
     // Only write to depth == 1
-    glDepthFunc(GL_EQUAL);
+    renderer.GetDevice().SetDepthFunction(GL_EQUAL);
 
     const Mesh& fullscreenMesh = renderer.GetFullscreenMesh();
     fullscreenMesh.DrawSubmesh(0);
     
     // Restore default value
-    glDepthFunc(GL_LESS);
+    renderer.GetDevice().SetDepthFunction(GL_LESS);
 }
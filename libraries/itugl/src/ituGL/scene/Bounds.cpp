@@ -1,5 +1,11 @@
 #include <ituGL/scene/Bounds.h>
 
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 SphereBounds::SphereBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_radius(0.0f)
 {
     switch (bounds.GetType())
@@ -8,10 +14,10 @@ SphereBounds::SphereBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m
         m_radius = static_cast<const SphereBounds&>(bounds).GetRadius();
         break;
     case Type::AABB:
-        m_radius = static_cast<const AabbBounds&>(bounds).GetSize().length();
+        m_radius = glm::length(static_cast<const AabbBounds&>(bounds).GetSize());
         break;
     case Type::Box:
-        m_radius = static_cast<const BoxBounds&>(bounds).GetSize().length();
+        m_radius = glm::length(static_cast<const BoxBounds&>(bounds).GetSize());
         break;
     default:
         assert(false);
@@ -30,10 +36,9 @@ AabbBounds::AabbBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_siz
         break;
     case Type::Box:
         {
+            // Each axis adds its projection to the half size
             glm::mat3 scaledMatrix = static_cast<const BoxBounds&>(bounds).GetScaledMatrix();
-            m_size = glm::abs(scaledMatrix[0]);
-            m_size = glm::max(m_size, glm::abs(scaledMatrix[1]));
-            m_size = glm::max(m_size, glm::abs(scaledMatrix[2]));
+            m_size = glm::abs(scaledMatrix[0]) + glm::abs(scaledMatrix[1]) + glm::abs(scaledMatrix[2]);
         }
         break;
     default:
@@ -109,7 +114,8 @@ bool TestSeparationAxis(const glm::vec3& axis, const glm::vec3& distance, const
         projSize += std::abs(glm::dot(mA[i], axis));
         projSize += std::abs(glm::dot(mB[i], axis));
     }
-    return projSize <= projDistance;
+    // Not separated on this axis if the projected distance is not larger than the projected sizes
+    return projDistance <= projSize;
 }
 
 template<>
@@ -117,7 +123,7 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const BoxBounds& boundsB)
 {
     glm::vec3 distance = boundsB.GetCenter() - boundsA.GetCenter();
     glm::mat3 mA = boundsA.GetScaledMatrix();
-    glm::mat3 mB = boundsA.GetScaledMatrix();
+    glm::mat3 mB = boundsB.GetScaledMatrix();
     return TestSeparationAxis(boundsA.GetXVector(), distance, mA, mB)
         && TestSeparationAxis(boundsA.GetYVector(), distance, mA, mB)
         && TestSeparationAxis(boundsA.GetZVector(), distance, mA, mB)
@@ -135,22 +141,47 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const BoxBounds& boundsB)
         && TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetZVector()), distance, mA, mB);
 }
 
+// Signed distance from the center to the plane, and the extent of the bounds in the plane normal
+// The bounds are outside if they are completely behind any of the planes
+static bool IsInsidePlanes(const std::array<glm::vec4, 6>& planes, const glm::vec3& center, float radius, const glm::mat3& axes)
+{
+    for (const glm::vec4& plane : planes)
+    {
+        glm::vec3 normal(plane);
+        float distance = glm::dot(normal, center) + plane.w;
+        float extent = radius + std::abs(glm::dot(normal, axes[0])) + std::abs(glm::dot(normal, axes[1])) + std::abs(glm::dot(normal, axes[2]));
+        if (distance < -extent)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const SphereBounds& boundsB)
 {
-    return true;
+    return IsInsidePlanes(boundsA.GetPlanes(), boundsB.GetCenter(), boundsB.GetRadius(), glm::mat3(0.0f));
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const AabbBounds& boundsB)
 {
-    return true;
+    glm::vec3 size = boundsB.GetSize();
+    return IsInsidePlanes(boundsA.GetPlanes(), boundsB.GetCenter(), 0.0f, glm::mat3(size.x, 0, 0, 0, size.y, 0, 0, 0, size.z));
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const BoxBounds& boundsB)
 {
-    return true;
+    return IsInsidePlanes(boundsA.GetPlanes(), boundsB.GetCenter(), 0.0f, boundsB.GetScaledMatrix());
+}
+
+template<>
+bool Bounds::Intersects(const FrustumBounds& /*boundsA*/, const FrustumBounds& /*boundsB*/)
+{
+    assert(false);
+    return false;
 }
 
 bool Bounds::Intersects(const Bounds& boundsA, const Bounds& boundsB)
@@ -163,6 +194,8 @@ bool Bounds::Intersects(const Bounds& boundsA, const Bounds& boundsB)
         return Bounds::Intersects(static_cast<const AabbBounds&>(boundsA), boundsB);
     case Type::Box:
         return Bounds::Intersects(static_cast<const BoxBounds&>(boundsA), boundsB);
+    case Type::Frustum:
+        return Bounds::Intersects(static_cast<const FrustumBounds&>(boundsA), boundsB);
     default:
         assert(false);
         return false;
@@ -178,3 +211,130 @@ glm::mat3 BoxBounds::GetScaledMatrix() const
         m_rotationMatrix[2] * m_size[2]
     );
 }
+
+FrustumBounds::FrustumBounds(const glm::mat4& viewProjectionMatrix) : Bounds(glm::vec3(0.0f))
+{
+    // Each plane is a combination of the last row of the matrix with one of the others (Gribb-Hartmann)
+    glm::mat4 m = glm::transpose(viewProjectionMatrix);
+    m_planes[0] = m[3] + m[0]; // Left
+    m_planes[1] = m[3] - m[0]; // Right
+    m_planes[2] = m[3] + m[1]; // Bottom
+    m_planes[3] = m[3] - m[1]; // Top
+    m_planes[4] = m[3] + m[2]; // Near
+    m_planes[5] = m[3] - m[2]; // Far
+
+    for (glm::vec4& plane : m_planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    // Center of the frustum, halfway between the centers of the near and far planes
+    glm::mat4 inverseMatrix = glm::inverse(viewProjectionMatrix);
+    glm::vec4 nearCenter = inverseMatrix * glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+    glm::vec4 farCenter = inverseMatrix * glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    m_center = 0.5f * (glm::vec3(nearCenter) / nearCenter.w + glm::vec3(farCenter) / farCenter.w);
+}
+
+void FrustumBounds::Intersects(const BoundsBatch& batch, std::vector<uint8_t>& results) const
+{
+    const unsigned int count = batch.GetCount();
+    results.resize(count);
+
+    // Blocks of bounds, tested against one plane at a time. Plain loops of a fixed size over float arrays, without branches,
+    // so the compiler uses SIMD. The margins are a local array, so it knows they don't overlap with the inputs
+    const unsigned int blockSize = BoundsBatch::s_blockSize;
+    for (unsigned int blockStart = 0; blockStart < count; blockStart += blockSize)
+    {
+        const float* centerX = batch.m_centerX.data() + blockStart;
+        const float* centerY = batch.m_centerY.data() + blockStart;
+        const float* centerZ = batch.m_centerZ.data() + blockStart;
+        const float* radius = batch.m_radius.data() + blockStart;
+        const float* axisXX = batch.m_axes[0].data() + blockStart, * axisXY = batch.m_axes[1].data() + blockStart, * axisXZ = batch.m_axes[2].data() + blockStart;
+        const float* axisYX = batch.m_axes[3].data() + blockStart, * axisYY = batch.m_axes[4].data() + blockStart, * axisYZ = batch.m_axes[5].data() + blockStart;
+        const float* axisZX = batch.m_axes[6].data() + blockStart, * axisZY = batch.m_axes[7].data() + blockStart, * axisZZ = batch.m_axes[8].data() + blockStart;
+
+        // Smallest margin of each bounds to the planes. Negative means completely outside of one of them
+        float margin[blockSize];
+        std::fill(margin, margin + blockSize, std::numeric_limits<float>::max());
+
+        for (const glm::vec4& plane : m_planes)
+        {
+            const float nx = plane.x, ny = plane.y, nz = plane.z, d = plane.w;
+            for (unsigned int i = 0; i < blockSize; ++i)
+            {
+                float distance = nx * centerX[i] + ny * centerY[i] + nz * centerZ[i] + d;
+                float extent = radius[i]
+                    + std::abs(nx * axisXX[i] + ny * axisXY[i] + nz * axisXZ[i])
+                    + std::abs(nx * axisYX[i] + ny * axisYY[i] + nz * axisYZ[i])
+                    + std::abs(nx * axisZX[i] + ny * axisZY[i] + nz * axisZZ[i]);
+                margin[i] = std::min(margin[i], distance + extent);
+            }
+        }
+
+        // The padding at the end of the last block is not copied
+        const unsigned int blockCount = std::min(blockSize, count - blockStart);
+        for (unsigned int i = 0; i < blockCount; ++i)
+        {
+            results[blockStart + i] = margin[i] >= 0.0f;
+        }
+    }
+}
+
+BoundsBatch::BoundsBatch() : m_count(0)
+{
+}
+
+void BoundsBatch::Add(const SphereBounds& bounds)
+{
+    Add(bounds.GetCenter(), bounds.GetRadius(), glm::mat3(0.0f));
+}
+
+void BoundsBatch::Add(const AabbBounds& bounds)
+{
+    glm::vec3 size = bounds.GetSize();
+    Add(bounds.GetCenter(), 0.0f, glm::mat3(size.x, 0, 0, 0, size.y, 0, 0, 0, size.z));
+}
+
+void BoundsBatch::Add(const BoxBounds& bounds)
+{
+    Add(bounds.GetCenter(), 0.0f, bounds.GetScaledMatrix());
+}
+
+void BoundsBatch::Add(const glm::vec3& center, float radius, const glm::mat3& axes)
+{
+    if (m_count == m_centerX.size())
+    {
+        size_t size = m_count + s_blockSize;
+        m_centerX.resize(size);
+        m_centerY.resize(size);
+        m_centerZ.resize(size);
+        m_radius.resize(size);
+        for (std::vector<float>& axis : m_axes)
+        {
+            axis.resize(size);
+        }
+    }
+
+    m_centerX[m_count] = center.x;
+    m_centerY[m_count] = center.y;
+    m_centerZ[m_count] = center.z;
+    m_radius[m_count] = radius;
+    for (int i = 0; i < 9; ++i)
+    {
+        m_axes[i][m_count] = axes[i / 3][i % 3];
+    }
+    ++m_count;
+}
+
+void BoundsBatch::Clear()
+{
+    m_count = 0;
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_radius.clear();
+    for (std::vector<float>& axis : m_axes)
+    {
+        axis.clear();
+    }
+}
@@ -1,15 +1,78 @@
 #include <ituGL/scene/RendererSceneVisitor.h>
 
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/camera/Camera.h>
 #include <ituGL/scene/SceneCamera.h>
 #include <ituGL/scene/SceneLight.h>
 #include <ituGL/scene/SceneModel.h>
 #include <ituGL/scene/Transform.h>
+#include <ituGL/utils/Profiler.h>
 
-RendererSceneVisitor::RendererSceneVisitor(Renderer& renderer) : m_renderer(renderer)
+RendererSceneVisitor::RendererSceneVisitor(Renderer& renderer)
+    : m_renderer(renderer)
+    , m_cullingEnabled(true)
+    , m_frustum(glm::mat4(1.0f))
+    , m_visibleCount(0)
+    , m_culledCount(0)
+    , m_sceneCulledCount(0)
 {
 }
 
+void RendererSceneVisitor::BeginVisit()
+{
+    m_models.clear();
+    m_bounds.Clear();
+    m_sceneCulledCount = 0;
+}
+
+const FrustumBounds* RendererSceneVisitor::GetCullingFrustum()
+{
+    if (!m_cullingEnabled || !m_renderer.HasCamera())
+    {
+        return nullptr;
+    }
+
+    m_frustum = FrustumBounds(m_renderer.GetCurrentCamera().GetViewProjectionMatrix());
+    return &m_frustum;
+}
+
+void RendererSceneVisitor::SetCulledNodeCount(unsigned int count)
+{
+    m_sceneCulledCount = count;
+}
+
+void RendererSceneVisitor::EndVisit()
+{
+    ITUGL_PROFILE_SCOPE("FrustumCulling");
+
+    // The scene culls with the fat bounds of its hierarchy, so the models visited are tested again with their box bounds
+    // The const scene doesn't cull, and can visit the camera after the models, so this waits until all are visited
+    bool culling = m_cullingEnabled && m_renderer.HasCamera();
+    if (culling)
+    {
+        FrustumBounds frustum(m_renderer.GetCurrentCamera().GetViewProjectionMatrix());
+        frustum.Intersects(m_bounds, m_visible);
+    }
+
+    m_visibleCount = 0;
+    m_culledCount = m_sceneCulledCount;
+    for (size_t i = 0; i < m_models.size(); ++i)
+    {
+        if (culling && !m_visible[i])
+        {
+            ++m_culledCount;
+            continue;
+        }
+
+        const SceneModel& sceneModel = *m_models[i];
+        m_renderer.AddModel(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix());
+        ++m_visibleCount;
+    }
+
+    m_models.clear();
+    m_bounds.Clear();
+}
+
 void RendererSceneVisitor::VisitCamera(SceneCamera& sceneCamera)
 {
     assert(!m_renderer.HasCamera()); // Currently, only one camera per scene supported
@@ -24,5 +87,6 @@ void RendererSceneVisitor::VisitLight(SceneLight& sceneLight)
 void RendererSceneVisitor::VisitModel(SceneModel& sceneModel)
 {
     assert(sceneModel.GetTransform());
-    m_renderer.AddModel(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix());
+    m_models.push_back(&sceneModel);
+    m_bounds.Add(sceneModel.GetBoxBounds());
 }
@@ -2,6 +2,8 @@
 
 #include <ituGL/scene/SceneNode.h>
 #include <ituGL/scene/SceneVisitor.h>
+#include <ituGL/scene/Transform.h>
+#include <ituGL/utils/Profiler.h>
 #include <cassert>
 
 Scene::Scene()
@@ -13,6 +15,7 @@ Scene::~Scene()
     for (auto& pair : m_nodes)
     {
         pair.second->SetOwnerScene(nullptr);
+        pair.second->m_bvhProxy = SceneBvh::NullProxy;
     }
 }
 
@@ -32,6 +35,10 @@ bool Scene::AddSceneNode(std::shared_ptr<SceneNode> node)
     assert(m_nodes.find(node->GetName()) == m_nodes.end());
     m_nodes[node->GetName()] = node;
     node->SetOwnerScene(this);
+
+    // Added to the bounding volume hierarchy on the next update
+    node->m_bvhProxy = SceneBvh::NullProxy;
+    node->InvalidateBounds();
     return true;
 }
 
@@ -48,6 +55,7 @@ bool Scene::RemoveSceneNode(const std::string& name)
     {
         assert(it->second);
         assert(it->second->GetOwnerScene() == this);
+        RemoveFromBvh(*it->second);
         it->second->SetOwnerScene(nullptr);
         m_nodes.erase(it);
         return true;
@@ -57,16 +65,99 @@ bool Scene::RemoveSceneNode(const std::string& name)
 
 void Scene::AcceptVisitor(SceneVisitor& visitor)
 {
-    for (auto& pair : m_nodes)
+    UpdateBounds();
+
+    visitor.BeginVisit();
+
+    // Cameras and lights first, so the visitor can cull with the camera frustum
+    for (SceneNode* node : m_unboundedNodes)
     {
-        pair.second->AcceptVisitor(visitor);
+        node->AcceptVisitor(visitor);
+    }
+
+    m_visibleNodes.clear();
+    if (const FrustumBounds* frustum = visitor.GetCullingFrustum())
+    {
+        m_bvh.Query(*frustum, m_visibleNodes);
+    }
+    else
+    {
+        for (auto& pair : m_nodes)
+        {
+            if (pair.second->m_bvhProxy != SceneBvh::NullProxy)
+            {
+                m_visibleNodes.push_back(pair.second.get());
+            }
+        }
     }
+    visitor.SetCulledNodeCount(m_bvh.GetProxyCount() - static_cast<unsigned int>(m_visibleNodes.size()));
+
+    for (SceneNode* node : m_visibleNodes)
+    {
+        node->AcceptVisitor(visitor);
+    }
+    visitor.EndVisit();
 }
 
 void Scene::AcceptVisitor(SceneVisitor& visitor) const
 {
+    visitor.BeginVisit();
     for (auto& pair : m_nodes)
     {
         pair.second->AcceptVisitor(visitor);
     }
+    visitor.EndVisit();
+}
+
+void Scene::UpdateBounds()
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    // Checking the versions is cheap. Only the nodes that moved out of their fat bounds change the tree
+    m_unboundedNodes.clear();
+    for (auto& pair : m_nodes)
+    {
+        SceneNode& node = *pair.second;
+        if (!node.HasBounds() || !node.GetTransform())
+        {
+            RemoveFromBvh(node);
+            m_unboundedNodes.push_back(&node);
+            continue;
+        }
+
+        uint64_t transformVersion = node.GetTransform()->GetVersion();
+        if (node.m_bvhProxy == SceneBvh::NullProxy)
+        {
+            node.m_bvhProxy = m_bvh.Insert(&node, node.GetAabbBounds());
+        }
+        else if (node.m_bvhTransformVersion != transformVersion)
+        {
+            m_bvh.Move(node.m_bvhProxy, node.GetAabbBounds());
+        }
+        node.m_bvhTransformVersion = transformVersion;
+    }
+}
+
+void Scene::QueryNodes(const FrustumBounds& frustum, std::vector<SceneNode*>& nodes) const
+{
+    m_bvh.Query(frustum, nodes);
+}
+
+void Scene::QueryNodes(const AabbBounds& bounds, std::vector<SceneNode*>& nodes) const
+{
+    m_bvh.Query(bounds, nodes);
+}
+
+SceneNode* Scene::Pick(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+    return m_bvh.RayCast(origin, direction, distance);
+}
+
+void Scene::RemoveFromBvh(SceneNode& node)
+{
+    if (node.m_bvhProxy != SceneBvh::NullProxy)
+    {
+        m_bvh.Remove(node.m_bvhProxy);
+        node.m_bvhProxy = SceneBvh::NullProxy;
+    }
 }
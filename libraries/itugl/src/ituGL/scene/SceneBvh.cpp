@@ -0,0 +1,418 @@
+#include <ituGL/scene/SceneBvh.h>
+
+#include <ituGL/scene/SceneNode.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Half the surface area of the box, used as the cost of a node
+static float GetPerimeter(const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 size = max - min;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+// Distances along the ray where it enters and leaves the box. No hit if enter > exit
+static void IntersectRayAabb(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& min, const glm::vec3& max,
+    float& enter, float& exit)
+{
+    glm::vec3 t0 = (min - origin) * inverseDirection;
+    glm::vec3 t1 = (max - origin) * inverseDirection;
+    glm::vec3 tMin = glm::min(t0, t1);
+    glm::vec3 tMax = glm::max(t0, t1);
+    enter = std::max(std::max(tMin.x, tMin.y), tMin.z);
+    exit = std::min(std::min(tMax.x, tMax.y), tMax.z);
+}
+
+SceneBvh::SceneBvh(float margin) : m_root(NullProxy), m_freeList(NullProxy), m_proxyCount(0), m_margin(margin)
+{
+}
+
+int SceneBvh::AllocateNode()
+{
+    if (m_freeList == NullProxy)
+    {
+        m_nodes.push_back(Node());
+        m_nodes.back().parent = NullProxy;
+        m_freeList = static_cast<int>(m_nodes.size()) - 1;
+    }
+
+    int index = m_freeList;
+    Node& node = m_nodes[index];
+    m_freeList = node.parent;
+    node.sceneNode = nullptr;
+    node.parent = NullProxy;
+    node.child1 = NullProxy;
+    node.child2 = NullProxy;
+    node.height = 0;
+    return index;
+}
+
+void SceneBvh::FreeNode(int index)
+{
+    Node& node = m_nodes[index];
+    node.parent = m_freeList;
+    node.height = -1;
+    m_freeList = index;
+}
+
+int SceneBvh::Insert(SceneNode* sceneNode, const AabbBounds& bounds)
+{
+    int proxy = AllocateNode();
+    Node& node = m_nodes[proxy];
+    node.min = bounds.GetMin() - glm::vec3(m_margin);
+    node.max = bounds.GetMax() + glm::vec3(m_margin);
+    node.sceneNode = sceneNode;
+    InsertLeaf(proxy);
+    ++m_proxyCount;
+    return proxy;
+}
+
+void SceneBvh::Remove(int proxy)
+{
+    assert(m_nodes[proxy].IsLeaf());
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --m_proxyCount;
+}
+
+bool SceneBvh::Move(int proxy, const AabbBounds& bounds)
+{
+    Node& node = m_nodes[proxy];
+    assert(node.IsLeaf());
+
+    glm::vec3 min = bounds.GetMin();
+    glm::vec3 max = bounds.GetMax();
+    if (glm::all(glm::lessThanEqual(node.min, min)) && glm::all(glm::lessThanEqual(max, node.max)))
+    {
+        // Still inside the fat bounds
+        return false;
+    }
+
+    RemoveLeaf(proxy);
+    m_nodes[proxy].min = min - glm::vec3(m_margin);
+    m_nodes[proxy].max = max + glm::vec3(m_margin);
+    InsertLeaf(proxy);
+    return true;
+}
+
+void SceneBvh::Clear()
+{
+    m_nodes.clear();
+    m_root = NullProxy;
+    m_freeList = NullProxy;
+    m_proxyCount = 0;
+}
+
+int SceneBvh::GetHeight() const
+{
+    return m_root != NullProxy ? m_nodes[m_root].height : 0;
+}
+
+void SceneBvh::InsertLeaf(int leaf)
+{
+    if (m_root == NullProxy)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = NullProxy;
+        return;
+    }
+
+    // Find the best sibling, going down while it is cheaper to add the leaf to one of the children
+    const glm::vec3 leafMin = m_nodes[leaf].min;
+    const glm::vec3 leafMax = m_nodes[leaf].max;
+    int index = m_root;
+    while (!m_nodes[index].IsLeaf())
+    {
+        const Node& node = m_nodes[index];
+
+        float area = GetPerimeter(node.min, node.max);
+        float combinedArea = GetPerimeter(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+
+        // Cost of creating a new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+
+        // Minimum cost of pushing the leaf further down, all the ancestors grow
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        int children[2] = { node.child1, node.child2 };
+        for (int i = 0; i < 2; ++i)
+        {
+            const Node& child = m_nodes[children[i]];
+            float childArea = GetPerimeter(glm::min(child.min, leafMin), glm::max(child.max, leafMax));
+            childCosts[i] = (child.IsLeaf() ? childArea : childArea - GetPerimeter(child.min, child.max)) + inheritanceCost;
+        }
+
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+
+        index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+    }
+    int sibling = index;
+
+    // New parent for the sibling and the leaf
+    int oldParent = m_nodes[sibling].parent;
+    int newParent = AllocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].min = glm::min(leafMin, m_nodes[sibling].min);
+    m_nodes[newParent].max = glm::max(leafMax, m_nodes[sibling].max);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if (oldParent != NullProxy)
+    {
+        Node& parent = m_nodes[oldParent];
+        (parent.child1 == sibling ? parent.child1 : parent.child2) = newParent;
+    }
+    else
+    {
+        m_root = newParent;
+    }
+
+    // Walk back up, balancing and fixing the bounds and heights
+    index = m_nodes[leaf].parent;
+    while (index != NullProxy)
+    {
+        index = Balance(index);
+        UpdateNode(index);
+        index = m_nodes[index].parent;
+    }
+}
+
+void SceneBvh::RemoveLeaf(int leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NullProxy;
+        return;
+    }
+
+    // The sibling takes the place of the parent
+    int parent = m_nodes[leaf].parent;
+    int grandParent = m_nodes[parent].parent;
+    int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    if (grandParent != NullProxy)
+    {
+        Node& grandParentNode = m_nodes[grandParent];
+        (grandParentNode.child1 == parent ? grandParentNode.child1 : grandParentNode.child2) = sibling;
+        m_nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+
+        int index = grandParent;
+        while (index != NullProxy)
+        {
+            index = Balance(index);
+            UpdateNode(index);
+            index = m_nodes[index].parent;
+        }
+    }
+    else
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = NullProxy;
+        FreeNode(parent);
+    }
+}
+
+void SceneBvh::UpdateNode(int index)
+{
+    Node& node = m_nodes[index];
+    const Node& child1 = m_nodes[node.child1];
+    const Node& child2 = m_nodes[node.child2];
+    node.min = glm::min(child1.min, child2.min);
+    node.max = glm::max(child1.max, child2.max);
+    node.height = 1 + std::max(child1.height, child2.height);
+}
+
+int SceneBvh::Balance(int indexA)
+{
+    Node& a = m_nodes[indexA];
+    if (a.IsLeaf() || a.height < 2)
+    {
+        return indexA;
+    }
+
+    int indexB = a.child1;
+    int indexC = a.child2;
+    int balance = m_nodes[indexC].height - m_nodes[indexB].height;
+
+    // Rotate the taller child up, and A down in its place. A keeps the shorter grandchild
+    if (balance > 1 || balance < -1)
+    {
+        bool rotateC = balance > 1;
+        int indexUp = rotateC ? indexC : indexB;
+        Node& up = m_nodes[indexUp];
+        int indexF = up.child1;
+        int indexG = up.child2;
+
+        // The child that goes up takes the place of A in its parent
+        up.child1 = indexA;
+        up.parent = a.parent;
+        a.parent = indexUp;
+        if (up.parent != NullProxy)
+        {
+            Node& parent = m_nodes[up.parent];
+            (parent.child1 == indexA ? parent.child1 : parent.child2) = indexUp;
+        }
+        else
+        {
+            m_root = indexUp;
+        }
+
+        // The taller grandchild stays with the child that goes up, the other one moves to A
+        bool keepF = m_nodes[indexF].height > m_nodes[indexG].height;
+        int indexKeep = keepF ? indexF : indexG;
+        int indexMove = keepF ? indexG : indexF;
+        up.child2 = indexKeep;
+        (rotateC ? a.child2 : a.child1) = indexMove;
+        m_nodes[indexMove].parent = indexA;
+
+        UpdateNode(indexA);
+        UpdateNode(indexUp);
+        return indexUp;
+    }
+
+    return indexA;
+}
+
+void SceneBvh::Query(const FrustumBounds& frustum, std::vector<SceneNode*>& sceneNodes) const
+{
+    if (m_root == NullProxy)
+        return;
+
+    const std::array<glm::vec4, 6>& planes = frustum.GetPlanes();
+
+    // Stack of nodes to visit, with a bit for each plane that still needs testing. Children of nodes that are
+    // completely inside a plane don't test it again
+    std::vector<std::pair<int, unsigned int>> stack;
+    stack.reserve(64);
+    stack.emplace_back(m_root, 0x3Fu);
+    while (!stack.empty())
+    {
+        auto [index, planeMask] = stack.back();
+        stack.pop_back();
+        const Node& node = m_nodes[index];
+
+        bool outside = false;
+        glm::vec3 center = 0.5f * (node.min + node.max);
+        glm::vec3 extents = 0.5f * (node.max - node.min);
+        for (int i = 0; i < 6 && !outside; ++i)
+        {
+            if ((planeMask & (1u << i)) == 0)
+                continue;
+
+            glm::vec3 normal(planes[i]);
+            float distance = glm::dot(normal, center) + planes[i].w;
+            float extent = glm::dot(glm::abs(normal), extents);
+            if (distance < -extent)
+            {
+                outside = true;
+            }
+            else if (distance > extent)
+            {
+                planeMask &= ~(1u << i);
+            }
+        }
+
+        if (outside)
+            continue;
+
+        if (node.IsLeaf())
+        {
+            sceneNodes.push_back(node.sceneNode);
+        }
+        else
+        {
+            stack.emplace_back(node.child1, planeMask);
+            stack.emplace_back(node.child2, planeMask);
+        }
+    }
+}
+
+void SceneBvh::Query(const AabbBounds& bounds, std::vector<SceneNode*>& sceneNodes) const
+{
+    if (m_root == NullProxy)
+        return;
+
+    const glm::vec3 min = bounds.GetMin();
+    const glm::vec3 max = bounds.GetMax();
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        if (glm::any(glm::lessThan(node.max, min)) || glm::any(glm::lessThan(max, node.min)))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            sceneNodes.push_back(node.sceneNode);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+SceneNode* SceneBvh::RayCast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+    SceneNode* closestNode = nullptr;
+    if (m_root == NullProxy)
+        return closestNode;
+
+    // Divisions by 0 give infinities, and the slab test still works with them
+    const glm::vec3 inverseDirection = 1.0f / direction;
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(m_root);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        // Skip the nodes that are missed, or farther than the closest hit so far
+        float enter, exit;
+        IntersectRayAabb(origin, inverseDirection, node.min, node.max, enter, exit);
+        if (enter > exit || exit < 0.0f || enter > distance)
+            continue;
+
+        if (!node.IsLeaf())
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+            continue;
+        }
+
+        // Exact test with the box, in its local space
+        BoxBounds box = node.sceneNode->GetBoxBounds();
+        glm::mat3 inverseRotation = glm::transpose(box.GetRotationMatrix());
+        glm::vec3 localOrigin = inverseRotation * (origin - box.GetCenter());
+        glm::vec3 localInverseDirection = 1.0f / (inverseRotation * direction);
+        IntersectRayAabb(localOrigin, localInverseDirection, -box.GetSize(), box.GetSize(), enter, exit);
+        if (enter <= exit && exit >= 0.0f)
+        {
+            float hitDistance = std::max(enter, 0.0f);
+            if (hitDistance <= distance)
+            {
+                distance = hitDistance;
+                closestNode = node.sceneNode;
+            }
+        }
+    }
+
+    return closestNode;
+}
@@ -4,7 +4,9 @@
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/scene/Transform.h>
 #include <ituGL/scene/SceneVisitor.h>
+#include <glm/geometric.hpp>
 #include <cassert>
+#include <cmath>
 
 SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model) : SceneNode(name), m_model(model)
 {
@@ -22,6 +24,7 @@ std::shared_ptr<Model> SceneModel::GetModel() const
 void SceneModel::SetModel(std::shared_ptr<Model> model)
 {
     m_model = model;
+    InvalidateBounds();
 }
 
 /*glm::mat4 SceneModel::GetWorldMatrix() const
@@ -43,6 +46,11 @@ const Drawcall& SceneModel::GetDrawcall(int index, const VertexArrayObject*& vao
     return mesh.GetSubmeshDrawcall(index);
 }*/
 
+bool SceneModel::HasBounds() const
+{
+    return m_model != nullptr;
+}
+
 SphereBounds SceneModel::GetSphereBounds() const
 {
     return SphereBounds(GetBoxBounds());
@@ -57,7 +65,24 @@ BoxBounds SceneModel::GetBoxBounds() const
 {
     assert(m_transform);
     assert(m_model);
-    return BoxBounds(m_transform->GetTranslation(), m_transform->GetRotationMatrix(), m_transform->GetScale() /* * m_model->GetSize()*/);
+    // Local bounds of the model, transformed by the world matrix, the same one used to draw it (with the parents)
+    // Each axis of the box is a column of the matrix, split in direction and length. Parents with non-uniform scale
+    // can make the axes not perpendicular, and the box keeps them like that, so the scaled axes stay exact
+    const glm::mat4 worldMatrix = m_transform->GetTransformMatrix();
+    glm::vec3 center(worldMatrix * glm::vec4(m_model->GetLocalBoundsCenter(), 1.0f));
+    glm::mat3 rotationMatrix(1.0f);
+    glm::vec3 size(0.0f);
+    for (int i = 0; i < 3; ++i)
+    {
+        glm::vec3 axis(worldMatrix[i]);
+        float scale = glm::length(axis);
+        if (scale > 0.0f)
+        {
+            rotationMatrix[i] = axis / scale;
+        }
+        size[i] = scale * std::abs(m_model->GetLocalBoundsSize()[i]);
+    }
+    return BoxBounds(center, rotationMatrix, size);
 }
 
 void SceneModel::AcceptVisitor(SceneVisitor& visitor)
@@ -7,7 +7,8 @@ SceneNode::SceneNode(const std::string& name) : SceneNode(name, std::make_shared
 {
 }
 
-SceneNode::SceneNode(const std::string& name, std::shared_ptr<Transform> transform) : m_scene(nullptr), m_name(name), m_transform(transform)
+SceneNode::SceneNode(const std::string& name, std::shared_ptr<Transform> transform)
+    : m_scene(nullptr), m_bvhProxy(-1), m_bvhTransformVersion(0), m_name(name), m_transform(transform)
 {
 }
 
@@ -49,6 +50,12 @@ std::shared_ptr<const Transform> SceneNode::GetTransform() const
 void SceneNode::SetTransform(std::shared_ptr<Transform> transform)
 {
     m_transform = transform;
+    InvalidateBounds();
+}
+
+void SceneNode::InvalidateBounds()
+{
+    m_bvhTransformVersion = 0;
 }
 
 Scene* SceneNode::GetOwnerScene() const
@@ -61,6 +68,11 @@ void SceneNode::SetOwnerScene(Scene* scene)
     m_scene = scene;
 }
 
+bool SceneNode::HasBounds() const
+{
+    return false;
+}
+
 SphereBounds SceneNode::GetSphereBounds() const
 {
     return SphereBounds(glm::vec3(m_transform->GetTranslation()), 0.0f); // use world translation?
@@ -1,5 +1,22 @@
 #include <ituGL/scene/SceneVisitor.h>
 
+void SceneVisitor::BeginVisit()
+{
+}
+
+void SceneVisitor::EndVisit()
+{
+}
+
+const FrustumBounds* SceneVisitor::GetCullingFrustum()
+{
+    return nullptr;
+}
+
+void SceneVisitor::SetCulledNodeCount(unsigned int /*count*/)
+{
+}
+
 void SceneVisitor::VisitCamera(SceneCamera& sceneCamera)
 {
     VisitCamera(const_cast<const SceneCamera&>(sceneCamera));
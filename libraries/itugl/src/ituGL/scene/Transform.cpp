@@ -1,8 +1,11 @@
 #include <ituGL/scene/Transform.h>
 
 #include <glm/ext/matrix_transform.hpp>
+#include <algorithm>
 
-Transform::Transform() : m_translation(0, 0, 0), m_rotation(0, 0, 0), m_scale(1, 1, 1), m_matrix(1.0f), m_dirty(false)
+uint64_t Transform::s_lastVersion = 0;
+
+Transform::Transform() : m_translation(0, 0, 0), m_rotation(0, 0, 0), m_scale(1, 1, 1), m_matrix(1.0f), m_matrixVersion(0), m_version(NewVersion())
 {
 }
 
@@ -27,19 +30,31 @@ glm::mat4 Transform::GetScaleMatrix() const
 
 glm::mat4 Transform::GetTransformMatrix() const
 {
-    if (IsDirty())
+    uint64_t version = GetVersion();
+    if (m_matrixVersion != version)
     {
         m_matrix = GetTranslationMatrix() * GetRotationMatrix() * GetScaleMatrix();
         if (m_parent)
         {
             m_matrix = m_parent->GetTransformMatrix() * m_matrix;
         }
-        m_dirty = false;
+        m_matrixVersion = version;
     }
     return m_matrix;
 }
 
 bool Transform::IsDirty() const
 {
-    return m_dirty || (m_parent && m_parent->IsDirty());
+    return m_matrixVersion != GetVersion();
+}
+
+uint64_t Transform::GetVersion() const
+{
+    // A new stamp is always greater than all the previous ones, so the latest one changes when any of them changes
+    return m_parent ? std::max(m_version, m_parent->GetVersion()) : m_version;
+}
+
+uint64_t Transform::NewVersion()
+{
+    return ++s_lastVersion;
 }
@@ -1,5 +1,6 @@
 #include <ituGL/shader/Material.h>
 #include <ituGL/core/DeviceGL.h>
+#include <ituGL/utils/Profiler.h>
 #include <cassert>
 
 Material::Material() : Material(nullptr)
@@ -203,7 +204,10 @@ void Material::Use(OverrideFlags overrideFlags) const
     m_shaderProgram->Use();
 
     // Set the value of all the uniforms stored as properties
-    SetUniforms();
+    {
+        ITUGL_PROFILE_SCOPE("SetUniforms");
+        SetUniforms();
+    }
 
     if (m_shaderSetupFunction)
     {
@@ -211,6 +215,16 @@ void Material::Use(OverrideFlags overrideFlags) const
         m_shaderSetupFunction(*m_shaderProgram);
     }
 
+    UseRenderStates(overrideFlags);
+}
+
+void Material::UseRenderStates(OverrideFlags overrideFlags) const
+{
+    assert(m_shaderProgram);
+
+    // Set the shader program as the one currently in use. The device skips it if it already is
+    m_shaderProgram->Use();
+
     // If not skipped, set the depth settings
     if ((overrideFlags & OverrideFlags::OverrideDepthTest) == 0)
     {
@@ -232,39 +246,43 @@ void Material::Use(OverrideFlags overrideFlags) const
 
 void Material::UseDepthTest() const
 {
+    DeviceGL& device = DeviceGL::GetInstance();
+
     // Depth function
-    glDepthFunc(static_cast<GLenum>(m_depthTestFunction));
+    device.SetDepthFunction(static_cast<GLenum>(m_depthTestFunction));
 
     // Depth write
-    glDepthMask(m_depthWrite ? GL_TRUE : GL_FALSE);
+    device.SetDepthWrite(m_depthWrite);
 }
 
 void Material::UseStencilTest() const
 {
+    DeviceGL& device = DeviceGL::GetInstance();
+
     // Stencil operations
     if (m_stencilFail[0] == m_stencilFail[1] && m_stencilDepthFail[0] == m_stencilDepthFail[1] && m_stencilDepthPass[0] == m_stencilDepthPass[1])
     {
         // Same for front and back
-        glStencilOp(static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
+        device.SetStencilOperation(GL_FRONT_AND_BACK, static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
     }
     else
     {
         // Separate functions for front and back
-        glStencilOpSeparate(GL_FRONT, static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
-        glStencilOpSeparate(GL_BACK, static_cast<GLenum>(m_stencilFail[1]), static_cast<GLenum>(m_stencilDepthFail[1]), static_cast<GLenum>(m_stencilDepthPass[1]));
+        device.SetStencilOperation(GL_FRONT, static_cast<GLenum>(m_stencilFail[0]), static_cast<GLenum>(m_stencilDepthFail[0]), static_cast<GLenum>(m_stencilDepthPass[0]));
+        device.SetStencilOperation(GL_BACK, static_cast<GLenum>(m_stencilFail[1]), static_cast<GLenum>(m_stencilDepthFail[1]), static_cast<GLenum>(m_stencilDepthPass[1]));
     }
 
     // Stencil functions
     if (m_stencilTestFunctions[0] == m_stencilTestFunctions[1] && m_stencilRefValues[0] == m_stencilRefValues[1] && m_stencilMasks[0] == m_stencilMasks[1])
     {
         // Same for front and back
-        glStencilFunc(static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
+        device.SetStencilFunction(GL_FRONT_AND_BACK, static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
     }
     else
     {
         // Separate functions for front and back
-        glStencilFuncSeparate(GL_FRONT, static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
-        glStencilFuncSeparate(GL_BACK, static_cast<GLenum>(m_stencilTestFunctions[1]), m_stencilRefValues[1], m_stencilMasks[1]);
+        device.SetStencilFunction(GL_FRONT, static_cast<GLenum>(m_stencilTestFunctions[0]), m_stencilRefValues[0], m_stencilMasks[0]);
+        device.SetStencilFunction(GL_BACK, static_cast<GLenum>(m_stencilTestFunctions[1]), m_stencilRefValues[1], m_stencilMasks[1]);
     }
 }
 
@@ -272,7 +290,8 @@ void Material::UseBlend() const
 {
     // If the blend equation is None for color and alpha, do nothing
     bool blending = HasBlend();
-    DeviceGL::GetInstance().SetFeatureEnabled(GL_BLEND, blending);
+    DeviceGL& device = DeviceGL::GetInstance();
+    device.SetFeatureEnabled(GL_BLEND, blending);
     if (blending)
     {
         std::array<BlendParam, 4> blendParams = m_blendParams;
@@ -281,7 +300,7 @@ void Material::UseBlend() const
         if (m_blendEquations[0] == m_blendEquations[1])
         {
             // Set the same blend equation for color and alpha
-            glBlendEquation(static_cast<GLenum>(m_blendEquations[0]));
+            device.SetBlendEquation(static_cast<GLenum>(m_blendEquations[0]), static_cast<GLenum>(m_blendEquations[0]));
         }
         else
         {
@@ -303,19 +322,20 @@ void Material::UseBlend() const
             }
 
             // Set separate blend equation for color and alpha
-            glBlendEquationSeparate(blendEquationColor, blendEquationAlpha);
+            device.SetBlendEquation(blendEquationColor, blendEquationAlpha);
         }
 
         // Set blend params
         if (blendParams[0] == blendParams[2] && blendParams[1] == blendParams[3])
         {
             // Set the same blend params for color and alpha
-            glBlendFunc(static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]));
+            device.SetBlendFunction(static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]),
+                static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]));
         }
         else
         {
             // Set separate blend params for color and alpha
-            glBlendFuncSeparate(
+            device.SetBlendFunction(
                 static_cast<GLenum>(blendParams[0]), static_cast<GLenum>(blendParams[1]),
                 static_cast<GLenum>(blendParams[2]), static_cast<GLenum>(blendParams[3]));
         }
@@ -0,0 +1,196 @@
+#include <ituGL/shader/MaterialBlockPool.h>
+
+#include <ituGL/core/DeviceGL.h>
+#include <algorithm>
+#include <cassert>
+
+std::weak_ptr<MaterialBlockPool> MaterialBlockPool::s_instance;
+
+MaterialBlockPool::MaterialBlockPool()
+    : m_bufferSize(0)
+    , m_allocatedSize(0)
+    , m_dirtyBegin(0)
+    , m_dirtyEnd(0)
+{
+}
+
+std::shared_ptr<MaterialBlockPool> MaterialBlockPool::GetInstance()
+{
+    std::shared_ptr<MaterialBlockPool> instance = s_instance.lock();
+    if (!instance)
+    {
+        instance = std::make_shared<MaterialBlockPool>();
+        s_instance = instance;
+    }
+    return instance;
+}
+
+size_t MaterialBlockPool::Allocate(size_t size)
+{
+    // Round up the size, so the next range is aligned too
+    size_t alignment = UniformBufferObject::GetOffsetAlignment();
+    size = (size + alignment - 1) / alignment * alignment;
+    m_allocatedSize += size;
+
+    // First free range that is big enough
+    for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it)
+    {
+        if (it->size >= size)
+        {
+            size_t offset = it->offset;
+            it->offset += size;
+            it->size -= size;
+            if (it->size == 0)
+            {
+                m_freeRanges.erase(it);
+            }
+            return offset;
+        }
+    }
+
+    // Otherwise, add it at the end
+    size_t offset = m_data.size();
+    m_data.resize(offset + size);
+    return offset;
+}
+
+void MaterialBlockPool::Free(size_t offset, size_t size)
+{
+    size_t alignment = UniformBufferObject::GetOffsetAlignment();
+    size = (size + alignment - 1) / alignment * alignment;
+    assert(offset + size <= m_data.size() && size <= m_allocatedSize);
+    m_allocatedSize -= size;
+
+    auto it = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), offset,
+        [](const FreeRange& range, size_t offset) { return range.offset < offset; });
+    it = m_freeRanges.insert(it, { offset, size });
+
+    // Merge with the next range, then with the previous one
+    if (it + 1 != m_freeRanges.end() && it->offset + it->size == (it + 1)->offset)
+    {
+        it->size += (it + 1)->size;
+        m_freeRanges.erase(it + 1);
+    }
+    if (it != m_freeRanges.begin() && (it - 1)->offset + (it - 1)->size == it->offset)
+    {
+        (it - 1)->size += it->size;
+        m_freeRanges.erase(it);
+    }
+}
+
+std::span<std::byte> MaterialBlockPool::GetData(size_t offset, size_t size)
+{
+    assert(offset + size <= m_data.size());
+    return std::span<std::byte>(m_data.data() + offset, size);
+}
+
+void MaterialBlockPool::SetDirty(size_t offset, size_t size)
+{
+    if (m_dirtyBegin == m_dirtyEnd)
+    {
+        m_dirtyBegin = offset;
+        m_dirtyEnd = offset + size;
+    }
+    else
+    {
+        m_dirtyBegin = std::min(m_dirtyBegin, offset);
+        m_dirtyEnd = std::max(m_dirtyEnd, offset + size);
+    }
+}
+
+void MaterialBlockPool::BindRange(size_t offset, size_t size)
+{
+    UploadData();
+    m_buffer.BindRange(MaterialBlockBinding, offset, size);
+}
+
+void MaterialBlockPool::UploadData()
+{
+    if (m_bufferSize < m_data.size())
+    {
+        // Grow the buffer, with some room for the next materials, and upload everything again
+        // Reallocating makes DeviceGL forget the bound range, so it is bound again
+        m_bufferSize = std::max(m_data.size(), m_bufferSize * 2);
+        m_buffer.Bind();
+        m_buffer.AllocateData(m_bufferSize);
+        m_buffer.UpdateData(std::span<const std::byte>(m_data));
+        DeviceGL::GetInstance().OnUniformSet(m_data.size());
+        m_dirtyBegin = m_dirtyEnd = 0;
+    }
+    else if (m_dirtyBegin != m_dirtyEnd)
+    {
+        // Only the range that changed, in one call
+        m_buffer.Bind();
+        m_buffer.UpdateData(std::span<const std::byte>(m_data.data() + m_dirtyBegin, m_dirtyEnd - m_dirtyBegin), m_dirtyBegin);
+        DeviceGL::GetInstance().OnUniformSet(m_dirtyEnd - m_dirtyBegin);
+        m_dirtyBegin = m_dirtyEnd = 0;
+    }
+}
+
+MaterialBlockPool::Range::Range() : m_offset(0), m_size(0)
+{
+}
+
+MaterialBlockPool::Range::Range(const Range& other) : Range()
+{
+    *this = other;
+}
+
+MaterialBlockPool::Range::~Range()
+{
+    Free();
+}
+
+MaterialBlockPool::Range& MaterialBlockPool::Range::operator = (const Range& other)
+{
+    if (this != &other)
+    {
+        Free();
+        if (other.IsValid())
+        {
+            Allocate(other.m_size);
+            std::span<std::byte> data = GetData();
+            std::span<std::byte> otherData = other.GetData();
+            std::copy(otherData.begin(), otherData.end(), data.begin());
+            SetDirty();
+        }
+    }
+    return *this;
+}
+
+void MaterialBlockPool::Range::Allocate(size_t size)
+{
+    Free();
+    m_pool = MaterialBlockPool::GetInstance();
+    m_offset = m_pool->Allocate(size);
+    m_size = size;
+}
+
+void MaterialBlockPool::Range::Free()
+{
+    if (m_pool)
+    {
+        m_pool->Free(m_offset, m_size);
+        m_pool.reset();
+        m_offset = 0;
+        m_size = 0;
+    }
+}
+
+std::span<std::byte> MaterialBlockPool::Range::GetData() const
+{
+    assert(IsValid());
+    return m_pool->GetData(m_offset, m_size);
+}
+
+void MaterialBlockPool::Range::SetDirty() const
+{
+    assert(IsValid());
+    m_pool->SetDirty(m_offset, m_size);
+}
+
+void MaterialBlockPool::Range::Bind() const
+{
+    assert(IsValid());
+    m_pool->BindRange(m_offset, m_size);
+}
@@ -2,6 +2,7 @@
 
 #include <ituGL/shader/Shader.h>
 #include <ituGL/texture/TextureObject.h>
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 #ifndef NDEBUG
@@ -20,17 +21,23 @@ ShaderProgram::~ShaderProgram()
     {
         Handle& handle = GetHandle();
         glDeleteProgram(handle);
+        if (DeviceGL* device = DeviceGL::GetInstancePointer())
+        {
+            device->OnProgramDeleted(handle);
+        }
         handle = NullHandle;
     }
 }
 
 ShaderProgram::ShaderProgram(ShaderProgram&& shaderProgram) noexcept : Object(std::move(shaderProgram))
+    , m_uniformVersions(std::move(shaderProgram.m_uniformVersions))
 {
 }
 
 ShaderProgram& ShaderProgram::operator = (ShaderProgram&& shaderProgram) noexcept
 {
     Object::operator=(std::move(shaderProgram));
+    m_uniformVersions = std::move(shaderProgram.m_uniformVersions);
     return *this;
 }
 
@@ -97,6 +104,10 @@ bool ShaderProgram::Link()
 {
     assert(IsValid());
     glLinkProgram(GetHandle());
+
+    // Linking resets all the uniforms
+    m_uniformVersions.clear();
+
     return IsLinked();
 }
 
@@ -118,13 +129,51 @@ void ShaderProgram::GetLinkingErrors(std::span<char> errors) const
     glGetProgramInfoLog(GetHandle(), static_cast<GLsizei>(errors.size()), nullptr, errors.data());
 }
 
+// Must be set before linking
+void ShaderProgram::SetBinaryRetrievable(bool retrievable)
+{
+    assert(IsValid());
+    glProgramParameteri(GetHandle(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, retrievable ? GL_TRUE : GL_FALSE);
+}
+
+// Get the binary of the linked program
+bool ShaderProgram::GetBinary(std::vector<std::byte>& binary, GLenum& format) const
+{
+    assert(IsValid());
+    assert(IsLinked());
+
+    GLint length = 0;
+    glGetProgramiv(GetHandle(), GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return false;
+    }
+
+    binary.resize(length);
+    glGetProgramBinary(GetHandle(), length, &length, &format, binary.data());
+    binary.resize(length);
+    return length > 0;
+}
+
+// Link the program from a binary
+bool ShaderProgram::LoadBinary(std::span<const std::byte> binary, GLenum format)
+{
+    assert(IsValid());
+    glProgramBinary(GetHandle(), format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // Like linking, it resets all the uniforms
+    m_uniformVersions.clear();
+
+    return IsLinked();
+}
+
 // Set the shader program as the active one to be used for rendering
 void ShaderProgram::Use() const
 {
     assert(IsValid());
     assert(IsLinked());
     Handle handle = GetHandle();
-    glUseProgram(handle);
+    DeviceGL::GetInstance().UseProgram(handle);
 #ifndef NDEBUG
     s_usedHandle = handle;
 #endif
@@ -160,6 +209,50 @@ void ShaderProgram::GetUniformInfo(unsigned int index, int& size, GLenum& glType
     glGetActiveUniform(GetHandle(), index, uniformName.size(), nullptr, &size, &glType, uniformName.data());
 }
 
+// Find a uniform block index by name
+GLuint ShaderProgram::GetUniformBlockIndex(const char* name) const
+{
+    return glGetUniformBlockIndex(GetHandle(), name);
+}
+
+// Set the binding point of a uniform block
+void ShaderProgram::SetUniformBlockBinding(GLuint blockIndex, GLuint binding) const
+{
+    assert(blockIndex != GL_INVALID_INDEX);
+    glUniformBlockBinding(GetHandle(), blockIndex, binding);
+}
+
+// Get the size of a uniform block, including the padding
+GLint ShaderProgram::GetUniformBlockSize(GLuint blockIndex) const
+{
+    assert(blockIndex != GL_INVALID_INDEX);
+    GLint size = 0;
+    glGetActiveUniformBlockiv(GetHandle(), blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+    return size;
+}
+
+// Get where a uniform is stored in its block
+void ShaderProgram::GetUniformBlockMemberInfo(unsigned int index, GLint& blockIndex, GLint& offset, GLint& arrayStride, GLint& matrixStride) const
+{
+    glGetActiveUniformsiv(GetHandle(), 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+    glGetActiveUniformsiv(GetHandle(), 1, &index, GL_UNIFORM_OFFSET, &offset);
+    glGetActiveUniformsiv(GetHandle(), 1, &index, GL_UNIFORM_ARRAY_STRIDE, &arrayStride);
+    glGetActiveUniformsiv(GetHandle(), 1, &index, GL_UNIFORM_MATRIX_STRIDE, &matrixStride);
+}
+
+// Find a shader storage block index by name
+GLuint ShaderProgram::GetShaderStorageBlockIndex(const char* name) const
+{
+    return glGetProgramResourceIndex(GetHandle(), GL_SHADER_STORAGE_BLOCK, name);
+}
+
+// Set the binding point of a shader storage block
+void ShaderProgram::SetShaderStorageBlockBinding(GLuint blockIndex, GLuint binding) const
+{
+    assert(blockIndex != GL_INVALID_INDEX);
+    glShaderStorageBlockBinding(GetHandle(), blockIndex, binding);
+}
+
 // All the different combinations of Get/SetUniform
 template<>
 void ShaderProgram::GetUniform<GLint>(Location location, std::span<GLint> value) const
@@ -393,6 +486,32 @@ void ShaderProgram::SetUniforms<GLfloat, 4, 4>(Location location, const GLfloat*
     glUniformMatrix4fv(location, count, false, values);
 }
 
+bool ShaderProgram::HasUniformVersion(Location location, uint64_t version) const
+{
+    assert(location >= 0 && version != 0);
+    return static_cast<size_t>(location) < m_uniformVersions.size() && m_uniformVersions[location] == version;
+}
+
+void ShaderProgram::SetUniformVersion(Location location, uint64_t version) const
+{
+    assert(location >= 0);
+    if (static_cast<size_t>(location) >= m_uniformVersions.size())
+    {
+        m_uniformVersions.resize(location + 1, 0);
+    }
+    m_uniformVersions[location] = version;
+}
+
+void ShaderProgram::OnUniformsSet(Location location, GLsizei count, size_t bytes) const
+{
+    // Arrays take one location per element, forget them all
+    for (Location end = location + count; location >= 0 && location < end && static_cast<size_t>(location) < m_uniformVersions.size(); ++location)
+    {
+        m_uniformVersions[location] = 0;
+    }
+    DeviceGL::GetInstance().OnUniformSet(bytes);
+}
+
 void ShaderProgram::SetTexture(Location location, GLint textureUnit, const TextureObject& texture) const
 {
     assert(IsValid());
@@ -0,0 +1,223 @@
+#include <ituGL/shader/ShaderProgramCache.h>
+
+#include <ituGL/shader/Shader.h>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Stored before the binary in each file
+struct ProgramBinaryHeader
+{
+    uint32_t magic;
+    uint32_t format;
+    uint64_t key;
+};
+
+static const uint32_t s_programBinaryMagic = 0x42504749; // "IGPB"
+
+ShaderProgramCache::ShaderProgramCache(const char* directory)
+    : m_directory(directory)
+    , m_initialized(false)
+    , m_enabled(false)
+{
+}
+
+bool ShaderProgramCache::Build(ShaderProgram& shaderProgram, std::span<const char*> vertexSource, std::span<const char*> fragmentSource)
+{
+    Initialize();
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    uint64_t key = GetKey(vertexSource, fragmentSource);
+    if (m_enabled && LoadBinary(shaderProgram, key))
+    {
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.hitTime += duration.count();
+        m_stats.hitCount++;
+        return true;
+    }
+
+    // Miss, or the binary was rejected: compile the sources
+    Shader vertexShader(Shader::VertexShader);
+    Shader fragmentShader(Shader::FragmentShader);
+    bool built = CompileShader(vertexShader, vertexSource) && CompileShader(fragmentShader, fragmentSource);
+    if (built)
+    {
+        shaderProgram.SetBinaryRetrievable(m_enabled);
+        built = shaderProgram.Build(vertexShader, fragmentShader);
+        if (!built)
+        {
+            std::array<char, 512> errors;
+            shaderProgram.GetLinkingErrors(errors);
+            std::cerr << "Error linking shaders" << std::endl;
+            std::cerr << errors.data() << std::endl;
+        }
+        else if (m_enabled)
+        {
+            StoreBinary(shaderProgram, key);
+        }
+    }
+
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.missTime += duration.count();
+    m_stats.missCount++;
+    return built;
+}
+
+ShaderProgramCache::Stats ShaderProgramCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void ShaderProgramCache::Initialize()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_initialized)
+        return;
+    m_initialized = true;
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    m_enabled = formatCount > 0;
+
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        const GLubyte* value = glGetString(name);
+        m_driver += value ? reinterpret_cast<const char*>(value) : "";
+        m_driver += '\n';
+    }
+}
+
+uint64_t ShaderProgramCache::GetKey(std::span<const char*> vertexSource, std::span<const char*> fragmentSource) const
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto addBytes = [&hash](const char* bytes, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(bytes[i]);
+            hash *= 1099511628211ull;
+        }
+    };
+
+    // The terminators are added too, so moving text from one source to the next changes the key
+    addBytes(m_driver.c_str(), m_driver.size() + 1);
+    for (std::span<const char*> stageSource : { vertexSource, fragmentSource })
+    {
+        for (const char* source : stageSource)
+        {
+            addBytes(source, std::strlen(source) + 1);
+        }
+        addBytes("\xff", 1);
+    }
+    return hash;
+}
+
+std::filesystem::path ShaderProgramCache::GetPath(uint64_t key) const
+{
+    std::ostringstream fileName;
+    fileName << std::hex << key << ".bin";
+    return m_directory / fileName.str();
+}
+
+bool ShaderProgramCache::LoadBinary(ShaderProgram& shaderProgram, uint64_t key) const
+{
+    std::ifstream file(GetPath(key), std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != s_programBinaryMagic || header.key != key)
+    {
+        return false;
+    }
+
+    std::vector<std::byte> binary;
+    file.seekg(0, std::ios::end);
+    std::streamoff size = static_cast<std::streamoff>(file.tellg()) - static_cast<std::streamoff>(sizeof(header));
+    if (size <= 0)
+    {
+        return false;
+    }
+    binary.resize(static_cast<size_t>(size));
+    file.seekg(sizeof(header));
+    if (!file.read(reinterpret_cast<char*>(binary.data()), size))
+    {
+        return false;
+    }
+
+    // Drivers can reject binaries of an older version, even with the same version string
+    return shaderProgram.LoadBinary(binary, header.format);
+}
+
+void ShaderProgramCache::StoreBinary(const ShaderProgram& shaderProgram, uint64_t key) const
+{
+    ProgramBinaryHeader header = { s_programBinaryMagic, 0, key };
+    std::vector<std::byte> binary;
+    GLenum format;
+    if (!shaderProgram.GetBinary(binary, format))
+    {
+        return;
+    }
+    header.format = format;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    // Written to a temporary file with a unique name, and renamed when it is complete. Other threads or processes
+    // building the same program, or an interrupted write, can't leave a truncated binary in the cache
+    std::filesystem::path path = GetPath(key);
+    std::ostringstream temporaryName;
+    temporaryName << path.filename().string() << "." << std::this_thread::get_id() << "."
+        << std::chrono::steady_clock::now().time_since_epoch().count() << ".tmp";
+    std::filesystem::path temporaryPath = m_directory / temporaryName.str();
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Can't write shader cache file: " << temporaryPath << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+        if (!file.flush())
+        {
+            std::cerr << "Can't write shader cache file: " << temporaryPath << std::endl;
+            file.close();
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        std::cerr << "Can't write shader cache file: " << path << std::endl;
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+bool ShaderProgramCache::CompileShader(Shader& shader, std::span<const char*> source)
+{
+    shader.SetSource(source);
+    if (!shader.Compile())
+    {
+        std::array<char, 512> errors;
+        shader.GetCompilationErrors(errors);
+        std::cerr << "Error compiling shader" << std::endl;
+        std::cerr << errors.data() << std::endl;
+        return false;
+    }
+    return true;
+}
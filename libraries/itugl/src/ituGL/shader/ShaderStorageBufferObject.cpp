@@ -0,0 +1,29 @@
+#include <ituGL/shader/ShaderStorageBufferObject.h>
+
+ShaderStorageBufferObject::ShaderStorageBufferObject()
+{
+    // Nothing to do here, it is done by the base class
+}
+
+// Call the base implementation with Usage::DynamicDraw
+void ShaderStorageBufferObject::AllocateData(size_t size)
+{
+    AllocateData(size, Usage::DynamicDraw);
+}
+
+// Call the base implementation with Usage::DynamicDraw
+void ShaderStorageBufferObject::AllocateData(std::span<const std::byte> data)
+{
+    AllocateData(data, Usage::DynamicDraw);
+}
+
+size_t ShaderStorageBufferObject::GetOffsetAlignment()
+{
+    // Constant for the context, so it is queried only once
+    static GLint alignment = 0;
+    if (alignment == 0)
+    {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    }
+    return static_cast<size_t>(alignment);
+}
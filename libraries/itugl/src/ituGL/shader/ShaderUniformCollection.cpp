@@ -1,7 +1,12 @@
 #include <ituGL/shader/ShaderUniformCollection.h>
+
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
+#include <algorithm>
 #include <array>
 
+uint64_t ShaderUniformCollection::s_lastVersion = 0;
+
 ShaderUniformCollection::ShaderUniformCollection() : m_shaderProgram(nullptr)
 {
 }
@@ -21,11 +26,23 @@ std::shared_ptr<const ShaderProgram> ShaderUniformCollection::GetShaderProgram()
     return m_shaderProgram;
 }
 
-void ShaderUniformCollection::ChangeShader(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet& filteredUniforms)
+void ShaderUniformCollection::ChangeShader(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet& filteredUniforms, bool keepValues)
 {
+    // Keep the previous uniforms, with the previous program to find them by name
+    ShaderUniformCollection previous;
+    if (keepValues && m_shaderProgram)
+    {
+        previous = *this;
+    }
+
     Reset();
     m_shaderProgram = shaderProgram;
     ExtractUniforms(filteredUniforms);
+
+    if (previous.m_shaderProgram)
+    {
+        CopyUniformValues(previous);
+    }
 }
 
 ShaderProgram::Location ShaderUniformCollection::GetAttributeLocation(const char* name) const
@@ -35,6 +52,14 @@ ShaderProgram::Location ShaderUniformCollection::GetAttributeLocation(const char
 
 ShaderProgram::Location ShaderUniformCollection::GetUniformLocation(const char* name) const
 {
+    if (!m_blockLocations.empty())
+    {
+        auto it = m_blockLocations.find(name);
+        if (it != m_blockLocations.end())
+        {
+            return it->second;
+        }
+    }
     return m_shaderProgram->GetUniformLocation(name);
 }
 
@@ -72,6 +97,9 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
 
     unsigned int uniformCount = shaderProgram.GetUniformCount();
 
+    // Uniforms in this block are stored in the material block pool
+    GLuint materialBlockIndex = shaderProgram.GetUniformBlockIndex("MaterialBlock");
+
     // Loop over all the uniforms
     for (unsigned int i = 0; i < uniformCount; ++i)
     {
@@ -85,9 +113,35 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
         if (filteredUniforms.contains(uniformName))
             continue;
 
-        // Get the uniform location
-        ShaderProgram::Location location = GetUniformLocation(uniformName);
-        assert(location >= 0);
+        GLint blockIndex, blockOffset, arrayStride, matrixStride;
+        shaderProgram.GetUniformBlockMemberInfo(i, blockIndex, blockOffset, arrayStride, matrixStride);
+
+        ShaderProgram::Location location;
+        if (blockIndex < 0)
+        {
+            // Get the uniform location
+            location = GetUniformLocation(uniformName);
+            if (location < 0)
+                continue;
+            blockOffset = -1;
+        }
+        else if (static_cast<GLuint>(blockIndex) == materialBlockIndex)
+        {
+            // Uniforms in MaterialBlock don't have a location in the program, they get one of the collection
+            // Arrays can be found by name with or without "[0]", like in the program
+            location = s_blockLocationBase + static_cast<ShaderProgram::Location>(m_dataUniforms.size());
+            std::string name(uniformName);
+            m_blockLocations[name] = location;
+            if (name.ends_with("[0]"))
+            {
+                m_blockLocations[name.substr(0, name.size() - 3)] = location;
+            }
+        }
+        else
+        {
+            // Uniforms in other blocks get their values from buffers bound by someone else
+            continue;
+        }
 
         Data::Type type;
         UniformDimension dimension;
@@ -100,6 +154,10 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
             uniform.type = type;
             uniform.dimension = dimension;
             uniform.count = size;
+            uniform.blockOffset = blockOffset;
+            uniform.arrayStride = arrayStride;
+            uniform.matrixStride = matrixStride;
+            uniform.blockVersion = 0;
             AddUniform(uniform);
         }
         else if (IsTextureUniform(glType, target))
@@ -108,6 +166,7 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
             TextureUniform uniform;
             uniform.location = location;
             uniform.target = target;
+            uniform.version = NewVersion();
             AddUniform(uniform);
         }
         else
@@ -116,6 +175,13 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
             assert(false);
         }
     }
+
+    // Allocate the range for MaterialBlock. Its uniforms are written the first time the collection is used
+    if (materialBlockIndex != GL_INVALID_INDEX)
+    {
+        m_materialBlock.Allocate(shaderProgram.GetUniformBlockSize(materialBlockIndex));
+        shaderProgram.SetUniformBlockBinding(materialBlockIndex, MaterialBlockPool::MaterialBlockBinding);
+    }
 }
 
 bool ShaderUniformCollection::IsDataUniform(GLenum glType, Data::Type& type, UniformDimension& dimension)
@@ -288,9 +354,16 @@ void ShaderUniformCollection::AddUniform(const TextureUniform& uniform)
 
 void ShaderUniformCollection::SetUniforms() const
 {
+    if (m_materialBlock.IsValid())
+    {
+        UseMaterialBlock();
+    }
     for (const DataUniform& uniform : m_dataUniforms)
     {
-        UseUniform(uniform);
+        if (uniform.blockOffset < 0)
+        {
+            UseUniform(uniform);
+        }
     }
     for (const TextureUniform& uniform : m_textureUniforms)
     {
@@ -298,8 +371,80 @@ void ShaderUniformCollection::SetUniforms() const
     }
 }
 
+void ShaderUniformCollection::UseMaterialBlock() const
+{
+    std::span<std::byte> blockData = m_materialBlock.GetData();
+
+    bool changed = false;
+    for (const DataUniform& uniform : m_dataUniforms)
+    {
+        if (uniform.blockOffset >= 0 && uniform.blockVersion != uniform.version)
+        {
+            WriteBlockUniform(uniform, blockData);
+            uniform.blockVersion = uniform.version;
+            changed = true;
+        }
+    }
+    if (changed)
+    {
+        m_materialBlock.SetDirty();
+    }
+
+    // Replaces all the uniform calls of the block
+    m_materialBlock.Bind();
+}
+
+void ShaderUniformCollection::WriteBlockUniform(const DataUniform& uniform, std::span<std::byte> blockData) const
+{
+    const std::byte* values = nullptr;
+    size_t componentSize = 0;
+    switch (uniform.type)
+    {
+    case Data::Type::Int:
+        values = reinterpret_cast<const std::byte*>(&m_intDataValues[uniform.index]);
+        componentSize = sizeof(int);
+        break;
+    case Data::Type::UInt:
+        values = reinterpret_cast<const std::byte*>(&m_uintDataValues[uniform.index]);
+        componentSize = sizeof(unsigned int);
+        break;
+    case Data::Type::Float:
+        values = reinterpret_cast<const std::byte*>(&m_floatDataValues[uniform.index]);
+        componentSize = sizeof(float);
+        break;
+    case Data::Type::Double:
+        values = reinterpret_cast<const std::byte*>(&m_doubleDataValues[uniform.index]);
+        componentSize = sizeof(double);
+        break;
+    default:
+        assert(false);
+        return;
+    }
+
+    // Values are packed, but in std140 each array element and each matrix column starts at its own stride
+    int columns, rows;
+    GetDimensionSize(uniform.dimension, columns, rows);
+    size_t columnSize = rows * componentSize;
+    for (unsigned int element = 0; element < uniform.count; ++element)
+    {
+        for (int column = 0; column < columns; ++column)
+        {
+            size_t offset = uniform.blockOffset + element * uniform.arrayStride + column * uniform.matrixStride;
+            assert(offset + columnSize <= blockData.size());
+            std::memcpy(&blockData[offset], values, columnSize);
+            values += columnSize;
+        }
+    }
+}
+
 void ShaderUniformCollection::UseUniform(const DataUniform& uniform) const
 {
+    if (m_shaderProgram->HasUniformVersion(uniform.location, uniform.version))
+    {
+        DeviceGL::GetInstance().OnUniformSkipped();
+        return;
+    }
+
     switch (uniform.type)
     {
     case Data::Type::Int:
@@ -317,6 +462,7 @@ void ShaderUniformCollection::UseUniform(const DataUniform& uniform) const
     default:
         assert(false);
     }
+    m_shaderProgram->SetUniformVersion(uniform.location, uniform.version);
 }
 
 void ShaderUniformCollection::UseUniform(const TextureUniform& uniform) const
@@ -324,8 +470,21 @@ void ShaderUniformCollection::UseUniform(const TextureUniform& uniform) const
     //TODO: default texture
     if (uniform.texture)
     {
-        size_t textureIndex = &uniform - m_textureUniforms.data();
-        m_shaderProgram->SetTexture(uniform.location, static_cast<int>(textureIndex), *uniform.texture);
+        // Texture units are shared by all programs, so the texture is always bound. The device skips it if it already is
+        // Only the unit in the sampler uniform can be skipped
+        GLint textureUnit = static_cast<GLint>(&uniform - m_textureUniforms.data());
+        TextureObject::SetActiveTexture(textureUnit);
+        uniform.texture->Bind();
+
+        if (m_shaderProgram->HasUniformVersion(uniform.location, uniform.version))
+        {
+            DeviceGL::GetInstance().OnUniformSkipped();
+        }
+        else
+        {
+            m_shaderProgram->SetUniform(uniform.location, textureUnit);
+            m_shaderProgram->SetUniformVersion(uniform.location, uniform.version);
+        }
     }
 }
 
@@ -391,7 +550,11 @@ void ShaderUniformCollection::SetUniformValue(ShaderProgram::Location location,
 {
     TextureUniform& uniform = GetTextureUniform(location);
     assert(!value || uniform.target == value->GetTarget());
-    uniform.texture = value;
+    if (uniform.texture != value)
+    {
+        uniform.texture = value;
+        uniform.version = NewVersion();
+    }
 }
 
 int ShaderUniformCollection::GetDataUniformSize(const DataUniform& uniform) const
@@ -436,6 +599,93 @@ int ShaderUniformCollection::GetDataUniformSize(const DataUniform& uniform) cons
     return size * uniform.count;
 }
 
+void ShaderUniformCollection::GetDimensionSize(UniformDimension dimension, int& columns, int& rows)
+{
+    if (dimension >= UniformDimension::MatrixFirst && dimension <= UniformDimension::MatrixLast)
+    {
+        int offset = static_cast<int>(dimension) - static_cast<int>(UniformDimension::MatrixFirst);
+        columns = offset / 3 + 2;
+        rows = offset % 3 + 2;
+    }
+    else if (dimension >= UniformDimension::VectorFirst && dimension <= UniformDimension::VectorLast)
+    {
+        columns = 1;
+        rows = static_cast<int>(dimension) - static_cast<int>(UniformDimension::VectorFirst) + 2;
+    }
+    else
+    {
+        columns = 1;
+        rows = 1;
+    }
+}
+
+uint64_t ShaderUniformCollection::NewVersion()
+{
+    return ++s_lastVersion;
+}
+
+void ShaderUniformCollection::CopyUniformValues(const ShaderUniformCollection& other)
+{
+    assert(other.m_shaderProgram != m_shaderProgram);
+
+    // Locations can change, so the uniforms are matched by name
+    unsigned int uniformCount = m_shaderProgram->GetUniformCount();
+    for (unsigned int i = 0; i < uniformCount; ++i)
+    {
+        int size;
+        GLenum glType;
+        char uniformName[256];
+        m_shaderProgram->GetUniformInfo(i, size, glType, std::span(uniformName, sizeof(uniformName)));
+
+        ShaderProgram::Location location = GetUniformLocation(uniformName);
+        ShaderProgram::Location otherLocation = other.GetUniformLocation(uniformName);
+        if (location < 0 || otherLocation < 0)
+            continue;
+
+        auto dataIt = m_locationDataIndex.find(location);
+        auto otherDataIt = other.m_locationDataIndex.find(otherLocation);
+        auto textureIt = m_locationTextureIndex.find(location);
+        auto otherTextureIt = other.m_locationTextureIndex.find(otherLocation);
+        if (dataIt != m_locationDataIndex.end() && otherDataIt != other.m_locationDataIndex.end())
+        {
+            DataUniform& uniform = m_dataUniforms[dataIt->second];
+            const DataUniform& otherUniform = other.m_dataUniforms[otherDataIt->second];
+            if (uniform.type != otherUniform.type || uniform.dimension != otherUniform.dimension || uniform.count != otherUniform.count)
+                continue;
+
+            int valueCount = GetDataUniformSize(uniform);
+            switch (uniform.type)
+            {
+            case Data::Type::Int:
+                std::copy_n(&other.m_intDataValues[otherUniform.index], valueCount, &m_intDataValues[uniform.index]);
+                break;
+            case Data::Type::UInt:
+                std::copy_n(&other.m_uintDataValues[otherUniform.index], valueCount, &m_uintDataValues[uniform.index]);
+                break;
+            case Data::Type::Float:
+                std::copy_n(&other.m_floatDataValues[otherUniform.index], valueCount, &m_floatDataValues[uniform.index]);
+                break;
+            case Data::Type::Double:
+                std::copy_n(&other.m_doubleDataValues[otherUniform.index], valueCount, &m_doubleDataValues[uniform.index]);
+                break;
+            default:
+                assert(false);
+            }
+            uniform.version = NewVersion();
+        }
+        else if (textureIt != m_locationTextureIndex.end() && otherTextureIt != other.m_locationTextureIndex.end())
+        {
+            TextureUniform& uniform = m_textureUniforms[textureIt->second];
+            const TextureUniform& otherUniform = other.m_textureUniforms[otherTextureIt->second];
+            if (uniform.target == otherUniform.target)
+            {
+                uniform.texture = otherUniform.texture;
+                uniform.version = NewVersion();
+            }
+        }
+    }
+}
+
 void ShaderUniformCollection::Reset()
 {
     m_shaderProgram = nullptr;
@@ -447,6 +697,8 @@ void ShaderUniformCollection::Reset()
     m_uintDataValues.clear();
     m_floatDataValues.clear();
     m_doubleDataValues.clear();
+    m_blockLocations.clear();
+    m_materialBlock.Free();
 }
 
 #ifndef NDEBUG
@@ -0,0 +1,29 @@
+#include <ituGL/shader/UniformBufferObject.h>
+
+UniformBufferObject::UniformBufferObject()
+{
+    // Nothing to do here, it is done by the base class
+}
+
+// Call the base implementation with Usage::DynamicDraw
+void UniformBufferObject::AllocateData(size_t size)
+{
+    AllocateData(size, Usage::DynamicDraw);
+}
+
+// Call the base implementation with Usage::DynamicDraw
+void UniformBufferObject::AllocateData(std::span<const std::byte> data)
+{
+    AllocateData(data, Usage::DynamicDraw);
+}
+
+size_t UniformBufferObject::GetOffsetAlignment()
+{
+    // Constant for the context, so it is queried only once
+    static GLint alignment = 0;
+    if (alignment == 0)
+    {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    }
+    return static_cast<size_t>(alignment);
+}
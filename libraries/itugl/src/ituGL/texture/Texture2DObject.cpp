@@ -16,6 +16,17 @@ void Texture2DObject::SetImage<std::byte>(GLint level, GLsizei width, GLsizei he
     glTexImage2D(GetTarget(), level, internalFormat, width, height, 0, format, type == Data::Type::None ? GL_BYTE : static_cast<GLenum>(type), data.data());
 }
 
+template <>
+void Texture2DObject::GetImage<std::byte>(GLint level, Format format, std::span<std::byte> data, Data::Type type) const
+{
+    assert(IsBound());
+    assert(type != Data::Type::None);
+
+    // The pixel rows are tightly packed, even when their size is not a multiple of 4 bytes
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GetTarget(), level, format, static_cast<GLenum>(type), data.data());
+}
+
 void Texture2DObject::SetImage(GLint level, GLsizei width, GLsizei height, Format format, InternalFormat internalFormat)
 {
     SetImage<float>(level, width, height, format, internalFormat, std::span<float>());
@@ -1,5 +1,6 @@
 #include <ituGL/texture/TextureObject.h>
 
+#include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
 TextureObject::TextureObject() : Object(NullHandle)
@@ -12,6 +13,10 @@ TextureObject::~TextureObject()
 {
     Handle& handle = GetHandle();
     glDeleteTextures(1, &handle);
+    if (DeviceGL* device = DeviceGL::GetInstancePointer())
+    {
+        device->OnTextureDeleted(handle);
+    }
 }
 
 #ifndef NDEBUG
@@ -25,19 +30,19 @@ GLint TextureObject::GetActiveTexture()
 
 void TextureObject::SetActiveTexture(GLint textureUnit)
 {
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    DeviceGL::GetInstance().SetActiveTexture(textureUnit);
 }
 
 void TextureObject::Bind(Target target) const
 {
     Handle handle = GetHandle();
-    glBindTexture(target, handle);
+    DeviceGL::GetInstance().BindTexture(target, handle);
 }
 
 void TextureObject::Unbind(Target target)
 {
     Handle handle = NullHandle;
-    glBindTexture(target, handle);
+    DeviceGL::GetInstance().BindTexture(target, handle);
 }
 
 void TextureObject::GenerateMipmap()
@@ -0,0 +1,125 @@
+#include <ituGL/utils/FileWatcher.h>
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+FileWatcher::FileWatcher()
+#ifdef __linux__
+    : m_inotifyDescriptor(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+#endif
+{
+#ifdef __linux__
+    if (m_inotifyDescriptor < 0)
+    {
+        std::cerr << "Can't initialize inotify, files are checked by their modification time" << std::endl;
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+    if (m_inotifyDescriptor >= 0)
+    {
+        close(m_inotifyDescriptor);
+    }
+#endif
+}
+
+void FileWatcher::AddFile(const std::filesystem::path& path)
+{
+    std::error_code error;
+    std::filesystem::path absolutePath = std::filesystem::weakly_canonical(std::filesystem::absolute(path, error), error);
+    m_files.push_back({ absolutePath, GetLastWriteTime(absolutePath), false });
+
+#ifdef __linux__
+    std::filesystem::path directory = absolutePath.parent_path();
+    bool watched = std::any_of(m_directories.begin(), m_directories.end(),
+        [&directory](const auto& entry) { return entry.second == directory; });
+    if (m_inotifyDescriptor >= 0 && !watched)
+    {
+        int watchDescriptor = inotify_add_watch(m_inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (watchDescriptor >= 0)
+        {
+            m_directories[watchDescriptor] = directory;
+            watched = true;
+        }
+        else
+        {
+            std::cerr << "Can't watch directory: " << directory << std::endl;
+        }
+    }
+    m_files.back().watched = watched;
+#endif
+}
+
+std::vector<std::filesystem::path> FileWatcher::GetChangedFiles()
+{
+    std::vector<std::filesystem::path> changedFiles;
+    auto addChangedFile = [&changedFiles](const std::filesystem::path& path)
+    {
+        if (std::find(changedFiles.begin(), changedFiles.end(), path) == changedFiles.end())
+        {
+            changedFiles.push_back(path);
+        }
+    };
+
+#ifdef __linux__
+    if (m_inotifyDescriptor >= 0)
+    {
+        // Read all the pending events. The descriptor is non-blocking, so it stops when there are no more
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(m_inotifyDescriptor, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* eventPointer = buffer; eventPointer < buffer + length; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(eventPointer);
+                eventPointer += sizeof(inotify_event) + event->len;
+
+                auto directoryIt = m_directories.find(event->wd);
+                if (event->len == 0 || directoryIt == m_directories.end())
+                    continue;
+
+                std::filesystem::path path = directoryIt->second / event->name;
+                for (const WatchedFile& file : m_files)
+                {
+                    if (file.path == path)
+                    {
+                        addChangedFile(path);
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    // Files without inotify, check the modification times
+    for (WatchedFile& file : m_files)
+    {
+        if (file.watched)
+            continue;
+
+        std::filesystem::file_time_type lastWriteTime = GetLastWriteTime(file.path);
+        if (lastWriteTime != file.lastWriteTime)
+        {
+            file.lastWriteTime = lastWriteTime;
+            addChangedFile(file.path);
+        }
+    }
+    return changedFiles;
+}
+
+std::filesystem::file_time_type FileWatcher::GetLastWriteTime(const std::filesystem::path& path)
+{
+    // Files being replaced can be missing for a moment, that counts as a change too
+    std::error_code error;
+    std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type::min() : lastWriteTime;
+}
@@ -0,0 +1,265 @@
+#include <ituGL/utils/Profiler.h>
+
+#include <imgui.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// Depth of the scopes currently open in this thread
+static thread_local uint32_t s_scopeDepth = 0;
+
+Profiler::Scope::Scope(const char* name) : m_name(nullptr), m_start(0)
+{
+    Profiler& profiler = Profiler::GetInstance();
+    if (profiler.IsEnabled())
+    {
+        m_name = name;
+        m_start = profiler.GetTime();
+        ++s_scopeDepth;
+    }
+}
+
+Profiler::Scope::~Scope()
+{
+    // If the profiler was disabled when the scope started, there is nothing to record
+    if (m_name)
+    {
+        --s_scopeDepth;
+        Profiler& profiler = Profiler::GetInstance();
+        profiler.Record(Event{ m_name, m_start, profiler.GetTime(), GetThreadId(), s_scopeDepth });
+    }
+}
+
+Profiler::Profiler()
+    : m_slots(new Slot[s_slotCount])
+    , m_writeIndex(0)
+    , m_enabled(false)
+    , m_frameStarts{}
+    , m_frameTimes{}
+    , m_frameCount(0)
+    , m_paused(false)
+    , m_guiFrameStart(0)
+    , m_guiFrameEnd(0)
+{
+    for (size_t i = 0; i < s_slotCount; ++i)
+    {
+        m_slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+Profiler& Profiler::GetInstance()
+{
+    // Created on first use, so scopes in static initialization are safe too
+    static Profiler instance;
+    return instance;
+}
+
+uint64_t Profiler::GetTime() const
+{
+    static const auto startTime = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint32_t Profiler::GetThreadId()
+{
+    // Small sequential ids, easier to read than the system ones
+    static std::atomic<uint32_t> s_nextThreadId(0);
+    static thread_local uint32_t threadId = s_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return threadId;
+}
+
+void Profiler::BeginFrame()
+{
+    uint64_t time = GetTime();
+    if (m_frameCount > 0)
+    {
+        uint64_t previousStart = m_frameStarts[(m_frameCount - 1) % s_frameHistorySize];
+        m_frameTimes[(m_frameCount - 1) % s_frameHistorySize] = (time - previousStart) * 1e-6f;
+    }
+    m_frameStarts[m_frameCount % s_frameHistorySize] = time;
+    ++m_frameCount;
+}
+
+void Profiler::Record(const Event& event)
+{
+    // Claim a slot, then mark it as incomplete while it is written, so readers never see half an event
+    uint64_t index = m_writeIndex.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = m_slots[index % s_slotCount];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = event;
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::GetEvents(uint64_t start, uint64_t end, std::vector<Event>& events) const
+{
+    events.clear();
+
+    uint64_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+    uint64_t firstIndex = writeIndex > s_slotCount ? writeIndex - s_slotCount : 0;
+    for (uint64_t index = firstIndex; index < writeIndex; ++index)
+    {
+        const Slot& slot = m_slots[index % s_slotCount];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+            continue;
+
+        Event event = slot.event;
+
+        // If the slot changed while copying, the copy is not valid
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != index + 1)
+            continue;
+
+        if (event.start >= start && event.start < end)
+        {
+            events.push_back(event);
+        }
+    }
+
+    // Events are recorded when they end, so parents come after their children
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b)
+        {
+            return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+        });
+}
+
+void Profiler::GetLastFrame(uint64_t& start, uint64_t& end) const
+{
+    start = end = 0;
+    if (m_frameCount >= 2)
+    {
+        start = m_frameStarts[(m_frameCount - 2) % s_frameHistorySize];
+        end = m_frameStarts[(m_frameCount - 1) % s_frameHistorySize];
+    }
+}
+
+bool Profiler::ExportChromeTrace(const char* path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::vector<Event> events;
+    GetEvents(0, ~0ULL, events);
+
+    // Complete events ("X"), with the times in microseconds
+    file << "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const Event& event = events[i];
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            i ? "," : "", event.name, event.threadId, event.start * 1e-3, (event.end - event.start) * 1e-3);
+        file << line;
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return file.good();
+}
+
+void Profiler::DrawImGui()
+{
+    bool enabled = IsEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled))
+    {
+        SetEnabled(enabled);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Pause", &m_paused);
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome trace"))
+    {
+        ExportChromeTrace("profile.json");
+    }
+
+    // Frame times, oldest first
+    unsigned int frameTimeCount = std::min(m_frameCount > 0 ? m_frameCount - 1 : 0, s_frameHistorySize);
+    unsigned int frameTimeOffset = m_frameCount > s_frameHistorySize ? m_frameCount - 1 : 0;
+    ImGui::PlotLines("Frame (ms)", m_frameTimes, frameTimeCount, frameTimeOffset % s_frameHistorySize, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+    if (!m_paused)
+    {
+        GetLastFrame(m_guiFrameStart, m_guiFrameEnd);
+        GetEvents(m_guiFrameStart, m_guiFrameEnd, m_guiEvents);
+    }
+    if (m_guiFrameEnd <= m_guiFrameStart)
+        return;
+
+    const double frameDuration = static_cast<double>(m_guiFrameEnd - m_guiFrameStart);
+    ImGui::Text("Last frame: %.3f ms, %u events", frameDuration * 1e-6, static_cast<unsigned int>(m_guiEvents.size()));
+
+    // One row per depth, with the rows of each thread below the previous thread
+    // Worker threads can be short-lived, so only the threads with events in this frame get rows
+    std::vector<uint32_t> threadIds;
+    uint32_t depthCount = 0;
+    for (const Event& event : m_guiEvents)
+    {
+        if (std::find(threadIds.begin(), threadIds.end(), event.threadId) == threadIds.end())
+        {
+            threadIds.push_back(event.threadId);
+        }
+        depthCount = std::max(depthCount, event.depth + 1);
+    }
+    std::sort(threadIds.begin(), threadIds.end());
+    const uint32_t threadCount = static_cast<uint32_t>(threadIds.size());
+
+    const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+    const float height = rowHeight * depthCount * threadCount;
+    ImGui::InvisibleButton("Timeline", ImVec2(width, std::max(height, rowHeight)));
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    for (const Event& event : m_guiEvents)
+    {
+        float x0 = origin.x + static_cast<float>((event.start - m_guiFrameStart) / frameDuration) * width;
+        float x1 = origin.x + static_cast<float>(std::min(event.end - m_guiFrameStart, m_guiFrameEnd - m_guiFrameStart) / frameDuration) * width;
+        uint32_t threadRow = static_cast<uint32_t>(std::lower_bound(threadIds.begin(), threadIds.end(), event.threadId) - threadIds.begin());
+        float y0 = origin.y + (threadRow * depthCount + event.depth) * rowHeight;
+        ImVec2 min(x0, y0);
+        ImVec2 max(std::max(x1, x0 + 1.0f), y0 + rowHeight - 1.0f);
+
+        // Same color for the same name, from the address of the string
+        uint32_t hash = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(event.name) * 2654435761u);
+        ImU32 color = IM_COL32(80 + (hash & 0x7F), 80 + ((hash >> 8) & 0x7F), 80 + ((hash >> 16) & 0x7F), 255);
+        drawList->AddRectFilled(min, max, color);
+
+        // Label only if it fits
+        if (ImGui::CalcTextSize(event.name).x < max.x - min.x - 4.0f)
+        {
+            drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32_BLACK, event.name);
+        }
+
+        if (ImGui::IsMouseHoveringRect(min, max))
+        {
+            ImGui::SetTooltip("%s: %.3f ms", event.name, (event.end - event.start) * 1e-6);
+        }
+    }
+
+    // Total time per name, for the scopes that are too small to see in the timeline
+    if (ImGui::TreeNode("Totals"))
+    {
+        std::vector<std::pair<const char*, uint64_t>> totals;
+        for (const Event& event : m_guiEvents)
+        {
+            auto itFind = std::find_if(totals.begin(), totals.end(), [&](const auto& total) { return std::strcmp(total.first, event.name) == 0; });
+            if (itFind == totals.end())
+            {
+                totals.emplace_back(event.name, 0);
+                itFind = totals.end() - 1;
+            }
+            itFind->second += event.end - event.start;
+        }
+        std::sort(totals.begin(), totals.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        for (const auto& total : totals)
+        {
+            ImGui::Text("%8.3f ms  %s", total.second * 1e-6, total.first);
+        }
+        ImGui::TreePop();
+    }
+}
@@ -1,31 +1,48 @@
 #include "Geometry4D.h"
+#include "Hypercube.h"
 #include <ituGL/shader/Shader.h>
 #include <ituGL/shader/ShaderProgram.h>
 #include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
 #include <ituGL/geometry/VertexFormat.h>
 #include <ituGL/camera/Camera.h>
 #include <ituGL/scene/SceneCamera.h>
 #include <ituGL/scene/Transform.h>
 #include <ituGL/application/Window.h>
+#include <ituGL/utils/Profiler.h>
 #include <imgui.h>
 #include <stb_image.h>
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <array>
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <cstdio>
 #include <vector>
 #include <filesystem>
+#include <type_traits>
 #include <time.h>
 #include <glm/gtx/transform.hpp>
 #include <glm/ext.hpp>
 
-Geometry4DApplication::Geometry4DApplication()
-    : Application(1024, 1024, "4D-Geometry demo")
-    , m_colorUniform(-1)
-    , m_texture(-1)
-    , m_usingTexture(-1)
+Geometry4DApplication::Geometry4DApplication(unsigned int headlessFrameCount, const char* outputPath)
+    : Application(1024, 1024, "4D-Geometry demo", headlessFrameCount > 0)
+    , m_texturedSubmesh(0)
+    , m_solidSubmesh(0)
+    , m_wireframeSubmesh(0)
+    , m_polytopeSolidSubmesh(0)
+    , m_polytopeWireframeSubmesh(0)
+    , m_crossSectionCapacity(0)
+    , m_crossSectionVertexCount(0)
+    , m_shaderProgramCache("shader_cache")
+    , m_shaderStartupTime(0.0)
+    , m_shaderPermutations({ "shaders/shader.vert" }, { "shaders/shader.frag" }, &m_shaderProgramCache)
+    , m_instancedShaderPermutations({ "shaders/shader_instanced.vert" }, { "shaders/shader.frag" }, &m_shaderProgramCache)
+    , m_shaderReloading(false)
+    , m_outputPath(outputPath ? outputPath : "")
     , m_ambientReflectionUniform(-1)
     , m_diffuseReflectionUniform(-1)
     , m_specularReflectionUniform(-1)
@@ -33,21 +50,24 @@ Geometry4DApplication::Geometry4DApplication()
     , m_ambientColorUniform(-1)
     , m_lightColorUniform(-1)
     , m_lightPositionUniform(-1)
-    , m_cameraPositionUniform(-1)
     , m_worldRotationMatrixUniform(-1)
     , m_worldTranslationVectorUniform(-1)
     , m_worldScaleVectorUniform(-1)
-    , m_viewProjMatrixUniform(-1)
+    , m_colorUniform(-1)
+    , m_texturedTextureUniform(-1)
+    , m_texturedColorUniform(-1)
+    , m_texturedWorldRotationMatrixUniform(-1)
+    , m_texturedWorldTranslationVectorUniform(-1)
+    , m_texturedWorldScaleVectorUniform(-1)
+    , m_cubeObject(0)
+    , m_gridObject(0)
+    , m_instanceObjectCount(0)
+    , m_scale(1)
     , m_rotationVelocities(0)
     , m_cubeCenter(0)
-    , m_scale(1)
-    , m_xyRotation(0)
-    , m_xzRotation(0)
-    , m_yzRotation(0)
-    , m_xwRotation(0)
-    , m_ywRotation(0)
-    , m_zwRotation(0)
 {
+    // Headless frames advance a fixed 60 fps, so the output does not depend on how fast they render
+    SetFrameLimit(headlessFrameCount, 1.0f / 60.0f);
 }
 
 
@@ -58,21 +78,28 @@ void Geometry4DApplication::Initialize()
     m_imGui.Initialize(GetMainWindow());
 
     InitializeGeometry();
+    InitializeCrossSection();
+    InitializeInstances();
     InitializeShaders();
     InitializeCamera();
     InitializeTextures();
     InitializeUniforms();
+    InitializeHeadless();
 
     // The Perspective-Projection-like approach for rendering 4D objects breaks when edges can cross w = 0
     m_cubeCenter[3] = 1;
 
+    // The grid has no rotation of its own, only the center, so rotating the cube does not move the instances around
+    m_cubeObject = m_transforms.Add();
+    m_gridObject = m_transforms.Add();
+
     // Backface Culling disabled, since 3D representation of 4D faces gets flipped during rotations in the w dimension
     //glEnable(GL_CULL_FACE);
     //glCullFace(GL_BACK
     
     // Allows fragments to be discarded if their depth value is higher than the depth of the sample it is written to: i.e. don't
     // Render fragments hidden behind other fragments
-    glEnable(GL_DEPTH_TEST);
+    GetDevice().EnableFeature(GL_DEPTH_TEST);
 }
 
 void Geometry4DApplication::Update()
@@ -83,143 +110,176 @@ void Geometry4DApplication::Update()
 
     ResetState();
 
+    UpdateShaders();
+
+    UpdateTransforms();
+
     m_camera = *m_cameraController.GetCamera()->GetCamera();
+    UpdateCameraBuffer();
 }
 
 void Geometry4DApplication::Render()
 {
     Application::Render();
 
+    if (m_headlessFramebuffer)
+    {
+        m_headlessFramebuffer->Bind();
+    }
+
     GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
 
+    if (m_showInstances)
+    {
+        RenderInstances();
+        EndFrame();
+        return;
+    }
+
     glm::vec4 white = glm::vec4(1.0f);
     glm::vec4 red = glm::vec4(1.0f, 0, 0, 0);
 
-    // How far in the x-direction are the various submeshes from each other
-    float gap = (m_cubeCenter[3] * m_scale * 2.5);
-
-    // 3D rotations
-    m_xyRotation += m_rotationVelocities[0] / 1000;
-    m_xzRotation += m_rotationVelocities[2] / 1000;
-    m_yzRotation += m_rotationVelocities[1] / 1000;
-
-    // 4D rotations
-    m_xwRotation += m_rotationVelocities[3] / 1000;
-    m_ywRotation += m_rotationVelocities[4] / 1000;
-    m_zwRotation += m_rotationVelocities[5] / 1000;
+    const glm::vec4& cubeTranslation = m_transforms.GetWorldTranslation(m_cubeObject);
 
+    // How far in the x-direction are the various submeshes from each other
+    float gap = (cubeTranslation.w * m_transforms.GetWorldScale(m_cubeObject).x * 2.5);
 
     // The world transformations are seperated into 3 seperate uniforms: Rotation (mat4), Translation (vec4) and Scale (vec4)
     // This is because glm and glsl doesn't support mat5, which is what would be necessary to implement affine transformations
     // in 4D. Instead, this is used: Translation + (Rotation * (Scale * VertexPosition4D))
-    glm::mat4 worldRotationMatrix =
-        Rotate4D(m_xyRotation, m_xzRotation, m_yzRotation, m_xwRotation, m_ywRotation, m_zwRotation);
+    glm::mat4 worldRotationMatrix = m_transforms.GetWorldRotationMatrix(m_cubeObject);
 
     glm::vec4 worldTranslationVector = glm::vec4(
-        m_cubeCenter[0] - gap,
-        m_cubeCenter[1],
-        m_cubeCenter[2],
-        m_cubeCenter[3]
+        cubeTranslation.x - gap,
+        cubeTranslation.y,
+        cubeTranslation.z,
+        cubeTranslation.w
     );
 
 
-    glm::vec4 worldScaleVector = glm::vec4(glm::vec3(m_scale), 1);
+    glm::vec4 worldScaleVector = m_transforms.GetWorldScale(m_cubeObject);
 
-    m_shaderProgram.Use();
+    // The textured cube uses the textured variant, once it is compiled in the background. Until then, it is drawn
+    // without texture. In headless mode, it waits for it, so the frames don't depend on how long it takes
+    std::shared_ptr<ShaderProgram> texturedShaderProgram = m_shaderPermutations.GetProgram({ "TEXTURED" }, IsHeadless());
+    if (texturedShaderProgram && texturedShaderProgram != m_texturedShaderProgram)
+    {
+        m_texturedShaderProgram = texturedShaderProgram;
+        InitializeTexturedUniforms();
+    }
+    if (texturedShaderProgram)
+    {
+        ShaderProgram& shaderProgram = *texturedShaderProgram;
+        shaderProgram.Use();
 
-    // m_usingTexture holds an int, but is treated like a boolean (since true === 1 and false === 0)
-    m_shaderProgram.SetUniform(m_usingTexture, 1);
+        std::shared_ptr<Texture2DObject> textures[] = { m_dirtTexture, m_grassTexture, m_rockTexture, m_snowTexture };
+        shaderProgram.SetTexture(m_texturedTextureUniform, 0, *textures[m_selectedTexture]);
+        shaderProgram.SetUniform(m_texturedColorUniform, white);
 
-    switch (m_selectedTexture)
-    {
-        case 0:
-            m_shaderProgram.SetTexture(m_texture, 0, *m_dirtTexture);
-            break;
-        case 1:
-            m_shaderProgram.SetTexture(m_texture, 0, *m_grassTexture);
-            break;
-        case 2:
-            m_shaderProgram.SetTexture(m_texture, 0, *m_rockTexture);
-            break;
-        case 3:
-            m_shaderProgram.SetTexture(m_texture, 0, *m_snowTexture);
-            break;
+        SetBlinnPhongUniforms(shaderProgram, m_texturedBlinnPhongUniforms);
+        shaderProgram.SetUniform(m_texturedWorldRotationMatrixUniform, worldRotationMatrix);
+        shaderProgram.SetUniform(m_texturedWorldTranslationVectorUniform, worldTranslationVector);
+        shaderProgram.SetUniform(m_texturedWorldScaleVectorUniform, worldScaleVector);
+
+        m_cube.DrawSubmesh(m_texturedSubmesh);
     }
 
-    m_shaderProgram.SetUniform(m_colorUniform, white);
+    m_shaderProgram->Use();
+
+    m_shaderProgram->SetUniform(m_colorUniform, white);
 
     // Blinn-Phong material uniforms
-    m_shaderProgram.SetUniform(m_ambientReflectionUniform, 1.0f);
+    m_shaderProgram->SetUniform(m_ambientReflectionUniform, 1.0f);
 
-    m_shaderProgram.SetUniform(m_diffuseReflectionUniform, 1.0f);
+    m_shaderProgram->SetUniform(m_diffuseReflectionUniform, 1.0f);
     
-    m_shaderProgram.SetUniform(m_specularReflectionUniform, 1.0f);
+    m_shaderProgram->SetUniform(m_specularReflectionUniform, 1.0f);
     
-    m_shaderProgram.SetUniform(m_specularExponentUniform, 100.0f);
+    m_shaderProgram->SetUniform(m_specularExponentUniform, 100.0f);
 
     // Other Blinn-Phong uniforms
 
-    m_shaderProgram.SetUniform(m_ambientColorUniform, glm::vec3(0.35f)*glm::vec3(white));
+    m_shaderProgram->SetUniform(m_ambientColorUniform, glm::vec3(0.35f)*glm::vec3(white));
 
-    m_shaderProgram.SetUniform(m_lightColorUniform, glm::vec3(white));
+    m_shaderProgram->SetUniform(m_lightColorUniform, glm::vec3(white));
 
-    m_shaderProgram.SetUniform(m_lightPositionUniform, glm::vec3(0, 10, -1));
-
-    m_shaderProgram.SetUniform(m_cameraPositionUniform, m_cameraController.GetCamera()->GetTransform()->GetTranslation());
+    m_shaderProgram->SetUniform(m_lightPositionUniform, glm::vec3(0, 10, -1));
 
     // End of Blinn-Phong uniforms
 
-    m_shaderProgram.SetUniform(m_viewProjMatrixUniform, m_camera.GetViewProjectionMatrix());
-
-    m_shaderProgram.SetUniform(m_worldRotationMatrixUniform, worldRotationMatrix);
-
-    m_shaderProgram.SetUniform(m_worldTranslationVectorUniform, worldTranslationVector);
+    m_shaderProgram->SetUniform(m_worldRotationMatrixUniform, worldRotationMatrix);
 
-    m_shaderProgram.SetUniform(m_worldScaleVectorUniform, worldScaleVector);
+    m_shaderProgram->SetUniform(m_worldTranslationVectorUniform, worldTranslationVector);
 
-    m_cube.DrawSubmesh(0);
+    m_shaderProgram->SetUniform(m_worldScaleVectorUniform, worldScaleVector);
 
-    m_shaderProgram.SetUniform(m_usingTexture, 0);
+    if (!texturedShaderProgram)
+    {
+        m_cube.DrawSubmesh(m_texturedSubmesh);
+    }
 
-    m_shaderProgram.SetUniform(m_colorUniform, red);
+    m_shaderProgram->SetUniform(m_colorUniform, red);
 
-    m_cube.DrawSubmesh(1);
+    m_cube.DrawSubmesh(m_wireframeSubmesh);
 
     worldTranslationVector = glm::vec4(
-        m_cubeCenter[0],
-        m_cubeCenter[1],
-        m_cubeCenter[2],
-        m_cubeCenter[3]
+        cubeTranslation.x,
+        cubeTranslation.y,
+        cubeTranslation.z,
+        cubeTranslation.w
     );
 
-    m_shaderProgram.SetUniform(m_colorUniform, white);
+    m_shaderProgram->SetUniform(m_colorUniform, white);
 
-    m_shaderProgram.SetUniform(m_worldTranslationVectorUniform, worldTranslationVector);
+    m_shaderProgram->SetUniform(m_worldTranslationVectorUniform, worldTranslationVector);
 
-    m_cube.DrawSubmesh(2);
+    m_polytopeMesh.DrawSubmesh(m_polytopeSolidSubmesh);
 
-    m_shaderProgram.SetUniform(m_colorUniform, red);
+    m_shaderProgram->SetUniform(m_colorUniform, red);
 
-    m_cube.DrawSubmesh(3);
+    m_polytopeMesh.DrawSubmesh(m_polytopeWireframeSubmesh);
 
     worldTranslationVector = glm::vec4(
-        m_cubeCenter[0] + gap,
-        m_cubeCenter[1],
-        m_cubeCenter[2],
-        m_cubeCenter[3]
+        cubeTranslation.x + gap,
+        cubeTranslation.y,
+        cubeTranslation.z,
+        cubeTranslation.w
     );
 
-    m_shaderProgram.SetUniform(m_colorUniform, white);
+    m_shaderProgram->SetUniform(m_colorUniform, white);
 
-    m_shaderProgram.SetUniform(m_worldTranslationVectorUniform, worldTranslationVector);
+    if (m_showCrossSection)
+    {
+        // The cross-section is already rotated and scaled, and its vertices are 3D (w = 0),
+        // so a translation with w = 1 draws it unchanged next to the others
+        UpdateCrossSection(worldRotationMatrix, worldScaleVector);
 
-    m_cube.DrawSubmesh(4);
+        m_shaderProgram->SetUniform(m_worldRotationMatrixUniform, glm::mat4(1.0f));
+        m_shaderProgram->SetUniform(m_worldScaleVectorUniform, glm::vec4(1.0f));
+        m_shaderProgram->SetUniform(m_worldTranslationVectorUniform, glm::vec4(glm::vec3(worldTranslationVector), 1.0f));
 
-    RenderGUI();
+        DrawCrossSection();
+    }
+    else
+    {
+        m_shaderProgram->SetUniform(m_worldTranslationVectorUniform, worldTranslationVector);
+
+        m_polytopeMesh.DrawSubmesh(m_polytopeWireframeSubmesh);
+    }
+
+    EndFrame();
 }
 
 void Geometry4DApplication::Cleanup()
 {
+    if (IsHeadless())
+    {
+        // Goes to stderr, as stdout can be a pipe with the frames
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - m_headlessStartTime;
+        std::cerr << "Rendered " << GetFrameIndex() << " frames in " << duration.count() << " s ("
+            << duration.count() * 1000.0 / std::max(GetFrameIndex(), 1u) << " ms per frame)" << std::endl;
+    }
+
     // Cleanup DearImGUI
     m_imGui.Cleanup();
 
@@ -228,35 +288,128 @@ void Geometry4DApplication::Cleanup()
 
 void Geometry4DApplication::InitializeGeometry()
 {
-    // Textured Hypercube
-    CreateTextured4DCube(&m_cube, 1.0f);
-    // Textured Hypercube Outline
-    Create4DCubeWireframe(&m_cube, 1.0f);
-    // Untextured Hypercube 
-    Create4DCube(&m_cube, 1.0f);
-    // Untextured Hypercube Outline
-    Create4DCubeWireframe(&m_cube, 1.0f);
-    // Hypercube Wireframe
-    Create4DCubeWireframe(&m_cube, 1.0f);
+    // Textured hypercube, untextured hypercube and hypercube wireframe (also used as outline), all sharing the same vertices
+    // Increase the template argument to subdivide each face of the hypercube
+    CreateHypercube<1>(m_cube, 1.0f);
+
+    // Regular polytope, starting with the tesseract
+    SetPolytope(static_cast<Polytope4D::Type>(m_selectedPolytope));
+}
+
+void Geometry4DApplication::InitializeCrossSection()
+{
+    // The cross-section uses its own VBO, which is updated every frame, and a VAO with the position and normal attributes.
+    // Texture coordinates are not in the VBO, so their attribute stays disabled
+    m_crossSectionVBO = std::make_unique<VertexBufferObject>();
+    m_crossSectionVAO = std::make_unique<VertexArrayObject>();
+
+    m_crossSectionVAO->Bind();
+    m_crossSectionVBO->Bind();
+
+    VertexAttribute vec4Attribute(Data::Type::Float, 4);
+    m_crossSectionVAO->SetAttribute(0, vec4Attribute, offsetof(Slicer4D::Vertex, position), sizeof(Slicer4D::Vertex));
+    m_crossSectionVAO->SetAttribute(1, vec4Attribute, offsetof(Slicer4D::Vertex, normal), sizeof(Slicer4D::Vertex));
+
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+}
+
+void Geometry4DApplication::InitializeInstances()
+{
+    // The instances use the VBO and EBO of m_cube, which only has one of each, with the vertex layout of CreateHypercube
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(4);
+    vertexFormat.AddVertexAttribute<float>(4);
+    vertexFormat.AddVertexAttribute<float>(2);
+
+    m_instanceBatch = std::make_unique<InstanceBatch4D>();
+    m_instanceBatch->Initialize(m_cube, 0, 0, vertexFormat.LayoutBegin(0, true /* interleaved */), vertexFormat.LayoutEnd());
+}
+
+void Geometry4DApplication::InitializeHeadless()
+{
+    if (!IsHeadless())
+        return;
+
+    int width, height;
+    GetMainWindow().GetDimensions(width, height);
+
+    // The window is never shown, so the frames are rendered to textures instead of its default framebuffer
+    m_headlessDepthTexture = std::make_shared<Texture2DObject>();
+    m_headlessDepthTexture->Bind();
+    m_headlessDepthTexture->SetImage(0, width, height, TextureObject::FormatDepth, TextureObject::InternalFormatDepth24);
+    m_headlessDepthTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_headlessDepthTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+
+    m_headlessColorTexture = std::make_shared<Texture2DObject>();
+    m_headlessColorTexture->Bind();
+    m_headlessColorTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8);
+    m_headlessColorTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_headlessColorTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+    Texture2DObject::Unbind();
+
+    m_headlessFramebuffer = std::make_shared<FramebufferObject>();
+    m_headlessFramebuffer->Bind();
+    m_headlessFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_headlessDepthTexture);
+    m_headlessFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_headlessColorTexture);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "Error creating the offscreen framebuffer" << std::endl;
+    }
+    FramebufferObject::Unbind();
+
+    GetDevice().SetViewport(0, 0, width, height);
+    m_headlessPixels.resize(width * height * 3);
+
+    if (!m_outputPath.empty() && m_outputPath != "-")
+    {
+        std::filesystem::create_directories(m_outputPath);
+    }
+
+    m_headlessStartTime = std::chrono::steady_clock::now();
 }
 
 void Geometry4DApplication::InitializeShaders()
 {
-    // Load and compile vertex shader
-    Shader vertexShader(Shader::VertexShader);
+    auto startTime = std::chrono::steady_clock::now();
 
-    LoadAndCompileShader(vertexShader, "shaders/shader.vert");
+    // Variants of the main program are built in the background, when they are first requested
+    // The untextured one is needed for everything, so it is waited for
+    m_shaderPermutations.StartBackgroundCompilation(GetMainWindow());
+    m_shaderProgram = m_shaderPermutations.GetProgram({}, true);
+    if (!m_shaderProgram)
+    {
+        std::cerr << "Error building shaders" << std::endl;
+        m_shaderProgram = std::make_shared<ShaderProgram>();
+        return;
+    }
 
-    // Load and compile fragment shader
-    Shader fragmentShader(Shader::FragmentShader);
-    LoadAndCompileShader(fragmentShader, "shaders/shader.frag");
+    // Request the textured one now, so it is ready sooner
+    m_shaderPermutations.GetProgram({ "TEXTURED" });
 
-    // Attach shaders and link
-    if (!m_shaderProgram.Build(vertexShader, fragmentShader))
+    // Instanced version, with the same fragment shader, untextured
+    m_instancedShaderPermutations.StartBackgroundCompilation(GetMainWindow());
+    m_instancedShaderProgram = m_instancedShaderPermutations.GetProgram({}, true);
+    if (!m_instancedShaderProgram)
     {
-        std::cout << "Error linking shaders" << std::endl;
+        std::cerr << "Error building instanced shaders" << std::endl;
+        m_instancedShaderProgram = std::make_shared<ShaderProgram>();
         return;
     }
+    m_instancedBlinnPhongUniforms = GetBlinnPhongUniforms(*m_instancedShaderProgram);
+    SetCameraBlockBinding(*m_instancedShaderProgram);
+
+    // Editing the shaders rebuilds the programs while the application runs, see UpdateShaders
+    m_shaderFileWatcher.AddFile("shaders/shader.vert");
+    m_shaderFileWatcher.AddFile("shaders/shader_instanced.vert");
+    m_shaderFileWatcher.AddFile("shaders/shader.frag");
+
+    // Compiling dominates the startup, so report how long it took and how much came from the cache
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    m_shaderStartupTime = duration.count();
+    ShaderProgramCache::Stats stats = m_shaderProgramCache.GetStats();
+    std::cerr << "Shaders ready in " << m_shaderStartupTime * 1000.0 << " ms: "
+        << stats.hitCount << " loaded from the cache, " << stats.missCount << " compiled" << std::endl;
 }
 
 void Geometry4DApplication::InitializeCamera()
@@ -272,35 +425,48 @@ void Geometry4DApplication::InitializeCamera()
 
     // Set the camera scene node to be controlled by the camera controller
     m_cameraController.SetCamera(sceneCamera);
+
+    // Same layout as the camera block of the renderer, so the shaders can be shared with it
+    m_cameraBuffer.Bind();
+    m_cameraBuffer.AllocateData(sizeof(Renderer::CameraBlock));
+    UniformBufferObject::Unbind();
 }
 
 void Geometry4DApplication::InitializeUniforms()
 {
-    m_colorUniform = m_shaderProgram.GetUniformLocation("Color");
+    m_colorUniform = m_shaderProgram->GetUniformLocation("Color");
 
-    // Texture Uniforms
-    m_texture = m_shaderProgram.GetUniformLocation("Texture");
-    m_usingTexture = m_shaderProgram.GetUniformLocation("UsingTexture");
 
     // Blinn-Phong Material Uniforms
-    m_ambientReflectionUniform = m_shaderProgram.GetUniformLocation("AmbientReflection");
-    m_diffuseReflectionUniform = m_shaderProgram.GetUniformLocation("DiffuseReflection");
-    m_specularReflectionUniform = m_shaderProgram.GetUniformLocation("SpecularReflection");
-    m_specularExponentUniform = m_shaderProgram.GetUniformLocation("SpecularExponent");
+    m_ambientReflectionUniform = m_shaderProgram->GetUniformLocation("AmbientReflection");
+    m_diffuseReflectionUniform = m_shaderProgram->GetUniformLocation("DiffuseReflection");
+    m_specularReflectionUniform = m_shaderProgram->GetUniformLocation("SpecularReflection");
+    m_specularExponentUniform = m_shaderProgram->GetUniformLocation("SpecularExponent");
 
     // Other Blinn-Phong Uniforms
-    m_ambientColorUniform = m_shaderProgram.GetUniformLocation("AmbientColor");
-    m_lightColorUniform = m_shaderProgram.GetUniformLocation("LightColor");
-    m_lightPositionUniform = m_shaderProgram.GetUniformLocation("LightPosition");
-    m_cameraPositionUniform = m_shaderProgram.GetUniformLocation("CameraPosition");
+    m_ambientColorUniform = m_shaderProgram->GetUniformLocation("AmbientColor");
+    m_lightColorUniform = m_shaderProgram->GetUniformLocation("LightColor");
+    m_lightPositionUniform = m_shaderProgram->GetUniformLocation("LightPosition");
 
     // Transformation Uniforms
-    m_worldRotationMatrixUniform = m_shaderProgram.GetUniformLocation("WorldRotationMatrix");
-    m_worldTranslationVectorUniform = m_shaderProgram.GetUniformLocation("WorldTranslationVector");
-    m_worldScaleVectorUniform = m_shaderProgram.GetUniformLocation("WorldScaleVector");
+    m_worldRotationMatrixUniform = m_shaderProgram->GetUniformLocation("WorldRotationMatrix");
+    m_worldTranslationVectorUniform = m_shaderProgram->GetUniformLocation("WorldTranslationVector");
+    m_worldScaleVectorUniform = m_shaderProgram->GetUniformLocation("WorldScaleVector");
 
-    // Camera Perspective Uniform
-    m_viewProjMatrixUniform = m_shaderProgram.GetUniformLocation("ViewProjMatrix");
+    // Camera matrices and position
+    SetCameraBlockBinding(*m_shaderProgram);
+}
+
+void Geometry4DApplication::InitializeTexturedUniforms()
+{
+    ShaderProgram& shaderProgram = *m_texturedShaderProgram;
+    m_texturedTextureUniform = shaderProgram.GetUniformLocation("Texture");
+    m_texturedColorUniform = shaderProgram.GetUniformLocation("Color");
+    m_texturedBlinnPhongUniforms = GetBlinnPhongUniforms(shaderProgram);
+    m_texturedWorldRotationMatrixUniform = shaderProgram.GetUniformLocation("WorldRotationMatrix");
+    m_texturedWorldTranslationVectorUniform = shaderProgram.GetUniformLocation("WorldTranslationVector");
+    m_texturedWorldScaleVectorUniform = shaderProgram.GetUniformLocation("WorldScaleVector");
+    SetCameraBlockBinding(shaderProgram);
 }
 
 void Geometry4DApplication::InitializeTextures()
@@ -311,32 +477,41 @@ void Geometry4DApplication::InitializeTextures()
     m_snowTexture = LoadTexture("textures/snow.jpg");
 }
 
-void Geometry4DApplication::LoadAndCompileShader(Shader& shader, const char* path)
+void Geometry4DApplication::UpdateShaders()
 {
-    // Open the file for reading
-    std::ifstream file(path);
-    if (!file.is_open())
+    // Rebuild the programs in the background when their files change
+    if (!m_shaderFileWatcher.GetChangedFiles().empty())
     {
-        std::cout << "Can't find file: " << path << std::endl;
-        std::cout << "Is your working directory properly set?" << std::endl;
-        return;
+        m_shaderPermutations.Reload();
+        m_instancedShaderPermutations.Reload();
+        if (!m_shaderReloading)
+        {
+            m_shaderReloading = true;
+            m_shaderReloadStartTime = std::chrono::steady_clock::now();
+        }
     }
 
-    // Dump the contents into a string
-    std::stringstream stringStream;
-    stringStream << file.rdbuf();
-
-    // Set the source code from the string
-    shader.SetSource(stringStream.str().c_str());
+    // Swap them once they are built. Locations can change, so they are looked up again. The values are set every frame
+    // The textured variant is swapped when Render gets it, see InitializeTexturedUniforms
+    std::shared_ptr<ShaderProgram> shaderProgram = m_shaderPermutations.GetProgram({});
+    if (shaderProgram && shaderProgram != m_shaderProgram)
+    {
+        m_shaderProgram = shaderProgram;
+        InitializeUniforms();
+    }
+    std::shared_ptr<ShaderProgram> instancedShaderProgram = m_instancedShaderPermutations.GetProgram({});
+    if (instancedShaderProgram && instancedShaderProgram != m_instancedShaderProgram)
+    {
+        m_instancedShaderProgram = instancedShaderProgram;
+        m_instancedBlinnPhongUniforms = GetBlinnPhongUniforms(*m_instancedShaderProgram);
+        SetCameraBlockBinding(*m_instancedShaderProgram);
+    }
 
-    // Try to compile
-    if (!shader.Compile())
+    if (m_shaderReloading && m_shaderPermutations.GetPendingCount() == 0 && m_instancedShaderPermutations.GetPendingCount() == 0)
     {
-        // Get errors in case of failure
-        std::array<char, 256> errors;
-        shader.GetCompilationErrors(errors);
-        std::cout << "Error compiling shader: " << path << std::endl;
-        std::cout << errors.data() << std::endl;
+        m_shaderReloading = false;
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - m_shaderReloadStartTime;
+        std::cerr << "Shaders reloaded in " << duration.count() * 1000.0 << " ms" << std::endl;
     }
 }
 
@@ -350,27 +525,137 @@ void Geometry4DApplication::ResetState()
         m_cubeCenter[0] = m_cubeCenter[1] = m_cubeCenter[2] = 0;
         m_rotationVelocities[0] = m_rotationVelocities[1] = m_rotationVelocities[2]
             = m_rotationVelocities[3] = m_rotationVelocities[4] = m_rotationVelocities[5] = 0;
-        m_xyRotation = m_yzRotation = m_xzRotation = m_xwRotation = m_ywRotation = m_zwRotation = 0;
+        m_transforms.SetRotation(m_cubeObject, Rotor4D());
+        m_transformsEdited = true;
+
+        // Rebuilt with their initial rotations
+        m_transforms.Truncate(m_gridObject + 1);
+        m_instanceObjectCount = 0;
+    }
+}
+
+void Geometry4DApplication::EndFrame()
+{
+    if (IsHeadless())
+    {
+        WriteFrame();
+    }
+    else
+    {
+        RenderGUI();
+    }
+}
+
+void Geometry4DApplication::WriteFrame()
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    FramebufferObject::Unbind();
+    if (m_outputPath.empty())
+        return;
+
+    int width, height;
+    GetMainWindow().GetDimensions(width, height);
+
+    m_headlessColorTexture->Bind();
+    m_headlessColorTexture->GetImage(0, TextureObject::FormatRGB, std::span<unsigned char>(m_headlessPixels));
+    Texture2DObject::Unbind();
+
+    // Binary PPM, with the rows from top to bottom (OpenGL starts at the bottom)
+    std::ostringstream header;
+    header << "P6\n" << width << " " << height << "\n255\n";
+
+    std::ofstream file;
+    std::ostream* output = &std::cout;
+    if (m_outputPath != "-")
+    {
+        char fileName[32];
+        std::snprintf(fileName, sizeof(fileName), "frame_%05u.ppm", GetFrameIndex());
+        file.open(std::filesystem::path(m_outputPath) / fileName, std::ios::binary);
+        output = &file;
     }
+
+    *output << header.str();
+    const size_t rowSize = width * 3;
+    for (int row = height - 1; row >= 0; --row)
+    {
+        output->write(reinterpret_cast<const char*>(&m_headlessPixels[row * rowSize]), rowSize);
+    }
+    output->flush();
 }
 
 void Geometry4DApplication::RenderGUI()
 {
+    ITUGL_PROFILE_FUNCTION();
+
     m_imGui.BeginFrame();
 
     if (auto window = m_imGui.UseWindow("Scene parameters"))
     {
-        glm::mat4 viewMatrix = m_cameraController.GetCamera()->GetCamera()->GetViewMatrix();
-
         if (ImGui::TreeNodeEx("Cube", ImGuiTreeNodeFlags_DefaultOpen))
         {
             ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
-            ImGui::SliderFloat("Scale", &m_scale, 0.5f, 1.5f);
-            ImGui::SliderFloat3("Center", &m_cubeCenter[0], -5.0f, 5.0f);
-            ImGui::SliderFloat3("3D Rotation Velocity", &m_rotationVelocities[0], -5.0f, 5.0f);
-            ImGui::SliderFloat("Center W", &m_cubeCenter[3], 1.0f, 5.0f);
-            ImGui::SliderFloat3("4D Rotation Velocity", &m_rotationVelocities[3], -5.0f, 5.0f);
+            m_transformsEdited |= ImGui::SliderFloat("Scale", &m_scale, 0.5f, 1.5f);
+            m_transformsEdited |= ImGui::SliderFloat3("Center", &m_cubeCenter[0], -5.0f, 5.0f);
+            m_transformsEdited |= ImGui::SliderFloat3("3D Rotation Velocity", &m_rotationVelocities[0], -5.0f, 5.0f);
+            m_transformsEdited |= ImGui::SliderFloat("Center W", &m_cubeCenter[3], 1.0f, 5.0f);
+            m_transformsEdited |= ImGui::SliderFloat3("4D Rotation Velocity", &m_rotationVelocities[3], -5.0f, 5.0f);
             ImGui::Combo("Texture", &m_selectedTexture, m_textureList, IM_ARRAYSIZE(m_textureList));
+            auto getPolytopeName = [](void*, int index, const char** name)
+            {
+                *name = Polytope4D::GetName(static_cast<Polytope4D::Type>(index));
+                return true;
+            };
+            if (ImGui::Combo("Polytope", &m_selectedPolytope, getPolytopeName, nullptr, static_cast<int>(Polytope4D::Type::Count)))
+            {
+                SetPolytope(static_cast<Polytope4D::Type>(m_selectedPolytope));
+            }
+            ImGui::Checkbox("Instanced Grid", &m_showInstances);
+            if (m_showInstances)
+            {
+                ImGui::SliderInt("Instance Count", &m_instanceCount, 1, 100000);
+                ImGui::Text("Changed transforms: %u", m_transforms.GetChangedCount());
+            }
+            ImGui::Checkbox("Cross-section", &m_showCrossSection);
+            if (m_showCrossSection)
+            {
+                ImGui::SliderFloat4("Slice Normal", m_sliceNormal, -1.0f, 1.0f);
+                ImGui::SliderFloat("Slice Distance", &m_sliceDistance, -1.5f, 1.5f);
+                ImGui::Text("Cross-section triangles: %u", m_crossSectionVertexCount / 3);
+            }
+            ImGui::TreePop();
+        }
+    }
+
+    if (auto window = m_imGui.UseWindow("Profiler"))
+    {
+        Profiler::GetInstance().DrawImGui();
+
+        // Render state changes of the last frame, and how many were redundant and skipped
+        if (ImGui::TreeNode("Render states"))
+        {
+            const DeviceGL::StateCounters& counters = GetDevice().GetLastFrameStateCounters();
+            ImGui::Text("Programs:      %u set, %u skipped", counters.programChanges, counters.programSkips);
+            ImGui::Text("Vertex arrays: %u set, %u skipped", counters.vertexArrayChanges, counters.vertexArraySkips);
+            ImGui::Text("Textures:      %u set, %u skipped", counters.textureChanges, counters.textureSkips);
+            ImGui::Text("Buffers:       %u set, %u skipped", counters.bufferBindingChanges, counters.bufferBindingSkips);
+            ImGui::Text("Fixed states:  %u set, %u skipped", counters.fixedStateChanges, counters.fixedStateSkips);
+            ImGui::Text("Uniforms:      %u set, %u skipped, %zu bytes", counters.uniformChanges, counters.uniformSkips, counters.uniformBytes);
+            ImGui::TreePop();
+        }
+
+        // Time to get the shader programs ready at startup
+        if (ImGui::TreeNode("Shader cache"))
+        {
+            ShaderProgramCache::Stats stats = m_shaderProgramCache.GetStats();
+            ImGui::Text("Startup:  %.2f ms", m_shaderStartupTime * 1000.0);
+            ImGui::Text("Loaded:   %u in %.2f ms", stats.hitCount, stats.hitTime * 1000.0);
+            ImGui::Text("Compiled: %u in %.2f ms", stats.missCount, stats.missTime * 1000.0);
+            ImGui::Text("Variants: %u, %u compiling", m_shaderPermutations.GetPermutationCount(), m_shaderPermutations.GetPendingCount());
+            if (!m_shaderProgramCache.IsEnabled())
+            {
+                ImGui::Text("No program binary formats, the cache is disabled");
+            }
             ImGui::TreePop();
         }
     }
@@ -378,10 +663,18 @@ void Geometry4DApplication::RenderGUI()
     m_imGui.EndFrame();
 }
 
-void Geometry4DApplication::CreateTextured4DCube(Mesh* mesh, float size)
+template<int S>
+void Geometry4DApplication::CreateHypercube(Mesh& mesh, float size)
 {
-    // In order to properly texture the cube, duplicate vertices are needed with unique texture coordinates
-    // Not that this hypercube does not have a consistent winding order (Since backface culling is non-trivial for 4D objects)
+    // Creates a hypercube where all the submeshes share a single VBO, EBO and VAO, each one drawing a range of the EBO
+    // The VBO starts with the unique vertices of the hypercube, used by the solid and the wireframe submeshes.
+    // In order to properly texture the cube, duplicate vertices are needed with unique texture coordinates,
+    // so the corners of each face are appended after them for the textured submesh
+    // Note that the faces do not have a consistent winding order (Since backface culling is non-trivial for 4D objects)
+    using HypercubeType = Hypercube<4, S>;
+    constexpr int vertexCount = HypercubeType::VertexCount + HypercubeType::FaceCount * 4;
+    using Index = std::conditional_t<(vertexCount <= 0xFF), unsigned char,
+        std::conditional_t<(vertexCount <= 0xFFFF), unsigned short, unsigned int>>;
 
     VertexFormat vertexFormat;
     vertexFormat.AddVertexAttribute<float>(4);
@@ -389,151 +682,80 @@ void Geometry4DApplication::CreateTextured4DCube(Mesh* mesh, float size)
     vertexFormat.AddVertexAttribute<float>(2);
 
     std::vector<Vertex> vertices;
-    std::vector<unsigned short> indices;
+    vertices.reserve(vertexCount);
+
+    std::vector<Index> indices;
+    indices.reserve(HypercubeType::FaceCount * 6 * 2 + HypercubeType::EdgeCount * 2);
 
     //VBO
-    vertices = {
-        //Top Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, -size / 2), glm::vec2(0, 0)),
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, -size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, -size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, -size / 2), glm::vec2(1, 0)),
-        //4D Top Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, size / 2), glm::vec2(0, 0)),
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, size / 2), glm::vec2(0, 1)),
-
-        //Left Square
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, -size / 2), glm::vec2(0, 0)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, -size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, -size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, -size / 2), glm::vec2(1, 1)),
-        //4D Left Square
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, size / 2), glm::vec2(0, 0)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, size / 2), glm::vec2(1, 0)),
-
-        //Right Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, -size / 2), glm::vec2(0, 0)),
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, -size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, -size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, -size / 2), glm::vec2(1, 1)),
-        //4D Right Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, size / 2), glm::vec2(0, 0)),
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, size / 2), glm::vec2(1, 0)),
-
-        //Front Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, -size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, -size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, -size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, -size / 2), glm::vec2(0, 0)),
-        //4D Front Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, size / 2), glm::vec2(0, 0)),
-
-        //Back Square
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, -size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, -size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, -size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, -size / 2), glm::vec2(0, 0)),
-        //4D Back Square
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, size / 2), glm::vec2(0, 0)),
-
-        //Bottom Square
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, -size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, -size / 2), glm::vec2(1, 1)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, -size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, -size / 2), glm::vec2(0, 0)),
-        //4D Bottom Square
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, size / 2), glm::vec2(1, 0)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, size / 2), glm::vec2(0, 0)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, size / 2), glm::vec2(0, 1)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, size / 2), glm::vec2(1, 1)),
-    };
-
-    for (int i = 0; i < vertices.size(); i++) {
-        vertices[i].normal = glm::normalize(vertices[i].position);
+    for (const typename HypercubeType::Coordinates& coordinates : HypercubeType::Vertices)
+    {
+        glm::vec4 position(
+            HypercubeType::GetCoordinate(coordinates[0], size),
+            HypercubeType::GetCoordinate(coordinates[1], size),
+            HypercubeType::GetCoordinate(coordinates[2], size),
+            HypercubeType::GetCoordinate(coordinates[3], size));
+        vertices.emplace_back(position, glm::normalize(position));
+    }
+
+    for (const std::array<typename HypercubeType::Index, 4>& face : HypercubeType::Faces)
+    {
+        // The texture is stretched over the whole face of the original tesseract, so each subdivided face gets a part of it
+        const typename HypercubeType::Coordinates& origin = HypercubeType::Vertices[face[0]];
+        int uAxis = 0, vAxis = 0;
+        for (int axis = 0; axis < 4; ++axis)
+        {
+            uAxis = HypercubeType::Vertices[face[1]][axis] != origin[axis] ? axis : uAxis;
+            vAxis = HypercubeType::Vertices[face[3]][axis] != origin[axis] ? axis : vAxis;
+        }
+
+        for (typename HypercubeType::Index vertexIndex : face)
+        {
+            const typename HypercubeType::Coordinates& coordinates = HypercubeType::Vertices[vertexIndex];
+            glm::vec2 texCoord(static_cast<float>(coordinates[uAxis]) / S, static_cast<float>(coordinates[vAxis]) / S);
+            vertices.emplace_back(vertices[vertexIndex].position, vertices[vertexIndex].normal, texCoord);
+        }
     }
 
     //EBO
-    indices = {
-        //Top Square
-        0, 1, 3,
-        1, 2, 3,
-        4, 5, 7,
-        5, 6, 7,
-        //Left Square
-        8, 10, 11,
-        8, 11, 9,
-        12, 14, 15,
-        12, 15, 13,
-        //Right Square
-        16, 17, 18,
-        17, 18, 19,
-        20, 21, 22,
-        21, 22, 23,
-        //Back Square
-        24, 25, 26,
-        25, 26, 27,
-        28, 29, 30,
-        29, 30, 31,
-        //Front Square
-        32, 33, 35,
-        32, 35, 34,
-        36, 37, 39,
-        36, 39, 38,
-        //Bottom Square
-        40, 41, 42,
-        40, 42, 43,
-        44, 45, 46,
-        44, 46, 47,
-        //Connect the Top
-        0, 4, 3,
-        4, 3, 7,
-        0, 1, 5,
-        0, 5, 4,
-        1, 2, 6,
-        1, 6, 5,
-        2, 3, 7,
-        2, 7, 6,
-        //Connect the Bottom
-        40, 44, 43,
-        44, 43, 47,
-        40, 41, 45,
-        40, 45, 44,
-        41, 42, 46,
-        41, 46, 45,
-        42, 43, 47,
-        42, 47, 46,
-        //Connect the Left
-        8, 10, 14,
-        8, 14, 12,
-        9, 11, 15,
-        9, 15, 13,
-        //Connect the Right
-        16, 18, 22,
-        16, 22, 20,
-        17, 19, 23,
-        17, 23, 21,
-    };
-
-    mesh->AddSubmesh<Vertex, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, indices,
-        vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), true /* interleaved */), vertexFormat.LayoutEnd());
+    // Textured faces, using the duplicated vertices
+    for (int faceIndex = 0; faceIndex < HypercubeType::FaceCount; ++faceIndex)
+    {
+        Index first = static_cast<Index>(HypercubeType::VertexCount + faceIndex * 4);
+        indices.insert(indices.end(), { first, Index(first + 1), Index(first + 2), first, Index(first + 2), Index(first + 3) });
+    }
+    int texturedElementCount = static_cast<int>(indices.size());
+
+    // Untextured faces, with no repeating vertices
+    for (const std::array<typename HypercubeType::Index, 4>& face : HypercubeType::Faces)
+    {
+        indices.insert(indices.end(), { Index(face[0]), Index(face[1]), Index(face[2]), Index(face[0]), Index(face[2]), Index(face[3]) });
+    }
+    int solidElementCount = static_cast<int>(indices.size()) - texturedElementCount;
+
+    // Wireframe edges
+    for (const std::array<typename HypercubeType::Index, 2>& edge : HypercubeType::Edges)
+    {
+        indices.insert(indices.end(), { Index(edge[0]), Index(edge[1]) });
+    }
+    int wireframeElementCount = static_cast<int>(indices.size()) - texturedElementCount - solidElementCount;
+
+    unsigned int vboIndex = mesh.AddVertexData(std::span<const Vertex>(vertices));
+    unsigned int eboIndex = mesh.AddElementData(std::span<const Index>(indices));
+
+    VertexFormat::LayoutIterator layoutIterator = vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), true /* interleaved */);
+    unsigned int vaoIndex = mesh.AddVertexArray(vboIndex, eboIndex, layoutIterator, vertexFormat.LayoutEnd());
+
+    Data::Type elementType = Data::GetType<Index>();
+    m_texturedSubmesh = mesh.AddSubmesh(vaoIndex, Drawcall::Primitive::Triangles, 0, texturedElementCount, elementType);
+    m_solidSubmesh = mesh.AddSubmesh(vaoIndex, Drawcall::Primitive::Triangles, texturedElementCount, solidElementCount, elementType);
+    m_wireframeSubmesh = mesh.AddSubmesh(vaoIndex, Drawcall::Primitive::Lines, texturedElementCount + solidElementCount, wireframeElementCount, elementType);
 }
 
-void Geometry4DApplication::Create4DCube(Mesh* mesh, float size)
+void Geometry4DApplication::CreatePolytope(Mesh& mesh, const Polytope4D& polytope, float size)
 {
-    // Creates a hypercube with no repeating vertices. Good for rendering geometry, but cannot be textured.
-    // Does have a consistent winding order, despite backface culling not being enabled
+    // Creates a polytope from its shared topology, with a single VBO, EBO and VAO for all the submeshes
+    // Faces are convex and stored in cyclic order, so they are triangulated as fans
 
     VertexFormat vertexFormat;
     vertexFormat.AddVertexAttribute<float>(4);
@@ -541,236 +763,241 @@ void Geometry4DApplication::Create4DCube(Mesh* mesh, float size)
     vertexFormat.AddVertexAttribute<float>(2);
 
     std::vector<Vertex> vertices;
-    std::vector<unsigned short> indices;
+    vertices.reserve(polytope.GetVertexCount());
+
+    std::vector<Polytope4D::Index> indices;
+    indices.reserve(polytope.GetFaceCount() * (polytope.GetFaceSize() - 2) * 3 + polytope.GetEdgeCount() * 2);
 
     //VBO
-    vertices = {
-        //Top Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, -size / 2)),
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, -size / 2)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, -size / 2)),
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, -size / 2)),
-        //Bottom Square
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, -size / 2)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, -size / 2)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, -size / 2)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, -size / 2)),
-        //4D Top Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, size / 2)),
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, size / 2)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, size / 2)),
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, size / 2)),
-        //4D Bottom Square
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, size / 2)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, size / 2)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, size / 2)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, size / 2))
-    };
-
-    for (int i = 0; i < vertices.size(); i++) {
-        vertices[i].normal = glm::normalize(vertices[i].position);
+    for (const glm::vec4& vertex : polytope.GetVertices())
+    {
+        glm::vec4 position = vertex * size;
+        vertices.emplace_back(position, glm::normalize(position));
     }
 
     //EBO
-    indices = {
-        //Top Square
-        2, 1, 0,
-        3, 2, 0,
-        10, 9, 8,
-        11, 10, 8,
-        //Right Square
-        5, 1, 2,
-        6, 5, 2,
-        13, 9, 10,
-        14, 13, 10,
-        //Left Square
-        3, 0, 7,
-        0, 4, 7,
-        11, 8, 15,
-        8, 12, 15,
-        //Back Square
-        7, 2, 3,
-        2, 7, 6,
-        15, 10, 11,
-        10, 15, 14,
-        //Front Square
-        5, 0, 1,
-        4, 0, 5,
-        13, 8, 9,
-        8, 13, 12,
-        //Bottom Square
-        7, 4, 5,
-        6, 7, 5,
-        15, 12, 13,
-        14, 15, 13,
-        //Connect the Top
-        0, 8, 1,
-        8, 9, 1,
-        1, 9, 2,
-        9, 10, 2,
-        2, 10, 3,
-        10, 11, 3,
-        3, 11, 0,
-        11, 8, 0,
-        //Connect the Bottom
-        4, 5, 12,
-        5, 13, 12,
-        5, 6, 13,
-        6, 14, 13,
-        6, 7, 14,
-        7, 15, 14,
-        7, 4, 15,
-        4, 12, 15,
-        //Connect the Left
-        0, 8, 12,
-        4, 0, 12,
-        3, 11, 15,
-        7, 3, 15,
-        //Connect the Right
-        1, 9, 13,
-        5, 1, 13,
-        2, 10, 14,
-        6, 2, 14,
-    };
-
-    mesh->AddSubmesh<Vertex, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, indices,
-        vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), true /* interleaved */), vertexFormat.LayoutEnd());
+    std::span<const Polytope4D::Index> faces = polytope.GetFaces();
+    const unsigned int faceSize = polytope.GetFaceSize();
+    for (size_t face = 0; face < faces.size(); face += faceSize)
+    {
+        for (unsigned int i = 1; i + 1 < faceSize; ++i)
+        {
+            indices.insert(indices.end(), { faces[face], faces[face + i], faces[face + i + 1] });
+        }
+    }
+    int solidElementCount = static_cast<int>(indices.size());
+
+    std::span<const Polytope4D::Index> edges = polytope.GetEdges();
+    indices.insert(indices.end(), edges.begin(), edges.end());
+    int wireframeElementCount = static_cast<int>(edges.size());
+
+    unsigned int vboIndex = mesh.AddVertexData(std::span<const Vertex>(vertices));
+    unsigned int eboIndex = mesh.AddElementData(std::span<const Polytope4D::Index>(indices));
+
+    VertexFormat::LayoutIterator layoutIterator = vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), true /* interleaved */);
+    unsigned int vaoIndex = mesh.AddVertexArray(vboIndex, eboIndex, layoutIterator, vertexFormat.LayoutEnd());
+
+    Data::Type elementType = Data::GetType<Polytope4D::Index>();
+    m_polytopeSolidSubmesh = mesh.AddSubmesh(vaoIndex, Drawcall::Primitive::Triangles, 0, solidElementCount, elementType);
+    m_polytopeWireframeSubmesh = mesh.AddSubmesh(vaoIndex, Drawcall::Primitive::Lines, solidElementCount, wireframeElementCount, elementType);
 }
 
-void Geometry4DApplication::Create4DCubeWireframe(Mesh* mesh, float size)
+void Geometry4DApplication::SetPolytope(Polytope4D::Type type)
 {
-    // Creates the wireframe of a hypercube. Optimal for seeing/understanding 4D rotations, or creating an outline for solid hypercubes
+    // The topology arrays are reused, and the old GPU buffers are released when the mesh is replaced
+    m_polytope.Build(type);
+    m_polytopeMesh = Mesh();
+    CreatePolytope(m_polytopeMesh, m_polytope, 1.0f);
+
+    // Tetrahedral cells of the polytope, for the cross-section
+    m_polytopeTetrahedra.BuildFromPolytope(m_polytope, 1.0f);
+    m_polytopeVertices = Vertex4DArray(m_polytopeTetrahedra.GetVertices());
+}
 
-    VertexFormat vertexFormat;
-    vertexFormat.AddVertexAttribute<float>(4);
-    vertexFormat.AddVertexAttribute<float>(4);
-    vertexFormat.AddVertexAttribute<float>(2);
+void Geometry4DApplication::UpdateCrossSection(const glm::mat4& rotation, const glm::vec4& scale)
+{
+    ITUGL_PROFILE_FUNCTION();
 
-    std::vector<Vertex> vertices;
-    std::vector<unsigned short> indices;
+    // The polytope is sliced around its own center, so the hyperplane stays in place when the polytope is moved
+    Transform4DKernel(rotation, glm::vec4(0.0f), scale).TransformWorld(m_polytopeVertices, m_slicedVertices);
 
-    //VBO
-    vertices = {
-        //Top Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, -size / 2)),
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, -size / 2)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, -size / 2)),
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, -size / 2)),
-        //Bottom Square
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, -size / 2)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, -size / 2)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, -size / 2)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, -size / 2)),
-        //4D Top Square
-        Vertex(glm::vec4(-size / 2, size / 2, -size / 2, size / 2)),
-        Vertex(glm::vec4(size / 2, size / 2, -size / 2, size / 2)),
-        Vertex(glm::vec4(size / 2, size / 2, size / 2, size / 2)),
-        Vertex(glm::vec4(-size / 2, size / 2, size / 2, size / 2)),
-        //4D Bottom Square
-        Vertex(glm::vec4(-size / 2, -size / 2, -size / 2, size / 2)),
-        Vertex(glm::vec4(size / 2, -size / 2, -size / 2, size / 2)),
-        Vertex(glm::vec4(size / 2, -size / 2, size / 2, size / 2)),
-        Vertex(glm::vec4(-size / 2, -size / 2, size / 2, size / 2))
-    };
-
-
-    for (int i = 0; i < vertices.size(); i++) {
-        vertices[i].normal = glm::normalize(vertices[i].position);
+    glm::vec4 sliceNormal = glm::make_vec4(m_sliceNormal);
+    if (glm::length(sliceNormal) < 0.001f)
+    {
+        sliceNormal = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
     }
-    //EBO
-    indices = {
-        0, 1,
-        0, 3,
-        0, 4,
-        0, 8,
-        1, 2,
-        1, 5,
-        1, 9,
-        2, 3,
-        2, 6,
-        2, 10,
-        3, 7,
-        3, 11,
-        4, 5,
-        4, 7,
-        4, 12,
-        5, 6,
-        5, 13,
-        6, 7,
-        6, 14,
-        7, 15,
-        8, 9,
-        8, 11,
-        8, 12,
-        9, 10,
-        9, 13,
-        10, 11,
-        10, 14,
-        11, 15,
-        12, 13,
-        12, 15,
-        13, 14,
-        14, 15
-    };
-
-    mesh->AddSubmesh<Vertex, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Lines, vertices, indices,
-        vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), true /* interleaved */), vertexFormat.LayoutEnd());
+    m_slicer.SetHyperplane(sliceNormal, m_sliceDistance);
+    {
+        ITUGL_PROFILE_SCOPE("Slice");
+        m_slicer.Slice(m_slicedVertices, m_polytopeTetrahedra, glm::vec4(0.0f));
+    }
+
+    m_crossSectionVertexCount = m_slicer.GetVertexCount();
+
+    // The buffer only grows, and it is reallocated every frame (orphaned) so the driver does not have to wait until
+    // the previous frame is done with it. Each thread output is copied straight to its range of the buffer
+    m_crossSectionCapacity = std::max(m_crossSectionCapacity, m_crossSectionVertexCount);
+    m_crossSectionVBO->Bind();
+    m_crossSectionVBO->AllocateData(m_crossSectionCapacity * sizeof(Slicer4D::Vertex), BufferObject::StreamDraw);
+    for (unsigned int output = 0; output < m_slicer.GetOutputCount(); ++output)
+    {
+        m_crossSectionVBO->UpdateData(m_slicer.GetOutput(output), m_slicer.GetOutputOffset(output) * sizeof(Slicer4D::Vertex));
+    }
+    VertexBufferObject::Unbind();
+}
+
+void Geometry4DApplication::DrawCrossSection()
+{
+    if (m_crossSectionVertexCount == 0)
+        return;
+
+    m_crossSectionVAO->Bind();
+    Drawcall(Drawcall::Primitive::Triangles, m_crossSectionVertexCount).Draw();
+    VertexArrayObject::Unbind();
 }
 
+void Geometry4DApplication::RenderInstances()
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    // The instance data is only rebuilt for the objects that changed, and only uploaded if any of them did
+    bool changed = m_instances.size() != m_instanceObjectCount;
+    m_instances.resize(m_instanceObjectCount);
+    for (unsigned int i = 0; i < m_instanceObjectCount; ++i)
+    {
+        unsigned int object = m_gridObject + 1 + i;
+        if (!m_transforms.IsChanged(object) && !changed)
+            continue;
+
+        float hue = static_cast<float>(i) / m_instanceObjectCount * 6.2832f;
+
+        Instance4D& instance = m_instances[i];
+        instance.rotation = m_transforms.GetWorldRotationMatrix(object);
+        instance.translation = m_transforms.GetWorldTranslation(object);
+        instance.scale = m_transforms.GetWorldScale(object);
+        instance.color = glm::vec4(0.5f + 0.5f * glm::cos(hue + glm::vec3(0.0f, 2.0944f, 4.1888f)), 1.0f);
+    }
+    if (changed || m_transforms.GetChangedCount() > 0)
+    {
+        ITUGL_PROFILE_SCOPE("UploadInstances");
+        m_instanceBatch->SetInstances(m_instances);
+    }
+
+    {
+        ITUGL_PROFILE_SCOPE("SetUniforms");
+        m_instancedShaderProgram->Use();
+        SetBlinnPhongUniforms(*m_instancedShaderProgram, m_instancedBlinnPhongUniforms);
+    }
+
+    m_instanceBatch->DrawSubmesh(m_cube, m_solidSubmesh);
+}
+
+Geometry4DApplication::BlinnPhongUniforms Geometry4DApplication::GetBlinnPhongUniforms(const ShaderProgram& shaderProgram)
+{
+    BlinnPhongUniforms uniforms;
+    uniforms.ambientReflection = shaderProgram.GetUniformLocation("AmbientReflection");
+    uniforms.diffuseReflection = shaderProgram.GetUniformLocation("DiffuseReflection");
+    uniforms.specularReflection = shaderProgram.GetUniformLocation("SpecularReflection");
+    uniforms.specularExponent = shaderProgram.GetUniformLocation("SpecularExponent");
+    uniforms.ambientColor = shaderProgram.GetUniformLocation("AmbientColor");
+    uniforms.lightColor = shaderProgram.GetUniformLocation("LightColor");
+    uniforms.lightPosition = shaderProgram.GetUniformLocation("LightPosition");
+    return uniforms;
+}
+
+void Geometry4DApplication::SetBlinnPhongUniforms(ShaderProgram& shaderProgram, const BlinnPhongUniforms& uniforms)
+{
+    // Same values used for m_shaderProgram in Render
+    shaderProgram.SetUniform(uniforms.ambientReflection, 1.0f);
+    shaderProgram.SetUniform(uniforms.diffuseReflection, 1.0f);
+    shaderProgram.SetUniform(uniforms.specularReflection, 1.0f);
+    shaderProgram.SetUniform(uniforms.specularExponent, 100.0f);
+
+    shaderProgram.SetUniform(uniforms.ambientColor, glm::vec3(0.35f));
+    shaderProgram.SetUniform(uniforms.lightColor, glm::vec3(1.0f));
+    shaderProgram.SetUniform(uniforms.lightPosition, glm::vec3(0, 10, -1));
+}
+
+void Geometry4DApplication::SetCameraBlockBinding(const ShaderProgram& shaderProgram)
+{
+    GLuint cameraBlockIndex = shaderProgram.GetUniformBlockIndex("CameraBlock");
+    if (cameraBlockIndex != GL_INVALID_INDEX)
+    {
+        shaderProgram.SetUniformBlockBinding(cameraBlockIndex, Renderer::CameraBlockBinding);
+    }
+}
+
+void Geometry4DApplication::UpdateCameraBuffer()
+{
+    Renderer::CameraBlock cameraBlock = Renderer::GetCameraBlock(m_camera);
+    m_cameraBuffer.Bind();
+    m_cameraBuffer.UpdateData(Data::GetBytes(cameraBlock));
+    m_cameraBuffer.BindBase(Renderer::CameraBlockBinding);
+}
+
+void Geometry4DApplication::UpdateTransforms()
+{
+    ITUGL_PROFILE_FUNCTION();
+
+    UpdateInstanceObjects();
+
+    if (m_transformsEdited)
+    {
+        // The velocities are applied as a single rotation in all the planes at once, around the fixed world axes.
+        // Angles are negated to keep the directions of the old rotation matrices
+        // 3D rotations: xy, xz and yz. 4D rotations: xw, yw and zw
+        Bivector4D velocity = Bivector4D(m_rotationVelocities[0], m_rotationVelocities[1], m_rotationVelocities[3],
+            m_rotationVelocities[2], m_rotationVelocities[4], m_rotationVelocities[5]) * -0.001f;
+        glm::vec4 center = glm::make_vec4(m_cubeCenter);
+        glm::vec4 scale(glm::vec3(m_scale), 1.0f);
+
+        m_transforms.SetTranslation(m_cubeObject, center);
+        m_transforms.SetScale(m_cubeObject, scale);
+        m_transforms.SetAngularVelocity(m_cubeObject, velocity);
+
+        // Instances are placed in a cube-shaped grid around the center, spaced like the submeshes in Render
+        m_transforms.SetTranslation(m_gridObject, center);
+        const unsigned int side = static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<float>(m_instanceObjectCount))));
+        const float spacing = 2.5f * m_scale * m_cubeCenter[3];
+        const glm::vec3 origin = glm::vec3(-0.5f * spacing * static_cast<float>(side - 1));
+        for (unsigned int i = 0; i < m_instanceObjectCount; ++i)
+        {
+            unsigned int object = m_gridObject + 1 + i;
+            glm::vec3 cell(i % side, (i / side) % side, i / (side * side));
+            m_transforms.SetTranslation(object, glm::vec4(origin + spacing * cell, 0.0f));
+            m_transforms.SetScale(object, scale);
+            m_transforms.SetAngularVelocity(object, velocity);
+        }
+
+        m_transformsEdited = false;
+    }
+
+    // Velocities are in radians per frame
+    m_transforms.Update(1.0f);
+}
+
+void Geometry4DApplication::UpdateInstanceObjects()
+{
+    unsigned int instanceCount = m_showInstances ? static_cast<unsigned int>(m_instanceCount) : 0;
+    if (instanceCount == m_instanceObjectCount)
+        return;
+
+    // The instances are the last objects in the pool, so they can be removed all at once
+    m_transforms.Truncate(m_gridObject + 1);
+    for (unsigned int i = 0; i < instanceCount; ++i)
+    {
+        unsigned int object = m_transforms.Add(m_gridObject);
+
+        // Each instance gets a fixed random rotation, applied before the rotation of the velocities
+        float phase = static_cast<float>(i);
+        m_transforms.SetRotation(object, Rotor4D::FromAngles(Bivector4D(
+            std::sin(phase * 1.1f), std::sin(phase * 1.3f), std::sin(phase * 1.7f),
+            std::sin(phase * 1.9f), std::sin(phase * 2.3f), std::sin(phase * 2.9f))));
+    }
+    m_instanceObjectCount = instanceCount;
 
-glm::mat4 Geometry4DApplication::Rotate4D(float xy, float yz, float xz, float xw, float yw, float zw)
-{
-    // Creates the Rotation matrix for 4D objects, given the rotation in the xy, yz, xz, xw, yw and zw planes.
- 
-    float mXY[16] = {
-            cos(xy), -sin(xy), 0, 0,
-            sin(xy), cos(xy), 0, 0,
-            0, 0, 1, 0,
-            0, 0, 0, 1
-    };
-    glm::mat4 rXY = glm::make_mat4(mXY);
-
-    float mYZ[16] = {
-    1, 0, 0, 0,
-    0, cos(yz), -sin(yz), 0,
-    0, sin(yz), cos(yz), 0,
-    0, 0, 0, 1
-    };
-    glm::mat4 rYZ = glm::make_mat4(mYZ);
-
-    float mXZ[16] = {
-            cos(xz), 0, -sin(xz), 0,
-            0, 1, 0, 0,
-            sin(xz), 0, cos(xz), 0,
-            0, 0, 0, 1
-    };
-    glm::mat4 rXZ = glm::make_mat4(mXZ);
-
-    float mXW[16] = {
-        cos(xw), 0, 0, -sin(xw),
-        0, 1, 0, 0,
-        0, 0, 1, 0,
-        sin(xw), 0, 0, cos(xw)
-    };
-    glm::mat4 rXW = glm::make_mat4(mXW);
-
-    float mYW[16] = {
-        1, 0, 0, 0,
-        0, cos(yw), 0, -sin(yw),
-        0, 0, 1, 0,
-        0, sin(yw), 0, cos(yw)
-    };
-    glm::mat4 rYW = glm::make_mat4(mYW);
-
-    float mZW[16] = {
-        1, 0, 0, 0,
-        0, 1, 0, 0,
-        0, 0, cos(zw), -sin(zw),
-        0, 0, sin(zw), cos(zw)
-    };
-    glm::mat4 rZW = glm::make_mat4(mZW);
-
-    return rXY * rXZ * rYZ * rXW * rYW * rZW;
+    // Positions, scales and velocities depend on the number of instances
+    m_transformsEdited = true;
 }
 
 std::shared_ptr<Texture2DObject> Geometry4DApplication::LoadTexture(const char* path)
@@ -2,10 +2,23 @@
 
 #include <ituGL/application/Application.h>
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/shader/ShaderProgramCache.h>
+#include <ituGL/asset/ShaderPermutationCache.h>
+#include <ituGL/utils/FileWatcher.h>
 #include <ituGL/camera/Camera.h>
 #include <ituGL/camera/CameraController.h>
 #include <ituGL/utils/DearImGui.h>
 #include <glm/glm.hpp>
+#include "Polytope4D.h"
+#include "InstanceBatch4D.h"
+#include "Rotor4D.h"
+#include "Slicer4D.h"
+#include "TetrahedralMesh4D.h"
+#include "Transform4DKernel.h"
+#include "Transform4DPool.h"
+#include <chrono>
+#include <memory>
+#include <string>
 
 // The Vertex struct contains the necessary vertex information:
 // Position (vec4)
@@ -24,11 +37,15 @@ struct Vertex
 };
 
 class Texture2DObject;
+class FramebufferObject;
 
 class Geometry4DApplication : public Application
 {
 public:
-    Geometry4DApplication();
+    // With headlessFrameCount > 0, renders that many frames offscreen, with no window, and quits
+    // Each frame is written as a PPM image to the outputPath directory, or to stdout if outputPath is "-" (to pipe it
+    // to a video encoder). With no outputPath, the frames are only rendered, for benchmarking
+    Geometry4DApplication(unsigned int headlessFrameCount = 0, const char* outputPath = nullptr);
 
 protected:
     void Initialize() override;
@@ -42,18 +59,57 @@ private:
     void InitializeCamera();
     void InitializeUniforms();
     void InitializeTextures();
+    void InitializeCrossSection();
+    void InitializeInstances();
+    void InitializeHeadless();
 
     void RenderGUI();
-    void LoadAndCompileShader(Shader& shader, const char* path);
+    // Draws the GUI, or in headless mode, writes the frame
+    void EndFrame();
+    // Reads back the offscreen color texture and writes it as a PPM image
+    void WriteFrame();
+    // Draws a grid of hypercubes with a single instanced drawcall
+    void RenderInstances();
+    // Locations of the Blinn-Phong uniforms shared by all the shader programs
+    struct BlinnPhongUniforms
+    {
+        ShaderProgram::Location ambientReflection = -1;
+        ShaderProgram::Location diffuseReflection = -1;
+        ShaderProgram::Location specularReflection = -1;
+        ShaderProgram::Location specularExponent = -1;
+        ShaderProgram::Location ambientColor = -1;
+        ShaderProgram::Location lightColor = -1;
+        ShaderProgram::Location lightPosition = -1;
+    };
+    static BlinnPhongUniforms GetBlinnPhongUniforms(const ShaderProgram& shaderProgram);
+    void SetBlinnPhongUniforms(ShaderProgram& shaderProgram, const BlinnPhongUniforms& uniforms);
+    // Looks up the uniforms of the textured variant, when it is swapped in
+    void InitializeTexturedUniforms();
+    // Binds the camera block of a program to the buffer of m_cameraBuffer. Needed again for every new program
+    void SetCameraBlockBinding(const ShaderProgram& shaderProgram);
+    // Uploads the camera block, once per frame
+    void UpdateCameraBuffer();
+    // Reloads the shaders when their files change
+    void UpdateShaders();
     void ResetState();
 
     // 4D Meshes
-    void CreateTextured4DCube(Mesh* mesh, float size);
-    void Create4DCube(Mesh* mesh, float size);
-    void Create4DCubeWireframe(Mesh* mesh, float size);
+    // Creates the textured, untextured and wireframe submeshes of a hypercube subdivided S times, sharing the same buffers
+    template<int S>
+    void CreateHypercube(Mesh& mesh, float size);
+    // Creates the solid and wireframe submeshes of a regular polytope, sharing the same buffers
+    void CreatePolytope(Mesh& mesh, const Polytope4D& polytope, float size);
+    // Rebuilds the polytope and its mesh
+    void SetPolytope(Polytope4D::Type type);
+    // Slices the polytope with the hyperplane from the GUI, and streams the cross-section into its vertex buffer
+    void UpdateCrossSection(const glm::mat4& rotation, const glm::vec4& scale);
+    void DrawCrossSection();
 
     // 4D Transformations
-    glm::mat4 Rotate4D(float xy, float yz, float xz, float xw, float yw, float zw);
+    // Copies the parameters edited in the GUI to the transform pool, and advances the animated objects by one step
+    void UpdateTransforms();
+    // Adds or removes the objects of the instanced grid so there is one for each instance
+    void UpdateInstanceObjects();
 
     // Textures
     std::shared_ptr<Texture2DObject> LoadTexture(const char* path);
@@ -63,7 +119,56 @@ private:
 
     Mesh m_cube;
 
-    ShaderProgram m_shaderProgram;
+    // Submeshes of m_cube
+    unsigned int m_texturedSubmesh;
+    unsigned int m_solidSubmesh;
+    unsigned int m_wireframeSubmesh;
+
+    // Regular polytope selected in the GUI, and its mesh
+    Polytope4D m_polytope;
+    Mesh m_polytopeMesh;
+    unsigned int m_polytopeSolidSubmesh;
+    unsigned int m_polytopeWireframeSubmesh;
+
+    // Cross-section of the polytope, rebuilt every frame
+    TetrahedralMesh4D m_polytopeTetrahedra;
+    Vertex4DArray m_polytopeVertices;
+    Vertex4DArray m_slicedVertices;
+    Slicer4D m_slicer;
+    std::unique_ptr<VertexBufferObject> m_crossSectionVBO;
+    std::unique_ptr<VertexArrayObject> m_crossSectionVAO;
+    unsigned int m_crossSectionCapacity;
+    unsigned int m_crossSectionVertexCount;
+
+    // Untextured and textured variants of the main program, and the instanced one
+    std::shared_ptr<ShaderProgram> m_shaderProgram;
+    std::shared_ptr<ShaderProgram> m_texturedShaderProgram;
+    std::shared_ptr<ShaderProgram> m_instancedShaderProgram;
+
+    // Linked programs from previous runs, and how long the shaders took to be ready at startup, in seconds
+    ShaderProgramCache m_shaderProgramCache;
+    double m_shaderStartupTime;
+
+    // Variants of the main program, with and without TEXTURED, and of the instanced one
+    ShaderPermutationCache m_shaderPermutations;
+    ShaderPermutationCache m_instancedShaderPermutations;
+
+    // Shader files, and when the last change started reloading them
+    FileWatcher m_shaderFileWatcher;
+    bool m_shaderReloading;
+    std::chrono::steady_clock::time_point m_shaderReloadStartTime;
+
+    // Grid of instanced hypercubes, and the per-instance data, only uploaded when some instance changed
+    std::unique_ptr<InstanceBatch4D> m_instanceBatch;
+    std::vector<Instance4D> m_instances;
+
+    // Headless mode: offscreen target, where to write the frames, and when the first frame started
+    std::shared_ptr<FramebufferObject> m_headlessFramebuffer;
+    std::shared_ptr<Texture2DObject> m_headlessColorTexture;
+    std::shared_ptr<Texture2DObject> m_headlessDepthTexture;
+    std::vector<unsigned char> m_headlessPixels;
+    std::string m_outputPath;
+    std::chrono::steady_clock::time_point m_headlessStartTime;
 
     // Textures
     std::shared_ptr<Texture2DObject> m_dirtTexture;
@@ -71,10 +176,6 @@ private:
     std::shared_ptr<Texture2DObject> m_rockTexture;
     std::shared_ptr<Texture2DObject> m_snowTexture;
 
-    // Texture Uniforms
-    ShaderProgram::Location m_texture;
-    ShaderProgram::Location m_usingTexture;
-
     // Blinn-Phong Material Uniforms
     ShaderProgram::Location m_ambientReflectionUniform;
     ShaderProgram::Location m_diffuseReflectionUniform;
@@ -85,32 +186,45 @@ private:
     ShaderProgram::Location m_ambientColorUniform;
     ShaderProgram::Location m_lightColorUniform;
     ShaderProgram::Location m_lightPositionUniform;
-    ShaderProgram::Location m_cameraPositionUniform;
 
     // Transformation Uniforms
     ShaderProgram::Location m_worldRotationMatrixUniform;
     ShaderProgram::Location m_worldTranslationVectorUniform;
     ShaderProgram::Location m_worldScaleVectorUniform;
 
-    ShaderProgram::Location m_viewProjMatrixUniform;
-    
     ShaderProgram::Location m_colorUniform;
 
+    // Uniforms of the textured variant, and of the instanced program
+    ShaderProgram::Location m_texturedTextureUniform;
+    ShaderProgram::Location m_texturedColorUniform;
+    ShaderProgram::Location m_texturedWorldRotationMatrixUniform;
+    ShaderProgram::Location m_texturedWorldTranslationVectorUniform;
+    ShaderProgram::Location m_texturedWorldScaleVectorUniform;
+    BlinnPhongUniforms m_texturedBlinnPhongUniforms;
+    BlinnPhongUniforms m_instancedBlinnPhongUniforms;
+
+    // Camera matrices and position, read by all the programs from the CameraBlock
     Camera m_camera;
+    UniformBufferObject m_cameraBuffer;
     CameraController m_cameraController;
 
-    //Cube Parameters
+    // Transforms of all the 4D objects. The instances of the grid are children of m_gridObject, after it in the pool
+    Transform4DPool m_transforms;
+    unsigned int m_cubeObject;
+    unsigned int m_gridObject;
+    unsigned int m_instanceObjectCount;
+
+    // Imgui member variables. Only copied to m_transforms when m_transformsEdited is set
     float m_scale;
-    float m_xyRotation;
-    float m_yzRotation;
-    float m_xzRotation;
-    float m_xwRotation;
-    float m_ywRotation;
-    float m_zwRotation;
-
-    // Imgui member variables
     float m_rotationVelocities[6];
     float m_cubeCenter[4];
+    bool m_transformsEdited = true;
     const char* m_textureList[4] = {"Dirt", "Grass", "Rock", "Snow"};
     int m_selectedTexture = 0;
+    int m_selectedPolytope = static_cast<int>(Polytope4D::Type::Cell8);
+    bool m_showCrossSection = false;
+    float m_sliceNormal[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    float m_sliceDistance = 0.0f;
+    bool m_showInstances = false;
+    int m_instanceCount = 1000;
 };
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <array>
+#include <type_traits>
+
+// Helper base class that computes the boundary of the subdivided lattice [0, S]^N at compile time
+// Use the Hypercube class below, which stores the generated tables
+template<int N, int S>
+class HypercubeGenerator
+{
+    static_assert(N >= 1 && N <= 8, "Unsupported hypercube dimension");
+    static_assert(S >= 1, "Subdivision level must be at least 1");
+
+public:
+    // Number of k-cells on the boundary: choose the k free axes, place the cell in the free axes (S options each)
+    // and in the fixed axes (S + 1 options each), with at least one fixed axis on the boundary of the lattice
+    static constexpr int GetCellCount(int k)
+    {
+        return k > N ? 0 : Binomial(N, k) * Power(S, k) * (Power(S + 1, N - k) - Power(S - 1, N - k));
+    }
+
+    using Coordinates = std::array<int, N>;
+
+protected:
+    static constexpr int Power(int base, int exponent)
+    {
+        int result = 1;
+        for (int i = 0; i < exponent; ++i)
+        {
+            result *= base;
+        }
+        return result;
+    }
+
+    static constexpr int Binomial(int n, int k)
+    {
+        int result = 1;
+        for (int i = 1; i <= k; ++i)
+        {
+            result = result * (n - k + i) / i;
+        }
+        return result;
+    }
+
+    static constexpr int LatticeSize = Power(S + 1, N);
+
+    static constexpr int GetLatticeIndex(const Coordinates& coordinates)
+    {
+        int index = 0;
+        for (int axis = N - 1; axis >= 0; --axis)
+        {
+            index = index * (S + 1) + coordinates[axis];
+        }
+        return index;
+    }
+
+    static constexpr bool IsOnBoundary(const Coordinates& coordinates)
+    {
+        for (int axis = 0; axis < N; ++axis)
+        {
+            if (coordinates[axis] == 0 || coordinates[axis] == S)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static constexpr std::array<Coordinates, GetCellCount(0)> GenerateVertices()
+    {
+        std::array<Coordinates, GetCellCount(0)> vertices{};
+        int vertexIndex = 0;
+        for (int latticeIndex = 0; latticeIndex < LatticeSize; ++latticeIndex)
+        {
+            Coordinates coordinates{};
+            for (int axis = 0, remainder = latticeIndex; axis < N; ++axis, remainder /= S + 1)
+            {
+                coordinates[axis] = remainder % (S + 1);
+            }
+            if (IsOnBoundary(coordinates))
+            {
+                vertices[vertexIndex++] = coordinates;
+            }
+        }
+        return vertices;
+    }
+
+    // Maps each lattice point to its vertex index, or -1 if the point is inside the hypercube
+    static constexpr std::array<int, LatticeSize> GenerateVertexLookup()
+    {
+        std::array<int, LatticeSize> lookup{};
+        for (int& vertexIndex : lookup)
+        {
+            vertexIndex = -1;
+        }
+        const std::array<Coordinates, GetCellCount(0)> vertices = GenerateVertices();
+        for (int vertexIndex = 0; vertexIndex < GetCellCount(0); ++vertexIndex)
+        {
+            lookup[GetLatticeIndex(vertices[vertexIndex])] = vertexIndex;
+        }
+        return lookup;
+    }
+
+    // Enumerates all the boundary cells spanned by K axes, storing their 2^K corners
+    template<int K, typename Index>
+    static constexpr std::array<std::array<Index, 1 << K>, GetCellCount(K)> GenerateCells()
+    {
+        std::array<std::array<Index, 1 << K>, GetCellCount(K)> cells{};
+        const std::array<int, LatticeSize> lookup = GenerateVertexLookup();
+        int cellIndex = 0;
+
+        // Each set of free axes is a bitmask with K bits set
+        for (int axisMask = 0; axisMask < (1 << N); ++axisMask)
+        {
+            int freeAxes[K > 0 ? K : 1] = {};
+            int freeAxisCount = 0;
+            for (int axis = 0; axis < N; ++axis)
+            {
+                if (axisMask & (1 << axis))
+                {
+                    if (freeAxisCount < K)
+                    {
+                        freeAxes[freeAxisCount] = axis;
+                    }
+                    ++freeAxisCount;
+                }
+            }
+            if (freeAxisCount != K)
+            {
+                continue;
+            }
+
+            // The lowest corner of the cell can go from 0 to S-1 in free axes, and from 0 to S in fixed axes
+            for (int latticeIndex = 0; latticeIndex < LatticeSize; ++latticeIndex)
+            {
+                Coordinates base{};
+                bool valid = true;
+                bool onBoundary = false;
+                for (int axis = 0, remainder = latticeIndex; axis < N; ++axis, remainder /= S + 1)
+                {
+                    base[axis] = remainder % (S + 1);
+                    if (axisMask & (1 << axis))
+                    {
+                        valid = valid && base[axis] < S;
+                    }
+                    else
+                    {
+                        onBoundary = onBoundary || base[axis] == 0 || base[axis] == S;
+                    }
+                }
+                if (!valid || !onBoundary)
+                {
+                    continue;
+                }
+
+                std::array<Index, 1 << K>& cell = cells[cellIndex++];
+                for (int corner = 0; corner < (1 << K); ++corner)
+                {
+                    Coordinates coordinates = base;
+                    for (int i = 0; i < K; ++i)
+                    {
+                        coordinates[freeAxes[i]] += (corner >> i) & 1;
+                    }
+                    cell[corner] = static_cast<Index>(lookup[GetLatticeIndex(coordinates)]);
+                }
+
+                // Faces are stored in cyclic order instead of binary order, so they can be triangulated as a fan
+                if constexpr (K == 2)
+                {
+                    Index swap = cell[2];
+                    cell[2] = cell[3];
+                    cell[3] = swap;
+                }
+            }
+        }
+        return cells;
+    }
+};
+
+// Compile-time generator for the boundary of an N-dimensional hypercube, subdivided S times along every axis
+// Only the lattice points and k-cells lying on the boundary are emitted: vertices, edges (1-cells),
+// square faces (2-cells) and cubic cells (3-cells)
+// All the tables are static constexpr, so they are built by the compiler and cost nothing at startup
+// Hypercube<4, 1> is the tesseract: 16 vertices, 32 edges, 24 faces and 8 cells
+template<int N, int S = 1>
+class Hypercube : public HypercubeGenerator<N, S>
+{
+    using Generator = HypercubeGenerator<N, S>;
+
+public:
+    static constexpr int Dimension = N;
+    static constexpr int Subdivisions = S;
+
+    static constexpr int VertexCount = Generator::GetCellCount(0);
+    static constexpr int EdgeCount = Generator::GetCellCount(1);
+    static constexpr int FaceCount = Generator::GetCellCount(2);
+    static constexpr int CellCount = Generator::GetCellCount(3);
+
+    // Smallest unsigned type that can index all the vertices, to be used as element type
+    using Index = std::conditional_t<(VertexCount <= 0xFF), unsigned char,
+        std::conditional_t<(VertexCount <= 0xFFFF), unsigned short, unsigned int>>;
+
+    using Coordinates = typename Generator::Coordinates;
+
+    // Lattice coordinates of each vertex, in the range [0, S]
+    static constexpr std::array<Coordinates, VertexCount> Vertices = Generator::GenerateVertices();
+
+    // Each edge, as the 2 vertex indices at its ends
+    static constexpr std::array<std::array<Index, 2>, EdgeCount> Edges = Generator::template GenerateCells<1, Index>();
+
+    // Each square face, as the 4 vertex indices of its corners in cyclic order
+    static constexpr std::array<std::array<Index, 4>, FaceCount> Faces = Generator::template GenerateCells<2, Index>();
+
+    // Each cubic cell, as the 8 vertex indices of its corners. Corner i has the offset (i & 1, i & 2, i & 4) along its axes
+    static constexpr std::array<std::array<Index, 8>, CellCount> Cells = Generator::template GenerateCells<3, Index>();
+
+    // Position of a vertex coordinate inside a hypercube of the given size, centered in the origin
+    static constexpr float GetCoordinate(int latticeCoordinate, float size)
+    {
+        return size * (static_cast<float>(latticeCoordinate) / S - 0.5f);
+    }
+};
@@ -0,0 +1,68 @@
+#include "InstanceBatch4D.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+InstanceBatch4D::InstanceBatch4D() : m_instanceCount(0), m_instanceCapacity(0)
+{
+}
+
+void InstanceBatch4D::Initialize(const Mesh& mesh, unsigned int vboIndex, unsigned int eboIndex,
+    VertexFormat::LayoutIterator it, const VertexFormat::LayoutIterator itEnd)
+{
+    m_vao.Bind();
+
+    // Vertex attributes, from the VBO of the mesh
+    GLuint location = 0;
+    mesh.GetVertexBuffer(vboIndex).Bind();
+    for (; it != itEnd; it++)
+    {
+        m_vao.SetAttribute(location, it->GetAttribute(), it->GetOffset(), it->GetStride());
+        location += it->GetAttribute().GetLocationSize();
+    }
+    assert(location <= FirstInstanceLocation);
+
+    // Instance attributes, advancing once per instance
+    VertexAttribute vec4Attribute(Data::Type::Float, 4);
+    const GLsizei stride = sizeof(Instance4D);
+    m_instanceVBO.Bind();
+    for (int column = 0; column < 4; ++column)
+    {
+        m_vao.SetAttribute(FirstInstanceLocation + column, vec4Attribute, offsetof(Instance4D, rotation) + column * sizeof(glm::vec4), stride);
+    }
+    m_vao.SetAttribute(FirstInstanceLocation + 4, vec4Attribute, offsetof(Instance4D, translation), stride);
+    m_vao.SetAttribute(FirstInstanceLocation + 5, vec4Attribute, offsetof(Instance4D, scale), stride);
+    m_vao.SetAttribute(FirstInstanceLocation + 6, vec4Attribute, offsetof(Instance4D, color), stride);
+    for (GLuint instanceLocation = FirstInstanceLocation; instanceLocation < FirstInstanceLocation + 7; ++instanceLocation)
+    {
+        m_vao.SetAttributeDivisor(instanceLocation, 1);
+    }
+
+    mesh.GetElementBuffer(eboIndex).Bind();
+
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+    ElementBufferObject::Unbind();
+}
+
+void InstanceBatch4D::SetInstances(std::span<const Instance4D> instances)
+{
+    m_instanceCount = static_cast<unsigned int>(instances.size());
+
+    // Reallocating every time (orphaning) lets the driver keep the old data for the previous frame instead of waiting
+    m_instanceCapacity = std::max(m_instanceCapacity, m_instanceCount);
+    m_instanceVBO.Bind();
+    m_instanceVBO.AllocateData(m_instanceCapacity * sizeof(Instance4D), BufferObject::StreamDraw);
+    m_instanceVBO.UpdateData(instances);
+    VertexBufferObject::Unbind();
+}
+
+void InstanceBatch4D::DrawSubmesh(const Mesh& mesh, unsigned int submeshIndex) const
+{
+    if (m_instanceCount == 0)
+        return;
+
+    m_vao.Bind();
+    mesh.GetSubmeshDrawcall(submeshIndex).DrawInstanced(m_instanceCount);
+}
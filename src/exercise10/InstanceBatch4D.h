@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <glm/glm.hpp>
+#include <span>
+
+// Per-instance data of shader_instanced.vert: the same 4D transform as the uniforms of shader.vert, and a color
+struct Instance4D
+{
+    glm::mat4 rotation;
+    glm::vec4 translation;
+    glm::vec4 scale;
+    glm::vec4 color;
+};
+
+// Draws many copies of the submeshes of a mesh, each one with its own Instance4D, in a single drawcall per submesh
+// The instance data goes to its own VBO, and a separate VAO combines it with the VBO and EBO of the mesh,
+// so the mesh itself can still be drawn without instancing
+class InstanceBatch4D
+{
+public:
+    // Location of the first instance attribute. The rotation matrix takes 4 locations, one for each column
+    static const GLuint FirstInstanceLocation = 3;
+
+public:
+    InstanceBatch4D();
+
+    // Sets up the VAO with the vertex attributes of the mesh (from its VBO and EBO) and the instance attributes
+    void Initialize(const Mesh& mesh, unsigned int vboIndex, unsigned int eboIndex,
+        VertexFormat::LayoutIterator it, const VertexFormat::LayoutIterator itEnd);
+
+    // Replaces the instance data, growing the VBO if needed
+    void SetInstances(std::span<const Instance4D> instances);
+    inline unsigned int GetInstanceCount() const { return m_instanceCount; }
+
+    // Draws all the instances of a submesh. The submesh must use the VBO and EBO passed to Initialize
+    void DrawSubmesh(const Mesh& mesh, unsigned int submeshIndex) const;
+
+private:
+    VertexBufferObject m_instanceVBO;
+    VertexArrayObject m_vao;
+
+    unsigned int m_instanceCount;
+    unsigned int m_instanceCapacity;
+};
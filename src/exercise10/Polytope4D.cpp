@@ -0,0 +1,411 @@
+#include "Polytope4D.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+Polytope4D::Polytope4D() : m_type(Type::Count), m_faceSize(0), m_cellSize(0), m_cellVertexCount(0)
+{
+}
+
+const char* Polytope4D::GetName(Type type)
+{
+    switch (type)
+    {
+    case Type::Cell5:
+        return "5-cell";
+    case Type::Cell8:
+        return "8-cell (tesseract)";
+    case Type::Cell16:
+        return "16-cell";
+    case Type::Cell24:
+        return "24-cell";
+    case Type::Cell120:
+        return "120-cell";
+    case Type::Cell600:
+        return "600-cell";
+    default:
+        return "";
+    }
+}
+
+void Polytope4D::Build(Type type)
+{
+    m_type = type;
+    m_vertices.clear();
+    m_scratchPoints.clear();
+
+    // Generate the vertices from the symmetry group, and the normals of the cells when they are not tetrahedra
+    switch (type)
+    {
+    case Type::Cell5:
+    {
+        // A regular tetrahedron from the even sign changes of (1, 1, 1), and an apex on the w axis
+        const float w = 1.0f / std::sqrt(5.0f);
+        m_vertices.emplace_back(1.0f, 1.0f, 1.0f, -w);
+        m_vertices.emplace_back(1.0f, -1.0f, -1.0f, -w);
+        m_vertices.emplace_back(-1.0f, 1.0f, -1.0f, -w);
+        m_vertices.emplace_back(-1.0f, -1.0f, 1.0f, -w);
+        m_vertices.emplace_back(0.0f, 0.0f, 0.0f, 4.0f * w);
+        break;
+    }
+    case Type::Cell8:
+        AddOrbit(m_vertices, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), false);
+        // Cubic cells are centered on the axes
+        AddOrbit(m_scratchPoints, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), false);
+        break;
+    case Type::Cell16:
+        AddOrbit(m_vertices, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), false);
+        break;
+    case Type::Cell24:
+        AddOrbit(m_vertices, glm::vec4(1.0f, 1.0f, 0.0f, 0.0f), false);
+        // Octahedral cells are centered on the vertices of the dual 24-cell
+        AddOrbit(m_scratchPoints, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), false);
+        AddOrbit(m_scratchPoints, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), false);
+        break;
+    case Type::Cell120:
+    case Type::Cell600:
+    {
+        // 8 vertices of a 16-cell, 16 of a tesseract and 96 from the even permutations of (phi, 1, 1/phi, 0)
+        // The 120-cell is built later as the dual of the 600-cell
+        const float goldenRatio = 0.5f * (1.0f + std::sqrt(5.0f));
+        AddOrbit(m_vertices, glm::vec4(2.0f, 0.0f, 0.0f, 0.0f), false);
+        AddOrbit(m_vertices, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), false);
+        AddOrbit(m_vertices, glm::vec4(goldenRatio, 1.0f, 1.0f / goldenRatio, 0.0f), true);
+        break;
+    }
+    default:
+        assert(false);
+        return;
+    }
+
+    NormalizeVertices();
+    BuildEdges();
+
+    if (m_scratchPoints.empty())
+    {
+        BuildSimplicialCells();
+    }
+    else
+    {
+        BuildCellsFromNormals(m_scratchPoints);
+    }
+
+    if (type == Type::Cell120)
+    {
+        BuildDual();
+        NormalizeVertices();
+        BuildEdges();
+    }
+
+    BuildFaces();
+}
+
+void Polytope4D::AddOrbit(std::vector<glm::vec4>& points, const glm::vec4& seed, bool evenPermutationsOnly)
+{
+    std::array<int, 4> permutation = { 0, 1, 2, 3 };
+    do
+    {
+        // Count the inversions to get the parity of the permutation
+        int inversions = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = i + 1; j < 4; ++j)
+            {
+                inversions += permutation[i] > permutation[j] ? 1 : 0;
+            }
+        }
+        if (evenPermutationsOnly && (inversions & 1))
+        {
+            continue;
+        }
+
+        for (int signs = 0; signs < 16; ++signs)
+        {
+            glm::vec4 point;
+            for (int i = 0; i < 4; ++i)
+            {
+                point[i] = (signs & (1 << i)) ? -seed[permutation[i]] : seed[permutation[i]];
+            }
+
+            // Permutations and sign changes of repeated or zero coordinates produce the same point several times
+            bool duplicated = std::any_of(points.begin(), points.end(),
+                [&point](const glm::vec4& other) { glm::vec4 delta = other - point; return glm::dot(delta, delta) < 1e-6f; });
+            if (!duplicated)
+            {
+                points.push_back(point);
+            }
+        }
+    } while (std::next_permutation(permutation.begin(), permutation.end()));
+}
+
+void Polytope4D::NormalizeVertices()
+{
+    for (glm::vec4& vertex : m_vertices)
+    {
+        vertex = glm::normalize(vertex);
+    }
+}
+
+void Polytope4D::BuildEdges()
+{
+    const unsigned int vertexCount = GetVertexCount();
+    assert(vertexCount > 1);
+
+    // All the vertices of a regular polytope have the same neighbourhood, so the closest vertex to the first one gives the edge length
+    float edgeLength2 = 4.0f;
+    for (unsigned int j = 1; j < vertexCount; ++j)
+    {
+        glm::vec4 delta = m_vertices[j] - m_vertices[0];
+        edgeLength2 = std::min(edgeLength2, glm::dot(delta, delta));
+    }
+    const float tolerance = edgeLength2 * 1e-3f;
+
+    m_edges.clear();
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        for (unsigned int j = i + 1; j < vertexCount; ++j)
+        {
+            glm::vec4 delta = m_vertices[j] - m_vertices[i];
+            if (std::abs(glm::dot(delta, delta) - edgeLength2) < tolerance)
+            {
+                m_edges.push_back(static_cast<Index>(i));
+                m_edges.push_back(static_cast<Index>(j));
+            }
+        }
+    }
+
+    // Count the neighbours of each vertex, then fill the lists. Edges are sorted, so the lists end up sorted too
+    m_adjacencyOffsets.assign(vertexCount + 1, 0);
+    for (Index vertex : m_edges)
+    {
+        ++m_adjacencyOffsets[vertex + 1];
+    }
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        m_adjacencyOffsets[i + 1] += m_adjacencyOffsets[i];
+    }
+
+    m_adjacency.resize(m_edges.size());
+    m_scratchIndices.assign(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < m_edges.size(); i += 2)
+    {
+        m_adjacency[m_scratchIndices[m_edges[i]]++] = m_edges[i + 1];
+        m_adjacency[m_scratchIndices[m_edges[i + 1]]++] = m_edges[i];
+    }
+}
+
+bool Polytope4D::AreAdjacent(Index vertex0, Index vertex1) const
+{
+    auto itBegin = m_adjacency.begin() + m_adjacencyOffsets[vertex0];
+    auto itEnd = m_adjacency.begin() + m_adjacencyOffsets[vertex0 + 1];
+    return std::binary_search(itBegin, itEnd, vertex1);
+}
+
+void Polytope4D::BuildSimplicialCells()
+{
+    m_cellVertexCount = 4;
+    m_cellVertices.clear();
+
+    // Find the sets of 4 vertices a < b < c < d where all of them are adjacent to each other
+    for (unsigned int a = 0; a < GetVertexCount(); ++a)
+    {
+        const unsigned int begin = m_adjacencyOffsets[a];
+        const unsigned int end = m_adjacencyOffsets[a + 1];
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            Index b = m_adjacency[i];
+            if (b < a)
+            {
+                continue;
+            }
+            for (unsigned int j = i + 1; j < end; ++j)
+            {
+                Index c = m_adjacency[j];
+                if (!AreAdjacent(b, c))
+                {
+                    continue;
+                }
+                for (unsigned int k = j + 1; k < end; ++k)
+                {
+                    Index d = m_adjacency[k];
+                    if (AreAdjacent(b, d) && AreAdjacent(c, d))
+                    {
+                        m_cellVertices.insert(m_cellVertices.end(), { static_cast<Index>(a), b, c, d });
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Polytope4D::BuildCellsFromNormals(std::span<const glm::vec4> normals)
+{
+    m_cellVertexCount = 0;
+    m_cellVertices.clear();
+
+    for (const glm::vec4& normal : normals)
+    {
+        float maxDistance = -1.0f;
+        for (const glm::vec4& vertex : m_vertices)
+        {
+            maxDistance = std::max(maxDistance, glm::dot(normal, vertex));
+        }
+
+        size_t cellBegin = m_cellVertices.size();
+        for (unsigned int i = 0; i < GetVertexCount(); ++i)
+        {
+            if (glm::dot(normal, m_vertices[i]) > maxDistance - 1e-4f)
+            {
+                m_cellVertices.push_back(static_cast<Index>(i));
+            }
+        }
+
+        assert(m_cellVertexCount == 0 || m_cellVertexCount == m_cellVertices.size() - cellBegin);
+        m_cellVertexCount = static_cast<unsigned int>(m_cellVertices.size() - cellBegin);
+    }
+}
+
+void Polytope4D::BuildVertexCells()
+{
+    const unsigned int vertexCount = GetVertexCount();
+    const unsigned int cellCount = static_cast<unsigned int>(m_cellVertices.size() / m_cellVertexCount);
+
+    m_vertexCellOffsets.assign(vertexCount + 1, 0);
+    for (Index vertex : m_cellVertices)
+    {
+        ++m_vertexCellOffsets[vertex + 1];
+    }
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        m_vertexCellOffsets[i + 1] += m_vertexCellOffsets[i];
+    }
+
+    // Cells are visited in order, so the list of each vertex ends up sorted
+    m_vertexCells.resize(m_cellVertices.size());
+    m_scratchIndices.assign(m_vertexCellOffsets.begin(), m_vertexCellOffsets.end() - 1);
+    for (unsigned int cell = 0; cell < cellCount; ++cell)
+    {
+        for (unsigned int i = 0; i < m_cellVertexCount; ++i)
+        {
+            m_vertexCells[m_scratchIndices[m_cellVertices[cell * m_cellVertexCount + i]]++] = static_cast<Index>(cell);
+        }
+    }
+}
+
+void Polytope4D::BuildDual()
+{
+    BuildVertexCells();
+
+    const unsigned int cellCount = static_cast<unsigned int>(m_cellVertices.size() / m_cellVertexCount);
+
+    // The centers of the cells are the new vertices
+    m_scratchPoints.clear();
+    for (unsigned int cell = 0; cell < cellCount; ++cell)
+    {
+        glm::vec4 center(0.0f);
+        for (unsigned int i = 0; i < m_cellVertexCount; ++i)
+        {
+            center += m_vertices[m_cellVertices[cell * m_cellVertexCount + i]];
+        }
+        m_scratchPoints.push_back(center / static_cast<float>(m_cellVertexCount));
+    }
+    m_vertices.swap(m_scratchPoints);
+
+    // The (sorted) lists of cells around each old vertex are the new cells
+    m_cellVertexCount = m_vertexCellOffsets[1] - m_vertexCellOffsets[0];
+    m_cellVertices.assign(m_vertexCells.begin(), m_vertexCells.end());
+}
+
+void Polytope4D::BuildFaces()
+{
+    BuildVertexCells();
+
+    const unsigned int cellCount = static_cast<unsigned int>(m_cellVertices.size() / m_cellVertexCount);
+
+    m_faceSize = 0;
+    m_faces.clear();
+    m_scratchIndices.clear();
+
+    // Two neighbour cells share a whole face. Cells that only share an edge or a vertex are skipped
+    for (unsigned int cell = 0; cell < cellCount; ++cell)
+    {
+        const Index* cellVertices = &m_cellVertices[cell * m_cellVertexCount];
+        for (unsigned int i = 0; i < m_cellVertexCount; ++i)
+        {
+            const Index vertex = cellVertices[i];
+            for (unsigned int j = m_vertexCellOffsets[vertex]; j < m_vertexCellOffsets[vertex + 1]; ++j)
+            {
+                const unsigned int otherCell = m_vertexCells[j];
+                if (otherCell <= cell)
+                {
+                    continue;
+                }
+
+                // Both lists are sorted, so the shared vertices come out sorted too
+                const Index* otherCellVertices = &m_cellVertices[otherCell * m_cellVertexCount];
+                std::array<Index, 8> sharedVertices;
+                unsigned int sharedCount = 0;
+                for (unsigned int a = 0, b = 0; a < m_cellVertexCount && b < m_cellVertexCount && sharedCount < sharedVertices.size();)
+                {
+                    if (cellVertices[a] < otherCellVertices[b])
+                    {
+                        ++a;
+                    }
+                    else if (otherCellVertices[b] < cellVertices[a])
+                    {
+                        ++b;
+                    }
+                    else
+                    {
+                        sharedVertices[sharedCount++] = cellVertices[a];
+                        ++a;
+                        ++b;
+                    }
+                }
+
+                // Only add the face once, when visiting its first vertex
+                if (sharedCount < 3 || sharedVertices[0] != vertex)
+                {
+                    continue;
+                }
+
+                // Walk along the edges of the face to sort its vertices in cyclic order
+                for (unsigned int k = 1; k + 1 < sharedCount; ++k)
+                {
+                    for (unsigned int l = k; l < sharedCount; ++l)
+                    {
+                        if (AreAdjacent(sharedVertices[k - 1], sharedVertices[l]))
+                        {
+                            std::swap(sharedVertices[k], sharedVertices[l]);
+                            break;
+                        }
+                    }
+                }
+
+                assert(m_faceSize == 0 || m_faceSize == sharedCount);
+                m_faceSize = sharedCount;
+                m_faces.insert(m_faces.end(), sharedVertices.begin(), sharedVertices.begin() + sharedCount);
+                m_scratchIndices.push_back(cell);
+                m_scratchIndices.push_back(otherCell);
+            }
+        }
+    }
+
+    // Each face is shared by exactly 2 cells, so all the cells get the same number of faces
+    const unsigned int faceCount = GetFaceCount();
+    m_cellSize = 2 * faceCount / cellCount;
+    m_cells.resize(cellCount * m_cellSize);
+
+    m_scratchCounts.assign(cellCount, 0);
+    for (unsigned int face = 0; face < faceCount; ++face)
+    {
+        for (unsigned int side = 0; side < 2; ++side)
+        {
+            const unsigned int cell = m_scratchIndices[face * 2 + side];
+            assert(m_scratchCounts[cell] < m_cellSize);
+            m_cells[cell * m_cellSize + m_scratchCounts[cell]++] = static_cast<Index>(face);
+        }
+    }
+}
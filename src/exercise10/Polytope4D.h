@@ -0,0 +1,115 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+// Regular convex 4-polytope, with its topology stored once in flat index arrays
+// In a regular polytope all faces have the same number of vertices and all cells have the same number of faces,
+// so each face and each cell is a fixed-size run inside its array, with no offset tables
+// The arrays are kept between calls to Build, so rebuilding only allocates the first time a bigger polytope is built
+class Polytope4D
+{
+public:
+    // The six regular convex 4-polytopes, named after their number of cells
+    enum class Type
+    {
+        Cell5,   // 4-simplex: 5 tetrahedra
+        Cell8,   // Tesseract: 8 cubes
+        Cell16,  // 4-orthoplex: 16 tetrahedra
+        Cell24,  // 24 octahedra
+        Cell120, // 120 dodecahedra
+        Cell600, // 600 tetrahedra
+        Count
+    };
+
+    // 16-bit indices are enough for every regular polytope (the 120-cell has 600 vertices and 1200 edges)
+    using Index = unsigned short;
+
+public:
+    Polytope4D();
+
+    // Generates the vertices and topology of the polytope, with circumradius 1 (like a tesseract of size 1)
+    void Build(Type type);
+
+    inline Type GetType() const { return m_type; }
+    static const char* GetName(Type type);
+
+    inline unsigned int GetVertexCount() const { return static_cast<unsigned int>(m_vertices.size()); }
+    inline unsigned int GetEdgeCount() const { return static_cast<unsigned int>(m_edges.size() / 2); }
+    inline unsigned int GetFaceCount() const { return m_faceSize ? static_cast<unsigned int>(m_faces.size() / m_faceSize) : 0; }
+    inline unsigned int GetCellCount() const { return m_cellSize ? static_cast<unsigned int>(m_cells.size() / m_cellSize) : 0; }
+
+    // Number of vertices in each face
+    inline unsigned int GetFaceSize() const { return m_faceSize; }
+    // Number of faces in each cell
+    inline unsigned int GetCellSize() const { return m_cellSize; }
+    // Number of vertices in each cell
+    inline unsigned int GetCellVertexCount() const { return m_cellVertexCount; }
+
+    // Position of each vertex
+    inline std::span<const glm::vec4> GetVertices() const { return m_vertices; }
+    // Pairs of vertex indices
+    inline std::span<const Index> GetEdges() const { return m_edges; }
+    // GetFaceSize() vertex indices per face, in cyclic order
+    inline std::span<const Index> GetFaces() const { return m_faces; }
+    // GetCellSize() face indices per cell
+    inline std::span<const Index> GetCells() const { return m_cells; }
+    // GetCellVertexCount() vertex indices per cell, sorted
+    inline std::span<const Index> GetCellVertices() const { return m_cellVertices; }
+
+private:
+    // Adds the orbit of the seed point under coordinate permutations (all or only even ones) and sign changes,
+    // which generate the symmetry groups of the regular polytopes (or, for the 600-cell, the parts of its group we need)
+    static void AddOrbit(std::vector<glm::vec4>& points, const glm::vec4& seed, bool evenPermutationsOnly);
+
+    // Edges connect each vertex with its closest neighbours
+    void BuildEdges();
+
+    // Cells of simplicial polytopes are the groups of 4 mutually adjacent vertices
+    void BuildSimplicialCells();
+
+    // Each cell is made of the vertices that are furthest along one of the cell normals
+    void BuildCellsFromNormals(std::span<const glm::vec4> normals);
+
+    // Replaces the polytope with its dual: cell centers become vertices, and the cells around each vertex become a cell
+    void BuildDual();
+
+    // Scales the vertices so they are all at distance 1 from the center
+    void NormalizeVertices();
+
+    // Faces are the intersections of neighbour cells, then each cell gets the list of its faces
+    void BuildFaces();
+
+    // For each vertex, fills the list of cells that contain it
+    void BuildVertexCells();
+
+    bool AreAdjacent(Index vertex0, Index vertex1) const;
+
+private:
+    Type m_type;
+
+    unsigned int m_faceSize;
+    unsigned int m_cellSize;
+    unsigned int m_cellVertexCount;
+
+    // Topology of the polytope
+    std::vector<glm::vec4> m_vertices;
+    std::vector<Index> m_edges;
+    std::vector<Index> m_faces;
+    std::vector<Index> m_cells;
+    std::vector<Index> m_cellVertices;
+
+    // Adjacency lists, as offsets into a flat array of neighbour vertices
+    std::vector<unsigned int> m_adjacencyOffsets;
+    std::vector<Index> m_adjacency;
+
+    // Cells containing each vertex, as offsets into a flat array of cell indices
+    std::vector<unsigned int> m_vertexCellOffsets;
+    std::vector<Index> m_vertexCells;
+
+    // Scratch buffers reused between builds
+    std::vector<glm::vec4> m_scratchPoints;
+    std::vector<unsigned int> m_scratchIndices;
+    std::vector<unsigned int> m_scratchCounts;
+};
@@ -0,0 +1,201 @@
+#include "Rotor4D.h"
+
+#include <cassert>
+#include <cmath>
+
+// The bivectors of R4 split into self-dual (B == B*) and anti-self-dual (B == -B*) parts, which commute and each behave
+// like the imaginary part of a quaternion. They are stored here with 3 coordinates each, in the planes xy, xz and xw
+// (the other 3 planes are given by the duality). Exp, Log and Slerp work on the two parts independently
+struct Rotor4DHalves
+{
+    glm::vec3 selfDual;
+    glm::vec3 antiSelfDual;
+};
+
+static Rotor4DHalves SplitBivector(const Bivector4D& bivector)
+{
+    Rotor4DHalves halves;
+    halves.selfDual = 0.5f * glm::vec3(bivector.GetXY() - bivector.GetZW(), bivector.GetXZ() + bivector.GetYW(), bivector.GetXW() - bivector.GetYZ());
+    halves.antiSelfDual = 0.5f * glm::vec3(bivector.GetXY() + bivector.GetZW(), bivector.GetXZ() - bivector.GetYW(), bivector.GetXW() + bivector.GetYZ());
+    return halves;
+}
+
+static Bivector4D JoinBivector(const glm::vec3& selfDual, const glm::vec3& antiSelfDual)
+{
+    return Bivector4D(
+        selfDual.x + antiSelfDual.x,  // xy
+        selfDual.y + antiSelfDual.y,  // xz
+        selfDual.z + antiSelfDual.z,  // xw
+        -selfDual.z + antiSelfDual.z, // yz
+        selfDual.y - antiSelfDual.y,  // yw
+        -selfDual.x + antiSelfDual.x  // zw
+    );
+}
+
+// sin(x) / x, without the division by 0
+static float Sinc(float x)
+{
+    return std::abs(x) > 1e-4f ? std::sin(x) / x : 1.0f - x * x / 6.0f;
+}
+
+Rotor4D::Rotor4D() : m_scalar(1.0f), m_bivector(), m_pseudoscalar(0.0f)
+{
+}
+
+Rotor4D::Rotor4D(float scalar, const Bivector4D& bivector, float pseudoscalar)
+    : m_scalar(scalar), m_bivector(bivector), m_pseudoscalar(pseudoscalar)
+{
+}
+
+Rotor4D Rotor4D::FromAngles(const Bivector4D& angles)
+{
+    return Exp(angles * -0.5f);
+}
+
+Rotor4D Rotor4D::Exp(const Bivector4D& bivector)
+{
+    // Each half squares to -angle^2 (in its own subalgebra), so its exponential is cos(angle) + sin(angle) * half / angle
+    Rotor4DHalves halves = SplitBivector(bivector);
+    float selfDualAngle = 2.0f * glm::length(halves.selfDual);
+    float antiSelfDualAngle = 2.0f * glm::length(halves.antiSelfDual);
+
+    float selfDualCos = std::cos(selfDualAngle);
+    float antiSelfDualCos = std::cos(antiSelfDualAngle);
+
+    Bivector4D result = JoinBivector(halves.selfDual * Sinc(selfDualAngle), halves.antiSelfDual * Sinc(antiSelfDualAngle));
+    return Rotor4D(0.5f * (selfDualCos + antiSelfDualCos), result, 0.5f * (selfDualCos - antiSelfDualCos));
+}
+
+Bivector4D Rotor4D::Log() const
+{
+    Rotor4DHalves halves = SplitBivector(m_bivector);
+
+    auto logHalf = [](const glm::vec3& half, float cos)
+    {
+        float sinLength = glm::length(half);
+        float angle = std::atan2(2.0f * sinLength, cos);
+        return sinLength > 1e-6f ? half * (0.5f * angle / sinLength) : half;
+    };
+
+    return JoinBivector(logHalf(halves.selfDual, m_scalar + m_pseudoscalar), logHalf(halves.antiSelfDual, m_scalar - m_pseudoscalar));
+}
+
+Rotor4D Rotor4D::operator*(const Rotor4D& other) const
+{
+    const float as = m_scalar, ap = m_pseudoscalar;
+    const float axy = m_bivector.GetXY(), axz = m_bivector.GetXZ(), axw = m_bivector.GetXW();
+    const float ayz = m_bivector.GetYZ(), ayw = m_bivector.GetYW(), azw = m_bivector.GetZW();
+    const float bs = other.m_scalar, bp = other.m_pseudoscalar;
+    const float bxy = other.m_bivector.GetXY(), bxz = other.m_bivector.GetXZ(), bxw = other.m_bivector.GetXW();
+    const float byz = other.m_bivector.GetYZ(), byw = other.m_bivector.GetYW(), bzw = other.m_bivector.GetZW();
+
+    // Geometric product of the two even multivectors
+    float scalar = as * bs - axy * bxy - axz * bxz - axw * bxw - ayz * byz - ayw * byw - azw * bzw + ap * bp;
+    Bivector4D bivector(
+        as * bxy + axy * bs - axz * byz + ayz * bxz - axw * byw + ayw * bxw - azw * bp - ap * bzw,
+        as * bxz + axz * bs + axy * byz - ayz * bxy - axw * bzw + azw * bxw + ayw * bp + ap * byw,
+        as * bxw + axw * bs + axy * byw - ayw * bxy + axz * bzw - azw * bxz - ayz * bp - ap * byz,
+        as * byz + ayz * bs - axy * bxz + axz * bxy - ayw * bzw + azw * byw - axw * bp - ap * bxw,
+        as * byw + ayw * bs + axw * bxy - axy * bxw + ayz * bzw - azw * byz + axz * bp + ap * bxz,
+        as * bzw + azw * bs + axw * bxz - axz * bxw + ayw * byz - ayz * byw - axy * bp - ap * bxy
+    );
+    float pseudoscalar = as * bp + ap * bs + axy * bzw + azw * bxy - axz * byw - ayw * bxz + axw * byz + ayz * bxw;
+
+    return Rotor4D(scalar, bivector, pseudoscalar);
+}
+
+Rotor4D Rotor4D::GetReverse() const
+{
+    return Rotor4D(m_scalar, -m_bivector, m_pseudoscalar);
+}
+
+Rotor4D Rotor4D::GetNormalized() const
+{
+    // R ~R = a + b xyzw, and the pseudoscalar squares to 1, so its inverse square root is
+    // ((1/sqrt(a+b) + 1/sqrt(a-b)) + (1/sqrt(a+b) - 1/sqrt(a-b)) xyzw) / 2, which commutes with R
+    float a = m_scalar * m_scalar + m_pseudoscalar * m_pseudoscalar
+        + m_bivector.GetXY() * m_bivector.GetXY() + m_bivector.GetXZ() * m_bivector.GetXZ() + m_bivector.GetXW() * m_bivector.GetXW()
+        + m_bivector.GetYZ() * m_bivector.GetYZ() + m_bivector.GetYW() * m_bivector.GetYW() + m_bivector.GetZW() * m_bivector.GetZW();
+    float b = 2.0f * (m_scalar * m_pseudoscalar - m_bivector.GetXY() * m_bivector.GetZW()
+        + m_bivector.GetXZ() * m_bivector.GetYW() - m_bivector.GetXW() * m_bivector.GetYZ());
+    assert(a > std::abs(b));
+
+    float selfDualFactor = 1.0f / std::sqrt(a + b);
+    float antiSelfDualFactor = 1.0f / std::sqrt(a - b);
+    float scalarFactor = 0.5f * (selfDualFactor + antiSelfDualFactor);
+    float pseudoscalarFactor = 0.5f * (selfDualFactor - antiSelfDualFactor);
+
+    return Rotor4D(
+        m_scalar * scalarFactor + m_pseudoscalar * pseudoscalarFactor,
+        m_bivector * scalarFactor + m_bivector.GetDual() * pseudoscalarFactor,
+        m_pseudoscalar * scalarFactor + m_scalar * pseudoscalarFactor);
+}
+
+Rotor4D Rotor4D::Slerp(const Rotor4D& from, const Rotor4D& to, float t)
+{
+    Rotor4D delta = from.GetReverse() * to;
+
+    // R and -R are the same rotation, take the one closer to the identity
+    if (delta.m_scalar < 0.0f)
+    {
+        delta = Rotor4D(-delta.m_scalar, -delta.m_bivector, -delta.m_pseudoscalar);
+    }
+
+    return from * Exp(delta.Log() * t);
+}
+
+// Columns of the matrix are R x ~R, R y ~R, R z ~R and R w ~R, expanded into the products of the rotor components
+static inline void Rotor4DToMatrix(float s, float xy, float xz, float xw, float yz, float yw, float zw, float p, glm::mat4& matrix)
+{
+    const float ss = s * s, pp = p * p;
+    const float xyxy = xy * xy, xzxz = xz * xz, xwxw = xw * xw, yzyz = yz * yz, ywyw = yw * yw, zwzw = zw * zw;
+
+    const float sxy = 2 * s * xy, sxz = 2 * s * xz, sxw = 2 * s * xw, syz = 2 * s * yz, syw = 2 * s * yw, szw = 2 * s * zw;
+    const float pxy = 2 * p * xy, pxz = 2 * p * xz, pxw = 2 * p * xw, pyz = 2 * p * yz, pyw = 2 * p * yw, pzw = 2 * p * zw;
+    const float xyxz = 2 * xy * xz, xyxw = 2 * xy * xw, xyyz = 2 * xy * yz, xyyw = 2 * xy * yw;
+    const float xzxw = 2 * xz * xw, xzyz = 2 * xz * yz, xzzw = 2 * xz * zw;
+    const float xwyw = 2 * xw * yw, xwzw = 2 * xw * zw;
+    const float yzyw = 2 * yz * yw, yzzw = 2 * yz * zw, ywzw = 2 * yw * zw;
+
+    matrix[0][0] = ss - pp - xyxy - xzxz - xwxw + yzyz + ywyw + zwzw;
+    matrix[0][1] = -sxy - xwyw - pzw - xzyz;
+    matrix[0][2] = -sxz - xwzw + xyyz + pyw;
+    matrix[0][3] = -sxw + xyyw - pyz + xzzw;
+
+    matrix[1][0] = sxy - xwyw + pzw - xzyz;
+    matrix[1][1] = ss - pp - xyxy + xzxz + xwxw - yzyz - ywyw + zwzw;
+    matrix[1][2] = -syz - pxw - xyxz - ywzw;
+    matrix[1][3] = -syw - xyxw + pxz + yzzw;
+
+    matrix[2][0] = sxz - xwzw + xyyz - pyw;
+    matrix[2][1] = syz + pxw - xyxz - ywzw;
+    matrix[2][2] = ss - pp + xyxy - xzxz + xwxw - yzyz + ywyw - zwzw;
+    matrix[2][3] = -szw - xzxw - pxy - yzyw;
+
+    matrix[3][0] = sxw + xyyw + pyz + xzzw;
+    matrix[3][1] = syw - xyxw - pxz + yzzw;
+    matrix[3][2] = szw - xzxw + pxy - yzyw;
+    matrix[3][3] = ss - pp + xyxy + xzxz - xwxw + yzyz - ywyw - zwzw;
+}
+
+glm::mat4 Rotor4D::ToMatrix() const
+{
+    glm::mat4 matrix;
+    Rotor4DToMatrix(m_scalar, m_bivector.GetXY(), m_bivector.GetXZ(), m_bivector.GetXW(),
+        m_bivector.GetYZ(), m_bivector.GetYW(), m_bivector.GetZW(), m_pseudoscalar, matrix);
+    return matrix;
+}
+
+void Rotor4D::ToMatrices(std::span<const Rotor4D> rotors, std::span<glm::mat4> matrices)
+{
+    assert(rotors.size() == matrices.size());
+
+    // The conversion has no branches and each rotor is independent, so the compiler can vectorize this loop
+    const size_t count = rotors.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Rotor4D& rotor = rotors[i];
+        Rotor4DToMatrix(rotor.m_scalar, rotor.m_bivector.GetXY(), rotor.m_bivector.GetXZ(), rotor.m_bivector.GetXW(),
+            rotor.m_bivector.GetYZ(), rotor.m_bivector.GetYW(), rotor.m_bivector.GetZW(), rotor.m_pseudoscalar, matrices[i]);
+    }
+}
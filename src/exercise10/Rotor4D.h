@@ -0,0 +1,84 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <span>
+
+// Bivector in 4D: one component for each of the 6 planes of rotation
+// Used for angular velocities and for the logarithm of a rotor
+class Bivector4D
+{
+public:
+    Bivector4D() : Bivector4D(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f) {}
+    Bivector4D(float xy, float xz, float xw, float yz, float yw, float zw)
+        : m_xy(xy), m_xz(xz), m_xw(xw), m_yz(yz), m_yw(yw), m_zw(zw) {}
+
+    inline float GetXY() const { return m_xy; }
+    inline float GetXZ() const { return m_xz; }
+    inline float GetXW() const { return m_xw; }
+    inline float GetYZ() const { return m_yz; }
+    inline float GetYW() const { return m_yw; }
+    inline float GetZW() const { return m_zw; }
+
+    // Product with the pseudoscalar xyzw: each plane is replaced by its orthogonal plane
+    inline Bivector4D GetDual() const { return Bivector4D(-m_zw, m_yw, -m_yz, -m_xw, m_xz, -m_xy); }
+
+    inline Bivector4D operator+(const Bivector4D& other) const
+    {
+        return Bivector4D(m_xy + other.m_xy, m_xz + other.m_xz, m_xw + other.m_xw, m_yz + other.m_yz, m_yw + other.m_yw, m_zw + other.m_zw);
+    }
+    inline Bivector4D operator-() const { return Bivector4D(-m_xy, -m_xz, -m_xw, -m_yz, -m_yw, -m_zw); }
+    inline Bivector4D operator*(float factor) const
+    {
+        return Bivector4D(m_xy * factor, m_xz * factor, m_xw * factor, m_yz * factor, m_yw * factor, m_zw * factor);
+    }
+
+private:
+    float m_xy, m_xz, m_xw, m_yz, m_yw, m_zw;
+};
+
+// Rotation in 4D, stored as an element of the even subalgebra of the geometric algebra of R4:
+// a scalar, a bivector and a pseudoscalar (xyzw), 8 floats in total
+// A vector is rotated with R v ~R. Unlike 3D, the pseudoscalar part is needed for double rotations (in 2 planes at once)
+// Composing rotors is cheaper than composing matrices, and renormalizing them is enough to remove the accumulated error
+class Rotor4D
+{
+public:
+    // Identity rotation
+    Rotor4D();
+    Rotor4D(float scalar, const Bivector4D& bivector, float pseudoscalar);
+
+    // Rotation by the angle in each plane of the bivector, all at the same time, in the direction from the first axis
+    // of the plane towards the second one (a positive xy angle rotates x towards y)
+    static Rotor4D FromAngles(const Bivector4D& angles);
+
+    // Exponential of a bivector, and its inverse for normalized rotors. FromAngles(angles) == Exp(angles * -0.5f)
+    static Rotor4D Exp(const Bivector4D& bivector);
+    Bivector4D Log() const;
+
+    inline float GetScalar() const { return m_scalar; }
+    inline const Bivector4D& GetBivector() const { return m_bivector; }
+    inline float GetPseudoscalar() const { return m_pseudoscalar; }
+
+    // Composition, like with matrices: (a * b) applies b first and then a
+    Rotor4D operator*(const Rotor4D& other) const;
+
+    // Reverse (the inverse rotation, for normalized rotors)
+    Rotor4D GetReverse() const;
+
+    // Closest valid rotation, with R ~R == 1
+    Rotor4D GetNormalized() const;
+
+    // Interpolates along the shortest path between two normalized rotors, with constant angular velocity
+    static Rotor4D Slerp(const Rotor4D& from, const Rotor4D& to, float t);
+
+    // Rotation matrix of a normalized rotor
+    glm::mat4 ToMatrix() const;
+
+    // Converts many normalized rotors at once. Both spans must have the same size
+    static void ToMatrices(std::span<const Rotor4D> rotors, std::span<glm::mat4> matrices);
+
+private:
+    float m_scalar;
+    Bivector4D m_bivector;
+    float m_pseudoscalar;
+};
@@ -0,0 +1,215 @@
+#include "Slicer4D.h"
+
+#include "WorkerPool.h"
+#include <ituGL/utils/Profiler.h>
+#include <algorithm>
+#include <cassert>
+
+// Smallest number of tetrahedra worth sending to another thread
+static const size_t s_minTetrahedraPerThread = 1024;
+
+Slicer4D::Slicer4D() : m_distance(0.0f), m_maxThreadCount(0), m_outputCount(0), m_vertexCount(0)
+{
+    SetHyperplane(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), 0.0f);
+}
+
+void Slicer4D::SetHyperplane(const glm::vec4& normal, float distance)
+{
+    assert(glm::length(normal) > 0.0f);
+    m_normal = glm::normalize(normal);
+    m_distance = distance;
+
+    // Gram-Schmidt on the axes, skipping the one closest to the normal. A w-slice keeps x, y and z unchanged
+    int skippedAxis = 0;
+    for (int axis = 1; axis < 4; ++axis)
+    {
+        skippedAxis = std::abs(m_normal[axis]) > std::abs(m_normal[skippedAxis]) ? axis : skippedAxis;
+    }
+
+    int basisCount = 0;
+    for (int axis = 0; axis < 4; ++axis)
+    {
+        if (axis == skippedAxis)
+            continue;
+
+        glm::vec4 vector(0.0f);
+        vector[axis] = 1.0f;
+        vector -= glm::dot(vector, m_normal) * m_normal;
+        for (int i = 0; i < basisCount; ++i)
+        {
+            vector -= glm::dot(vector, m_basis[i]) * m_basis[i];
+        }
+        m_basis[basisCount++] = glm::normalize(vector);
+    }
+
+    // Keep the basis right-handed, so the cross-section is not mirrored
+    if (glm::determinant(glm::mat4(m_basis[0], m_basis[1], m_basis[2], m_normal)) < 0.0f)
+    {
+        m_basis[2] = -m_basis[2];
+    }
+}
+
+void Slicer4D::SetMaxThreadCount(unsigned int maxThreadCount)
+{
+    m_maxThreadCount = maxThreadCount;
+}
+
+void Slicer4D::Slice(const Vertex4DArray& vertices, const TetrahedralMesh4D& mesh, const glm::vec4& interiorPoint)
+{
+    assert(vertices.GetSize() == mesh.GetVertexCount());
+    if (mesh.GetIndexType() == Data::Type::UShort)
+    {
+        Slice(vertices, mesh.GetTetrahedra<unsigned short>(), interiorPoint);
+    }
+    else
+    {
+        Slice(vertices, mesh.GetTetrahedra<unsigned int>(), interiorPoint);
+    }
+}
+
+template<typename Index>
+void Slicer4D::Slice(const Vertex4DArray& vertices, std::span<const Index> tetrahedra, const glm::vec4& interiorPoint)
+{
+    assert(tetrahedra.size() % 4 == 0);
+
+    // Signed distances are computed once per vertex, so all the cells sharing a vertex agree on its side of the hyperplane
+    const size_t vertexCount = vertices.GetSize();
+    m_vertexDistances.resize(vertexCount);
+    const float* x = vertices.GetX();
+    const float* y = vertices.GetY();
+    const float* z = vertices.GetZ();
+    const float* w = vertices.GetW();
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        m_vertexDistances[i] = m_normal.x * x[i] + m_normal.y * y[i] + m_normal.z * z[i] + m_normal.w * w[i] - m_distance;
+    }
+
+    // Split the tetrahedra in contiguous chunks, one per thread
+    WorkerPool& workerPool = WorkerPool::GetShared();
+    const size_t tetrahedronCount = tetrahedra.size() / 4;
+    size_t threadCount = std::min(m_maxThreadCount ? m_maxThreadCount : workerPool.GetThreadCount(), workerPool.GetThreadCount());
+    threadCount = std::clamp(tetrahedronCount / s_minTetrahedraPerThread, size_t(1), threadCount);
+    const size_t chunkSize = (tetrahedronCount + threadCount - 1) / threadCount;
+
+    m_outputCount = static_cast<unsigned int>(threadCount);
+    if (m_outputs.size() < threadCount)
+    {
+        m_outputs.resize(threadCount);
+    }
+    m_outputOffsets.resize(threadCount);
+
+    auto sliceChunk = [&](size_t chunk)
+    {
+        ITUGL_PROFILE_SCOPE("SliceChunk");
+        size_t first = std::min(chunk * chunkSize, tetrahedronCount);
+        size_t last = std::min(first + chunkSize, tetrahedronCount);
+        m_outputs[chunk].clear();
+        SliceRange(vertices, tetrahedra.subspan(first * 4, (last - first) * 4), interiorPoint, m_outputs[chunk]);
+    };
+
+    // Each chunk only writes to its own output, so no synchronization is needed until all of them are done
+    workerPool.Run(threadCount, sliceChunk);
+
+    // Prefix sum of the output sizes gives where each output goes in the final mesh
+    m_vertexCount = 0;
+    for (size_t chunk = 0; chunk < threadCount; ++chunk)
+    {
+        m_outputOffsets[chunk] = m_vertexCount;
+        m_vertexCount += static_cast<unsigned int>(m_outputs[chunk].size());
+    }
+}
+
+glm::vec3 Slicer4D::IntersectEdge(const Vertex4DArray& vertices, unsigned int vertex0, unsigned int vertex1) const
+{
+    if (vertex1 < vertex0)
+    {
+        std::swap(vertex0, vertex1);
+    }
+
+    float distance0 = m_vertexDistances[vertex0];
+    float distance1 = m_vertexDistances[vertex1];
+    float t = distance0 / (distance0 - distance1);
+
+    glm::vec4 position0 = vertices.Get(vertex0);
+    glm::vec4 position = position0 + t * (vertices.Get(vertex1) - position0);
+    return glm::vec3(glm::dot(position, m_basis[0]), glm::dot(position, m_basis[1]), glm::dot(position, m_basis[2]));
+}
+
+template<typename Index>
+void Slicer4D::SliceRange(const Vertex4DArray& vertices, std::span<const Index> tetrahedra, const glm::vec4& interiorPoint,
+    std::vector<Vertex>& output) const
+{
+    for (size_t tetrahedron = 0; tetrahedron < tetrahedra.size(); tetrahedron += 4)
+    {
+        const Index* indices = &tetrahedra[tetrahedron];
+
+        // Vertices on the positive side first, so each case only needs one layout
+        unsigned int positive[4], negative[4];
+        unsigned int positiveCount = 0, negativeCount = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (m_vertexDistances[indices[i]] > 0.0f)
+                positive[positiveCount++] = indices[i];
+            else
+                negative[negativeCount++] = indices[i];
+        }
+
+        if (positiveCount == 0 || negativeCount == 0)
+            continue;
+
+        // Normal of the cell in 4D (generalized cross product of its edges), pointing away from the interior
+        glm::vec4 origin = vertices.Get(indices[0]);
+        glm::vec4 u = vertices.Get(indices[1]) - origin;
+        glm::vec4 v = vertices.Get(indices[2]) - origin;
+        glm::vec4 w = vertices.Get(indices[3]) - origin;
+        glm::vec4 cellNormal(
+            glm::determinant(glm::mat3(u.y, v.y, w.y, u.z, v.z, w.z, u.w, v.w, w.w)),
+            -glm::determinant(glm::mat3(u.x, v.x, w.x, u.z, v.z, w.z, u.w, v.w, w.w)),
+            glm::determinant(glm::mat3(u.x, v.x, w.x, u.y, v.y, w.y, u.w, v.w, w.w)),
+            -glm::determinant(glm::mat3(u.x, v.x, w.x, u.y, v.y, w.y, u.z, v.z, w.z)));
+        if (glm::dot(cellNormal, origin - interiorPoint) < 0.0f)
+        {
+            cellNormal = -cellNormal;
+        }
+
+        // The normal of the cross-section is the part of the cell normal inside the hyperplane
+        glm::vec3 normal(glm::dot(cellNormal, m_basis[0]), glm::dot(cellNormal, m_basis[1]), glm::dot(cellNormal, m_basis[2]));
+        float normalLength = glm::length(normal);
+        if (normalLength == 0.0f)
+            continue;
+        normal /= normalLength;
+
+        // One vertex alone on its side gives a triangle, two on each side give a quad, in cyclic order
+        glm::vec3 points[4];
+        unsigned int pointCount = 0;
+        if (positiveCount == 1 || negativeCount == 1)
+        {
+            const unsigned int* alone = positiveCount == 1 ? positive : negative;
+            const unsigned int* others = positiveCount == 1 ? negative : positive;
+            for (int i = 0; i < 3; ++i)
+            {
+                points[pointCount++] = IntersectEdge(vertices, alone[0], others[i]);
+            }
+        }
+        else
+        {
+            points[pointCount++] = IntersectEdge(vertices, positive[0], negative[0]);
+            points[pointCount++] = IntersectEdge(vertices, positive[0], negative[1]);
+            points[pointCount++] = IntersectEdge(vertices, positive[1], negative[1]);
+            points[pointCount++] = IntersectEdge(vertices, positive[1], negative[0]);
+        }
+
+        // Counter-clockwise winding when looking against the normal
+        bool flip = glm::dot(glm::cross(points[1] - points[0], points[2] - points[0]), normal) < 0.0f;
+
+        glm::vec4 outputNormal(normal, 0.0f);
+        for (unsigned int i = 1; i + 1 < pointCount; ++i)
+        {
+            unsigned int second = flip ? i + 1 : i;
+            unsigned int third = flip ? i : i + 1;
+            output.push_back(Vertex{ glm::vec4(points[0], 0.0f), outputNormal });
+            output.push_back(Vertex{ glm::vec4(points[second], 0.0f), outputNormal });
+            output.push_back(Vertex{ glm::vec4(points[third], 0.0f), outputNormal });
+        }
+    }
+}
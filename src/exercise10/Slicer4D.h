@@ -0,0 +1,77 @@
+#pragma once
+
+#include "TetrahedralMesh4D.h"
+#include "Transform4DKernel.h"
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+// Intersects the tetrahedral cells of a 4D mesh with a hyperplane, producing the 3D triangle mesh of the cross-section
+// Work is split in chunks of tetrahedra, each one writing to its own output buffer. The buffers are not merged on the CPU:
+// GetOutputOffset gives where each one starts in the final mesh, so they can be copied straight into a vertex buffer
+class Slicer4D
+{
+public:
+    // Vertex of the cross-section. Position and normal are 3D, with w = 0
+    struct Vertex
+    {
+        glm::vec4 position;
+        glm::vec4 normal;
+    };
+
+public:
+    Slicer4D();
+
+    // Hyperplane with all the points p where dot(normal, p) == distance
+    // The cross-section is expressed in an orthonormal basis of the hyperplane. For normal (0, 0, 0, 1), that is x, y and z
+    void SetHyperplane(const glm::vec4& normal, float distance);
+    inline const glm::vec4& GetHyperplaneNormal() const { return m_normal; }
+    inline float GetHyperplaneDistance() const { return m_distance; }
+
+    // Maximum number of threads used by Slice, 0 to use all the threads of the shared WorkerPool
+    void SetMaxThreadCount(unsigned int maxThreadCount);
+
+    // Slices the tetrahedra of the mesh, using the given vertex positions (usually the mesh vertices, transformed)
+    // The mesh is expected to be the boundary of a convex object containing interiorPoint, which is used to orient
+    // the normals outwards
+    void Slice(const Vertex4DArray& vertices, const TetrahedralMesh4D& mesh, const glm::vec4& interiorPoint);
+
+    // Number of vertices in the cross-section, 3 for each triangle
+    inline unsigned int GetVertexCount() const { return m_vertexCount; }
+
+    // Output of each chunk of work, and the index of its first vertex in the cross-section
+    inline unsigned int GetOutputCount() const { return m_outputCount; }
+    inline std::span<const Vertex> GetOutput(unsigned int output) const { return m_outputs[output]; }
+    inline unsigned int GetOutputOffset(unsigned int output) const { return m_outputOffsets[output]; }
+
+private:
+    template<typename Index>
+    void Slice(const Vertex4DArray& vertices, std::span<const Index> tetrahedra, const glm::vec4& interiorPoint);
+
+    // Slices a range of tetrahedra, appending the triangles to the output
+    template<typename Index>
+    void SliceRange(const Vertex4DArray& vertices, std::span<const Index> tetrahedra, const glm::vec4& interiorPoint,
+        std::vector<Vertex>& output) const;
+
+    // Point where the edge crosses the hyperplane, in the hyperplane basis
+    // The edge is always interpolated from its lowest vertex index, so neighbour cells sharing the edge get exactly
+    // the same point and the cross-section has no cracks
+    glm::vec3 IntersectEdge(const Vertex4DArray& vertices, unsigned int vertex0, unsigned int vertex1) const;
+
+private:
+    // Hyperplane, and an orthonormal basis of it
+    glm::vec4 m_normal;
+    float m_distance;
+    glm::vec4 m_basis[3];
+
+    unsigned int m_maxThreadCount;
+
+    // Signed distance from each vertex to the hyperplane
+    std::vector<float> m_vertexDistances;
+
+    // Output buffers, kept between calls to reuse their memory
+    std::vector<std::vector<Vertex>> m_outputs;
+    std::vector<unsigned int> m_outputOffsets;
+    unsigned int m_outputCount;
+    unsigned int m_vertexCount;
+};
@@ -0,0 +1,120 @@
+#include "TetrahedralMesh4D.h"
+
+#include <ituGL/geometry/ElementBufferObject.h>
+#include <algorithm>
+
+TetrahedralMesh4D::TetrahedralMesh4D() : m_indexType(Data::Type::UShort)
+{
+}
+
+void TetrahedralMesh4D::Build(std::span<const glm::vec4> vertices, std::span<const unsigned int> tetrahedra)
+{
+    assert(tetrahedra.size() % 4 == 0);
+    m_vertices.assign(vertices.begin(), vertices.end());
+
+    // Same choice as for triangle meshes, but with at least 16 bits, so there are only 2 index types to support
+    m_indexType = ElementBufferObject::GetSmallestType(GetVertexCount());
+    if (m_indexType == Data::Type::UByte)
+    {
+        m_indexType = Data::Type::UShort;
+    }
+
+    m_indices16.clear();
+    m_indices32.clear();
+    if (m_indexType == Data::Type::UShort)
+    {
+        m_indices16.assign(tetrahedra.begin(), tetrahedra.end());
+    }
+    else
+    {
+        m_indices32.assign(tetrahedra.begin(), tetrahedra.end());
+    }
+
+    BuildNeighbours(tetrahedra);
+}
+
+void TetrahedralMesh4D::BuildFromPolytope(const Polytope4D& polytope, float size)
+{
+    m_scratchVertices.clear();
+    for (const glm::vec4& vertex : polytope.GetVertices())
+    {
+        m_scratchVertices.push_back(vertex * size);
+    }
+
+    // Cells are convex, so they are split as cones from their first vertex to the faces that do not contain it
+    // Faces are triangulated as fans from their first vertex, which is the same for the 2 cells sharing the face
+    std::span<const Polytope4D::Index> faces = polytope.GetFaces();
+    std::span<const Polytope4D::Index> cells = polytope.GetCells();
+    std::span<const Polytope4D::Index> cellVertices = polytope.GetCellVertices();
+    const unsigned int faceSize = polytope.GetFaceSize();
+    const unsigned int cellSize = polytope.GetCellSize();
+
+    m_scratchTetrahedra.clear();
+    for (unsigned int cell = 0; cell < polytope.GetCellCount(); ++cell)
+    {
+        Polytope4D::Index apex = cellVertices[cell * polytope.GetCellVertexCount()];
+        for (unsigned int cellFace = 0; cellFace < cellSize; ++cellFace)
+        {
+            std::span<const Polytope4D::Index> face = faces.subspan(cells[cell * cellSize + cellFace] * faceSize, faceSize);
+            if (std::find(face.begin(), face.end(), apex) != face.end())
+                continue;
+
+            for (unsigned int i = 1; i + 1 < faceSize; ++i)
+            {
+                m_scratchTetrahedra.insert(m_scratchTetrahedra.end(), { apex, face[0], face[i], face[i + 1] });
+            }
+        }
+    }
+
+    Build(m_scratchVertices, m_scratchTetrahedra);
+}
+
+void TetrahedralMesh4D::BuildNeighbours(std::span<const unsigned int> tetrahedra)
+{
+    // Each face gets a key with its 3 sorted vertex indices, 21 bits each, so the faces shared by 2 tetrahedra
+    // end up next to each other after sorting
+    const unsigned int tetrahedronCount = static_cast<unsigned int>(tetrahedra.size() / 4);
+    assert(GetVertexCount() < (1U << 21));
+
+    // The face is stored as tetrahedron * 4 + opposite vertex, the same position as its entry in m_neighbours
+    struct FaceKey
+    {
+        unsigned long long vertices;
+        unsigned int face;
+        bool operator<(const FaceKey& other) const { return vertices < other.vertices; }
+    };
+    std::vector<FaceKey> keys(tetrahedra.size());
+
+    for (unsigned int face = 0; face < tetrahedra.size(); ++face)
+    {
+        const unsigned int tetrahedron = face / 4;
+        const unsigned int opposite = face % 4;
+        unsigned int faceVertices[3];
+        for (unsigned int i = 0, j = 0; i < 4; ++i)
+        {
+            if (i != opposite)
+            {
+                faceVertices[j++] = tetrahedra[tetrahedron * 4 + i];
+            }
+        }
+        std::sort(faceVertices, faceVertices + 3);
+        keys[face].vertices = (static_cast<unsigned long long>(faceVertices[0]) << 42)
+            | (static_cast<unsigned long long>(faceVertices[1]) << 21) | faceVertices[2];
+        keys[face].face = face;
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    m_neighbours.assign(tetrahedronCount * 4, NoNeighbour);
+    for (size_t i = 0; i + 1 < keys.size(); ++i)
+    {
+        if (keys[i].vertices == keys[i + 1].vertices)
+        {
+            // In a valid mesh a face is shared by 2 tetrahedra at most
+            assert(i + 2 >= keys.size() || keys[i + 2].vertices != keys[i].vertices);
+            m_neighbours[keys[i].face] = keys[i + 1].face / 4;
+            m_neighbours[keys[i + 1].face] = keys[i].face / 4;
+            ++i;
+        }
+    }
+}
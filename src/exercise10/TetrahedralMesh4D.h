@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Hypercube.h"
+#include "Polytope4D.h"
+#include <ituGL/core/Data.h>
+#include <glm/glm.hpp>
+#include <cassert>
+#include <span>
+#include <vector>
+
+// 4D mesh stored as the tetrahedra that make up its boundary cells, with the neighbours of each tetrahedron
+// Indices are stored in a single flat array, 4 per tetrahedron, using 16-bit indices when the vertex count allows it
+// and 32-bit otherwise. Tetrahedra of the same cell are contiguous, so walking the mesh in order stays local in memory
+// The converters split the cells so the shared faces are split the same way on both sides, which keeps the mesh closed
+class TetrahedralMesh4D
+{
+public:
+    // Neighbour index of a face on the border of an open mesh
+    static constexpr unsigned int NoNeighbour = ~0U;
+
+public:
+    TetrahedralMesh4D();
+
+    // Builds the mesh from vertices and tetrahedra (4 vertex indices each), and computes the neighbours
+    void Build(std::span<const glm::vec4> vertices, std::span<const unsigned int> tetrahedra);
+
+    // Splits each cubic cell of a hypercube subdivided S times in 6 tetrahedra (Kuhn triangulation)
+    template<int S>
+    void BuildFromHypercube(float size);
+
+    // Splits each cell of a regular polytope in cones from one of its vertices to the triangulated faces
+    void BuildFromPolytope(const Polytope4D& polytope, float size);
+
+    inline unsigned int GetVertexCount() const { return static_cast<unsigned int>(m_vertices.size()); }
+    inline unsigned int GetTetrahedronCount() const { return static_cast<unsigned int>(m_neighbours.size() / 4); }
+
+    inline std::span<const glm::vec4> GetVertices() const { return m_vertices; }
+
+    // Type of the indices: UShort or UInt
+    inline Data::Type GetIndexType() const { return m_indexType; }
+
+    // 4 vertex indices per tetrahedron. Index must match GetIndexType()
+    template<typename Index>
+    std::span<const Index> GetTetrahedra() const;
+
+    // 4 tetrahedron indices per tetrahedron: neighbour i shares the face opposite to vertex i, or NoNeighbour
+    inline std::span<const unsigned int> GetNeighbours() const { return m_neighbours; }
+
+private:
+    // Fills m_neighbours by sorting the keys of all the faces, so the 2 tetrahedra sharing a face end up together
+    void BuildNeighbours(std::span<const unsigned int> tetrahedra);
+
+private:
+    std::vector<glm::vec4> m_vertices;
+
+    Data::Type m_indexType;
+    std::vector<unsigned short> m_indices16;
+    std::vector<unsigned int> m_indices32;
+
+    std::vector<unsigned int> m_neighbours;
+
+    // Scratch buffers reused between builds
+    std::vector<glm::vec4> m_scratchVertices;
+    std::vector<unsigned int> m_scratchTetrahedra;
+};
+
+template<typename Index>
+std::span<const Index> TetrahedralMesh4D::GetTetrahedra() const
+{
+    assert(Data::GetType<Index>() == m_indexType);
+    if constexpr (sizeof(Index) == sizeof(unsigned short))
+    {
+        return m_indices16;
+    }
+    else
+    {
+        return m_indices32;
+    }
+}
+
+template<int S>
+void TetrahedralMesh4D::BuildFromHypercube(float size)
+{
+    using HypercubeType = Hypercube<4, S>;
+
+    m_scratchVertices.clear();
+    for (const typename HypercubeType::Coordinates& coordinates : HypercubeType::Vertices)
+    {
+        m_scratchVertices.emplace_back(
+            HypercubeType::GetCoordinate(coordinates[0], size),
+            HypercubeType::GetCoordinate(coordinates[1], size),
+            HypercubeType::GetCoordinate(coordinates[2], size),
+            HypercubeType::GetCoordinate(coordinates[3], size));
+    }
+
+    // Each tetrahedron goes from the lowest to the highest corner of the cube, one axis at a time, in every axis order
+    // Cells store their corners in binary order of the axes, so the diagonal of every shared face is the same in both cells
+    static const unsigned int axisOrders[6][3] = { {1, 2, 4}, {1, 4, 2}, {2, 1, 4}, {2, 4, 1}, {4, 1, 2}, {4, 2, 1} };
+
+    m_scratchTetrahedra.clear();
+    m_scratchTetrahedra.reserve(HypercubeType::CellCount * 6 * 4);
+    for (const std::array<typename HypercubeType::Index, 8>& cell : HypercubeType::Cells)
+    {
+        for (const unsigned int* axisOrder : axisOrders)
+        {
+            m_scratchTetrahedra.insert(m_scratchTetrahedra.end(), {
+                cell[0], cell[axisOrder[0]], cell[axisOrder[0] | axisOrder[1]], cell[7] });
+        }
+    }
+
+    Build(m_scratchVertices, m_scratchTetrahedra);
+}
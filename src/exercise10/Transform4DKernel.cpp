@@ -0,0 +1,241 @@
+#include "Transform4DKernel.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define TRANSFORM4D_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRANSFORM4D_SSE
+#endif
+
+Vertex4DArray::Vertex4DArray()
+{
+}
+
+Vertex4DArray::Vertex4DArray(std::span<const glm::vec4> positions)
+{
+    Resize(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        Set(i, positions[i]);
+    }
+}
+
+void Vertex4DArray::Resize(size_t size)
+{
+    m_x.resize(size);
+    m_y.resize(size);
+    m_z.resize(size);
+    m_w.resize(size);
+}
+
+glm::vec4 Vertex4DArray::Get(size_t index) const
+{
+    return glm::vec4(m_x[index], m_y[index], m_z[index], m_w[index]);
+}
+
+void Vertex4DArray::Set(size_t index, const glm::vec4& position)
+{
+    m_x[index] = position.x;
+    m_y[index] = position.y;
+    m_z[index] = position.z;
+    m_w[index] = position.w;
+}
+
+// Wrappers with the same interface for a single float and for SIMD registers, so the kernel is only written once
+struct Transform4DScalarLane
+{
+    using Register = float;
+    static const size_t Width = 1;
+    static inline Register Load(const float* data) { return *data; }
+    static inline void Store(float* data, Register value) { *data = value; }
+    static inline Register Broadcast(float value) { return value; }
+    static inline Register Add(Register a, Register b) { return a + b; }
+    static inline Register Mul(Register a, Register b) { return a * b; }
+};
+
+#if defined(TRANSFORM4D_AVX)
+struct Transform4DAvxLane
+{
+    using Register = __m256;
+    static const size_t Width = 8;
+    static inline Register Load(const float* data) { return _mm256_loadu_ps(data); }
+    static inline void Store(float* data, Register value) { _mm256_storeu_ps(data, value); }
+    static inline Register Broadcast(float value) { return _mm256_set1_ps(value); }
+    static inline Register Add(Register a, Register b) { return _mm256_add_ps(a, b); }
+    static inline Register Mul(Register a, Register b) { return _mm256_mul_ps(a, b); }
+};
+#elif defined(TRANSFORM4D_SSE)
+struct Transform4DSseLane
+{
+    using Register = __m128;
+    static const size_t Width = 4;
+    static inline Register Load(const float* data) { return _mm_loadu_ps(data); }
+    static inline void Store(float* data, Register value) { _mm_storeu_ps(data, value); }
+    static inline Register Broadcast(float value) { return _mm_set1_ps(value); }
+    static inline Register Add(Register a, Register b) { return _mm_add_ps(a, b); }
+    static inline Register Mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+};
+#endif
+
+// Transform parameters broadcast to full registers, and the transforms for one register of vertices
+template<typename Lane>
+struct Transform4DLaneKernel
+{
+    using Register = typename Lane::Register;
+
+    Transform4DLaneKernel(const glm::mat4& rotation, const glm::vec4& translation, const glm::vec4& scale)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                m_rotation[i][j] = Lane::Broadcast(rotation[i][j]);
+            }
+            m_translation[i] = Lane::Broadcast(translation[i]);
+            m_scale[i] = Lane::Broadcast(scale[i]);
+        }
+    }
+
+    // Column by column, accumulating from left to right, like Rotate4D in shader.vert
+    inline void Rotate(const Register vector[4], Register result[4]) const
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            Register value = Lane::Mul(m_rotation[0][row], vector[0]);
+            value = Lane::Add(value, Lane::Mul(m_rotation[1][row], vector[1]));
+            value = Lane::Add(value, Lane::Mul(m_rotation[2][row], vector[2]));
+            value = Lane::Add(value, Lane::Mul(m_rotation[3][row], vector[3]));
+            result[row] = value;
+        }
+    }
+
+    inline void TransformWorld(const Register position[4], Register result[4]) const
+    {
+        Register scaled[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            scaled[i] = Lane::Mul(m_scale[i], position[i]);
+        }
+
+        Rotate(scaled, result);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            result[i] = Lane::Add(m_translation[i], result[i]);
+        }
+    }
+
+    inline void TransformProjected(const Register position[4], Register result[4]) const
+    {
+        // Only the w coordinate of the real position is needed, but it has to be computed exactly like in TransformWorld
+        Register real[4];
+        TransformWorld(position, real);
+        const Register realW = real[3];
+
+        Register weighted[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            weighted[i] = Lane::Mul(realW, position[i]);
+        }
+
+        Rotate(weighted, result);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            result[i] = Lane::Add(m_translation[i], Lane::Mul(m_scale[i], result[i]));
+        }
+        result[3] = realW;
+    }
+
+    // Transforms the vertices starting at begin, as long as there are enough left to fill a register
+    // Returns the index of the first vertex that was not transformed
+    template<bool Projected>
+    size_t Transform(const Vertex4DArray& input, Vertex4DArray& output, size_t begin) const
+    {
+        const size_t size = input.GetSize();
+        size_t i = begin;
+        for (; i + Lane::Width <= size; i += Lane::Width)
+        {
+            Register position[4] = {
+                Lane::Load(input.GetX() + i), Lane::Load(input.GetY() + i), Lane::Load(input.GetZ() + i), Lane::Load(input.GetW() + i)
+            };
+
+            Register result[4];
+            if constexpr (Projected)
+            {
+                TransformProjected(position, result);
+            }
+            else
+            {
+                TransformWorld(position, result);
+            }
+
+            Lane::Store(output.GetX() + i, result[0]);
+            Lane::Store(output.GetY() + i, result[1]);
+            Lane::Store(output.GetZ() + i, result[2]);
+            Lane::Store(output.GetW() + i, result[3]);
+        }
+        return i;
+    }
+
+    Register m_rotation[4][4];
+    Register m_translation[4];
+    Register m_scale[4];
+};
+
+// Runs the widest available kernel, and the scalar one for the remaining vertices
+template<bool Projected>
+static void TransformBatch(const glm::mat4& rotation, const glm::vec4& translation, const glm::vec4& scale,
+    const Vertex4DArray& input, Vertex4DArray& output)
+{
+    output.Resize(input.GetSize());
+
+    size_t i = 0;
+#if defined(TRANSFORM4D_AVX)
+    i = Transform4DLaneKernel<Transform4DAvxLane>(rotation, translation, scale).Transform<Projected>(input, output, i);
+#elif defined(TRANSFORM4D_SSE)
+    i = Transform4DLaneKernel<Transform4DSseLane>(rotation, translation, scale).Transform<Projected>(input, output, i);
+#endif
+    Transform4DLaneKernel<Transform4DScalarLane>(rotation, translation, scale).Transform<Projected>(input, output, i);
+}
+
+Transform4DKernel::Transform4DKernel(const glm::mat4& rotation, const glm::vec4& translation, const glm::vec4& scale)
+    : m_rotation(rotation), m_translation(translation), m_scale(scale)
+{
+}
+
+void Transform4DKernel::TransformWorld(const Vertex4DArray& input, Vertex4DArray& output) const
+{
+    TransformBatch<false>(m_rotation, m_translation, m_scale, input, output);
+}
+
+glm::vec4 Transform4DKernel::TransformWorld(const glm::vec4& position) const
+{
+    float result[4];
+    Transform4DLaneKernel<Transform4DScalarLane>(m_rotation, m_translation, m_scale).TransformWorld(&position[0], result);
+    return glm::vec4(result[0], result[1], result[2], result[3]);
+}
+
+void Transform4DKernel::TransformProjected(const Vertex4DArray& input, Vertex4DArray& output) const
+{
+    TransformBatch<true>(m_rotation, m_translation, m_scale, input, output);
+}
+
+glm::vec4 Transform4DKernel::TransformProjected(const glm::vec4& position) const
+{
+    float result[4];
+    Transform4DLaneKernel<Transform4DScalarLane>(m_rotation, m_translation, m_scale).TransformProjected(&position[0], result);
+    return glm::vec4(result[0], result[1], result[2], result[3]);
+}
+
+const char* Transform4DKernel::GetInstructionSet()
+{
+#if defined(TRANSFORM4D_AVX)
+    return "AVX";
+#elif defined(TRANSFORM4D_SSE)
+    return "SSE";
+#else
+    return "Scalar";
+#endif
+}
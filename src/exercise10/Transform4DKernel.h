@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+// Structure-of-arrays storage for 4D positions: one contiguous array per coordinate,
+// so the transform kernels can load several consecutive vertices in a single SIMD register
+class Vertex4DArray
+{
+public:
+    Vertex4DArray();
+    explicit Vertex4DArray(std::span<const glm::vec4> positions);
+
+    inline size_t GetSize() const { return m_x.size(); }
+    void Resize(size_t size);
+
+    // Access to a single vertex, converting from / to array-of-structures
+    glm::vec4 Get(size_t index) const;
+    void Set(size_t index, const glm::vec4& position);
+
+    // Direct access to the arrays of each coordinate
+    inline const float* GetX() const { return m_x.data(); }
+    inline const float* GetY() const { return m_y.data(); }
+    inline const float* GetZ() const { return m_z.data(); }
+    inline const float* GetW() const { return m_w.data(); }
+    inline float* GetX() { return m_x.data(); }
+    inline float* GetY() { return m_y.data(); }
+    inline float* GetZ() { return m_z.data(); }
+    inline float* GetW() { return m_w.data(); }
+
+private:
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_w;
+};
+
+// Applies the 4D transform of shader.vert on the CPU, to whole arrays of vertices at once
+// The batched functions use AVX or SSE when the compiler targets them, and a scalar loop otherwise
+// All paths (and shader.vert) do the same IEEE multiplications and additions in the same order, with no divisions
+// or fused multiply-adds, so they produce exactly the same results
+class Transform4DKernel
+{
+public:
+    Transform4DKernel(const glm::mat4& rotation, const glm::vec4& translation, const glm::vec4& scale);
+
+    // Real 4D position of the vertices: Translation + (Rotation * (Scale * Position))
+    void TransformWorld(const Vertex4DArray& input, Vertex4DArray& output) const;
+    glm::vec4 TransformWorld(const glm::vec4& position) const;
+
+    // Projected 3D position of the vertices, using their real w as a scale factor:
+    // Translation + Scale * (Rotation * (RealW * Position))
+    // The w coordinate of the output keeps the real w, so vertices crossing w = 0 can be detected
+    void TransformProjected(const Vertex4DArray& input, Vertex4DArray& output) const;
+    glm::vec4 TransformProjected(const glm::vec4& position) const;
+
+    // Name of the instruction set used by the batched functions
+    static const char* GetInstructionSet();
+
+private:
+    glm::mat4 m_rotation;
+    glm::vec4 m_translation;
+    glm::vec4 m_scale;
+};
@@ -0,0 +1,213 @@
+#include "Transform4DPool.h"
+
+#include "WorkerPool.h"
+#include <ituGL/utils/Profiler.h>
+#include <algorithm>
+#include <cassert>
+
+// Smallest number of objects worth sending to another thread
+static const size_t s_minObjectsPerThread = 4096;
+
+// Splits [0, count) in contiguous chunks and calls function(first, last) for each one, in parallel. Returns the sum of the results
+template<typename Function>
+static unsigned int ParallelSum(size_t count, unsigned int maxThreadCount, Function function)
+{
+    WorkerPool& workerPool = WorkerPool::GetShared();
+    size_t threadCount = std::min(maxThreadCount ? maxThreadCount : workerPool.GetThreadCount(), workerPool.GetThreadCount());
+    threadCount = std::clamp(count / s_minObjectsPerThread, size_t(1), threadCount);
+    const size_t chunkSize = (count + threadCount - 1) / threadCount;
+
+    // Each chunk writes its own result, summed when all of them are done
+    std::vector<unsigned int> results(threadCount);
+    workerPool.Run(threadCount, [&](size_t chunk)
+        {
+            ITUGL_PROFILE_SCOPE("Transform4DPoolChunk");
+            size_t first = std::min(chunk * chunkSize, count);
+            size_t last = std::min(first + chunkSize, count);
+            results[chunk] = function(first, last);
+        });
+
+    unsigned int sum = 0;
+    for (unsigned int result : results)
+    {
+        sum += result;
+    }
+    return sum;
+}
+
+Transform4DPool::Transform4DPool() : m_stepTimeStep(0.0f), m_levelsDirty(false), m_maxThreadCount(0), m_changedCount(0)
+{
+}
+
+unsigned int Transform4DPool::Add(unsigned int parent)
+{
+    unsigned int object = GetCount();
+    assert(parent == NoParent || parent < object);
+
+    m_parents.push_back(parent);
+    m_depths.push_back(parent == NoParent ? 0 : m_depths[parent] + 1);
+
+    m_translations.push_back(glm::vec4(0.0f));
+    m_scales.push_back(glm::vec4(1.0f));
+    m_rotations.push_back(Rotor4D());
+    m_angularVelocities.push_back(Bivector4D());
+    m_stepRotations.push_back(Rotor4D());
+
+    m_animated.push_back(0);
+    m_stepDirty.push_back(0);
+    m_dirty.push_back(1);
+    m_changed.push_back(0);
+
+    m_worldRotations.push_back(Rotor4D());
+    m_worldRotationMatrices.push_back(glm::mat4(1.0f));
+    m_worldTranslations.push_back(glm::vec4(0.0f));
+    m_worldScales.push_back(glm::vec4(1.0f));
+
+    m_levelsDirty = true;
+    return object;
+}
+
+void Transform4DPool::Truncate(unsigned int count)
+{
+    if (count >= GetCount())
+        return;
+
+    m_parents.resize(count);
+    m_depths.resize(count);
+    m_translations.resize(count);
+    m_scales.resize(count);
+    m_rotations.resize(count);
+    m_angularVelocities.resize(count);
+    m_stepRotations.resize(count);
+    m_animated.resize(count);
+    m_stepDirty.resize(count);
+    m_dirty.resize(count);
+    m_changed.resize(count);
+    m_worldRotations.resize(count);
+    m_worldRotationMatrices.resize(count);
+    m_worldTranslations.resize(count);
+    m_worldScales.resize(count);
+
+    m_levelsDirty = true;
+}
+
+void Transform4DPool::SetAngularVelocity(unsigned int object, const Bivector4D& angularVelocity)
+{
+    m_angularVelocities[object] = angularVelocity;
+    m_animated[object] = angularVelocity.GetXY() != 0.0f || angularVelocity.GetXZ() != 0.0f || angularVelocity.GetXW() != 0.0f
+        || angularVelocity.GetYZ() != 0.0f || angularVelocity.GetYW() != 0.0f || angularVelocity.GetZW() != 0.0f;
+    m_stepDirty[object] = 1;
+}
+
+void Transform4DPool::SetMaxThreadCount(unsigned int maxThreadCount)
+{
+    m_maxThreadCount = maxThreadCount;
+}
+
+void Transform4DPool::Update(float timeStep)
+{
+    UpdateLevels();
+
+    // All the step rotations are recomputed if the time step changes
+    bool timeStepChanged = timeStep != m_stepTimeStep;
+    m_stepTimeStep = timeStep;
+
+    // Animation only touches the local rotation of each object, so all of them can run in parallel
+    ParallelSum(GetCount(), m_maxThreadCount, [&](size_t first, size_t last)
+        {
+            for (size_t object = first; object < last; ++object)
+            {
+                if (m_animated[object])
+                {
+                    if (m_stepDirty[object] || timeStepChanged)
+                    {
+                        m_stepRotations[object] = Rotor4D::FromAngles(m_angularVelocities[object] * timeStep);
+                        m_stepDirty[object] = 0;
+                    }
+
+                    // Renormalized every step, so the rounding errors do not accumulate
+                    m_rotations[object] = (m_stepRotations[object] * m_rotations[object]).GetNormalized();
+                    m_dirty[object] = 1;
+                }
+            }
+            return 0u;
+        });
+
+    // World transforms, one depth at a time, so the parents are always done before their children
+    m_changedCount = 0;
+    for (size_t level = 0; level + 1 < m_levelOffsets.size(); ++level)
+    {
+        const unsigned int* objects = m_levelObjects.data() + m_levelOffsets[level];
+        size_t count = m_levelOffsets[level + 1] - m_levelOffsets[level];
+        m_changedCount += ParallelSum(count, m_maxThreadCount, [&](size_t first, size_t last)
+            {
+                return UpdateWorld(objects + first, last - first);
+            });
+    }
+}
+
+void Transform4DPool::UpdateLevels()
+{
+    if (!m_levelsDirty)
+        return;
+
+    // Counting sort by depth. Flat pools end up with a single level holding all the objects
+    unsigned int levelCount = 0;
+    for (unsigned int depth : m_depths)
+    {
+        levelCount = std::max(levelCount, depth + 1);
+    }
+
+    m_levelOffsets.assign(levelCount + 1, 0);
+    for (unsigned int depth : m_depths)
+    {
+        m_levelOffsets[depth + 1]++;
+    }
+    for (unsigned int level = 0; level < levelCount; ++level)
+    {
+        m_levelOffsets[level + 1] += m_levelOffsets[level];
+    }
+
+    m_levelObjects.resize(m_depths.size());
+    std::vector<unsigned int> next(m_levelOffsets.begin(), m_levelOffsets.end() - 1);
+    for (unsigned int object = 0; object < GetCount(); ++object)
+    {
+        m_levelObjects[next[m_depths[object]]++] = object;
+    }
+
+    m_levelsDirty = false;
+}
+
+unsigned int Transform4DPool::UpdateWorld(const unsigned int* objects, size_t count)
+{
+    unsigned int changedCount = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        unsigned int object = objects[i];
+        unsigned int parent = m_parents[object];
+
+        bool changed = m_dirty[object] || (parent != NoParent && m_changed[parent]);
+        m_changed[object] = changed;
+        if (!changed)
+            continue;
+
+        if (parent == NoParent)
+        {
+            m_worldRotations[object] = m_rotations[object];
+            m_worldTranslations[object] = m_translations[object];
+            m_worldScales[object] = m_scales[object];
+        }
+        else
+        {
+            m_worldRotations[object] = m_worldRotations[parent] * m_rotations[object];
+            m_worldTranslations[object] = m_worldTranslations[parent]
+                + m_worldRotationMatrices[parent] * (m_worldScales[parent] * m_translations[object]);
+            m_worldScales[object] = m_worldScales[parent] * m_scales[object];
+        }
+        m_worldRotationMatrices[object] = m_worldRotations[object].ToMatrix();
+
+        m_dirty[object] = 0;
+        ++changedCount;
+    }
+    return changedCount;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Rotor4D.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// 4D version of ituGL/scene/Transform, for many objects at once
+// Each object has a translation, a scale, a rotation and an angular velocity, and optionally a parent. Each property is
+// kept in its own dense array (structure of arrays), indexed by the object index returned by Add
+// Objects are only recomputed in Update when they changed, were animated, or their parent changed
+class Transform4DPool
+{
+public:
+    static const unsigned int NoParent = ~0U;
+
+public:
+    Transform4DPool();
+
+    // Adds an object and returns its index. The parent must already be in the pool, so parents always have lower
+    // indices than their children
+    unsigned int Add(unsigned int parent = NoParent);
+
+    // Removes all the objects from index count onwards. Children always come after their parents, so no object is
+    // left with a missing parent
+    void Truncate(unsigned int count);
+    inline void Clear() { Truncate(0); }
+
+    inline unsigned int GetCount() const { return static_cast<unsigned int>(m_parents.size()); }
+    inline unsigned int GetParent(unsigned int object) const { return m_parents[object]; }
+
+    // Local transform, relative to the parent
+    inline const glm::vec4& GetTranslation(unsigned int object) const { return m_translations[object]; }
+    inline void SetTranslation(unsigned int object, const glm::vec4& translation) { m_translations[object] = translation; m_dirty[object] = 1; }
+
+    inline const glm::vec4& GetScale(unsigned int object) const { return m_scales[object]; }
+    inline void SetScale(unsigned int object, const glm::vec4& scale) { m_scales[object] = scale; m_dirty[object] = 1; }
+
+    inline const Rotor4D& GetRotation(unsigned int object) const { return m_rotations[object]; }
+    inline void SetRotation(unsigned int object, const Rotor4D& rotation) { m_rotations[object] = rotation; m_dirty[object] = 1; }
+
+    // Angles added to the rotation for each unit of time passed to Update, around the axes of the parent
+    inline const Bivector4D& GetAngularVelocity(unsigned int object) const { return m_angularVelocities[object]; }
+    void SetAngularVelocity(unsigned int object, const Bivector4D& angularVelocity);
+
+    // Maximum number of threads used by Update, 0 to use all the threads of the shared WorkerPool
+    void SetMaxThreadCount(unsigned int maxThreadCount);
+
+    // Advances the animated objects and recomputes the world transform of the objects that changed
+    void Update(float timeStep);
+
+    // World transform, valid after Update, in the form used by the shaders: translation + rotation * (scale * position)
+    // With a non-uniform scale in the parent, the scale of the children is only approximated (it is kept along their own axes)
+    inline const Rotor4D& GetWorldRotation(unsigned int object) const { return m_worldRotations[object]; }
+    inline const glm::mat4& GetWorldRotationMatrix(unsigned int object) const { return m_worldRotationMatrices[object]; }
+    inline const glm::vec4& GetWorldTranslation(unsigned int object) const { return m_worldTranslations[object]; }
+    inline const glm::vec4& GetWorldScale(unsigned int object) const { return m_worldScales[object]; }
+
+    // Whether the world transform changed in the last Update, and how many objects did
+    inline bool IsChanged(unsigned int object) const { return m_changed[object] != 0; }
+    inline unsigned int GetChangedCount() const { return m_changedCount; }
+
+private:
+    // Groups the objects by depth in the hierarchy. Objects at the same depth do not depend on each other
+    void UpdateLevels();
+
+    // Recomputes the world transform of the objects in the range, returning how many changed
+    unsigned int UpdateWorld(const unsigned int* objects, size_t count);
+
+private:
+    // Hierarchy
+    std::vector<unsigned int> m_parents;
+    std::vector<unsigned int> m_depths;
+
+    // Local transform
+    std::vector<glm::vec4> m_translations;
+    std::vector<glm::vec4> m_scales;
+    std::vector<Rotor4D> m_rotations;
+    std::vector<Bivector4D> m_angularVelocities;
+
+    // Rotation of each animated object in one step of m_stepTimeStep, cached as velocities rarely change
+    std::vector<Rotor4D> m_stepRotations;
+    float m_stepTimeStep;
+
+    // Flags, one byte per object so threads can write them independently
+    std::vector<uint8_t> m_animated;
+    std::vector<uint8_t> m_stepDirty;
+    std::vector<uint8_t> m_dirty;
+    std::vector<uint8_t> m_changed;
+
+    // World transform
+    std::vector<Rotor4D> m_worldRotations;
+    std::vector<glm::mat4> m_worldRotationMatrices;
+    std::vector<glm::vec4> m_worldTranslations;
+    std::vector<glm::vec4> m_worldScales;
+
+    // Object indices sorted by depth, and where each depth starts. Rebuilt when the hierarchy changes
+    std::vector<unsigned int> m_levelObjects;
+    std::vector<unsigned int> m_levelOffsets;
+    bool m_levelsDirty;
+
+    unsigned int m_maxThreadCount;
+    unsigned int m_changedCount;
+};
@@ -0,0 +1,101 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool& WorkerPool::GetShared()
+{
+    static WorkerPool workerPool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return workerPool;
+}
+
+WorkerPool::WorkerPool(unsigned int workerCount)
+    : m_task(nullptr)
+    , m_taskCount(0)
+    , m_generation(0)
+    , m_activeWorkerCount(0)
+    , m_stop(false)
+    , m_nextTask(0)
+{
+    m_workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_workCondition.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkerPool::Run(size_t taskCount, const std::function<void(size_t)>& task)
+{
+    // Nothing to share, don't wake the workers
+    if (taskCount <= 1 || m_workers.empty())
+    {
+        for (size_t i = 0; i < taskCount; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(m_runMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_nextTask = 0;
+        ++m_generation;
+    }
+    m_workCondition.notify_all();
+
+    RunTasks(task, taskCount);
+
+    // All the tasks were taken. Workers that didn't join yet won't, and the ones running must finish before the task goes away
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task = nullptr;
+    m_doneCondition.wait(lock, [this] { return m_activeWorkerCount == 0; });
+}
+
+void WorkerPool::WorkerLoop()
+{
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_workCondition.wait(lock, [&] { return m_stop || (m_task && m_generation != generation); });
+        if (m_stop)
+            break;
+
+        generation = m_generation;
+        const std::function<void(size_t)>& task = *m_task;
+        size_t taskCount = m_taskCount;
+        ++m_activeWorkerCount;
+
+        lock.unlock();
+        RunTasks(task, taskCount);
+        lock.lock();
+
+        if (--m_activeWorkerCount == 0)
+        {
+            m_doneCondition.notify_one();
+        }
+    }
+}
+
+void WorkerPool::RunTasks(const std::function<void(size_t)>& task, size_t taskCount)
+{
+    for (size_t i = m_nextTask++; i < taskCount; i = m_nextTask++)
+    {
+        task(i);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads created once and kept waiting for work, so splitting the work of a frame doesn't start new threads each time
+// Run hands out the tasks to the workers and to the calling thread, and returns when all of them are done
+class WorkerPool
+{
+public:
+    // Pool shared by all the users, with one worker less than the hardware threads, created on first use
+    static WorkerPool& GetShared();
+
+    explicit WorkerPool(unsigned int workerCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator = (const WorkerPool&) = delete;
+
+    // Threads that can run tasks at the same time, the workers and the calling thread
+    inline unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+
+    // Calls task(i) for each i in [0, taskCount), and returns when all of them are done
+    // Tasks must not call Run themselves
+    void Run(size_t taskCount, const std::function<void(size_t)>& task);
+
+private:
+    void WorkerLoop();
+
+    // Takes tasks until there are none left
+    void RunTasks(const std::function<void(size_t)>& task, size_t taskCount);
+
+private:
+    std::vector<std::thread> m_workers;
+
+    // Only one Run at a time
+    std::mutex m_runMutex;
+
+    // Current work, protected by m_mutex. Workers only join while m_task is set, and Run waits for the ones that joined
+    std::mutex m_mutex;
+    std::condition_variable m_workCondition;
+    std::condition_variable m_doneCondition;
+    const std::function<void(size_t)>* m_task;
+    size_t m_taskCount;
+    uint64_t m_generation;
+    unsigned int m_activeWorkerCount;
+    bool m_stop;
+
+    std::atomic<size_t> m_nextTask;
+};
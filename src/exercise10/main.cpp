@@ -1,7 +1,33 @@
 #include "Geometry4D.h"
 
-int main()
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Usage: exercise10 [--headless <frame count>] [--output <directory, or - for stdout>]
+// For example, to encode a video: exercise10 --headless 600 --output - | ffmpeg -f image2pipe -i - out.mp4
+int main(int argc, char* argv[])
 {
-    Geometry4DApplication geometry4DApplication;
+    unsigned int headlessFrameCount = 0;
+    const char* outputPath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+        {
+            headlessFrameCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    Geometry4DApplication geometry4DApplication(headlessFrameCount, outputPath);
     return geometry4DApplication.Run();
 }
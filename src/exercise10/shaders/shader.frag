@@ -1,13 +1,12 @@
-#version 330 core
+#version 410 core
 
 in vec3 Position;
 in vec3 Normal;
 in vec2 TexCoord;
+in vec4 ObjectColor;
 
 out vec4 FragColor;
 
-uniform vec4 Color;
-
 uniform float AmbientReflection;
 uniform float DiffuseReflection;
 uniform float SpecularReflection;
@@ -16,10 +15,20 @@ uniform float SpecularExponent;
 uniform vec3 AmbientColor;
 uniform vec3 LightColor;
 uniform vec3 LightPosition;
-uniform vec3 CameraPosition;
 
+// Filled once per frame, see Renderer::CameraBlock
+layout(std140) uniform CameraBlock
+{
+	mat4 ViewMatrix;
+	mat4 ProjMatrix;
+	mat4 ViewProjMatrix;
+	vec4 CameraPosition;
+};
+
+// Variant selected with a define, so the untextured one doesn't branch
+#ifdef TEXTURED
 uniform sampler2D Texture;
-uniform bool UsingTexture;
+#endif
 
 //Blinn-Phong stuff
 vec3 GetAmbientReflection(vec3 objectColor)
@@ -48,14 +57,14 @@ vec3 GetBlinnPhongReflection(vec3 objectColor, vec3 lightVector, vec3 viewVector
 void main()
 {
 	// Reuses the code from the Exercise where we implement Blinn-Phong
-	vec4 objectColor = Color;
+	vec4 objectColor = ObjectColor;
 	vec3 lightVector = normalize(LightPosition - Position);
-	vec3 viewVector = normalize(CameraPosition - Position);
+	vec3 viewVector = normalize(CameraPosition.xyz - Position);
 	vec3 normalVector = normalize(Normal);
 
 	vec4 tColor = vec4(1.0f);
-	if (UsingTexture) {
-		tColor = texture(Texture, TexCoord);
-	}
+#ifdef TEXTURED
+	tColor = texture(Texture, TexCoord);
+#endif
 	FragColor = vec4(GetBlinnPhongReflection(objectColor.rgb * tColor.rgb, lightVector, viewVector, normalVector), 1.0f);
 }
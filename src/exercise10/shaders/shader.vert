@@ -1,4 +1,4 @@
-#version 330 core
+#version 410 core
 
 layout (location = 0) in vec4 VertexPosition;
 layout (location = 1) in vec4 VertexNormal;
@@ -7,25 +7,51 @@ layout (location = 2) in vec2 VertexTexCoord;
 out vec3 Position;
 out vec3 Normal;
 out vec2 TexCoord;
+out vec4 ObjectColor;
 
 uniform mat4 WorldRotationMatrix;
 uniform vec4 WorldTranslationVector;
 uniform vec4 WorldScaleVector;
-uniform mat4 ViewProjMatrix;
+
+// Filled once per frame, see Renderer::CameraBlock
+layout(std140) uniform CameraBlock
+{
+	mat4 ViewMatrix;
+	mat4 ProjMatrix;
+	mat4 ViewProjMatrix;
+	vec4 CameraPosition;
+};
+
+uniform vec4 Color;
+
+// Rotates a 4D vector column by column, accumulating from left to right
+// The operations are written out (and precise) so the results match Transform4DKernel on the CPU exactly
+vec4 Rotate4D(mat4 rotation, vec4 value)
+{
+	precise vec4 result = rotation[0] * value.x;
+	result = result + rotation[1] * value.y;
+	result = result + rotation[2] * value.z;
+	result = result + rotation[3] * value.w;
+	return result;
+}
 
 void main()
 {
 	// Gets the real 4D location of the Vertex after the transformations
-	vec4 Real4DPosition = WorldTranslationVector + (WorldRotationMatrix * (WorldScaleVector * VertexPosition));
-	
+	precise vec4 Real4DPosition = WorldTranslationVector + Rotate4D(WorldRotationMatrix, WorldScaleVector * VertexPosition);
+
 	float VertexW = Real4DPosition.w;
 
 	// Calculate the 3D Projected position of the Vertex, by treating The Vertex's w as a scale factor.
 	// Since there is a non-uniform scale (vertex scale depends on VertexW and WorldScaleVector), the ignores the scale
-	Position = (WorldScaleVector * ((WorldTranslationVector / WorldScaleVector) + (WorldRotationMatrix * (VertexW * VertexPosition)))).xyz;
+	// This is Scale * ((Translation / Scale) + (Rotation * (VertexW * VertexPosition))), without the division,
+	// which is not correctly rounded on the GPU
+	precise vec4 ProjectedPosition = WorldTranslationVector + WorldScaleVector * Rotate4D(WorldRotationMatrix, VertexW * VertexPosition);
+	Position = ProjectedPosition.xyz;
 
 	TexCoord = VertexTexCoord;
+	ObjectColor = Color;
 
 	Normal = normalize((WorldRotationMatrix * VertexNormal).xyz);
 	gl_Position = ViewProjMatrix * vec4(Position, 1.0f);
-} 
+}
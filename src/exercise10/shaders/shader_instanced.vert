@@ -0,0 +1,51 @@
+#version 410 core
+
+layout (location = 0) in vec4 VertexPosition;
+layout (location = 1) in vec4 VertexNormal;
+layout (location = 2) in vec2 VertexTexCoord;
+
+// Per-instance attributes (see InstanceBatch4D). The rotation matrix takes locations 3 to 6
+layout (location = 3) in mat4 InstanceRotationMatrix;
+layout (location = 7) in vec4 InstanceTranslationVector;
+layout (location = 8) in vec4 InstanceScaleVector;
+layout (location = 9) in vec4 InstanceColor;
+
+out vec3 Position;
+out vec3 Normal;
+out vec2 TexCoord;
+out vec4 ObjectColor;
+
+// Filled once per frame, see Renderer::CameraBlock
+layout(std140) uniform CameraBlock
+{
+	mat4 ViewMatrix;
+	mat4 ProjMatrix;
+	mat4 ViewProjMatrix;
+	vec4 CameraPosition;
+};
+
+// Same transform as shader.vert, taking the world transform from the instance attributes instead of uniforms
+vec4 Rotate4D(mat4 rotation, vec4 value)
+{
+	precise vec4 result = rotation[0] * value.x;
+	result = result + rotation[1] * value.y;
+	result = result + rotation[2] * value.z;
+	result = result + rotation[3] * value.w;
+	return result;
+}
+
+void main()
+{
+	precise vec4 Real4DPosition = InstanceTranslationVector + Rotate4D(InstanceRotationMatrix, InstanceScaleVector * VertexPosition);
+
+	float VertexW = Real4DPosition.w;
+
+	precise vec4 ProjectedPosition = InstanceTranslationVector + InstanceScaleVector * Rotate4D(InstanceRotationMatrix, VertexW * VertexPosition);
+	Position = ProjectedPosition.xyz;
+
+	TexCoord = VertexTexCoord;
+	ObjectColor = InstanceColor;
+
+	Normal = normalize((InstanceRotationMatrix * VertexNormal).xyz);
+	gl_Position = ViewProjMatrix * vec4(Position, 1.0f);
+}
@@ -0,0 +1,268 @@
+#include "GBufferBenchmark.h"
+
+#include <ituGL/shader/Shader.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+GBufferBenchmarkApplication::GBufferBenchmarkApplication(unsigned int measuredFrameCount)
+    : Application(256, 256, "G-buffer benchmark", true)
+    , m_warmUpFrameCount(10)
+    , m_measuredFrameCount(std::max(measuredFrameCount, 1u))
+    , m_queries{}
+{
+    for (GBufferRenderPass::Layout layout : { GBufferRenderPass::Layout::Standard, GBufferRenderPass::Layout::Compact })
+    {
+        m_configurations.push_back({ layout, 1920, 1080 });
+        m_configurations.push_back({ layout, 3840, 2160 });
+    }
+
+    // The time is not used, but the frame limit stops the application after the last configuration
+    unsigned int frameCount = static_cast<unsigned int>(m_configurations.size()) * (m_warmUpFrameCount + m_measuredFrameCount);
+    SetFrameLimit(frameCount, 1.0f / 60.0f);
+}
+
+void GBufferBenchmarkApplication::Initialize()
+{
+    Application::Initialize();
+
+    for (GBufferRenderPass::Layout layout : { GBufferRenderPass::Layout::Standard, GBufferRenderPass::Layout::Compact })
+    {
+        int layoutIndex = static_cast<int>(layout);
+        BuildShaderProgram(m_gbufferShaderPrograms[layoutIndex], layout, "shaders/gbuffer.frag");
+        BuildShaderProgram(m_lightingShaderPrograms[layoutIndex], layout, "shaders/lighting.frag");
+    }
+
+    glGenQueries(2, m_queries);
+
+    PrintHeader();
+}
+
+void GBufferBenchmarkApplication::BuildShaderProgram(ShaderProgram& shaderProgram, GBufferRenderPass::Layout layout, const char* fragmentShaderPath)
+{
+    // Read the files of the shader sources, in order
+    auto readSources = [](std::span<const char* const> paths)
+    {
+        std::vector<std::string> sources;
+        for (const char* path : paths)
+        {
+            std::ifstream file(path);
+            if (!file.is_open())
+            {
+                std::cerr << "Can't find file: " << path << std::endl;
+                std::cerr << "Is your working directory properly set?" << std::endl;
+            }
+            std::stringstream stringStream;
+            stringStream << file.rdbuf();
+            sources.push_back(stringStream.str());
+        }
+        return sources;
+    };
+
+    // The version goes first, then the defines of the layout, so the G-buffer functions are built for it
+    auto compileShader = [&](Shader& shader, std::span<const char* const> paths)
+    {
+        std::vector<std::string> fileSources = readSources(paths);
+        std::vector<const char*> sources = { "#version 410 core\n", GBufferRenderPass::GetLayoutDefines(layout) };
+        for (const std::string& source : fileSources)
+        {
+            sources.push_back(source.c_str());
+        }
+        shader.SetSource(sources);
+        if (!shader.Compile())
+        {
+            std::array<char, 512> errors;
+            shader.GetCompilationErrors(errors);
+            std::cerr << "Error compiling shader: " << paths.back() << std::endl;
+            std::cerr << errors.data() << std::endl;
+        }
+    };
+
+    Shader vertexShader(Shader::VertexShader);
+    compileShader(vertexShader, std::array<const char*, 1>({ "shaders/fullscreen.vert" }));
+
+    Shader fragmentShader(Shader::FragmentShader);
+    compileShader(fragmentShader, std::array<const char*, 2>({ "shaders/gbuffer.glsl", fragmentShaderPath }));
+
+    if (!shaderProgram.Build(vertexShader, fragmentShader))
+    {
+        std::array<char, 512> errors;
+        shaderProgram.GetLinkingErrors(errors);
+        std::cerr << "Error linking shaders: " << fragmentShaderPath << std::endl;
+        std::cerr << errors.data() << std::endl;
+    }
+}
+
+void GBufferBenchmarkApplication::InitializeConfiguration(const Configuration& configuration)
+{
+    // The G-buffer pass owns its textures and framebuffer. It is only used for them here, there is no Renderer
+    m_gbufferRenderPass = std::make_unique<GBufferRenderPass>(configuration.width, configuration.height, 0, false, configuration.layout);
+
+    m_lightingTexture = std::make_shared<Texture2DObject>();
+    m_lightingTexture->Bind();
+    m_lightingTexture->SetImage(0, configuration.width, configuration.height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA16F);
+    m_lightingTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_lightingTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+    Texture2DObject::Unbind();
+
+    m_lightingFramebuffer = std::make_shared<FramebufferObject>();
+    m_lightingFramebuffer->Bind();
+    m_lightingFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_lightingTexture);
+    FramebufferObject::Unbind();
+
+    m_timings = Timings();
+}
+
+void GBufferBenchmarkApplication::Render()
+{
+    unsigned int framesPerConfiguration = m_warmUpFrameCount + m_measuredFrameCount;
+    const Configuration& configuration = m_configurations[GetFrameIndex() / framesPerConfiguration];
+    unsigned int configurationFrame = GetFrameIndex() % framesPerConfiguration;
+
+    if (configurationFrame == 0)
+    {
+        InitializeConfiguration(configuration);
+    }
+
+    // Wait for the previous frames, so the time is only for this one
+    glFinish();
+    auto startTime = std::chrono::steady_clock::now();
+
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[0]);
+    RenderGBuffer(configuration);
+    glEndQuery(GL_TIME_ELAPSED);
+
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[1]);
+    RenderLighting(configuration);
+    glEndQuery(GL_TIME_ELAPSED);
+
+    glFinish();
+    std::chrono::duration<double> frameDuration = std::chrono::steady_clock::now() - startTime;
+
+    if (configurationFrame >= m_warmUpFrameCount)
+    {
+        m_timings.gbufferTime += GetQueryTime(m_queries[0]);
+        m_timings.lightingTime += GetQueryTime(m_queries[1]);
+        m_timings.frameTime += frameDuration.count();
+    }
+
+    if (configurationFrame + 1 == framesPerConfiguration)
+    {
+        PrintResults(configuration);
+    }
+}
+
+void GBufferBenchmarkApplication::RenderGBuffer(const Configuration& configuration)
+{
+    DeviceGL& device = GetDevice();
+    const ShaderProgram& shaderProgram = m_gbufferShaderPrograms[static_cast<int>(configuration.layout)];
+
+    m_gbufferRenderPass->GetTargetFramebuffer()->Bind();
+    device.SetViewport(0, 0, configuration.width, configuration.height);
+    device.EnableFeature(GL_DEPTH_TEST);
+    device.SetDepthFunction(GL_LESS);
+    device.SetDepthWrite(true);
+    device.Clear(true, Color(0.0f, 0.0f, 0.0f, 0.0f), true, 1.0f);
+
+    shaderProgram.Use();
+    shaderProgram.SetUniform(shaderProgram.GetUniformLocation("Resolution"), glm::vec2(configuration.width, configuration.height));
+
+    ShaderProgram::Location depthLocation = shaderProgram.GetUniformLocation("Depth");
+    ShaderProgram::Location layerLocation = shaderProgram.GetUniformLocation("Layer");
+
+    // From far to near, so every layer passes the depth test
+    m_emptyVAO.Bind();
+    for (unsigned int layer = 0; layer < s_layerCount; ++layer)
+    {
+        shaderProgram.SetUniform(depthLocation, 0.9f - 1.6f * layer / s_layerCount);
+        shaderProgram.SetUniform(layerLocation, static_cast<float>(layer));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+}
+
+void GBufferBenchmarkApplication::RenderLighting(const Configuration& configuration)
+{
+    DeviceGL& device = GetDevice();
+    const ShaderProgram& shaderProgram = m_lightingShaderPrograms[static_cast<int>(configuration.layout)];
+
+    m_lightingFramebuffer->Bind();
+    device.DisableFeature(GL_DEPTH_TEST);
+
+    float aspectRatio = static_cast<float>(configuration.width) / configuration.height;
+    glm::mat4 projMatrix = glm::perspective(glm::radians(60.0f), aspectRatio, 0.1f, 100.0f);
+
+    shaderProgram.Use();
+    shaderProgram.SetUniform(shaderProgram.GetUniformLocation("Resolution"), glm::vec2(configuration.width, configuration.height));
+    shaderProgram.SetUniform(shaderProgram.GetUniformLocation("InvProjMatrix"), glm::inverse(projMatrix));
+    shaderProgram.SetTexture(shaderProgram.GetUniformLocation("DepthTexture"), 0, *m_gbufferRenderPass->GetDepthTexture());
+    shaderProgram.SetTexture(shaderProgram.GetUniformLocation("AlbedoTexture"), 1, *m_gbufferRenderPass->GetAlbedoTexture());
+    shaderProgram.SetTexture(shaderProgram.GetUniformLocation("NormalTexture"), 2, *m_gbufferRenderPass->GetNormalTexture());
+    if (m_gbufferRenderPass->GetOthersTexture())
+    {
+        shaderProgram.SetTexture(shaderProgram.GetUniformLocation("OthersTexture"), 3, *m_gbufferRenderPass->GetOthersTexture());
+    }
+
+    m_emptyVAO.Bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    FramebufferObject::Unbind();
+}
+
+void GBufferBenchmarkApplication::PrintHeader() const
+{
+    std::cout << std::left
+        << std::setw(10) << "layout" << std::setw(12) << "resolution" << std::setw(12) << "bytes/px"
+        << std::setw(14) << "gbuffer MB" << std::setw(14) << "gbuffer ms" << std::setw(14) << "lighting ms"
+        << std::setw(12) << "frame ms" << "GB/s" << std::endl;
+}
+
+void GBufferBenchmarkApplication::PrintResults(const Configuration& configuration) const
+{
+    size_t pixelCount = static_cast<size_t>(configuration.width) * configuration.height;
+    size_t bytesPerPixel = GBufferRenderPass::GetBytesPerPixel(configuration.layout);
+
+    // Estimated traffic: each layer tests the depth and writes all the targets, and the lighting reads them all once
+    // and writes RGBA16F. Caches and framebuffer compression can make the real traffic lower
+    size_t gbufferBytes = s_layerCount * (bytesPerPixel + 4) * pixelCount;
+    size_t lightingBytes = (bytesPerPixel + 8) * pixelCount;
+    double frameTime = m_timings.frameTime / m_measuredFrameCount;
+    double bandwidth = (gbufferBytes + lightingBytes) / frameTime / 1.0e9;
+
+    std::ostringstream resolution;
+    resolution << configuration.width << "x" << configuration.height;
+
+    std::cout << std::left << std::fixed << std::setprecision(3)
+        << std::setw(10) << (configuration.layout == GBufferRenderPass::Layout::Compact ? "compact" : "standard")
+        << std::setw(12) << resolution.str()
+        << std::setw(12) << bytesPerPixel
+        << std::setw(14) << bytesPerPixel * pixelCount / (1024.0 * 1024.0)
+        << std::setw(14) << m_timings.gbufferTime * 1000.0 / m_measuredFrameCount
+        << std::setw(14) << m_timings.lightingTime * 1000.0 / m_measuredFrameCount
+        << std::setw(12) << frameTime * 1000.0
+        << bandwidth << std::endl;
+}
+
+double GBufferBenchmarkApplication::GetQueryTime(GLuint query)
+{
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    return nanoseconds * 1.0e-9;
+}
+
+void GBufferBenchmarkApplication::Cleanup()
+{
+    glDeleteQueries(2, m_queries);
+
+    m_gbufferRenderPass.reset();
+    m_lightingFramebuffer.reset();
+    m_lightingTexture.reset();
+
+    Application::Cleanup();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <ituGL/application/Application.h>
+#include <ituGL/renderer/GBufferRenderPass.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+class Texture2DObject;
+class FramebufferObject;
+
+// Renders the G-buffer and the lighting pass that reconstructs the surfaces from it, with no window, for each layout
+// of GBufferRenderPass and each resolution. Prints the time of each pass and an estimate of the memory traffic
+class GBufferBenchmarkApplication : public Application
+{
+public:
+    // Each configuration renders some warm up frames, and then measuredFrameCount frames
+    GBufferBenchmarkApplication(unsigned int measuredFrameCount = 100);
+
+protected:
+    void Initialize() override;
+    void Render() override;
+    void Cleanup() override;
+
+private:
+    struct Configuration
+    {
+        GBufferRenderPass::Layout layout;
+        int width;
+        int height;
+    };
+
+    // Accumulated time of the measured frames of the current configuration, in seconds
+    struct Timings
+    {
+        double gbufferTime = 0.0;
+        double lightingTime = 0.0;
+        double frameTime = 0.0;
+    };
+
+    void InitializeConfiguration(const Configuration& configuration);
+    void BuildShaderProgram(ShaderProgram& shaderProgram, GBufferRenderPass::Layout layout, const char* fragmentShaderPath);
+
+    void RenderGBuffer(const Configuration& configuration);
+    void RenderLighting(const Configuration& configuration);
+
+    void PrintHeader() const;
+    void PrintResults(const Configuration& configuration) const;
+
+    // Elapsed GPU time of the query, in seconds. Waits for the result
+    static double GetQueryTime(GLuint query);
+
+private:
+    std::vector<Configuration> m_configurations;
+    unsigned int m_warmUpFrameCount;
+    unsigned int m_measuredFrameCount;
+
+    // Overdraw of the G-buffer pass: each layer writes all the pixels
+    static const unsigned int s_layerCount = 4;
+
+    std::unique_ptr<GBufferRenderPass> m_gbufferRenderPass;
+    std::shared_ptr<Texture2DObject> m_lightingTexture;
+    std::shared_ptr<FramebufferObject> m_lightingFramebuffer;
+
+    // Shader programs built for each layout
+    ShaderProgram m_gbufferShaderPrograms[2];
+    ShaderProgram m_lightingShaderPrograms[2];
+
+    // Fullscreen triangles are generated in the vertex shader, but core profile needs a VAO bound to draw
+    VertexArrayObject m_emptyVAO;
+
+    // Time queries of the G-buffer and lighting passes
+    GLuint m_queries[2];
+
+    Timings m_timings;
+};
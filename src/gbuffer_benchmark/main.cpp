@@ -0,0 +1,28 @@
+#include "GBufferBenchmark.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Usage: gbuffer_benchmark [--frames <measured frames per configuration>]
+// Run from this directory, so the shaders are found
+int main(int argc, char* argv[])
+{
+    unsigned int measuredFrameCount = 100;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            measuredFrameCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    GBufferBenchmarkApplication gbufferBenchmarkApplication(measuredFrameCount);
+    return gbufferBenchmarkApplication.Run();
+}
@@ -0,0 +1,10 @@
+// Fullscreen triangle from the vertex index, drawn with no vertex attributes
+// Depth places it between the near (-1) and far (1) planes
+
+uniform float Depth;
+
+void main()
+{
+	vec2 position = vec2((gl_VertexID & 1) * 4.0 - 1.0, (gl_VertexID & 2) * 2.0 - 1.0);
+	gl_Position = vec4(position, Depth, 1.0);
+}
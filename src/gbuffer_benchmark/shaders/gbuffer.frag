@@ -0,0 +1,31 @@
+// Writes a procedural surface in the G-buffer. Each layer is drawn closer than the previous one, so every layer
+// writes all the pixels, as the worst case of overdraw
+
+layout(location = 0) out vec4 GBuffer0;
+layout(location = 1) out vec4 GBuffer1;
+#ifndef GBUFFER_COMPACT
+layout(location = 2) out vec4 GBuffer2;
+#endif
+
+uniform vec2 Resolution;
+uniform float Layer;
+
+void main()
+{
+	vec2 uv = gl_FragCoord.xy / Resolution;
+	vec2 wave = vec2(sin(uv.x * 40.0 + Layer), cos(uv.y * 30.0 - Layer));
+
+	GBufferData data;
+	data.albedo = vec3(uv, fract(Layer * 0.25));
+	data.normal = normalize(vec3(wave * 0.75, 1.0));
+	data.ambientOcclusion = 0.5 + 0.5 * wave.x * wave.y;
+	data.roughness = uv.x;
+	data.metalness = uv.y;
+
+	vec4 gbuffer2;
+#ifdef GBUFFER_COMPACT
+	EncodeGBuffer(data, GBuffer0, GBuffer1, gbuffer2);
+#else
+	EncodeGBuffer(data, GBuffer0, GBuffer1, GBuffer2);
+#endif
+}
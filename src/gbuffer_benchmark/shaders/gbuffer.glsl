@@ -0,0 +1,67 @@
+// Encoding of the G-buffer written by GBufferRenderPass, shared by the shaders that write and read it
+// Add GBufferRenderPass::GetLayoutDefines before this file, to build it for the same layout as the pass
+
+struct GBufferData
+{
+	vec3 albedo;
+	// View space, facing the camera
+	vec3 normal;
+	float ambientOcclusion;
+	float roughness;
+	float metalness;
+};
+
+// Octahedral encoding: the normal is projected on the octahedron |x| + |y| + |z| = 1, and the lower half is folded over
+// the upper one, so the whole sphere fits in a square with a similar precision everywhere
+vec2 OctahedronWrap(vec2 v)
+{
+	return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 EncodeNormalOctahedron(vec3 normal)
+{
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+	vec2 encoded = normal.z >= 0.0 ? normal.xy : OctahedronWrap(normal.xy);
+	return encoded * 0.5 + 0.5;
+}
+
+vec3 DecodeNormalOctahedron(vec2 encoded)
+{
+	encoded = encoded * 2.0 - 1.0;
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-normal.z, 0.0);
+	normal.xy += vec2(normal.x >= 0.0 ? -t : t, normal.y >= 0.0 ? -t : t);
+	return normalize(normal);
+}
+
+// The compact layout has no third texture, gbuffer2 is not used then
+void EncodeGBuffer(GBufferData data, out vec4 gbuffer0, out vec4 gbuffer1, out vec4 gbuffer2)
+{
+#ifdef GBUFFER_COMPACT
+	gbuffer0 = vec4(data.albedo, data.ambientOcclusion);
+	gbuffer1 = vec4(EncodeNormalOctahedron(data.normal), data.roughness, data.metalness);
+	gbuffer2 = vec4(0.0);
+#else
+	gbuffer0 = vec4(data.albedo, 1.0);
+	gbuffer1 = vec4(data.normal.xy, 0.0, 0.0);
+	gbuffer2 = vec4(data.ambientOcclusion, data.roughness, data.metalness, 1.0);
+#endif
+}
+
+GBufferData DecodeGBuffer(vec4 gbuffer0, vec4 gbuffer1, vec4 gbuffer2)
+{
+	GBufferData data;
+	data.albedo = gbuffer0.rgb;
+#ifdef GBUFFER_COMPACT
+	data.normal = DecodeNormalOctahedron(gbuffer1.xy);
+	data.ambientOcclusion = gbuffer0.a;
+	data.roughness = gbuffer1.z;
+	data.metalness = gbuffer1.w;
+#else
+	data.normal = vec3(gbuffer1.xy, sqrt(max(1.0 - dot(gbuffer1.xy, gbuffer1.xy), 0.0)));
+	data.ambientOcclusion = gbuffer2.r;
+	data.roughness = gbuffer2.g;
+	data.metalness = gbuffer2.b;
+#endif
+	return data;
+}
@@ -0,0 +1,54 @@
+// Reconstructs the surface from the G-buffer, with the view position from the depth, and lights it with a few point lights
+
+out vec4 FragColor;
+
+uniform sampler2D DepthTexture;
+uniform sampler2D AlbedoTexture;
+uniform sampler2D NormalTexture;
+#ifndef GBUFFER_COMPACT
+uniform sampler2D OthersTexture;
+#endif
+
+uniform vec2 Resolution;
+uniform mat4 InvProjMatrix;
+
+const int LightCount = 8;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 gbuffer0 = texelFetch(AlbedoTexture, pixel, 0);
+	vec4 gbuffer1 = texelFetch(NormalTexture, pixel, 0);
+#ifdef GBUFFER_COMPACT
+	vec4 gbuffer2 = vec4(0.0);
+#else
+	vec4 gbuffer2 = texelFetch(OthersTexture, pixel, 0);
+#endif
+	GBufferData data = DecodeGBuffer(gbuffer0, gbuffer1, gbuffer2);
+
+	float depth = texelFetch(DepthTexture, pixel, 0).r;
+	vec4 clipPosition = vec4(gl_FragCoord.xy / Resolution * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 viewPosition = InvProjMatrix * clipPosition;
+	vec3 position = viewPosition.xyz / viewPosition.w;
+
+	vec3 viewDir = normalize(-position);
+	float specularExponent = mix(256.0, 4.0, data.roughness);
+	vec3 specularColor = mix(vec3(0.04), data.albedo, data.metalness);
+
+	vec3 color = vec3(0.1) * data.albedo * data.ambientOcclusion;
+	for (int i = 0; i < LightCount; ++i)
+	{
+		float angle = 6.2831853 * float(i) / float(LightCount);
+		vec3 lightPosition = vec3(cos(angle), sin(angle), 0.0) * 2.0 + vec3(0.0, 0.0, -2.0);
+		vec3 lightVector = lightPosition - position;
+		vec3 lightDir = normalize(lightVector);
+		vec3 halfDir = normalize(lightDir + viewDir);
+		float attenuation = 1.0 / (1.0 + dot(lightVector, lightVector));
+
+		float diffuse = max(dot(data.normal, lightDir), 0.0);
+		float specular = pow(max(dot(data.normal, halfDir), 0.0), specularExponent);
+		color += attenuation * (diffuse * data.albedo * (1.0 - data.metalness) + specular * specularColor);
+	}
+
+	FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,338 @@
+#include "RendererBenchmark.h"
+
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <ituGL/lighting/PointLight.h>
+#include <ituGL/renderer/ForwardRenderPass.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+RendererBenchmarkApplication::RendererBenchmarkApplication(unsigned int measuredFrameCount)
+    : Application(256, 256, "Renderer benchmark", true)
+    , m_warmUpFrameCount(10)
+    , m_measuredFrameCount(std::max(measuredFrameCount, 1u))
+    , m_shaderPermutations({ "shaders/renderer.glsl", "shaders/forward.vert" }, { "shaders/renderer.glsl", "shaders/forward.frag" })
+    , m_rendererUniforms({ "WorldMatrix", "WorldViewProjMatrix", "LightIndirect", "LightColor", "LightPosition", "LightDirection", "LightAttenuation" })
+    , m_query(0)
+{
+    // Same scene and shader code, the defines only change where the shader reads the data from
+    m_configurations.push_back({ "uniforms", {} });
+    m_configurations.push_back({ "transform block", { "TRANSFORM_BLOCK" } });
+    m_configurations.push_back({ "light block", { "TRANSFORM_BLOCK", "LIGHT_BLOCK" } });
+    m_configurations.push_back({ "material block", { "TRANSFORM_BLOCK", "LIGHT_BLOCK", "MATERIAL_BLOCK" } });
+    m_configurations.push_back({ "transform array", { "TRANSFORM_ARRAY", "LIGHT_BLOCK", "MATERIAL_BLOCK" }, false });
+    m_configurations.push_back({ "multi draw", { "TRANSFORM_ARRAY", "LIGHT_BLOCK", "MATERIAL_BLOCK" }, true });
+}
+
+void RendererBenchmarkApplication::Initialize()
+{
+    Application::Initialize();
+
+    // Storage blocks and multi draw indirect need OpenGL 4.3. Without them, skip the configurations that use them
+    if (!GetDevice().IsMultiDrawIndirectSupported())
+    {
+        std::erase_if(m_configurations, [](const Configuration& configuration) { return configuration.defines.contains("TRANSFORM_ARRAY"); });
+    }
+
+    // The time is not used, but the frame limit stops the application after the last configuration
+    unsigned int frameCount = static_cast<unsigned int>(m_configurations.size()) * (m_warmUpFrameCount + m_measuredFrameCount);
+    SetFrameLimit(frameCount, 1.0f / 60.0f);
+
+    m_renderer = std::make_unique<Renderer>(GetDevice());
+    m_renderer->AddRenderPass(std::make_unique<ForwardRenderPass>());
+
+    InitializeMeshes();
+    InitializeMaterials();
+    InitializeScene();
+    InitializeFramebuffer();
+
+    // Editing the shaders while the benchmark runs rebuilds the programs, see Update
+    m_shaderFileWatcher.AddFile("shaders/renderer.glsl");
+    m_shaderFileWatcher.AddFile("shaders/forward.vert");
+    m_shaderFileWatcher.AddFile("shaders/forward.frag");
+
+    glGenQueries(1, &m_query);
+
+    PrintHeader();
+}
+
+void RendererBenchmarkApplication::InitializeMeshes()
+{
+    struct Vertex
+    {
+        Vertex(const glm::vec3& position, const glm::vec3& normal) : position(position), normal(normal) {}
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3);
+    vertexFormat.AddVertexAttribute<float>(3);
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned short> indices;
+
+    // Cube of size 1, with 4 vertices per face, so each face has its own normal
+    // The tangent and bitangent of each face are ordered so the triangles are counterclockwise from outside
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (float side : { -1.0f, 1.0f })
+        {
+            glm::vec3 normal(0.0f);
+            normal[axis] = side;
+            glm::vec3 tangent(0.0f);
+            tangent[(axis + 1) % 3] = 1.0f;
+            glm::vec3 bitangent = glm::cross(normal, tangent);
+
+            unsigned short firstVertex = static_cast<unsigned short>(vertices.size());
+            for (const glm::vec2& corner : { glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 1.0f), glm::vec2(-1.0f, 1.0f) })
+            {
+                vertices.emplace_back(0.5f * (normal + corner.x * tangent + corner.y * bitangent), normal);
+            }
+            for (int index : { 0, 1, 2, 0, 2, 3 })
+            {
+                indices.push_back(static_cast<unsigned short>(firstVertex + index));
+            }
+        }
+    }
+
+    m_cubeMesh = std::make_shared<Mesh>();
+    unsigned int vboIndex = m_cubeMesh->AddVertexData(std::span<const Vertex>(vertices));
+    unsigned int eboIndex = m_cubeMesh->AddElementData(std::span<const unsigned short>(indices));
+
+    VertexFormat::LayoutIterator layoutIterator = vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), true /* interleaved */);
+    unsigned int vaoIndex = m_cubeMesh->AddVertexArray(vboIndex, eboIndex, layoutIterator, vertexFormat.LayoutEnd());
+    m_cubeMesh->AddSubmesh(vaoIndex, Drawcall::Primitive::Triangles, 0, static_cast<GLsizei>(indices.size()), Data::GetType<unsigned short>());
+}
+
+void RendererBenchmarkApplication::InitializeMaterials()
+{
+    // Built now, so the materials get their uniforms. UpdateMaterials switches them to each configuration later
+    std::shared_ptr<ShaderProgram> shaderProgram = m_shaderPermutations.GetProgram(m_configurations[0].defines, true);
+    RegisterShaderProgram(shaderProgram);
+
+    for (const glm::vec3& color : { glm::vec3(0.8f, 0.2f, 0.2f), glm::vec3(0.2f, 0.8f, 0.2f), glm::vec3(0.2f, 0.2f, 0.8f), glm::vec3(0.8f, 0.8f, 0.8f) })
+    {
+        std::shared_ptr<Material> material = std::make_shared<Material>(shaderProgram, m_rendererUniforms);
+        material->SetUniformValue("Color", color);
+        material->SetUniformValue("SpecularExponent", 32.0f);
+        m_materials.push_back(material);
+
+        std::shared_ptr<Model> model = std::make_shared<Model>(m_cubeMesh);
+        model->AddMaterial(material);
+        model->SetLocalBounds(glm::vec3(0.0f), glm::vec3(0.5f));
+        m_models.push_back(model);
+    }
+}
+
+void RendererBenchmarkApplication::InitializeScene()
+{
+    // Cubes spaced by twice their size. The materials alternate, so sorting by state has something to group
+    float gridOffset = (s_gridSize - 1) * 0.5f;
+    for (int z = 0; z < s_gridSize; ++z)
+    {
+        for (int x = 0; x < s_gridSize; ++x)
+        {
+            glm::vec3 position = 2.0f * glm::vec3(x - gridOffset, 0.0f, z - gridOffset);
+            Model* model = m_models[(x + z) % m_models.size()].get();
+            m_modelInstances.push_back({ model, glm::translate(glm::mat4(1.0f), position) });
+        }
+    }
+
+    // Point lights in a circle over the grid, each one reaching a part of it
+    const int lightCount = 8;
+    for (int i = 0; i < lightCount; ++i)
+    {
+        float angle = glm::two_pi<float>() * i / lightCount;
+        std::shared_ptr<PointLight> light = std::make_shared<PointLight>();
+        light->SetPosition(glm::vec3(12.0f * std::cos(angle), 3.0f, 12.0f * std::sin(angle)));
+        light->SetDistanceAttenuation(glm::vec2(4.0f, 16.0f));
+        light->SetColor(glm::vec3(1.0f, 0.9f, 0.8f));
+        light->SetIntensity(2.0f);
+        m_lights.push_back(light);
+    }
+
+    m_camera.SetViewMatrix(glm::vec3(0.0f, 30.0f, 40.0f), glm::vec3(0.0f));
+    m_camera.SetPerspectiveProjectionMatrix(glm::radians(60.0f), static_cast<float>(s_width) / s_height, 0.1f, 200.0f);
+}
+
+void RendererBenchmarkApplication::InitializeFramebuffer()
+{
+    m_colorTexture = std::make_shared<Texture2DObject>();
+    m_colorTexture->Bind();
+    m_colorTexture->SetImage(0, s_width, s_height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA16F);
+    m_colorTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_colorTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+
+    m_depthTexture = std::make_shared<Texture2DObject>();
+    m_depthTexture->Bind();
+    m_depthTexture->SetImage(0, s_width, s_height, TextureObject::FormatDepth, TextureObject::InternalFormatDepth24);
+    m_depthTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_depthTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+    Texture2DObject::Unbind();
+
+    m_framebuffer = std::make_shared<FramebufferObject>();
+    m_framebuffer->Bind();
+    m_framebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_colorTexture);
+    m_framebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_depthTexture);
+    FramebufferObject::Unbind();
+
+    // The forward pass has no framebuffer of its own, it draws to the current one
+    m_renderer->SetCurrentFramebuffer(m_framebuffer);
+}
+
+void RendererBenchmarkApplication::Update()
+{
+    Application::Update();
+
+    // The materials are switched to the new programs in UpdateMaterials, keeping the values they had
+    if (!m_shaderFileWatcher.GetChangedFiles().empty())
+    {
+        m_shaderPermutations.Reload();
+        std::cerr << "Shaders reloaded" << std::endl;
+    }
+}
+
+void RendererBenchmarkApplication::InitializeConfiguration(const Configuration& configuration)
+{
+    m_renderer->SetMultiDrawIndirectEnabled(configuration.multiDrawIndirect);
+
+    m_timings = Timings();
+}
+
+void RendererBenchmarkApplication::UpdateMaterials(const ShaderPermutationCache::DefineSet& defines)
+{
+    for (const std::shared_ptr<Material>& material : m_materials)
+    {
+        if (m_shaderPermutations.UpdateMaterial(*material, defines, m_rendererUniforms))
+        {
+            RegisterShaderProgram(material->GetShaderProgram());
+        }
+    }
+}
+
+void RendererBenchmarkApplication::RegisterShaderProgram(std::shared_ptr<ShaderProgram> shaderProgram)
+{
+    // Only used by the programs without TransformBlock, the renderer binds the block for the others
+    ShaderProgram::Location worldMatrixLocation = shaderProgram->GetUniformLocation("WorldMatrix");
+    ShaderProgram::Location worldViewProjMatrixLocation = shaderProgram->GetUniformLocation("WorldViewProjMatrix");
+    m_renderer->RegisterShaderProgram(shaderProgram,
+        [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool /*cameraChanged*/)
+        {
+            shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
+            shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
+        },
+        m_renderer->GetDefaultUpdateLightsFunction(*shaderProgram));
+}
+
+void RendererBenchmarkApplication::Render()
+{
+    unsigned int framesPerConfiguration = m_warmUpFrameCount + m_measuredFrameCount;
+    const Configuration& configuration = m_configurations[GetFrameIndex() / framesPerConfiguration];
+    unsigned int configurationFrame = GetFrameIndex() % framesPerConfiguration;
+
+    if (configurationFrame == 0)
+    {
+        InitializeConfiguration(configuration);
+    }
+    UpdateMaterials(configuration.defines);
+
+    // Wait for the previous frames, so the time is only for this one
+    glFinish();
+    auto startTime = std::chrono::steady_clock::now();
+
+    glBeginQuery(GL_TIME_ELAPSED, m_query);
+    RenderScene();
+    glEndQuery(GL_TIME_ELAPSED);
+
+    glFinish();
+    std::chrono::duration<double> frameDuration = std::chrono::steady_clock::now() - startTime;
+
+    if (configurationFrame >= m_warmUpFrameCount)
+    {
+        m_timings.renderTime += GetQueryTime(m_query);
+        m_timings.frameTime += frameDuration.count();
+        m_rendererCounters = m_renderer->GetLastFrameCounters();
+        m_stateCounters = GetDevice().GetStateCounters();
+    }
+
+    if (configurationFrame + 1 == framesPerConfiguration)
+    {
+        PrintResults(configuration);
+    }
+}
+
+void RendererBenchmarkApplication::RenderScene()
+{
+    DeviceGL& device = GetDevice();
+
+    m_framebuffer->Bind();
+    device.SetViewport(0, 0, s_width, s_height);
+    // The light passes after the first one don't write depth
+    device.SetDepthWrite(true);
+    device.Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
+
+    m_renderer->SetCurrentCamera(m_camera);
+    for (const std::shared_ptr<PointLight>& light : m_lights)
+    {
+        m_renderer->AddLight(*light);
+    }
+    for (const ModelInstance& modelInstance : m_modelInstances)
+    {
+        m_renderer->AddModel(*modelInstance.model, modelInstance.worldMatrix);
+    }
+    m_renderer->Render();
+}
+
+void RendererBenchmarkApplication::PrintHeader() const
+{
+    std::cout << std::left
+        << std::setw(18) << "configuration" << std::setw(12) << "render ms" << std::setw(12) << "frame ms"
+        << std::setw(12) << "drawcalls" << std::setw(12) << "indirect" << std::setw(12) << "uniforms" << std::setw(14) << "uniform KB"
+        << "buffer binds" << std::endl;
+}
+
+void RendererBenchmarkApplication::PrintResults(const Configuration& configuration) const
+{
+    std::cout << std::left << std::fixed << std::setprecision(3)
+        << std::setw(18) << configuration.name
+        << std::setw(12) << m_timings.renderTime * 1000.0 / m_measuredFrameCount
+        << std::setw(12) << m_timings.frameTime * 1000.0 / m_measuredFrameCount
+        << std::setw(12) << m_rendererCounters.drawcalls
+        << std::setw(12) << m_rendererCounters.indirectBatches
+        << std::setw(12) << m_stateCounters.uniformChanges
+        << std::setw(14) << m_stateCounters.uniformBytes / 1024.0
+        << m_stateCounters.bufferBindingChanges << std::endl;
+}
+
+double RendererBenchmarkApplication::GetQueryTime(GLuint query)
+{
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    return nanoseconds * 1.0e-9;
+}
+
+void RendererBenchmarkApplication::Cleanup()
+{
+    glDeleteQueries(1, &m_query);
+
+    m_renderer.reset();
+    m_modelInstances.clear();
+    m_models.clear();
+    m_materials.clear();
+    m_cubeMesh.reset();
+    m_framebuffer.reset();
+    m_depthTexture.reset();
+    m_colorTexture.reset();
+
+    Application::Cleanup();
+}
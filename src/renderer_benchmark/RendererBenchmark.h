@@ -0,0 +1,121 @@
+#pragma once
+
+#include <ituGL/application/Application.h>
+#include <ituGL/asset/ShaderPermutationCache.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/utils/FileWatcher.h>
+#include <glm/mat4x4.hpp>
+#include <memory>
+#include <vector>
+
+class Mesh;
+class Model;
+class Material;
+class PointLight;
+class Texture2DObject;
+class FramebufferObject;
+
+// Renders a grid of lit cubes through the Renderer and a ForwardRenderPass, with no window, for each configuration of
+// the forward shader. The configurations choose with defines how the shader gets its data, so each path of the renderer
+// is exercised and timed
+class RendererBenchmarkApplication : public Application
+{
+public:
+    // Each configuration renders some warm up frames, and then measuredFrameCount frames
+    RendererBenchmarkApplication(unsigned int measuredFrameCount = 100);
+
+protected:
+    void Initialize() override;
+    void Update() override;
+    void Render() override;
+    void Cleanup() override;
+
+private:
+    struct Configuration
+    {
+        const char* name;
+        ShaderPermutationCache::DefineSet defines;
+        // Only changes the drawing of the programs that read TransformArrayBlock
+        bool multiDrawIndirect = false;
+    };
+
+    // Accumulated time of the measured frames of the current configuration, in seconds
+    struct Timings
+    {
+        double renderTime = 0.0;
+        double frameTime = 0.0;
+    };
+
+    void InitializeMeshes();
+    void InitializeMaterials();
+    void InitializeScene();
+    void InitializeFramebuffer();
+
+    void InitializeConfiguration(const Configuration& configuration);
+
+    // Switch the materials to the program of the defines, and register it in the renderer if it is new
+    // Called every frame, so the materials also get the programs rebuilt after the shaders are edited
+    void UpdateMaterials(const ShaderPermutationCache::DefineSet& defines);
+    void RegisterShaderProgram(std::shared_ptr<ShaderProgram> shaderProgram);
+
+    void RenderScene();
+
+    void PrintHeader() const;
+    void PrintResults(const Configuration& configuration) const;
+
+    // Elapsed GPU time of the query, in seconds. Waits for the result
+    static double GetQueryTime(GLuint query);
+
+private:
+    std::vector<Configuration> m_configurations;
+    unsigned int m_warmUpFrameCount;
+    unsigned int m_measuredFrameCount;
+
+    static const int s_width = 1920;
+    static const int s_height = 1080;
+
+    // Cubes in the grid, per side
+    static const int s_gridSize = 24;
+
+    // Created in Initialize, once there is a context
+    std::unique_ptr<Renderer> m_renderer;
+
+    ShaderPermutationCache m_shaderPermutations;
+
+    // Reloads the shaders when their files change
+    FileWatcher m_shaderFileWatcher;
+
+    // Uniforms set by the renderer, not stored in the materials
+    ShaderUniformCollection::NameSet m_rendererUniforms;
+
+    std::shared_ptr<Mesh> m_cubeMesh;
+
+    // One model for each material, all with the same mesh
+    std::vector<std::shared_ptr<Material>> m_materials;
+    std::vector<std::shared_ptr<Model>> m_models;
+
+    struct ModelInstance
+    {
+        Model* model;
+        glm::mat4 worldMatrix;
+    };
+    std::vector<ModelInstance> m_modelInstances;
+
+    std::vector<std::shared_ptr<PointLight>> m_lights;
+
+    Camera m_camera;
+
+    std::shared_ptr<Texture2DObject> m_colorTexture;
+    std::shared_ptr<Texture2DObject> m_depthTexture;
+    std::shared_ptr<FramebufferObject> m_framebuffer;
+
+    // Time query of the renderer
+    GLuint m_query;
+
+    Timings m_timings;
+
+    // Work done in the last measured frame. It is the same in all the frames of a configuration
+    Renderer::Counters m_rendererCounters;
+    DeviceGL::StateCounters m_stateCounters;
+};
@@ -0,0 +1,79 @@
+// Blinn-Phong. With LIGHT_BLOCK, all the lights of the object in a single pass. Otherwise, one light per pass from the
+// uniforms of Renderer::GetDefaultUpdateLightsFunction. The first pass also adds the ambient light
+
+in vec3 WorldPosition;
+in vec3 WorldNormal;
+#ifdef TRANSFORM_ARRAY
+flat in uint ObjectIndex;
+#endif
+
+out vec4 FragColor;
+
+#ifdef MATERIAL_BLOCK
+// Stored in the shared buffer of MaterialBlockPool, switching material only binds its range
+layout(std140) uniform MaterialBlock
+{
+	vec3 Color;
+	float SpecularExponent;
+};
+#else
+uniform vec3 Color;
+uniform float SpecularExponent;
+#endif
+
+uniform int LightIndirect;
+#ifndef LIGHT_BLOCK
+uniform vec3 LightColor;
+uniform vec3 LightPosition;
+uniform vec3 LightDirection;
+uniform vec4 LightAttenuation;
+#endif
+
+const vec3 AmbientColor = vec3(0.05);
+
+// Attenuation as in Light::GetAttenuation: negative for directional lights, and the distances where it starts and ends
+// for point lights. The scene has no spot lights, their cone is not applied
+vec3 GetLighting(vec3 lightColor, vec3 lightPosition, vec3 lightDirection, vec4 lightAttenuation, vec3 position, vec3 normal, vec3 viewDir)
+{
+	vec3 lightDir = -lightDirection;
+	float attenuation = 1.0;
+	if (lightAttenuation.x >= 0.0)
+	{
+		vec3 lightVector = lightPosition - position;
+		float lightDistance = length(lightVector);
+		lightDir = lightVector / lightDistance;
+		attenuation = 1.0 - smoothstep(lightAttenuation.x, lightAttenuation.y, lightDistance);
+	}
+
+	vec3 halfDir = normalize(lightDir + viewDir);
+	float diffuse = max(dot(normal, lightDir), 0.0);
+	float specular = pow(max(dot(normal, halfDir), 0.0), SpecularExponent);
+	return attenuation * lightColor * (diffuse * Color + specular * vec3(0.04));
+}
+
+void main()
+{
+	vec3 normal = normalize(WorldNormal);
+	vec3 viewDir = normalize(CameraPosition.xyz - WorldPosition);
+
+	vec3 color = LightIndirect != 0 ? AmbientColor * Color : vec3(0.0);
+#ifdef LIGHT_BLOCK
+	// The lights that reach the object, the most relevant first
+#ifdef TRANSFORM_ARRAY
+	ivec4 objectLightIndices[2] = Transforms[ObjectIndex].ObjectLightIndices;
+	int objectLightCount = Transforms[ObjectIndex].ObjectLightCount;
+#else
+	ivec4 objectLightIndices[2] = ObjectLightIndices;
+	int objectLightCount = ObjectLightCount;
+#endif
+	for (int i = 0; i < objectLightCount; ++i)
+	{
+		Light light = Lights[objectLightIndices[i / 4][i % 4]];
+		color += GetLighting(light.Color.rgb, light.Position.xyz, light.Direction.xyz, light.Attenuation, WorldPosition, normal, viewDir);
+	}
+#else
+	color += GetLighting(LightColor, LightPosition, LightDirection, LightAttenuation, WorldPosition, normal, viewDir);
+#endif
+
+	FragColor = vec4(color, 1.0);
+}
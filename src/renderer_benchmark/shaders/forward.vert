@@ -0,0 +1,31 @@
+// Cubes of the benchmark, in world space for the lighting
+
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 1) in vec3 VertexNormal;
+#ifdef TRANSFORM_ARRAY
+// Index of the object in TransformArrayBlock, see Renderer::DrawIndexLocation
+layout (location = 15) in uint DrawIndex;
+#endif
+
+out vec3 WorldPosition;
+out vec3 WorldNormal;
+#ifdef TRANSFORM_ARRAY
+flat out uint ObjectIndex;
+#endif
+
+void main()
+{
+#ifdef TRANSFORM_ARRAY
+	mat4 worldMatrix = Transforms[DrawIndex].WorldMatrix;
+	mat4 worldViewProjMatrix = Transforms[DrawIndex].WorldViewProjMatrix;
+	ObjectIndex = DrawIndex;
+#else
+	mat4 worldMatrix = WorldMatrix;
+	mat4 worldViewProjMatrix = WorldViewProjMatrix;
+#endif
+
+	WorldPosition = (worldMatrix * vec4(VertexPosition, 1.0)).xyz;
+	// The cubes are only scaled uniformly, so the normals don't need the inverse transpose
+	WorldNormal = (worldMatrix * vec4(VertexNormal, 0.0)).xyz;
+	gl_Position = worldViewProjMatrix * vec4(VertexPosition, 1.0);
+}
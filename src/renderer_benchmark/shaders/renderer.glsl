@@ -0,0 +1,66 @@
+#version 410 core
+#ifdef TRANSFORM_ARRAY
+#extension GL_ARB_shader_storage_buffer_object : require
+#endif
+
+// Blocks filled by the renderer, see Renderer::CameraBlockBinding. Included first in both stages
+// The defines of the configuration select where each shader reads its data from
+
+layout(std140) uniform CameraBlock
+{
+	mat4 ViewMatrix;
+	mat4 ProjMatrix;
+	mat4 ViewProjMatrix;
+	vec4 CameraPosition;
+};
+
+#if defined(TRANSFORM_ARRAY)
+// All the transform blocks of the frame, for multi draw indirect. The vertex shader gets the index of its object in
+// the DrawIndex attribute, and passes it to the fragment shader
+struct Transform
+{
+	mat4 WorldMatrix;
+	mat4 WorldViewProjMatrix;
+	ivec4 ObjectLightIndices[2];
+	int ObjectLightCount;
+};
+
+layout(std430) readonly buffer TransformArrayBlock
+{
+	Transform Transforms[];
+};
+#elif defined(TRANSFORM_BLOCK)
+// One block per object, the renderer binds its range before each drawcall
+layout(std140) uniform TransformBlock
+{
+	mat4 WorldMatrix;
+	mat4 WorldViewProjMatrix;
+	ivec4 ObjectLightIndices[2];
+	int ObjectLightCount;
+};
+#else
+// Set in every drawcall, with the UpdateTransformsFunction of the program
+uniform mat4 WorldMatrix;
+uniform mat4 WorldViewProjMatrix;
+#endif
+
+#ifdef LIGHT_BLOCK
+#if !defined(TRANSFORM_BLOCK) && !defined(TRANSFORM_ARRAY)
+#error LIGHT_BLOCK needs the light indices of the object, from TRANSFORM_BLOCK or TRANSFORM_ARRAY
+#endif
+
+// All the lights of the frame, see Light::PackedData. Color is multiplied by the intensity, and Color.w is the type
+struct Light
+{
+	vec4 Color;
+	vec4 Position;
+	vec4 Direction;
+	vec4 Attenuation;
+};
+
+layout(std140) uniform LightBlock
+{
+	uint LightCount;
+	Light Lights[64];
+};
+#endif